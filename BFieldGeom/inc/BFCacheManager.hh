@@ -3,6 +3,9 @@
 // Andrei Gaponenko, 2012
 //
 // Modifed by Brian Pollack to use shared_ptrs to BFMaps for consistent use across classes.
+//
+// The lookup hands out plain pointers and keeps its hints outside of the
+// manager, so that one instance can be shared between threads.
 
 #ifndef BFCacheManager_hh
 #define BFCacheManager_hh
@@ -28,15 +31,20 @@ namespace mu2e {
     //
 
     class BFCacheManager {
-        // typedef std::vector<const BFMap*> SequenceType;
-        // typedef std::vector<std::shared_ptr<const BFMap>> SequenceType;
         typedef std::vector<std::shared_ptr<BFMap>> MapContainerType;
-        struct MapList : public MapContainerType {
-            // return the first matching map or 0
-            std::shared_ptr<const BFMap> findMap(const CLHEP::Hep3Vector& x) const {
-                for (MapContainerType::const_iterator i = begin(); i != end(); ++i) {
-                    if ((*i)->isValid(x)) {
-                        return *i;
+
+        // A map and the index of its cache element
+        struct MapEntry {
+            const BFMap* map;
+            int element;
+        };
+
+        struct MapList : public std::vector<MapEntry> {
+            // return the first matching entry or 0
+            const MapEntry* findMap(const CLHEP::Hep3Vector& x) const {
+                for (const_iterator i = begin(); i != end(); ++i) {
+                    if (i->map->isValid(x)) {
+                        return &*i;
                     }
                 }
                 return 0;
@@ -45,77 +53,80 @@ namespace mu2e {
 
         // An instance per (any) map, allows to optimize the lookup order of "inner" maps
         struct CacheElement {
-            std::shared_ptr<const BFMap> myMap;  // the map this instance is attached to
+            const BFMap* myMap;  // the map this instance is attached to
             // A list of "inner" maps optimized for the "my" map
             // If "my" map is an inner map, it is not in the list.
             MapList inner;
 
-            CacheElement(std::shared_ptr<const BFMap> my, const MapList& in)
-                : myMap(my), inner(in) {}
+            CacheElement(const BFMap* my, const MapList& in) : myMap(my), inner(in) {}
         };
 
-        // Inner map lists optimized for the last used map
-        mutable const CacheElement* innerForLastInner;
-        mutable const CacheElement* innerForLastOuter;  // never null
-
         // Outer maps in the user-specified order
         MapList outer;
 
-        typedef std::map<std::shared_ptr<const BFMap>, CacheElement> CacheType;
-        CacheType innerCache;  // keys are all inner maps
-        CacheType outerCache;  // keys are outer maps and 0
-        int counter;
+        std::vector<CacheElement> innerCache;  // one per inner map, in the input order
+        std::vector<CacheElement> outerCache;  // no map first, then one per outer map
+
+        // The maps pointed to above
+        MapContainerType maps;
 
        public:
+        // The last used maps, as indices in the cache.  Any hint gives the same
+        // maps, a hint from the previous lookup only makes it faster.
+        struct Hint {
+            int lastInner = -1;  // -1 if the last point was not in an inner map
+            int lastOuter = 0;   // 0 if the last point was in no outer map
+        };
+
         BFCacheManager();
 
         void setMaps(const MapContainerType& innerMaps, const MapContainerType& outerMaps);
 
+        // The hint of the calling thread, shared by all instances
+        static Hint& threadHint();
+
         // Returns pointers to an appropriate field map, or 0.
-        std::shared_ptr<const BFMap> findMap(const CLHEP::Hep3Vector& x) const {
+        const BFMap* findMap(const CLHEP::Hep3Vector& x) const { return findMap(x, threadHint()); }
+
+        // Same with a hint owned by the caller.
+        const BFMap* findMap(const CLHEP::Hep3Vector& x, Hint& hint) const {
             // First try to find if the point belong to any of the inner maps
 
-            if (innerForLastInner) {  // we were in an inner map last time
+            if (hint.lastInner >= 0 && hint.lastInner < int(innerCache.size())) {
+                // we were in an inner map last time
+                const CacheElement& last = innerCache[hint.lastInner];
 
-                if (innerForLastInner->myMap->isValid(x)) {
-                    // Cache update not needed, we are still in the same inner map
-                    return innerForLastInner->myMap;
+                if (last.myMap->isValid(x)) {
+                    // Hint update not needed, we are still in the same inner map
+                    return last.myMap;
                 }
 
                 // The lookup order here is optimized
-                std::shared_ptr<const BFMap> newinner = innerForLastInner->inner.findMap(x);
-                if (newinner) {  // Update cache
-                    CacheType::const_iterator p = innerCache.find(newinner);
-                    assert(p != innerCache.end());
-                    innerForLastInner = &p->second;
-                    return newinner;
+                const MapEntry* newinner = last.inner.findMap(x);
+                if (newinner) {
+                    hint.lastInner = newinner->element;
+                    return newinner->map;
                 }
             } else {  // We were not in an inner map last time
 
-                // innerForLastOuter is never null
-                std::shared_ptr<const BFMap> newinner = innerForLastOuter->inner.findMap(x);
-                if (newinner) {  // Update cache
-                    CacheType::const_iterator p = innerCache.find(newinner);
-                    assert(p != innerCache.end());
-                    innerForLastInner = &p->second;
-                    return newinner;
+                int lastOuter = hint.lastOuter > 0 && hint.lastOuter < int(outerCache.size()) ? hint.lastOuter : 0;
+                const MapEntry* newinner = outerCache[lastOuter].inner.findMap(x);
+                if (newinner) {
+                    hint.lastInner = newinner->element;
+                    return newinner->map;
                 }
             }
 
             // The current point is not in any of the inner maps
-            innerForLastInner = 0;
+            hint.lastInner = -1;
 
             // The lookup order of the outer maps is always the same
-            std::shared_ptr<const BFMap> newouter = outer.findMap(x);
+            const MapEntry* newouter = outer.findMap(x);
 
             // Keep the inner map lookup optimized
-            if (innerForLastOuter->myMap != newouter) {
-                CacheType::const_iterator p = outerCache.find(newouter);
-                assert(p != outerCache.end());
-                innerForLastOuter = &p->second;
-            }
+            hint.lastOuter = newouter ? newouter->element : 0;
 
-            return newouter;
+            return newouter ? newouter->map : 0;
         }
     };
 }  // namespace mu2e
@@ -10,12 +10,23 @@
 // Rewritten in part by Krzysztof Genser to save execution time
 // Rewritten again by Brian Pollack to separate out Grid-like maps from other map types
 //
+// The field values are read into a Container3D of Hep3Vectors and then repacked, by
+// packField(), into three contiguous arrays (structure of arrays) that are used by the
+// interpolators.
+// Maps read from a .bfmap file (see BFMapFile.hh) use the memory-mapped arrays directly.
+// The field gradient is the derivative of the interpolating polynomial, computed from the
+// same neighbors as the field.
+//
 
 //#include <iosfwd>
+#include <cstddef>
+#include <memory>
 #include <ostream>
 #include <string>
+#include <vector>
 #include "BFieldGeom/inc/BFInterpolationStyle.hh"
 #include "BFieldGeom/inc/BFMap.hh"
+#include "BFieldGeom/inc/BFMapFile.hh"
 #include "BFieldGeom/inc/BFMapType.hh"
 #include "BFieldGeom/inc/Container3D.hh"
 #include "CLHEP/Vector/ThreeVector.h"
@@ -62,19 +73,33 @@ namespace mu2e {
               _dx(dx),
               _dy(dy),
               _dz(dz),
-              _field(_nx, _ny, _nz),
-              _isDefined(_nx, _ny, _nz, false),
+              _field(),
+              _isDefined(),
               _allDefined(false),
-              _interpStyle(style){};
+              _interpStyle(style),
+              _packedField(),
+              _bx(nullptr),
+              _by(nullptr),
+              _bz(nullptr),
+              _mappedDefined(nullptr),
+              _fieldSign(1.){};
 
         ~BFGridMap(){};
 
+        // The packed arrays are referenced by pointer; do not copy.
+        BFGridMap(const BFGridMap&) = delete;
+        BFGridMap& operator=(const BFGridMap&) = delete;
+
         virtual bool getBFieldWithStatus(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const;
 
+        virtual bool getBFieldAndGradWithStatus(const CLHEP::Hep3Vector& point,
+                                                CLHEP::Hep3Vector& field,
+                                                CLHEP::Hep3Vector grad[3]) const;
+
         // Validity checker
         virtual bool isValid(const CLHEP::Hep3Vector& point) const;
         bool isValid(const GridPoint& ipoint) const {
-            return _field.isValid(ipoint.ix, ipoint.iy, ipoint.iz);
+            return ipoint.ix < _nx && ipoint.iy < _ny && ipoint.iz < _nz;
         }
 
         // Some extra checks for GMC format maps.
@@ -88,12 +113,34 @@ namespace mu2e {
         double dy() const { return _dy; };
         double dz() const { return _dz; };
 
+        bool flipy() const { return _flipy; }
+        BFInterpolationStyle interpolationStyle() const { return _interpStyle; }
+        double scaleFactor() const { return _scaleFactor; }
+        bool isDefined(unsigned ix, unsigned iy, unsigned iz) const {
+            if (_allDefined)
+                return true;
+            return _mappedDefined ? _mappedDefined[index(ix, iy, iz)] != 0
+                                  : _isDefined(ix, iy, iz);
+        }
+
+        // True if the field values are memory-mapped from a .bfmap file.
+        bool isMapped() const { return _mappedFile != nullptr; }
+
         CLHEP::Hep3Vector grid2point(unsigned ix, unsigned iy, unsigned iz) const {
             return CLHEP::Hep3Vector(_xmin + ix * _dx, _ymin + iy * _dy, _zmin + iz * _dz);
         }
 
         GridPoint point2grid(const CLHEP::Hep3Vector& pos) const;
 
+        // Field value stored at a grid point, without the scale factor; no bounds check.
+        // Before packField() the value is taken from the Container3D.
+        CLHEP::Hep3Vector fieldAt(unsigned ix, unsigned iy, unsigned iz) const {
+            if (_bx == nullptr)
+                return _field(ix, iy, iz);
+            std::size_t i = index(ix, iy, iz);
+            return CLHEP::Hep3Vector(_bx[i], _by[i], _bz[i]) * _fieldSign;
+        }
+
         // returns vector from ipos to pos normalized to grid spacing
         CLHEP::Hep3Vector cellFraction(const CLHEP::Hep3Vector& pos, const GridPoint& ipos) const;
 
@@ -111,7 +158,9 @@ namespace mu2e {
         // Distance between points.
         double _dx, _dy, _dz;
 
-        // Vector arrays for gridpoints and field values
+        // Field values and their validity as filled by BFieldManagerMaker, which also
+        // allocates them; _field is released by packField().  Neither is allocated for
+        // memory-mapped maps.
         mu2e::Container3D<CLHEP::Hep3Vector> _field;
         mu2e::Container3D<bool> _isDefined;
 
@@ -125,17 +174,61 @@ namespace mu2e {
         // yet to be defined.
         BFInterpolationStyle _interpStyle;
 
+        // Field components in structure of arrays layout, same index order as Container3D.
+        // _bx, _by and _bz point into _packedField or into _mappedFile.
+        std::vector<double> _packedField;
+        std::shared_ptr<const BFMapFile> _mappedFile;
+        const double* _bx;
+        const double* _by;
+        const double* _bz;
+
+        // Validity of the grid points of a memory-mapped map, null if all are defined.
+        const unsigned char* _mappedDefined;
+
+        // -1 if a memory-mapped map has been flipped; its field values are read-only.
+        double _fieldSign;
+
         // Functions used internally and by the code that populates the maps.
 
-        // method to store the neighbors
-        bool getNeighbors(int ix, int iy, int iz, CLHEP::Hep3Vector neighborsBF[3][3][3]) const;
+        // Copy _field into the packed arrays and release _field.  Must be called
+        // once the map is completely filled, before the first field lookup.
+        void packField();
+
+        // Use the field values from a memory-mapped file instead of _field;
+        // packField() then does nothing.
+        void useMappedFile(std::shared_ptr<const BFMapFile> file);
+
+        // Index into the packed arrays.
+        std::size_t index(unsigned ix, unsigned iy, unsigned iz) const {
+            return (std::size_t(ix) * _ny + iy) * _nz + iz;
+        }
 
-        // Interpolator
-        CLHEP::Hep3Vector interpolate(CLHEP::Hep3Vector const vec[3][3][3],
+        // Check that the 3x3x3 neighbors starting at (ix,iy,iz) all have a field defined
+        bool neighborsDefined(unsigned ix, unsigned iy, unsigned iz) const;
+
+        // Quadratic interpolator over the 3x3x3 neighbors starting at (ix,iy,iz);
+        // frac is the position of the point in units of the grid spacing, relative to (ix,iy,iz).
+        CLHEP::Hep3Vector interpolate(unsigned ix,
+                                      unsigned iy,
+                                      unsigned iz,
                                       const CLHEP::Hep3Vector& frac) const;
 
-        // Polynomial fit function used by interpolator
-        double gmcpoly2(double const f1d[3], double const& x) const;
+        // Same, also filling the gradient dB/dx_j of the interpolating polynomial.
+        CLHEP::Hep3Vector interpolate(unsigned ix,
+                                      unsigned iy,
+                                      unsigned iz,
+                                      const CLHEP::Hep3Vector& frac,
+                                      CLHEP::Hep3Vector grad[3]) const;
+
+        // Weights of the 2nd order Lagrange polynomial through the nodes 0, 1 and 2
+        static void gmcpoly2Weights(double x, double w[3]);
+
+        // Derivatives of those weights with respect to x
+        static void gmcpoly2Derivatives(double x, double d[3]);
+
+        // Change a gradient computed at (x,|y|,z) into the gradient at (x,y,z) for y < 0,
+        // where the field is (Bx,-By,Bz)(x,|y|,z).
+        static void flipGrad(CLHEP::Hep3Vector grad[3]);
 
         // Compute grid indices for a given point.
         std::size_t iX(double x) const { return static_cast<int>((x - _xmin) / _dx + 0.5); }
@@ -144,8 +237,13 @@ namespace mu2e {
 
         std::size_t iZ(double z) const { return static_cast<int>((z - _zmin) / _dz + 0.5); }
 
-        bool interpolateTriLinear(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const;
-        bool interpolateQuadratic(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const;
+        // The gradient is filled if grad is not null.
+        bool interpolateTriLinear(const CLHEP::Hep3Vector&,
+                                  CLHEP::Hep3Vector&,
+                                  CLHEP::Hep3Vector* grad = nullptr) const;
+        bool interpolateQuadratic(const CLHEP::Hep3Vector&,
+                                  CLHEP::Hep3Vector&,
+                                  CLHEP::Hep3Vector* grad = nullptr) const;
     };
 
     inline BFGridMap::GridPoint BFGridMap::point2grid(const CLHEP::Hep3Vector& pos) const {
@@ -50,6 +50,26 @@ namespace mu2e {
         // Accessors
         virtual bool getBFieldWithStatus(const CLHEP::Hep3Vector&, CLHEP::Hep3Vector&) const = 0;
 
+        // Field and its gradient, grad[j] = dB/dx_j, at one point.  Returns false, with a zero
+        // field and gradient, if the map is not valid at the point.  This default takes forward
+        // differences over 0.01 mm; maps that can compute the gradient should override it.
+        virtual bool getBFieldAndGradWithStatus(const CLHEP::Hep3Vector& point,
+                                                CLHEP::Hep3Vector& field,
+                                                CLHEP::Hep3Vector grad[3]) const {
+            static const double step(0.01);
+            if (!getBFieldWithStatus(point, field)) {
+                field = grad[0] = grad[1] = grad[2] = CLHEP::Hep3Vector(0., 0., 0.);
+                return false;
+            }
+            for (int j = 0; j != 3; ++j) {
+                CLHEP::Hep3Vector p(point), b;
+                p(j) += step;
+                getBFieldWithStatus(p, b);
+                grad[j] = (b - field) * (1. / step);
+            }
+            return true;
+        }
+
         // Validity checker
         virtual bool isValid(const CLHEP::Hep3Vector& point) const = 0;
 
@@ -0,0 +1,109 @@
+#ifndef BFieldGeom_BFMapFile_hh
+#define BFieldGeom_BFMapFile_hh
+//
+// Self-describing binary format for grid-like magnetic field maps, designed to be
+// mapped read-only into memory.  All processes on a node that use the same file
+// share one physical copy of the map, and pages are only read from disk when a
+// field lookup first touches them.
+//
+// Layout of a .bfmap file:
+//   BFMapFileHeader
+//   zero padding up to payloadOffset, a multiple of the page size
+//   bx[n], by[n], bz[n]   doubles, n = nx*ny*nz, index = (ix*ny + iy)*nz + iz
+//   defined[n]            one byte per grid point; only present if allDefinedFlag is not set
+//
+// The header carries its own checksum, which is checked every time the file is opened.
+// The payload checksum is only checked on request, since it touches every page.
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace mu2e {
+
+    struct BFMapFileHeader {
+        static constexpr uint32_t endianMarkerValue = 0XDEADBEEF;
+        static constexpr uint32_t currentVersion = 1;
+        static constexpr uint32_t flipYFlag = 0x1;
+        static constexpr uint32_t allDefinedFlag = 0x2;
+        static constexpr std::size_t keySize = 128;
+        static constexpr std::size_t alignment = 4096;
+
+        char magic[8];           // "MU2EBFM"
+        uint32_t endianMarker;   // endianMarkerValue
+        uint32_t version;        // currentVersion
+        uint64_t headerSize;     // sizeof(BFMapFileHeader)
+        uint64_t payloadOffset;  // offset of bx[0] from the start of the file
+        uint64_t payloadSize;    // bytes from payloadOffset to the end of the file
+        uint32_t nx, ny, nz;
+        uint32_t flags;
+        double xmin, ymin, zmin;  // mm, in the Mu2e coordinate system
+        double dx, dy, dz;        // mm
+        char key[keySize];        // name of the map when it was written
+        uint64_t payloadChecksum;
+        uint64_t headerChecksum;  // checksum of all of the header that precedes it
+
+        // Fill the fixed fields of the header and compute the payload layout.
+        void init(const std::string& mapKey);
+
+        std::size_t nPoints() const { return std::size_t(nx) * ny * nz; }
+        bool flipY() const { return flags & flipYFlag; }
+        bool allDefined() const { return flags & allDefinedFlag; }
+
+        uint64_t computeHeaderChecksum() const;
+    };
+
+    // The layout is part of the file format.
+    static_assert(sizeof(BFMapFileHeader) == 248, "BFMapFileHeader layout changed");
+
+    // FNV-1a 64 bit hash, used as the checksum of the header and of the payload.
+    uint64_t bfmapChecksum(const void* data, std::size_t nbytes,
+                           uint64_t hash = 0xcbf29ce484222325ULL);
+
+    // Write a .bfmap file.  The geometry fields and flags of the header must be set;
+    // the remaining fields are computed here.  defined may be null if all grid
+    // points are defined.  The file is written under a unique temporary name and then
+    // linked to filename, so other processes never see a partially written map.  Throws
+    // if filename already exists.
+    void writeBFMapFile(const std::string& filename,
+                        BFMapFileHeader header,
+                        const double* bx,
+                        const double* by,
+                        const double* bz,
+                        const unsigned char* defined);
+
+    // A read-only memory mapping of a .bfmap file, unmapped on destruction.
+    class BFMapFile {
+       public:
+        // Throws if the file cannot be mapped or the header is not valid.
+        explicit BFMapFile(const std::string& filename);
+        ~BFMapFile();
+
+        BFMapFile(const BFMapFile&) = delete;
+        BFMapFile& operator=(const BFMapFile&) = delete;
+
+        const BFMapFileHeader& header() const { return *_header; }
+        const std::string& filename() const { return _filename; }
+
+        const double* bx() const { return _bx; }
+        const double* by() const { return _bx + _header->nPoints(); }
+        const double* bz() const { return _bx + 2 * _header->nPoints(); }
+
+        // Null if all grid points are defined.
+        const unsigned char* defined() const;
+
+        // Compute the payload checksum; this reads the whole file.
+        bool verifyPayload() const;
+
+       private:
+        std::string _filename;
+        void* _addr;
+        std::size_t _size;
+        const BFMapFileHeader* _header;
+        const double* _bx;
+    };
+
+}  // namespace mu2e
+
+#endif /* BFieldGeom_BFMapFile_hh */
@@ -63,13 +63,25 @@ namespace mu2e {
         // to trigger the map-writing hack inside the BFieldManagerMaker code.
         bool writeBinaries() const { return writeBinaries_; }
 
+        // Format of the binaries written if writeBinaries is set:
+        // "G4BL" for .header/.bin pairs, "mapped" for memory-mappable .bfmap files.
+        const std::string& binaryFormat() const { return binaryFormat_; }
+
+        // Verify the payload checksum of .bfmap files when they are opened.
+        bool verifyMappedChecksums() const { return verifyMappedChecksums_; }
+
         int verbosityLevel() const { return verbosityLevel_; }
 
         bool flipBFieldMaps() const { return flipBFieldMaps_; }
 
        private:
         BFieldConfig()
-            : scaleFactor_(1.), writeBinaries_(false), verbosityLevel_(1), flipBFieldMaps_(false) {}
+            : scaleFactor_(1.),
+              writeBinaries_(false),
+              binaryFormat_("G4BL"),
+              verifyMappedChecksums_(false),
+              verbosityLevel_(1),
+              flipBFieldMaps_(false) {}
 
         // GMC, G4BL or possible future types.
         BFMapType mapType_;
@@ -95,6 +107,8 @@ namespace mu2e {
         CLHEP::Hep3Vector dsGradientValue_;
 
         bool writeBinaries_;
+        std::string binaryFormat_;
+        bool verifyMappedChecksums_;
         int verbosityLevel_;
         bool flipBFieldMaps_;
     };
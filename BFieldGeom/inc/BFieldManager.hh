@@ -15,6 +15,7 @@
 // C++ includes
 #include <set>
 #include <string>
+#include <vector>
 
 // Includes from Mu2e
 #include "BFieldGeom/inc/BFCacheManager.hh"
@@ -71,6 +72,12 @@ namespace mu2e {
           return result;
         }
 
+        // Get the field and its gradient, grad[j] = dB/dx_j, at one point.  Both are zero
+        // out of range.
+        bool getBFieldAndGradWithStatus(const CLHEP::Hep3Vector& point,
+                                        CLHEP::Hep3Vector& field,
+                                        CLHEP::Hep3Vector grad[3]) const;
+
         BFCacheManager cacheManager() const { return cm_; }
 
         const MapContainerType& getInnerMaps() const { return innerMaps_; }
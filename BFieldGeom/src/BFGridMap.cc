@@ -9,6 +9,7 @@
 // methods.
 
 // C++ includes
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 
@@ -61,27 +62,80 @@ namespace mu2e {
                                  (pos.z() - gridpos.z()) / _dz);
     }
 
-    // Populate a 3x3x3 array with the field values centered on the grid point
-    // that is the closest to the requested point.
-    bool BFGridMap::getNeighbors(int ix,
-                                 int iy,
-                                 int iz,
-                                 CLHEP::Hep3Vector neighborsBF[3][3][3]) const {
-        for (int i = 0; i != 3; ++i) {
-            unsigned int xindex = ix + i - 1;
-            for (int j = 0; j != 3; ++j) {
-                unsigned int yindex = iy + j - 1;
-                for (int k = 0; k != 3; ++k) {
-                    unsigned int zindex = iz + k - 1;
-                    if (!_isDefined(xindex, yindex, zindex))
+    // Copy the field values into the structure of arrays layout used by the interpolators
+    // and release the Container3D.
+    void BFGridMap::packField() {
+        // The quadratic interpolation uses 3 grid points along each dimension.
+        if (_interpStyle == BFInterpolationStyle::meco && (_nx < 3 || _ny < 3 || _nz < 3)) {
+            throw cet::exception("GEOM")
+                << "BFGridMap: map " << _key << " has " << _nx << " x " << _ny << " x " << _nz
+                << " grid points, at least 3 per dimension are needed for " << _interpStyle
+                << " interpolation\n";
+        }
+
+        if (_mappedFile)
+            return;
+
+        const std::size_t npoints = std::size_t(_nx) * _ny * _nz;
+        _packedField.assign(3 * npoints, 0.);
+        double* bx = _packedField.data();
+        double* by = bx + npoints;
+        double* bz = by + npoints;
+
+        _allDefined = true;
+        for (unsigned ix = 0; ix != _nx; ++ix) {
+            for (unsigned iy = 0; iy != _ny; ++iy) {
+                for (unsigned iz = 0; iz != _nz; ++iz) {
+                    std::size_t i = index(ix, iy, iz);
+                    const CLHEP::Hep3Vector& b = _field(ix, iy, iz);
+                    bx[i] = b.x();
+                    by[i] = b.y();
+                    bz[i] = b.z();
+                    _allDefined = _allDefined && _isDefined(ix, iy, iz);
+                }
+            }
+        }
+        _bx = bx;
+        _by = by;
+        _bz = bz;
+
+        _field.cleart();
+        if (_allDefined)
+            _isDefined = Container3D<bool>();
+    }
+
+    // Point the field arrays into the mapped file; the pages are only read in when used.
+    void BFGridMap::useMappedFile(std::shared_ptr<const BFMapFile> file) {
+        const BFMapFileHeader& h = file->header();
+        if (h.nx != _nx || h.ny != _ny || h.nz != _nz) {
+            throw cet::exception("GEOM")
+                << "BFGridMap: grid dimensions of " << file->filename()
+                << " do not match the map " << _key << "\n";
+        }
+
+        _flipy = h.flipY();
+        _allDefined = h.allDefined();
+        _mappedDefined = file->defined();
+
+        _bx = file->bx();
+        _by = file->by();
+        _bz = file->bz();
+        _mappedFile = std::move(file);
+
+        _field.cleart();
+        _isDefined = Container3D<bool>();
+        std::vector<double>().swap(_packedField);
+    }
+
+    // Check that all points of the 3x3x3 neighbor grid starting at (ix,iy,iz) have a field defined.
+    bool BFGridMap::neighborsDefined(unsigned ix, unsigned iy, unsigned iz) const {
+        if (_allDefined)
+            return true;
+        for (unsigned i = 0; i != 3; ++i) {
+            for (unsigned j = 0; j != 3; ++j) {
+                for (unsigned k = 0; k != 3; ++k) {
+                    if (!isDefined(ix + i, iy + j, iz + k))
                         return false;
-                    neighborsBF[i][j][k] = _field(xindex, yindex, zindex);
-                    /*
-                              cout << "Neighbor(" << xindex << "," << yindex << "," << zindex
-                              << ") = (" << neighborsBF(i,j,k).x() << ","
-                              << neighborsBF(i,j,k).y() << "," << neighborsBF(i,j,k).z()
-                              << ")" << endl;
-                    */
                 }
             }
         }
@@ -89,66 +143,109 @@ namespace mu2e {
     }
 
     // Function to interpolate the BField value at the point from the values
-    // at in the neighbor grid.
-    CLHEP::Hep3Vector BFGridMap::interpolate(CLHEP::Hep3Vector const vec[3][3][3],
+    // of the neighbor grid.  The 1D Lagrange interpolation is separable, so the
+    // result is the sum over the 27 neighbors weighted by wx[i]*wy[j]*wz[k];
+    // the innermost loop runs over contiguous memory.
+    CLHEP::Hep3Vector BFGridMap::interpolate(unsigned ix,
+                                             unsigned iy,
+                                             unsigned iz,
                                              const CLHEP::Hep3Vector& frac) const {
-        // Create vecs and vectors
-        double x1d[3], y1d[3], z1d[3];
-        CLHEP::Hep3Vector vecx[9];
-        CLHEP::Hep3Vector vecxy[3];
-        double xin = frac[0];
-        double yin = frac[1];
-        double zin = frac[2];
-
-        /*  cout << "--------Starting interpolation-------- \n" << "Input: ("
-            << xin << "," << yin << "," << zin << ")" << endl;*/
-
-        // First loop - interpolate xin
-        for (int j = 0; j != 3; ++j) {
-            for (int k = 0; k != 3; ++k) {
-                for (int i = 0; i != 3; ++i) {
-                    /*        cout << "1st loop access: (" << vec[i][j][k].x() << ","
-                              << vec[i][j][k].y() << "," << vec[i][j][k].z() << ")" << endl;*/
-                    x1d[i] = (vec[i][j][k]).x();
-                    y1d[i] = (vec[i][j][k]).y();
-                    z1d[i] = (vec[i][j][k]).z();
+        double wx[3], wy[3], wz[3];
+        gmcpoly2Weights(frac.x(), wx);
+        gmcpoly2Weights(frac.y(), wy);
+        gmcpoly2Weights(frac.z(), wz);
+
+        double bx(0.), by(0.), bz(0.);
+        for (unsigned i = 0; i != 3; ++i) {
+            for (unsigned j = 0; j != 3; ++j) {
+                const std::size_t base = index(ix + i, iy + j, iz);
+                const double wxy = wx[i] * wy[j];
+                for (unsigned k = 0; k != 3; ++k) {
+                    const double w = wxy * wz[k];
+                    bx += w * _bx[base + k];
+                    by += w * _by[base + k];
+                    bz += w * _bz[base + k];
                 }
-                vecx[j * 3 + k] =
-                    CLHEP::Hep3Vector(gmcpoly2(x1d, xin), gmcpoly2(y1d, xin), gmcpoly2(z1d, xin));
             }
         }
+        return CLHEP::Hep3Vector(bx, by, bz);
+    }
 
-        // Second loop - interpolate yin
-        for (int k = 0; k != 3; ++k) {
-            for (int j = 0; j != 3; ++j) {
-                int index = j * 3 + k;
-                x1d[j] = vecx[index].x();
-                y1d[j] = vecx[index].y();
-                z1d[j] = vecx[index].z();
+    // Same sum for the field; the gradient uses the derivative of the weights along
+    // one axis, in units of the grid spacing.
+    CLHEP::Hep3Vector BFGridMap::interpolate(unsigned ix,
+                                             unsigned iy,
+                                             unsigned iz,
+                                             const CLHEP::Hep3Vector& frac,
+                                             CLHEP::Hep3Vector grad[3]) const {
+        double wx[3], wy[3], wz[3], dwx[3], dwy[3], dwz[3];
+        gmcpoly2Weights(frac.x(), wx);
+        gmcpoly2Weights(frac.y(), wy);
+        gmcpoly2Weights(frac.z(), wz);
+        gmcpoly2Derivatives(frac.x(), dwx);
+        gmcpoly2Derivatives(frac.y(), dwy);
+        gmcpoly2Derivatives(frac.z(), dwz);
+
+        double bx(0.), by(0.), bz(0.);
+        double gxx(0.), gxy(0.), gxz(0.), gyx(0.), gyy(0.), gyz(0.), gzx(0.), gzy(0.), gzz(0.);
+        for (unsigned i = 0; i != 3; ++i) {
+            for (unsigned j = 0; j != 3; ++j) {
+                const std::size_t base = index(ix + i, iy + j, iz);
+                const double wxy = wx[i] * wy[j];
+                // sums along z, with the weights and with their derivatives
+                double sx(0.), sy(0.), sz(0.), dx(0.), dy(0.), dz(0.);
+                for (unsigned k = 0; k != 3; ++k) {
+                    const double w = wxy * wz[k];
+                    bx += w * _bx[base + k];
+                    by += w * _by[base + k];
+                    bz += w * _bz[base + k];
+                    sx += wz[k] * _bx[base + k];
+                    sy += wz[k] * _by[base + k];
+                    sz += wz[k] * _bz[base + k];
+                    dx += dwz[k] * _bx[base + k];
+                    dy += dwz[k] * _by[base + k];
+                    dz += dwz[k] * _bz[base + k];
+                }
+                const double wgx = dwx[i] * wy[j];
+                const double wgy = wx[i] * dwy[j];
+                gxx += wgx * sx;
+                gxy += wgx * sy;
+                gxz += wgx * sz;
+                gyx += wgy * sx;
+                gyy += wgy * sy;
+                gyz += wgy * sz;
+                gzx += wxy * dx;
+                gzy += wxy * dy;
+                gzz += wxy * dz;
             }
-            vecxy[k] =
-                CLHEP::Hep3Vector(gmcpoly2(x1d, yin), gmcpoly2(y1d, yin), gmcpoly2(z1d, yin));
         }
-
-        // Third loop - interpolate zin
-        for (int k = 0; k != 3; ++k) {
-            x1d[k] = vecxy[k].x();
-            y1d[k] = vecxy[k].y();
-            z1d[k] = vecxy[k].z();
-        }
-
-        // Return BField 3Vector
-        return CLHEP::Hep3Vector(gmcpoly2(x1d, zin), gmcpoly2(y1d, zin), gmcpoly2(z1d, zin));
+        grad[0] = CLHEP::Hep3Vector(gxx, gxy, gxz) * (1. / _dx);
+        grad[1] = CLHEP::Hep3Vector(gyx, gyy, gyz) * (1. / _dy);
+        grad[2] = CLHEP::Hep3Vector(gzx, gzy, gzz) * (1. / _dz);
+        return CLHEP::Hep3Vector(bx, by, bz);
     }
 
     // Standard Lagrange formula for 2nd order polynomial fit of
-    // univariate function
-    double BFGridMap::gmcpoly2(double const f1d[3], double const& x) const {
-        static const double x0(0.), x1(1.), x2(2.);
+    // univariate function, on the nodes x0=0, x1=1, x2=2.
+    void BFGridMap::gmcpoly2Weights(double x, double w[3]) {
+        w[0] = 0.5 * (x - 1.) * (x - 2.);
+        w[1] = -x * (x - 2.);
+        w[2] = 0.5 * x * (x - 1.);
+    }
+
+    void BFGridMap::gmcpoly2Derivatives(double x, double d[3]) {
+        d[0] = x - 1.5;
+        d[1] = 2. - 2. * x;
+        d[2] = x - 0.5;
+    }
 
-        return f1d[0] * (x - x1) * (x - x2) / ((x0 - x1) * (x0 - x2)) +
-               f1d[1] * (x - x0) * (x - x2) / ((x1 - x0) * (x1 - x2)) +
-               f1d[2] * (x - x0) * (x - x1) / ((x2 - x0) * (x2 - x1));
+    // The field is even in y for Bx and Bz and odd for By, so the derivatives
+    // change sign when exactly one of the component and the direction is y.
+    void BFGridMap::flipGrad(CLHEP::Hep3Vector grad[3]) {
+        grad[0].setY(-grad[0].y());
+        grad[1].setX(-grad[1].x());
+        grad[1].setZ(-grad[1].z());
+        grad[2].setY(-grad[2].y());
     }
 
     bool BFGridMap::getBFieldWithStatus(const CLHEP::Hep3Vector& testpoint,
@@ -166,7 +263,32 @@ namespace mu2e {
                 << "Unrecognized option for interpolation into the BField: " << _interpStyle
                 << "\n";
         }
-        result *= _scaleFactor;
+        result *= _fieldSign * _scaleFactor;
+        return retval;
+    }
+
+    bool BFGridMap::getBFieldAndGradWithStatus(const CLHEP::Hep3Vector& point,
+                                               CLHEP::Hep3Vector& field,
+                                               CLHEP::Hep3Vector grad[3]) const {
+        for (int j = 0; j != 3; ++j)
+            grad[j] = CLHEP::Hep3Vector(0., 0., 0.);
+
+        bool retval(false);
+        if (_interpStyle == BFInterpolationStyle::trilinear) {
+            retval = interpolateTriLinear(point, field, grad);
+
+        } else if (_interpStyle == BFInterpolationStyle::meco) {
+            retval = interpolateQuadratic(point, field, grad);
+
+        } else {
+            throw cet::exception("GEOM")
+                << "Unrecognized option for interpolation into the BField: " << _interpStyle
+                << "\n";
+        }
+        const double scale = _fieldSign * _scaleFactor;
+        field *= scale;
+        for (int j = 0; j != 3; ++j)
+            grad[j] *= scale;
         return retval;
     }
 
@@ -176,7 +298,8 @@ namespace mu2e {
     // its precise definition.  The field value at the test point is the weighted sum of
     // each of the 8 corner points.
     bool BFGridMap::interpolateTriLinear(const CLHEP::Hep3Vector& p,
-                                         CLHEP::Hep3Vector& result) const {
+                                         CLHEP::Hep3Vector& result,
+                                         CLHEP::Hep3Vector* grad) const {
         double px = p.x();
         double py = p.y();
         if (_flipy)
@@ -199,36 +322,64 @@ namespace mu2e {
             return false;
         }
 
+        // A point on the upper face of the map belongs to the last cell, with weight 1
+        // on its upper corners.  Along a dimension with a single grid point both corners
+        // are that point.
+        i = std::max(0, std::min(i, int(_nx) - 2));
+        j = std::max(0, std::min(j, int(_ny) - 2));
+        k = std::max(0, std::min(k, int(_nz) - 2));
+
         // Trilinear fractional weighting factors.
         double fx = 1.0 - (px - _xmin - i * _dx) / _dx;
         double fy = 1.0 - (py - _ymin - j * _dy) / _dy;
         double fz = 1.0 - (pz - _zmin - k * _dz) / _dz;
 
-        // Field values at the 8 corner points.
-        // Guess that a copy is faster than a pointer for reasons of locality
-        // of reference in the downstream code?
-        CLHEP::Hep3Vector c[8] = {_field(i, j, k),         _field(i + 1, j, k),
-                                  _field(i, j + 1, k),     _field(i + 1, j + 1, k),
-                                  _field(i, j, k + 1),     _field(i + 1, j, k + 1),
-                                  _field(i, j + 1, k + 1), _field(i + 1, j + 1, k + 1)};
-
-        double bx = c[0].x() * fx * fy * fz + c[1].x() * (1.0 - fx) * fy * fz +
-                    c[2].x() * fx * (1.0 - fy) * fz + c[3].x() * (1.0 - fx) * (1.0 - fy) * fz +
-                    c[4].x() * fx * fy * (1.0 - fz) + c[5].x() * (1.0 - fx) * fy * (1.0 - fz) +
-                    c[6].x() * fx * (1.0 - fy) * (1.0 - fz) +
-                    c[7].x() * (1.0 - fx) * (1.0 - fy) * (1.0 - fz);
-
-        double by = c[0].y() * fx * fy * fz + c[1].y() * (1.0 - fx) * fy * fz +
-                    c[2].y() * fx * (1.0 - fy) * fz + c[3].y() * (1.0 - fx) * (1.0 - fy) * fz +
-                    c[4].y() * fx * fy * (1.0 - fz) + c[5].y() * (1.0 - fx) * fy * (1.0 - fz) +
-                    c[6].y() * fx * (1.0 - fy) * (1.0 - fz) +
-                    c[7].y() * (1.0 - fx) * (1.0 - fy) * (1.0 - fz);
-
-        double bz = c[0].z() * fx * fy * fz + c[1].z() * (1.0 - fx) * fy * fz +
-                    c[2].z() * fx * (1.0 - fy) * fz + c[3].z() * (1.0 - fx) * (1.0 - fy) * fz +
-                    c[4].z() * fx * fy * (1.0 - fz) + c[5].z() * (1.0 - fx) * fy * (1.0 - fz) +
-                    c[6].z() * fx * (1.0 - fy) * (1.0 - fz) +
-                    c[7].z() * (1.0 - fx) * (1.0 - fy) * (1.0 - fz);
+        // Weights of the 8 corner points, ordered as (x,y,z) = 000, 100, 010, 110, 001, ...
+        const double w[8] = {fx * fy * fz,
+                             (1.0 - fx) * fy * fz,
+                             fx * (1.0 - fy) * fz,
+                             (1.0 - fx) * (1.0 - fy) * fz,
+                             fx * fy * (1.0 - fz),
+                             (1.0 - fx) * fy * (1.0 - fz),
+                             fx * (1.0 - fy) * (1.0 - fz),
+                             (1.0 - fx) * (1.0 - fy) * (1.0 - fz)};
+
+        // Offsets of the 8 corner points in the packed arrays.
+        const std::size_t sx = (_nx > 1) ? std::size_t(_ny) * _nz : 0;
+        const std::size_t sy = (_ny > 1) ? _nz : 0;
+        const std::size_t sz = (_nz > 1) ? 1 : 0;
+        const std::size_t base = index(i, j, k);
+        const std::size_t off[8] = {0, sx, sy, sx + sy, sz, sx + sz, sy + sz, sx + sy + sz};
+
+        double bx(0.), by(0.), bz(0.);
+        for (int c = 0; c != 8; ++c) {
+            bx += w[c] * _bx[base + off[c]];
+            by += w[c] * _by[base + off[c]];
+            bz += w[c] * _bz[base + off[c]];
+        }
+
+        // The gradient: each weight is a product of one factor per axis, f or 1-f,
+        // whose derivatives are -1/d and 1/d.
+        if (grad) {
+            const double ax[2] = {fx, 1.0 - fx}, ay[2] = {fy, 1.0 - fy}, az[2] = {fz, 1.0 - fz};
+            const double dax[2] = {-1.0 / _dx, 1.0 / _dx}, day[2] = {-1.0 / _dy, 1.0 / _dy},
+                         daz[2] = {-1.0 / _dz, 1.0 / _dz};
+            double g[3][3] = {{0., 0., 0.}, {0., 0., 0.}, {0., 0., 0.}};
+            for (int c = 0; c != 8; ++c) {
+                const int cx = c & 1, cy = (c >> 1) & 1, cz = (c >> 2) & 1;
+                const double wg[3] = {dax[cx] * ay[cy] * az[cz], ax[cx] * day[cy] * az[cz],
+                                      ax[cx] * ay[cy] * daz[cz]};
+                for (int d = 0; d != 3; ++d) {
+                    g[d][0] += wg[d] * _bx[base + off[c]];
+                    g[d][1] += wg[d] * _by[base + off[c]];
+                    g[d][2] += wg[d] * _bz[base + off[c]];
+                }
+            }
+            for (int d = 0; d != 3; ++d)
+                grad[d] = CLHEP::Hep3Vector(g[d][0], g[d][1], g[d][2]);
+            if (_flipy && p.y() < 0)
+                flipGrad(grad);
+        }
 
         // Need the signed value of p.y() here - the variable py will not do.
         if (_flipy && p.y() < 0)
@@ -241,7 +392,8 @@ namespace mu2e {
 
     // Function to return the BField for any point
     bool BFGridMap::interpolateQuadratic(const CLHEP::Hep3Vector& testpoint,
-                                         CLHEP::Hep3Vector& result) const {
+                                         CLHEP::Hep3Vector& result,
+                                         CLHEP::Hep3Vector* grad) const {
         result = CLHEP::Hep3Vector(0., 0., 0.);
 
         static const bool dflag = false;
@@ -319,12 +471,12 @@ namespace mu2e {
             cout << "Nearest Point:   " << grid2point(ix, iy, iz) << endl
                  << "Indices set to:  " << setw(4) << ix << " " << setw(4) << iy << " " << setw(4)
                  << iz << endl
-                 << "Field:              " << _field(ix, iy, iz) << endl;
+                 << "Field:              " << fieldAt(ix, iy, iz) << endl;
         }
 
         // check if the point had a field defined
 
-        if (!_isDefined(ix, iy, iz)) {
+        if (!isDefined(ix, iy, iz)) {
             if (_warnIfOutside) {
                 mf::LogWarning("GEOM")
                     << "Point's field is not defined in the map: " << _key << "\n"
@@ -334,9 +486,8 @@ namespace mu2e {
             return false;
         }
 
-        // Get the BField values of the nearest grid neighbors to the point
-        CLHEP::Hep3Vector neighborsBF[3][3][3];
-        if (!getNeighbors(ix, iy, iz, neighborsBF)) {
+        // Check that the BField is defined at the nearest grid neighbors to the point
+        if (!neighborsDefined(ix - 1, iy - 1, iz - 1)) {
             if (_warnIfOutside) {
                 mf::LogWarning("GEOM")
                     << "Point's neighboring field is not defined in the map: " << _key << "\n"
@@ -367,7 +518,11 @@ namespace mu2e {
         CLHEP::Hep3Vector frac(cellFraction(point, GridPoint(xindex, yindex, zindex)));
 
         // Run the interpolator
-        result = interpolate(neighborsBF, frac);
+        if (grad) {
+            result = interpolate(xindex, yindex, zindex, frac, grad);
+        } else {
+            result = interpolate(xindex, yindex, zindex, frac);
+        }
         if (dflag) {
             cout << "Interpolated Field: " << result << endl;
         }
@@ -375,6 +530,9 @@ namespace mu2e {
         // Reassign y sign
         if (_flipy && sign == -1) {
             result.setY(-result.y());
+            if (grad) {
+                flipGrad(grad);
+            }
         }
         return true;
     }
@@ -428,7 +586,7 @@ namespace mu2e {
 
         // check if the point had a field defined
 
-        if (!_isDefined(ix, iy, iz)) {
+        if (!isDefined(ix, iy, iz)) {
             if (_warnIfOutside) {
                 mf::LogWarning("GEOM")
                     << "Point's field is not defined in the map: " << _key << "\n"
@@ -446,7 +604,7 @@ namespace mu2e {
                 unsigned int yindex = iy + j - 1;
                 for (int k = 0; k != 3; ++k) {
                     unsigned int zindex = iz + k - 1;
-                    if (!_isDefined(xindex, yindex, zindex)) {
+                    if (!isDefined(xindex, yindex, zindex)) {
                         if (_warnIfOutside) {
                             mf::LogWarning("GEOM")
                                 << "Point's neighboring field is not defined in the map: " << _key
@@ -457,7 +615,7 @@ namespace mu2e {
                         }
                         return false;
                     }
-                    neighborBF[i][j][k] = _field(xindex, yindex, zindex);
+                    neighborBF[i][j][k] = fieldAt(xindex, yindex, zindex);
                     // Reassign y sign
                     if (_flipy && sign == -1) {
                         neighborBF[i][j][k].setY(-neighborBF[i][j][k].y());
@@ -487,11 +645,12 @@ namespace mu2e {
              << endl;
         cout << "Distance:       " << _dx << " " << _dy << " " << _dz << endl;
 
-        cout << "Field at the edges: " << _field(0, 0, 0) << ", " << _field(_nx - 1, 0, 0) << ", "
-             << _field(0, _ny - 1, 0) << ", " << _field(0, 0, _nz - 1) << ", "
-             << _field(_nx - 1, _ny - 1, 0) << ", " << _field(_nx - 1, _ny - 1, _nz - 1) << endl;
+        cout << "Field at the edges: " << fieldAt(0, 0, 0) << ", " << fieldAt(_nx - 1, 0, 0) << ", "
+             << fieldAt(0, _ny - 1, 0) << ", " << fieldAt(0, 0, _nz - 1) << ", "
+             << fieldAt(_nx - 1, _ny - 1, 0) << ", " << fieldAt(_nx - 1, _ny - 1, _nz - 1)
+             << endl;
 
-        cout << "Field in the middle: " << _field(_nx / 2, _ny / 2, _nz / 2) << endl;
+        cout << "Field in the middle: " << fieldAt(_nx / 2, _ny / 2, _nz / 2) << endl;
 
         if (_warnIfOutside) {
             cout << "Will warn if outside of the valid region." << endl;
@@ -0,0 +1,232 @@
+//
+// Read and write the memory-mappable binary format for grid field maps.
+//
+
+// Includes from C++
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Includes from C ( needed for block IO ).
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+// Framework includes
+#include "cetlib_except/exception.h"
+
+// Mu2e includes
+#include "BFieldGeom/inc/BFMapFile.hh"
+
+namespace mu2e {
+
+    namespace {
+        const char magicValue[8] = {'M', 'U', '2', 'E', 'B', 'F', 'M', '\0'};
+
+        // Write nbytes, retrying on partial writes.
+        void writeAll(int fd, const void* data, std::size_t nbytes, const std::string& filename) {
+            const char* p = static_cast<const char*>(data);
+            while (nbytes > 0) {
+                ssize_t s = write(fd, p, nbytes);
+                if (s == -1) {
+                    int errsave = errno;
+                    if (errsave == EINTR)
+                        continue;
+                    throw cet::exception("GEOM")
+                        << "writeBFMapFile: Error writing " << filename << "  errno: " << errsave
+                        << " " << strerror(errsave) << "\n";
+                }
+                p += s;
+                nbytes -= s;
+            }
+        }
+    }  // namespace
+
+    uint64_t bfmapChecksum(const void* data, std::size_t nbytes, uint64_t hash) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i != nbytes; ++i) {
+            hash ^= p[i];
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    void BFMapFileHeader::init(const std::string& mapKey) {
+        std::memcpy(magic, magicValue, sizeof(magic));
+        endianMarker = endianMarkerValue;
+        version = currentVersion;
+        headerSize = sizeof(BFMapFileHeader);
+        payloadOffset = alignment;
+        payloadSize = 3 * sizeof(double) * nPoints() + (allDefined() ? 0 : nPoints());
+        std::memset(key, 0, keySize);
+        std::strncpy(key, mapKey.c_str(), keySize - 1);
+    }
+
+    uint64_t BFMapFileHeader::computeHeaderChecksum() const {
+        return bfmapChecksum(this, offsetof(BFMapFileHeader, headerChecksum));
+    }
+
+    void writeBFMapFile(const std::string& filename,
+                        BFMapFileHeader header,
+                        const double* bx,
+                        const double* by,
+                        const double* bz,
+                        const unsigned char* defined) {
+        header.init(header.key);
+        const std::size_t n = header.nPoints();
+
+        header.payloadChecksum = bfmapChecksum(bx, n * sizeof(double));
+        header.payloadChecksum = bfmapChecksum(by, n * sizeof(double), header.payloadChecksum);
+        header.payloadChecksum = bfmapChecksum(bz, n * sizeof(double), header.payloadChecksum);
+        if (!header.allDefined()) {
+            header.payloadChecksum = bfmapChecksum(defined, n, header.payloadChecksum);
+        }
+        header.headerChecksum = header.computeHeaderChecksum();
+
+        // Write to a uniquely named file in the same directory, then link it to the final
+        // name; link() fails if the file exists, so an existing map is never overwritten
+        // (as in writeG4BLBinary) and other processes never see a partially written map.
+        std::string tmpname = filename + ".XXXXXX";
+        int fd = mkstemp(&tmpname[0]);
+        if (fd < 0) {
+            int errsave = errno;
+            throw cet::exception("GEOM") << "writeBFMapFile: Error creating a temporary file for "
+                                         << filename << "  errno: " << errsave << " "
+                                         << strerror(errsave) << "\n";
+        }
+
+        try {
+            if (fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) != 0) {
+                int errsave = errno;
+                throw cet::exception("GEOM") << "writeBFMapFile: Error doing fchmod() on "
+                                             << tmpname << "  errno: " << errsave << " "
+                                             << strerror(errsave) << "\n";
+            }
+
+            std::vector<char> padding(header.payloadOffset - sizeof(BFMapFileHeader), 0);
+            writeAll(fd, &header, sizeof(BFMapFileHeader), tmpname);
+            writeAll(fd, padding.data(), padding.size(), tmpname);
+            writeAll(fd, bx, n * sizeof(double), tmpname);
+            writeAll(fd, by, n * sizeof(double), tmpname);
+            writeAll(fd, bz, n * sizeof(double), tmpname);
+            if (!header.allDefined()) {
+                writeAll(fd, defined, n, tmpname);
+            }
+        } catch (...) {
+            close(fd);
+            unlink(tmpname.c_str());
+            throw;
+        }
+
+        // Errors of delayed writes may only be reported by close().
+        if (close(fd) != 0) {
+            int errsave = errno;
+            unlink(tmpname.c_str());
+            throw cet::exception("GEOM") << "writeBFMapFile: Error closing " << tmpname
+                                         << "  errno: " << errsave << " " << strerror(errsave)
+                                         << "\n";
+        }
+
+        if (link(tmpname.c_str(), filename.c_str()) != 0) {
+            int errsave = errno;
+            unlink(tmpname.c_str());
+            if (errsave == EEXIST) {
+                throw cet::exception("GEOM")
+                    << "writeBFMapFile: Error opening " << filename << "  File already exists.\n";
+            }
+            throw cet::exception("GEOM") << "writeBFMapFile: Error linking " << tmpname << " to "
+                                         << filename << "  errno: " << errsave << " "
+                                         << strerror(errsave) << "\n";
+        }
+        unlink(tmpname.c_str());
+    }
+
+    BFMapFile::BFMapFile(const std::string& filename)
+        : _filename(filename), _addr(MAP_FAILED), _size(0), _header(nullptr), _bx(nullptr) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            int errsave = errno;
+            throw cet::exception("GEOM") << "BFMapFile: Error opening " << filename
+                                         << "  errno: " << errsave << " " << strerror(errsave)
+                                         << "\n";
+        }
+
+        struct stat info;
+        if (fstat(fd, &info)) {
+            int errsave = errno;
+            close(fd);
+            throw cet::exception("GEOM") << "BFMapFile: Error doing fstat() on " << filename
+                                         << "  errno: " << errsave << " " << strerror(errsave)
+                                         << "\n";
+        }
+        _size = info.st_size;
+        if (_size < sizeof(BFMapFileHeader)) {
+            close(fd);
+            throw cet::exception("GEOM")
+                << "BFMapFile: " << filename << " is too short to be a field map: " << _size
+                << " bytes\n";
+        }
+
+        // The mapping stays valid after the file descriptor is closed.
+        _addr = mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+        int errsave = errno;
+        close(fd);
+        if (_addr == MAP_FAILED) {
+            throw cet::exception("GEOM") << "BFMapFile: Error doing mmap() on " << filename
+                                         << "  errno: " << errsave << " " << strerror(errsave)
+                                         << "\n";
+        }
+
+        _header = static_cast<const BFMapFileHeader*>(_addr);
+        const BFMapFileHeader& h = *_header;
+
+        std::string problem;
+        if (std::memcmp(h.magic, magicValue, sizeof(magicValue)) != 0) {
+            problem = "not a Mu2e binary field map";
+        } else if (h.endianMarker != BFMapFileHeader::endianMarkerValue) {
+            problem = "endian mismatch";
+        } else if (h.version != BFMapFileHeader::currentVersion) {
+            problem = "unsupported version " + std::to_string(h.version);
+        } else if (h.headerSize != sizeof(BFMapFileHeader)) {
+            problem = "unexpected header size";
+        } else if (h.headerChecksum != h.computeHeaderChecksum()) {
+            problem = "header checksum mismatch";
+        } else if (h.payloadOffset % sizeof(double) != 0 ||
+                   h.payloadOffset + h.payloadSize != _size ||
+                   h.payloadSize !=
+                       3 * sizeof(double) * h.nPoints() + (h.allDefined() ? 0 : h.nPoints())) {
+            problem = "file size does not match the grid dimensions";
+        }
+        if (!problem.empty()) {
+            munmap(_addr, _size);
+            _addr = MAP_FAILED;
+            throw cet::exception("GEOM") << "BFMapFile: " << filename << ": " << problem << "\n";
+        }
+
+        _bx = reinterpret_cast<const double*>(static_cast<const char*>(_addr) + h.payloadOffset);
+    }
+
+    BFMapFile::~BFMapFile() {
+        if (_addr != MAP_FAILED) {
+            munmap(_addr, _size);
+        }
+    }
+
+    const unsigned char* BFMapFile::defined() const {
+        if (_header->allDefined())
+            return nullptr;
+        return reinterpret_cast<const unsigned char*>(_bx + 3 * _header->nPoints());
+    }
+
+    bool BFMapFile::verifyPayload() const {
+        const char* payload = static_cast<const char*>(_addr) + _header->payloadOffset;
+        return bfmapChecksum(payload, _header->payloadSize) == _header->payloadChecksum;
+    }
+
+}  // namespace mu2e
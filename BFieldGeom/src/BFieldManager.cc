@@ -42,6 +42,20 @@ namespace mu2e {
     }
 
 
+    // Get field and gradient at an arbitrary point, from one lookup in the map.
+    bool BFieldManager::getBFieldAndGradWithStatus(const CLHEP::Hep3Vector& point,
+                                                   CLHEP::Hep3Vector& field,
+                                                   CLHEP::Hep3Vector grad[3]) const {
+        auto m = cm_.findMap(point);
+
+        if (m) {
+            return m->getBFieldAndGradWithStatus(point, field, grad);
+        }
+        field = grad[0] = grad[1] = grad[2] = CLHEP::Hep3Vector(0., 0., 0.);
+        return false;
+    }
+
+
     std::shared_ptr<BFGridMap> BFieldManager::addBFGridMap(MapContainerType* mapContainer,
                                                            const std::string& key,
                                                            int nx,
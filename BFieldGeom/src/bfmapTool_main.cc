@@ -0,0 +1,61 @@
+//
+// Inspect memory-mappable magnetic field map files (.bfmap).
+//
+//   bfmapTool info   file.bfmap [file.bfmap ...]   print the header
+//   bfmapTool verify file.bfmap [file.bfmap ...]   also check the payload checksum
+//
+// To convert existing maps to this format, run BFieldGeom/test/makeMappedMaps.fcl.
+//
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cetlib_except/exception.h"
+
+#include "BFieldGeom/inc/BFMapFile.hh"
+
+int main(int argc, char** argv) {
+    std::vector<std::string> words;
+    for (size_t i = 1; i < size_t(argc); ++i) {
+        words.emplace_back(argv[i]);
+    }
+
+    if (words.size() < 2 || (words[0] != "info" && words[0] != "verify")) {
+        std::cout << "Usage: bfmapTool info|verify file.bfmap [file.bfmap ...]" << std::endl;
+        return 1;
+    }
+    const bool verify = (words[0] == "verify");
+
+    int rc = 0;
+    for (size_t i = 1; i < words.size(); ++i) {
+        try {
+            mu2e::BFMapFile file(words[i]);
+            const mu2e::BFMapFileHeader& h = file.header();
+
+            std::cout << words[i] << "\n"
+                      << "  key:        " << h.key << "\n"
+                      << "  version:    " << h.version << "\n"
+                      << "  grid:       " << h.nx << " x " << h.ny << " x " << h.nz << "\n"
+                      << "  min:        " << h.xmin << " " << h.ymin << " " << h.zmin << "\n"
+                      << "  spacing:    " << h.dx << " " << h.dy << " " << h.dz << "\n"
+                      << "  flipY:      " << h.flipY() << "\n"
+                      << "  allDefined: " << h.allDefined() << "\n"
+                      << "  checksum:   " << std::hex << h.payloadChecksum << std::dec
+                      << std::endl;
+
+            if (verify) {
+                bool ok = file.verifyPayload();
+                std::cout << "  payload:    " << (ok ? "OK" : "CHECKSUM MISMATCH") << std::endl;
+                if (!ok)
+                    rc = 2;
+            }
+        } catch (cet::exception& e) {
+            std::cout << e.what() << std::endl;
+            rc = 2;
+        }
+    }
+
+    return rc;
+}
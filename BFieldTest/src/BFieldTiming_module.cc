@@ -0,0 +1,373 @@
+// Micro-benchmark of the magnetic field lookup.
+//
+// For each requested map, draw points uniformly within the volume of the map and
+// time the field lookup using:
+//  0) for grid maps, a copy of the field lookup as it was before the structure of
+//     arrays layout: Container3D of Hep3Vectors, corner/neighbor copies and, for
+//     the quadratic interpolation, three passes of 1D interpolation
+//  1) one call to BFMap::getBFieldWithStatus per point
+//  2) one call to BFieldManager::getBField per point (includes the map search)
+// and check that all methods give the same field.
+//
+// If nThreads is given, 2) is then run by that many threads at once, all sharing
+// the BFieldManager, to show how the lookup scales; every thread must find the
+// same field as 2).
+//
+// Method 0) runs in the same process, on the same points, so it gives the reference
+// timing for 1); its field must agree with 1) to rounding.
+//
+// The work is done in the beginRun member function.
+// The magnetic field map may depend on run number so it is
+// not available at c'to time or beginJob time.
+//
+
+#include "BFieldGeom/inc/BFGridMap.hh"
+#include "BFieldGeom/inc/BFieldManager.hh"
+#include "BFieldGeom/inc/Container3D.hh"
+#include "GeometryService/inc/GeomHandle.hh"
+#include "SeedService/inc/SeedService.hh"
+
+#include "art/Framework/Core/EDAnalyzer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Run.h"
+
+#include "CLHEP/Random/RandFlat.h"
+#include "CLHEP/Vector/ThreeVector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    // Find the named map.
+    mu2e::BFMap const& getMap(mu2e::BFieldManager const& bfmgr, std::string const& mapName) {
+        for (auto const& map : bfmgr.getInnerMaps()) {
+            if (map->getKey() == mapName) {
+                return *map;
+            }
+        }
+        for (auto const& map : bfmgr.getOuterMaps()) {
+            if (map->getKey() == mapName) {
+                return *map;
+            }
+        }
+        throw cet::exception("GEOM")
+            << "BFieldTiming: cannot find the map named: " << mapName << "\n";
+    }
+
+    // The grid map lookup before the structure of arrays layout, kept as the reference
+    // for the timing.  The field values are copied from the map.  Unlike the old code,
+    // the trilinear interpolation uses the last cell for points on the upper face of the
+    // map instead of reading past the end of the grid.
+    class ReferenceGridMap {
+       public:
+        explicit ReferenceGridMap(mu2e::BFGridMap const& map)
+            : map_(map),
+              nx_(map.nx()),
+              ny_(map.ny()),
+              nz_(map.nz()),
+              field_(nx_, ny_, nz_),
+              isDefined_(nx_, ny_, nz_, false) {
+            for (int ix = 0; ix < nx_; ++ix) {
+                for (int iy = 0; iy < ny_; ++iy) {
+                    for (int iz = 0; iz < nz_; ++iz) {
+                        field_.set(ix, iy, iz, map.fieldAt(ix, iy, iz));
+                        isDefined_.set(ix, iy, iz, map.isDefined(ix, iy, iz));
+                    }
+                }
+            }
+        }
+
+        bool getBFieldWithStatus(CLHEP::Hep3Vector const& p, CLHEP::Hep3Vector& b) const {
+            bool ok = (map_.interpolationStyle() == mu2e::BFInterpolationStyle::trilinear)
+                          ? triLinear(p, b)
+                          : quadratic(p, b);
+            b *= map_.scaleFactor();
+            return ok;
+        }
+
+       private:
+        mu2e::BFGridMap const& map_;
+        int nx_, ny_, nz_;
+        mu2e::Container3D<CLHEP::Hep3Vector> field_;
+        mu2e::Container3D<bool> isDefined_;
+
+        bool triLinear(CLHEP::Hep3Vector const& p, CLHEP::Hep3Vector& result) const {
+            double px = p.x();
+            double py = map_.flipy() ? std::abs(p.y()) : p.y();
+            double pz = p.z();
+
+            int i = floor((px - map_.xmin()) / map_.dx());
+            int j = floor((py - map_.ymin()) / map_.dy());
+            int k = floor((pz - map_.zmin()) / map_.dz());
+            if (i < 0 || i >= nx_ || j < 0 || j >= ny_ || k < 0 || k >= nz_) {
+                result = CLHEP::Hep3Vector(0., 0., 0.);
+                return false;
+            }
+            i = std::max(0, std::min(i, nx_ - 2));
+            j = std::max(0, std::min(j, ny_ - 2));
+            k = std::max(0, std::min(k, nz_ - 2));
+            const int i1 = std::min(i + 1, nx_ - 1), j1 = std::min(j + 1, ny_ - 1),
+                      k1 = std::min(k + 1, nz_ - 1);
+
+            double fx = 1.0 - (px - map_.xmin() - i * map_.dx()) / map_.dx();
+            double fy = 1.0 - (py - map_.ymin() - j * map_.dy()) / map_.dy();
+            double fz = 1.0 - (pz - map_.zmin() - k * map_.dz()) / map_.dz();
+
+            CLHEP::Hep3Vector c[8] = {field_(i, j, k),    field_(i1, j, k),   field_(i, j1, k),
+                                      field_(i1, j1, k),  field_(i, j, k1),   field_(i1, j, k1),
+                                      field_(i, j1, k1),  field_(i1, j1, k1)};
+
+            result = c[0] * (fx * fy * fz) + c[1] * ((1.0 - fx) * fy * fz) +
+                     c[2] * (fx * (1.0 - fy) * fz) + c[3] * ((1.0 - fx) * (1.0 - fy) * fz) +
+                     c[4] * (fx * fy * (1.0 - fz)) + c[5] * ((1.0 - fx) * fy * (1.0 - fz)) +
+                     c[6] * (fx * (1.0 - fy) * (1.0 - fz)) +
+                     c[7] * ((1.0 - fx) * (1.0 - fy) * (1.0 - fz));
+            if (map_.flipy() && p.y() < 0)
+                result.setY(-result.y());
+            return true;
+        }
+
+        static double poly2(double const f[3], double x) {
+            return f[0] * (x - 1.) * (x - 2.) / 2. - f[1] * x * (x - 2.) + f[2] * x * (x - 1.) / 2.;
+        }
+
+        bool quadratic(CLHEP::Hep3Vector const& testpoint, CLHEP::Hep3Vector& result) const {
+            result = CLHEP::Hep3Vector(0., 0., 0.);
+            CLHEP::Hep3Vector point(testpoint);
+            const bool flip = map_.flipy() && testpoint.y() < 0;
+            if (flip)
+                point.setY(-testpoint.y());
+            if (!map_.isValid(point))
+                return false;
+
+            int ix = static_cast<int>((point.x() - map_.xmin()) / map_.dx() + 0.5);
+            int iy = static_cast<int>((point.y() - map_.ymin()) / map_.dy() + 0.5);
+            int iz = static_cast<int>((point.z() - map_.zmin()) / map_.dz() + 0.5);
+            ix = std::max(1, std::min(ix, nx_ - 2));
+            iy = std::max(1, std::min(iy, ny_ - 2));
+            iz = std::max(1, std::min(iz, nz_ - 2));
+
+            CLHEP::Hep3Vector vec[3][3][3];
+            for (int i = 0; i != 3; ++i) {
+                for (int j = 0; j != 3; ++j) {
+                    for (int k = 0; k != 3; ++k) {
+                        if (!isDefined_(ix + i - 1, iy + j - 1, iz + k - 1))
+                            return false;
+                        vec[i][j][k] = field_(ix + i - 1, iy + j - 1, iz + k - 1);
+                    }
+                }
+            }
+
+            const double xin = (point.x() - map_.xmin()) / map_.dx() - (ix - 1);
+            const double yin = (point.y() - map_.ymin()) / map_.dy() - (iy - 1);
+            const double zin = (point.z() - map_.zmin()) / map_.dz() - (iz - 1);
+
+            double x1d[3], y1d[3], z1d[3];
+            CLHEP::Hep3Vector vecx[9], vecxy[3];
+            for (int j = 0; j != 3; ++j) {
+                for (int k = 0; k != 3; ++k) {
+                    for (int i = 0; i != 3; ++i) {
+                        x1d[i] = vec[i][j][k].x();
+                        y1d[i] = vec[i][j][k].y();
+                        z1d[i] = vec[i][j][k].z();
+                    }
+                    vecx[j * 3 + k] =
+                        CLHEP::Hep3Vector(poly2(x1d, xin), poly2(y1d, xin), poly2(z1d, xin));
+                }
+            }
+            for (int k = 0; k != 3; ++k) {
+                for (int j = 0; j != 3; ++j) {
+                    x1d[j] = vecx[j * 3 + k].x();
+                    y1d[j] = vecx[j * 3 + k].y();
+                    z1d[j] = vecx[j * 3 + k].z();
+                }
+                vecxy[k] = CLHEP::Hep3Vector(poly2(x1d, yin), poly2(y1d, yin), poly2(z1d, yin));
+            }
+            for (int k = 0; k != 3; ++k) {
+                x1d[k] = vecxy[k].x();
+                y1d[k] = vecxy[k].y();
+                z1d[k] = vecxy[k].z();
+            }
+            result = CLHEP::Hep3Vector(poly2(x1d, zin), poly2(y1d, zin), poly2(z1d, zin));
+            if (flip)
+                result.setY(-result.y());
+            return true;
+        }
+    };
+
+    // Largest absolute difference of any field component.
+    double maxDiff(std::vector<CLHEP::Hep3Vector> const& a,
+                   std::vector<CLHEP::Hep3Vector> const& b) {
+        double d(0.);
+        for (std::size_t i = 0; i != a.size(); ++i) {
+            d = std::max(d, (a[i] - b[i]).mag());
+        }
+        return d;
+    }
+
+    // Time, in ns per point, of nRepeat calls to f.
+    template <class F>
+    double timeIt(int nRepeat, std::size_t nPoints, F f) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < nRepeat; ++i) {
+            f();
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(t1 - t0).count() / nRepeat / nPoints;
+    }
+
+    // Time, in ns per point, of nThreads threads each looking up all points nRepeat times
+    // through the manager.  Fills the field found by each thread.
+    double timeThreads(int nThreads, int nRepeat, mu2e::BFieldManager const& bfmgr,
+                       std::vector<CLHEP::Hep3Vector> const& points,
+                       std::vector<std::vector<CLHEP::Hep3Vector>>& fields) {
+        fields.assign(nThreads, std::vector<CLHEP::Hep3Vector>(points.size()));
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int it = 0; it < nThreads; ++it) {
+            threads.emplace_back([&, it]() {
+                auto& b = fields[it];
+                for (int i = 0; i < nRepeat; ++i) {
+                    for (std::size_t j = 0; j != points.size(); ++j) {
+                        b[j] = bfmgr.getBField(points[j]);
+                    }
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(t1 - t0).count() / nRepeat /
+               points.size() / nThreads;
+    }
+
+}  // end anonymous namespace
+
+namespace mu2e {
+
+    class BFieldTiming : public art::EDAnalyzer {
+       public:
+        explicit BFieldTiming(const fhicl::ParameterSet& pset);
+
+        void beginRun(const art::Run& run) override;
+        void analyze(const art::Event&) override {}
+
+       private:
+        // Names of maps to time
+        std::vector<std::string> mapNames_;
+
+        // Number of test points to draw per map.
+        int nPoints_;
+
+        // Number of times each set of points is evaluated.
+        int nRepeat_;
+
+        // Numbers of threads for the multi-threaded lookup, none if empty.
+        std::vector<int> nThreads_;
+
+        // Uniform flat random distribution.
+        CLHEP::RandFlat flat_;
+
+        // Return a random point, distributed uniformly within the volume of the map;
+        CLHEP::Hep3Vector fire(mu2e::BFMap const& map);
+    };
+
+}  // namespace mu2e
+
+mu2e::BFieldTiming::BFieldTiming(const fhicl::ParameterSet& pset)
+    : art::EDAnalyzer(pset),
+      mapNames_(pset.get<std::vector<std::string>>("mapNames")),
+      nPoints_(pset.get<int>("nPoints")),
+      nRepeat_(pset.get<int>("nRepeat", 10)),
+      nThreads_(pset.get<std::vector<int>>("nThreads", std::vector<int>())),
+      flat_(createEngine(art::ServiceHandle<mu2e::SeedService>()->getSeed())) {}
+
+void mu2e::BFieldTiming::beginRun(const art::Run& run) {
+    GeomHandle<BFieldManager> bfmgr;
+
+    std::cout << "BFieldTiming: time per point in ns, " << nPoints_ << " points, " << nRepeat_
+              << " repetitions" << std::endl;
+    std::cout << std::setw(20) << "map" << std::setw(12) << "reference" << std::setw(12) << "map"
+              << std::setw(12) << "manager" << std::setw(14) << "max |dB| [T]" << std::setw(14)
+              << "ref |dB| [T]" << std::endl;
+
+    for (auto const& name : mapNames_) {
+        mu2e::BFMap const& map = getMap(*bfmgr, name);
+
+        std::vector<CLHEP::Hep3Vector> points;
+        points.reserve(nPoints_);
+        for (int i = 0; i < nPoints_; ++i) {
+            points.push_back(fire(map));
+        }
+
+        std::vector<CLHEP::Hep3Vector> b1(points.size()), b2(points.size());
+
+        double t1 = timeIt(nRepeat_, points.size(), [&]() {
+            for (std::size_t i = 0; i != points.size(); ++i) {
+                map.getBFieldWithStatus(points[i], b1[i]);
+            }
+        });
+        double t2 = timeIt(nRepeat_, points.size(), [&]() {
+            for (std::size_t i = 0; i != points.size(); ++i) {
+                b2[i] = bfmgr->getBField(points[i]);
+            }
+        });
+
+        // The reference lookup, for grid maps only.
+        double t0(0.), d0(0.);
+        if (auto gridMap = dynamic_cast<mu2e::BFGridMap const*>(&map)) {
+            ReferenceGridMap ref(*gridMap);
+            std::vector<CLHEP::Hep3Vector> b0(points.size());
+            t0 = timeIt(nRepeat_, points.size(), [&]() {
+                for (std::size_t i = 0; i != points.size(); ++i) {
+                    ref.getBFieldWithStatus(points[i], b0[i]);
+                }
+            });
+            d0 = maxDiff(b0, b1);
+        }
+
+        // Method 2 may pick a different map in regions where maps overlap.
+        double d = maxDiff(b1, b2);
+
+        std::cout << std::setw(20) << name << std::setw(12) << t0 << std::setw(12) << t1
+                  << std::setw(12) << t2 << std::setw(14) << d << std::setw(14) << d0
+                  << std::endl;
+
+        // Throughput of the manager lookup with all threads sharing the manager,
+        // relative to the first number of threads.
+        double tref(0.);
+        for (int n : nThreads_) {
+            std::vector<std::vector<CLHEP::Hep3Vector>> bt;
+            double t = timeThreads(n, nRepeat_, *bfmgr, points, bt);
+            if (tref == 0.) {
+                tref = t;
+            }
+            double dt(0.);
+            for (auto const& b : bt) {
+                dt = std::max(dt, maxDiff(b, b2));
+            }
+            std::cout << std::setw(20) << name << std::setw(4) << n << " threads: " << std::setw(10)
+                      << t << " ns/point, throughput x" << std::setw(6) << tref / t
+                      << ", max |dB| [T] " << dt << std::endl;
+        }
+    }
+}
+
+// Return a random point, uniformly distributed over the volume of the map.
+CLHEP::Hep3Vector mu2e::BFieldTiming::fire(mu2e::BFMap const& map) {
+    CLHEP::Hep3Vector val(flat_.fire(map.xmin(), map.xmax()), flat_.fire(map.ymin(), map.ymax()),
+                          flat_.fire(map.zmin(), map.zmax()));
+
+    return val;
+}
+
+DEFINE_ART_MODULE(mu2e::BFieldTiming);
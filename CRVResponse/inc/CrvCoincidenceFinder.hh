@@ -0,0 +1,84 @@
+#ifndef CrvCoincidenceFinder_h
+#define CrvCoincidenceFinder_h
+//
+// Coincidence search of CrvCoincidenceCheck for the hits of one sector type and side.
+// The hits of each layer are sorted by time (or by pulse start, if pulse overlaps are used),
+// and only hits within the time window of the hits already picked are combined, so the
+// cost grows with the number of hits close in time instead of the product of the layer
+// populations.  The coincidences are identical to the ones of the exhaustive search
+// (and in the same order), which is kept in FindCoincidencesExhaustive for comparisons.
+//
+// Original Author: Ralf Ehrlich
+
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace mu2eCrv
+{
+
+class CrvCoincidenceFinder
+{
+  public:
+  struct Hit
+  {
+    double _time;
+    double _timePulseStart, _timePulseEnd;
+    float  _PEs;
+    int    _layer, _counter;
+    double _x, _y;
+    int    _PEthreshold;
+    double _adjacentPulseTimeDifference;
+    double _maxTimeDifference;
+    bool   _useFourLayers;
+  };
+
+  CrvCoincidenceFinder(bool usePulseOverlaps, double minOverlapTime, double maxSlope, double maxSlopeDifference,
+                       bool acceptThreeAdjacentCounters);
+
+  //fills the coincidences as indices of hits (in the order in which the pulses are stored in the CrvCoincidence)
+  void FindCoincidences(const std::vector<Hit> &hits, std::vector<std::vector<size_t> > &coincidences);
+  void FindCoincidencesExhaustive(const std::vector<Hit> &hits, std::vector<std::vector<size_t> > &coincidences) const;
+
+  private:
+  enum TestResult {reject, accept, stop};  //stop: no other hit completes the current pair
+
+  bool       AboveThreshold(const std::vector<Hit> &hits, size_t iHit, const std::vector<size_t> &adjacentHits) const;
+  bool       FourLayerTest(const Hit &h0, const Hit &h1, const Hit &h2, const Hit &h3) const;
+  TestResult ThreeLayerTest(const Hit &h1, const Hit &h2, const Hit &h3) const;
+  bool       AdjacentCounterTest(const Hit &h1, const Hit &h2, const Hit &h3) const;
+
+  //the hits are sorted by pulse start, if the pulse overlap test is used, and by time otherwise.
+  //SortByKey returns the maximum pulse length of the sorted hits.
+  static double SortKey(const Hit &h, bool overlapTest) {return overlapTest?h._timePulseStart:h._time;}
+  static double SortByKey(const std::vector<Hit> &hits, const std::vector<size_t> &indices, bool overlapTest,
+                          std::vector<std::pair<double,size_t> > &sorted);
+  //range of positions in sorted with key in [lo,hi]
+  static std::pair<size_t,size_t> Window(const std::vector<std::pair<double,size_t> > &sorted, size_t begin, size_t end,
+                                         std::pair<double,double> keys);
+  //keys of the hits which can be combined with hits with times in [timeMin,timeMax] (maxDiff: maximum time difference),
+  //or with pulses overlapping [pulseStart,pulseEnd] (maxDiff: maximum pulse length of the candidate hits)
+  std::pair<double,double> KeyWindow(double timeMin, double timeMax, double maxDiff) const;
+  std::pair<double,double> OverlapKeyWindow(double pulseStart, double pulseEnd, double maxLength) const;
+
+  bool   _usePulseOverlaps;
+  double _minOverlapTime;
+  double _maxSlope;
+  double _maxSlopeDifference;
+  bool   _acceptThreeAdjacentCounters;
+
+  //scratch space, reused between calls
+  std::array<std::vector<size_t>,4>                       _layerHits;      //hits of each layer
+  std::array<std::vector<size_t>,4>                       _filteredHits;   //hits of each layer above the threshold
+  std::array<std::vector<std::pair<double,size_t> >,4>   _sortedHits;     //_layerHits or _filteredHits sorted by key
+  std::array<double,4>                                    _maxLength;      //maximum pulse length of _sortedHits
+  std::array<std::vector<double>,4>                       _minMaxTimeDifference[2];  //running minimum of _maxTimeDifference
+                                                                                     //of the filtered hits ([1]: excluding useFourLayers hits)
+  std::vector<size_t>                                     _candidates;
+  std::vector<std::array<size_t,4> >                      _combinations;
+};
+
+}
+
+#endif
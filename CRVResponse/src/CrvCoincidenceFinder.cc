@@ -0,0 +1,491 @@
+#include "CRVResponse/inc/CrvCoincidenceFinder.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <set>
+
+namespace
+{
+  //the time windows are widened by this amount, so that hits are never lost because of rounding;
+  //the exact tests are applied to all hits inside the windows
+  const double kMargin = 1e-6; //ns
+}
+
+namespace mu2eCrv
+{
+
+CrvCoincidenceFinder::CrvCoincidenceFinder(bool usePulseOverlaps, double minOverlapTime, double maxSlope, double maxSlopeDifference,
+                                           bool acceptThreeAdjacentCounters) :
+                                           _usePulseOverlaps(usePulseOverlaps), _minOverlapTime(minOverlapTime),
+                                           _maxSlope(maxSlope), _maxSlopeDifference(maxSlopeDifference),
+                                           _acceptThreeAdjacentCounters(acceptThreeAdjacentCounters)
+{}
+
+double CrvCoincidenceFinder::SortByKey(const std::vector<Hit> &hits, const std::vector<size_t> &indices, bool overlapTest,
+                                       std::vector<std::pair<double,size_t> > &sorted)
+{
+  double maxLength=0;
+  sorted.clear();
+  for(size_t i : indices)
+  {
+    sorted.emplace_back(SortKey(hits[i],overlapTest),i);
+    maxLength=std::max(maxLength,hits[i]._timePulseEnd-hits[i]._timePulseStart);
+  }
+  std::sort(sorted.begin(),sorted.end());
+  return maxLength;
+}
+
+std::pair<size_t,size_t> CrvCoincidenceFinder::Window(const std::vector<std::pair<double,size_t> > &sorted, size_t begin, size_t end,
+                                                      std::pair<double,double> keys)
+{
+  auto first=std::lower_bound(sorted.begin()+begin,sorted.begin()+end,keys.first,
+                              [](const std::pair<double,size_t> &a, double key){return a.first<key;});
+  auto last=std::upper_bound(first,sorted.begin()+end,keys.second,
+                             [](double key, const std::pair<double,size_t> &a){return key<a.first;});
+  return std::make_pair(first-sorted.begin(),last-sorted.begin());
+}
+
+std::pair<double,double> CrvCoincidenceFinder::KeyWindow(double timeMin, double timeMax, double maxDiff) const
+{
+  return std::make_pair(timeMax-maxDiff-kMargin,timeMin+maxDiff+kMargin);
+}
+
+std::pair<double,double> CrvCoincidenceFinder::OverlapKeyWindow(double pulseStart, double pulseEnd, double maxLength) const
+{
+  //a pulse [start,end] overlaps [pulseStart,pulseEnd] by at least minOverlapTime,
+  //if start<=pulseEnd-minOverlapTime and end>=pulseStart+minOverlapTime, where end<=start+maxLength
+  return std::make_pair(pulseStart+_minOverlapTime-maxLength-kMargin,pulseEnd-_minOverlapTime+kMargin);
+}
+
+//PE sum of the hit, the other SiPM of its counter, and one of the adjacent counters
+//(same as the original search, the hits are added in the order of the hit collection)
+bool CrvCoincidenceFinder::AboveThreshold(const std::vector<Hit> &hits, size_t iHit, const std::vector<size_t> &adjacentHits) const
+{
+  const Hit &hit=hits[iHit];
+  float PEs_thisCounter=hit._PEs;
+  float PEs_adjacentCounter1=0;
+  float PEs_adjacentCounter2=0;
+  for(size_t j : adjacentHits)
+  {
+    const Hit &hitAdjacent=hits[j];
+    if(!_usePulseOverlaps)
+    {
+      if(fabs(hitAdjacent._time-hit._time)>hit._adjacentPulseTimeDifference) continue;
+    }
+    else
+    {
+      double overlapTime=std::min(hitAdjacent._timePulseEnd,hit._timePulseEnd)-std::max(hitAdjacent._timePulseStart,hit._timePulseStart);
+      if(overlapTime<_minOverlapTime) continue; //no overlap or overlap time too short
+    }
+
+    int counterDiff=hitAdjacent._counter-hit._counter;
+    if(counterDiff==0) PEs_thisCounter+=hitAdjacent._PEs;
+    if(counterDiff==-1) PEs_adjacentCounter1+=hitAdjacent._PEs;
+    if(counterDiff==1) PEs_adjacentCounter2+=hitAdjacent._PEs;
+  }
+  if(PEs_thisCounter+PEs_adjacentCounter1>=hit._PEthreshold) return true;
+  if(PEs_thisCounter+PEs_adjacentCounter2>=hit._PEthreshold) return true;
+  return false;
+}
+
+bool CrvCoincidenceFinder::FourLayerTest(const Hit &h0, const Hit &h1, const Hit &h2, const Hit &h3) const
+{
+  if(!_usePulseOverlaps)
+  {
+    double maxTimeDifferences[4]={h0._maxTimeDifference,h1._maxTimeDifference,h2._maxTimeDifference,h3._maxTimeDifference};
+    double maxTimeDifference=*std::max_element(maxTimeDifferences,maxTimeDifferences+4);
+
+    double times[4]={h0._time,h1._time,h2._time,h3._time};
+    double timeMin = *std::min_element(times,times+4);
+    double timeMax = *std::max_element(times,times+4);
+    if(timeMax-timeMin>maxTimeDifference) return false;  //hits don't fall within the time window
+  }
+  else
+  {
+    double timesPulseStart[4]={h0._timePulseStart,h1._timePulseStart,h2._timePulseStart,h3._timePulseStart};
+    double timesPulseEnd[4]={h0._timePulseEnd,h1._timePulseEnd,h2._timePulseEnd,h3._timePulseEnd};
+    double timeMaxPulseStart = *std::max_element(timesPulseStart,timesPulseStart+4);
+    double timeMinPulseEnd = *std::min_element(timesPulseEnd,timesPulseEnd+4);
+    if(timeMinPulseEnd-timeMaxPulseStart<_minOverlapTime) return false;  //pulses don't overlap, or overlap time too short
+  }
+
+  double x[4]={h0._x,h1._x,h2._x,h3._x};
+  double y[4]={h0._y,h1._y,h2._y,h3._y};
+
+  bool coincidenceFound=true;
+  double slope[3];
+  for(int d=0; d<3; d++)
+  {
+    slope[d]=(x[d+1]-x[d])/(y[d+1]-y[d]);
+    if(fabs(slope[d])>_maxSlope) coincidenceFound=false;   //not more than maxSlope allowed for coincidence;
+  }
+
+  if(fabs(slope[0]-slope[1])>_maxSlopeDifference) coincidenceFound=false;   //slope must not change more than 2mm over 1mm (which is a little bit more than 1 counter per layer)
+  if(fabs(slope[0]-slope[2])>_maxSlopeDifference) coincidenceFound=false;
+  if(fabs(slope[1]-slope[2])>_maxSlopeDifference) coincidenceFound=false;
+
+  return coincidenceFound;
+}
+
+//note that the three layer and the adjacent counter searches use the time difference test
+//if pulse overlaps are requested, and the pulse overlap test otherwise
+CrvCoincidenceFinder::TestResult CrvCoincidenceFinder::ThreeLayerTest(const Hit &h1, const Hit &h2, const Hit &h3) const
+{
+  if(h1._useFourLayers && h2._useFourLayers && h3._useFourLayers) return reject; //all hits require a four layer coincidence
+
+  if(_usePulseOverlaps)
+  {
+    double maxTimeDifferences[3]={h1._maxTimeDifference,h2._maxTimeDifference,h3._maxTimeDifference};
+    double maxTimeDifference=*std::max_element(maxTimeDifferences,maxTimeDifferences+3);
+
+    if(fabs(h1._time-h2._time)>maxTimeDifference) return stop;  //no need to check any triplets containing the current pair of layer1 and layer2
+
+    double times[3]={h1._time,h2._time,h3._time};
+    double timeMin = *std::min_element(times,times+3);
+    double timeMax = *std::max_element(times,times+3);
+    if(timeMax-timeMin>maxTimeDifference) return reject;  //hits don't fall within the time window
+  }
+  else
+  {
+    double timesPulseStart[3]={h1._timePulseStart,h2._timePulseStart,h3._timePulseStart};
+    double timesPulseEnd[3]={h1._timePulseEnd,h2._timePulseEnd,h3._timePulseEnd};
+    double timeMaxPulseStart = *std::max_element(timesPulseStart,timesPulseStart+3);
+    double timeMinPulseEnd = *std::min_element(timesPulseEnd,timesPulseEnd+3);
+    if(timeMinPulseEnd-timeMaxPulseStart<_minOverlapTime) return reject;  //pulses don't overlap, or overlap time too short
+  }
+
+  double x[3]={h1._x,h2._x,h3._x};
+  double y[3]={h1._y,h2._y,h3._y};
+
+  bool coincidenceFound=true;
+  double slope[2];
+  for(int d=0; d<2; d++)
+  {
+    slope[d]=(x[d+1]-x[d])/(y[d+1]-y[d]);
+    if(fabs(slope[d])>_maxSlope) coincidenceFound=false;   //not more than maxSlope allowed for coincidence;
+  }
+
+  if(fabs(slope[0])>_maxSlope) return stop;  //no need to check any triplets containing the current pair of layer1 and layer2
+
+  if(fabs(slope[0]-slope[1])>_maxSlopeDifference) coincidenceFound=false;
+
+  return coincidenceFound?accept:reject;
+}
+
+bool CrvCoincidenceFinder::AdjacentCounterTest(const Hit &h1, const Hit &h2, const Hit &h3) const
+{
+  if(_usePulseOverlaps)
+  {
+    double times[3]={h1._time,h2._time,h3._time};
+    double timeMin = *std::min_element(times,times+3);
+    double timeMax = *std::max_element(times,times+3);
+
+    double maxTimeDifferences[3]={h1._maxTimeDifference,h2._maxTimeDifference,h3._maxTimeDifference};
+    double maxTimeDifference=*std::max_element(maxTimeDifferences,maxTimeDifferences+3);
+
+    if(timeMax-timeMin>maxTimeDifference) return false;  //hits don't fall within the time window
+  }
+  else
+  {
+    double timesPulseStart[3]={h1._timePulseStart,h2._timePulseStart,h3._timePulseStart};
+    double timesPulseEnd[3]={h1._timePulseEnd,h2._timePulseEnd,h3._timePulseEnd};
+    double timeMaxPulseStart = *std::max_element(timesPulseStart,timesPulseStart+3);
+    double timeMinPulseEnd = *std::min_element(timesPulseEnd,timesPulseEnd+3);
+    if(timeMinPulseEnd-timeMaxPulseStart<_minOverlapTime) return false;  //pulses don't overlap, or overlap time too short
+  }
+
+  std::set<int> counters{h1._counter,h2._counter,h3._counter};
+  if(counters.size()<3) return false;
+  if(*counters.rbegin()-*counters.begin()!=2) return false;
+  return true;
+}
+
+void CrvCoincidenceFinder::FindCoincidences(const std::vector<Hit> &hits, std::vector<std::vector<size_t> > &coincidences)
+{
+  //remove hits below the threshold
+  for(int layer=0; layer<4; layer++)
+  {
+    _layerHits[layer].clear();
+    _filteredHits[layer].clear();
+  }
+  for(size_t i=0; i<hits.size(); i++) _layerHits[hits[i]._layer].push_back(i);
+
+  for(int layer=0; layer<4; layer++)
+  {
+    const std::vector<size_t> &layerHits=_layerHits[layer];
+    std::vector<std::pair<double,size_t> > &sorted=_sortedHits[layer];
+    double maxLength=SortByKey(hits,layerHits,_usePulseOverlaps,sorted);
+
+    for(size_t i : layerHits)
+    {
+      const Hit &hit=hits[i];
+      std::pair<double,double> keys=_usePulseOverlaps?OverlapKeyWindow(hit._timePulseStart,hit._timePulseEnd,maxLength):
+                                                      KeyWindow(hit._time,hit._time,hit._adjacentPulseTimeDifference);
+      std::pair<size_t,size_t> window=Window(sorted,0,sorted.size(),keys);
+      _candidates.clear();
+      for(size_t k=window.first; k<window.second; k++)
+      {
+        size_t j=sorted[k].second;
+        if(j==i) continue;
+        if(std::abs(hits[j]._counter-hit._counter)>1) continue;
+        _candidates.push_back(j);
+      }
+      std::sort(_candidates.begin(),_candidates.end());
+      if(AboveThreshold(hits,i,_candidates)) _filteredHits[layer].push_back(i);
+    }
+  }
+
+  //largest time difference of all filtered hits
+  double maxTimeDifference=0;
+  for(int layer=0; layer<4; layer++)
+  {
+    for(size_t i : _filteredHits[layer]) maxTimeDifference=std::max(maxTimeDifference,hits[i]._maxTimeDifference);
+  }
+
+  //find coincidences using 4 hits in 4 layers
+  {
+    bool overlapTest=_usePulseOverlaps;
+    for(int layer=0; layer<4; layer++) _maxLength[layer]=SortByKey(hits,_filteredHits[layer],overlapTest,_sortedHits[layer]);
+
+    //keys of the hits which can be combined with the hits picked so far
+    auto keyWindow=[&](const Hit* const *picked, int nPicked, int layer)
+    {
+      double timeMin=picked[0]->_time, timeMax=timeMin;
+      double pulseStart=picked[0]->_timePulseStart, pulseEnd=picked[0]->_timePulseEnd;
+      for(int k=1; k<nPicked; k++)
+      {
+        timeMin=std::min(timeMin,picked[k]->_time);
+        timeMax=std::max(timeMax,picked[k]->_time);
+        pulseStart=std::max(pulseStart,picked[k]->_timePulseStart);
+        pulseEnd=std::min(pulseEnd,picked[k]->_timePulseEnd);
+      }
+      return overlapTest?OverlapKeyWindow(pulseStart,pulseEnd,_maxLength[layer]):KeyWindow(timeMin,timeMax,maxTimeDifference);
+    };
+
+    _combinations.clear();
+    const Hit* picked[4];
+    for(size_t i0 : _filteredHits[0])
+    {
+      picked[0]=&hits[i0];
+      std::pair<size_t,size_t> w1=Window(_sortedHits[1],0,_sortedHits[1].size(),keyWindow(picked,1,1));
+      for(size_t k1=w1.first; k1<w1.second; k1++)
+      {
+        size_t i1=_sortedHits[1][k1].second;
+        picked[1]=&hits[i1];
+        double slope0=(picked[1]->_x-picked[0]->_x)/(picked[1]->_y-picked[0]->_y);
+        if(fabs(slope0)>_maxSlope) continue;
+
+        std::pair<size_t,size_t> w2=Window(_sortedHits[2],0,_sortedHits[2].size(),keyWindow(picked,2,2));
+        for(size_t k2=w2.first; k2<w2.second; k2++)
+        {
+          size_t i2=_sortedHits[2][k2].second;
+          picked[2]=&hits[i2];
+          double slope1=(picked[2]->_x-picked[1]->_x)/(picked[2]->_y-picked[1]->_y);
+          if(fabs(slope1)>_maxSlope) continue;
+          if(fabs(slope0-slope1)>_maxSlopeDifference) continue;
+
+          std::pair<size_t,size_t> w3=Window(_sortedHits[3],0,_sortedHits[3].size(),keyWindow(picked,3,3));
+          for(size_t k3=w3.first; k3<w3.second; k3++)
+          {
+            size_t i3=_sortedHits[3][k3].second;
+            if(FourLayerTest(*picked[0],*picked[1],*picked[2],hits[i3])) _combinations.push_back({i0,i1,i2,i3});
+          }
+        }
+      }
+    }
+    std::sort(_combinations.begin(),_combinations.end());
+    for(const auto &c : _combinations) coincidences.emplace_back(c.begin(),c.end());
+  }
+
+  //find coincidences using 3 hits in 3 layers (ignored, if all three hits have a useFourLayers flag)
+  {
+    bool overlapTest=!_usePulseOverlaps;
+    for(int layer=0; layer<4; layer++)
+    {
+      _maxLength[layer]=SortByKey(hits,_filteredHits[layer],overlapTest,_sortedHits[layer]);
+      //running minimum of the max time difference, in the order of the hits: used to find
+      //the hit at which the original search stops looking for the third hit of a pair
+      for(int f=0; f<2; f++)
+      {
+        std::vector<double> &runningMin=_minMaxTimeDifference[f][layer];
+        runningMin.clear();
+        double m=std::numeric_limits<double>::infinity();
+        for(size_t i : _filteredHits[layer])
+        {
+          if(f==0 || !hits[i]._useFourLayers) m=std::min(m,hits[i]._maxTimeDifference);
+          runningMin.push_back(m);
+        }
+      }
+    }
+
+    for(int layer1=0; layer1<4; layer1++)
+    for(int layer2=layer1+1; layer2<4; layer2++)
+    for(int layer3=layer2+1; layer3<4; layer3++)
+    {
+      _combinations.clear();
+      const std::vector<size_t> &layer3Hits=_filteredHits[layer3];
+      for(size_t i1 : _filteredHits[layer1])
+      {
+        const Hit &h1=hits[i1];
+        std::pair<double,double> keys2=overlapTest?OverlapKeyWindow(h1._timePulseStart,h1._timePulseEnd,_maxLength[layer2]):
+                                                   KeyWindow(h1._time,h1._time,maxTimeDifference);
+        std::pair<size_t,size_t> w2=Window(_sortedHits[layer2],0,_sortedHits[layer2].size(),keys2);
+        for(size_t k2=w2.first; k2<w2.second; k2++)
+        {
+          size_t i2=_sortedHits[layer2][k2].second;
+          const Hit &h2=hits[i2];
+          double slope0=(h2._x-h1._x)/(h2._y-h1._y);
+          if(fabs(slope0)>_maxSlope) continue;
+
+          //with the time difference test, the original search stops at the first third hit
+          //for which the time difference of the pair exceeds the max time difference of all three hits
+          size_t stopIndex=hits.size();
+          if(!overlapTest)
+          {
+            double dt=fabs(h1._time-h2._time);
+            if(dt>std::max(h1._maxTimeDifference,h2._maxTimeDifference))
+            {
+              const std::vector<double> &runningMin=_minMaxTimeDifference[(h1._useFourLayers && h2._useFourLayers)?1:0][layer3];
+              auto stopHit=std::partition_point(runningMin.begin(),runningMin.end(),[dt](double m){return !(dt>m);});
+              if(stopHit!=runningMin.end()) stopIndex=layer3Hits[stopHit-runningMin.begin()];
+            }
+          }
+
+          std::pair<double,double> keys3=overlapTest?OverlapKeyWindow(std::max(h1._timePulseStart,h2._timePulseStart),
+                                                                      std::min(h1._timePulseEnd,h2._timePulseEnd),_maxLength[layer3]):
+                                                     KeyWindow(std::min(h1._time,h2._time),std::max(h1._time,h2._time),maxTimeDifference);
+          std::pair<size_t,size_t> w3=Window(_sortedHits[layer3],0,_sortedHits[layer3].size(),keys3);
+          for(size_t k3=w3.first; k3<w3.second; k3++)
+          {
+            size_t i3=_sortedHits[layer3][k3].second;
+            if(i3>=stopIndex) continue;
+            if(ThreeLayerTest(h1,h2,hits[i3])==accept) _combinations.push_back({i1,i2,i3,0});
+          }
+        }
+      }
+      std::sort(_combinations.begin(),_combinations.end());
+      for(const auto &c : _combinations) coincidences.emplace_back(c.begin(),c.begin()+3);
+    }
+  }
+
+  //find coincidences using 3 hits in adjacent counters in one layer
+  if(_acceptThreeAdjacentCounters)
+  {
+    bool overlapTest=!_usePulseOverlaps;
+    for(int layer=0; layer<4; layer++)
+    {
+      const std::vector<size_t> &layerHits=_filteredHits[layer];
+      if(layerHits.size()<3) continue; //less than three hits in this layer
+
+      //sort by counter, and by key within each counter
+      std::vector<std::pair<double,size_t> > &sorted=_sortedHits[layer];
+      double maxLength=SortByKey(hits,layerHits,overlapTest,sorted);
+      std::stable_sort(sorted.begin(),sorted.end(),
+                       [&hits](const std::pair<double,size_t> &a, const std::pair<double,size_t> &b)
+                       {return hits[a.second]._counter<hits[b.second]._counter;});
+      auto counterRange=[&](int counter)
+      {
+        auto first=std::partition_point(sorted.begin(),sorted.end(),
+                                        [&](const std::pair<double,size_t> &a){return hits[a.second]._counter<counter;});
+        auto last=std::partition_point(first,sorted.end(),
+                                       [&](const std::pair<double,size_t> &a){return hits[a.second]._counter<=counter;});
+        return std::pair<size_t,size_t>(first-sorted.begin(),last-sorted.begin());
+      };
+
+      _combinations.clear();
+      for(size_t begin1=0; begin1<sorted.size(); )
+      {
+        int counter=hits[sorted[begin1].second]._counter;
+        std::pair<size_t,size_t> range1=counterRange(counter);
+        std::pair<size_t,size_t> range2=counterRange(counter+1);
+        std::pair<size_t,size_t> range3=counterRange(counter+2);
+        begin1=range1.second;
+        if(range2.first==range2.second || range3.first==range3.second) continue;
+
+        for(size_t k1=range1.first; k1<range1.second; k1++)
+        {
+          const Hit &h1=hits[sorted[k1].second];
+          std::pair<double,double> keys2=overlapTest?OverlapKeyWindow(h1._timePulseStart,h1._timePulseEnd,maxLength):
+                                                     KeyWindow(h1._time,h1._time,maxTimeDifference);
+          std::pair<size_t,size_t> w2=Window(sorted,range2.first,range2.second,keys2);
+          for(size_t k2=w2.first; k2<w2.second; k2++)
+          {
+            const Hit &h2=hits[sorted[k2].second];
+            std::pair<double,double> keys3=overlapTest?OverlapKeyWindow(std::max(h1._timePulseStart,h2._timePulseStart),
+                                                                        std::min(h1._timePulseEnd,h2._timePulseEnd),maxLength):
+                                                       KeyWindow(std::min(h1._time,h2._time),std::max(h1._time,h2._time),maxTimeDifference);
+            std::pair<size_t,size_t> w3=Window(sorted,range3.first,range3.second,keys3);
+            for(size_t k3=w3.first; k3<w3.second; k3++)
+            {
+              std::array<size_t,4> c{sorted[k1].second,sorted[k2].second,sorted[k3].second,0};
+              std::sort(c.begin(),c.begin()+3);
+              if(AdjacentCounterTest(hits[c[0]],hits[c[1]],hits[c[2]])) _combinations.push_back(c);
+            }
+          }
+        }
+      }
+      std::sort(_combinations.begin(),_combinations.end());
+      for(const auto &c : _combinations) coincidences.emplace_back(c.begin(),c.begin()+3);
+    }
+  }
+}
+
+//the original search: all combinations of hits are tested
+void CrvCoincidenceFinder::FindCoincidencesExhaustive(const std::vector<Hit> &hits, std::vector<std::vector<size_t> > &coincidences) const
+{
+  //remove hits below the threshold
+  std::vector<std::vector<size_t> > filteredHits(4);
+  std::vector<size_t> adjacentHits;
+  for(size_t i=0; i<hits.size(); i++)
+  {
+    adjacentHits.clear();
+    for(size_t j=0; j<hits.size(); j++)
+    {
+      if(j!=i && hits[j]._layer==hits[i]._layer) adjacentHits.push_back(j);
+    }
+    if(AboveThreshold(hits,i,adjacentHits)) filteredHits[hits[i]._layer].push_back(i);
+  }
+
+  //find coincidences using 4 hits in 4 layers
+  for(size_t i0 : filteredHits[0])
+  for(size_t i1 : filteredHits[1])
+  for(size_t i2 : filteredHits[2])
+  for(size_t i3 : filteredHits[3])
+  {
+    if(FourLayerTest(hits[i0],hits[i1],hits[i2],hits[i3])) coincidences.push_back({i0,i1,i2,i3});
+  }
+
+  //find coincidences using 3 hits in 3 layers
+  for(int layer1=0; layer1<4; layer1++)
+  for(int layer2=layer1+1; layer2<4; layer2++)
+  for(int layer3=layer2+1; layer3<4; layer3++)
+  {
+    for(size_t i1 : filteredHits[layer1])
+    for(size_t i2 : filteredHits[layer2])
+    for(size_t i3 : filteredHits[layer3])
+    {
+      TestResult result=ThreeLayerTest(hits[i1],hits[i2],hits[i3]);
+      if(result==stop) break;
+      if(result==accept) coincidences.push_back({i1,i2,i3});
+    }
+  }
+
+  //find coincidences using 3 hits in adjacent counters in one layer
+  if(_acceptThreeAdjacentCounters)
+  {
+    for(int layer=0; layer<4; layer++)
+    {
+      const std::vector<size_t> &layerHits=filteredHits[layer];
+      for(size_t k1=0; k1<layerHits.size(); k1++)
+      for(size_t k2=k1+1; k2<layerHits.size(); k2++)
+      for(size_t k3=k2+1; k3<layerHits.size(); k3++)
+      {
+        if(AdjacentCounterTest(hits[layerHits[k1]],hits[layerHits[k2]],hits[layerHits[k3]]))
+          coincidences.push_back({layerHits[k1],layerHits[k2],layerHits[k3]});
+      }
+    }
+  }
+}
+
+}
@@ -78,6 +78,9 @@ namespace mu2e
       fhicl::Atom<art::InputTag> eventWindowMarkerTag{ Name("eventWindowMarkerTag"), Comment("EventWindowMarker producer"),"EWMProducer" };
       fhicl::Atom<art::InputTag> protonBunchTimeMCTag{ Name("protonBunchTimeMCTag"), Comment("ProtonBunchTimeMC producer"),"EWMProducer" };
       fhicl::Sequence<art::InputTag> timeOffsets { Name("timeOffsets"), Comment("Sim Particle Time Offset Maps")};
+      fhicl::Sequence<art::InputTag> crvPhotonsOverlays{ Name("crvPhotonsOverlays"), 
+                                                         Comment("pre-digitized CrvPhotons frames to add to the photons of the same SiPMs"),
+                                                         std::vector<art::InputTag>{} };
     };
     using Parameters = art::EDProducer::Table<Config>;
     explicit CrvPhotonGenerator(const Parameters& conf);
@@ -128,6 +131,7 @@ namespace mu2e
     double      _microBunchPeriod;
 
     SimParticleTimeOffset _timeOffsets;
+    std::vector<art::InputTag> _crvPhotonsOverlays;
 
     CLHEP::HepRandomEngine& _engine;
     CLHEP::RandFlat       _randFlat;
@@ -155,6 +159,7 @@ namespace mu2e
     _eventWindowMarkerTag(conf().eventWindowMarkerTag()),
     _protonBunchTimeMCTag(conf().protonBunchTimeMCTag()),
     _timeOffsets(conf().timeOffsets()),
+    _crvPhotonsOverlays(conf().crvPhotonsOverlays()),
     _engine{createEngine(art::ServiceHandle<SeedService>()->getSeed())},
     _randFlat(_engine),
     _randGaussQ(_engine),
@@ -201,6 +206,7 @@ namespace mu2e
       std::cout<<"CRV sector "<<i<<" ("<<_CRVSectors[i]<<") uses "<<_makeCrvPhotons.back()->GetFileName()<<" with scintillation yield of "<<_scintillationYields[i]<<" photons/MeV"<<std::endl;
     }
 
+    for(auto const& tag : _crvPhotonsOverlays) consumes<CrvPhotonsCollection>(tag);
     produces<CrvPhotonsCollection>();
   }
 
@@ -363,6 +369,20 @@ namespace mu2e
       } //loop over all StepPointMC collections
     } //loop over all module labels / process names from the fcl file
 
+    //add the photons of pre-digitized frames to the photons of the same SiPMs, 
+    //so that the SiPM response (and the dark noise) is simulated once for all of them.
+    //the photon times of the frames are already folded in the microbunch.
+    for(auto const& tag : _crvPhotonsOverlays)
+    {
+      auto const& overlayPhotons = *event.getValidHandle<CrvPhotonsCollection>(tag);
+      for(auto const& crvPhotons : overlayPhotons)
+      {
+        std::pair<CRSScintillatorBarIndex,int> barIndexSiPMNumber(crvPhotons.GetScintillatorBarIndex(),crvPhotons.GetSiPMNumber());
+        std::vector<CrvPhotons::SinglePhoton> &photons = photonMap[barIndexSiPMNumber];
+        photons.insert(photons.end(),crvPhotons.GetPhotons().begin(),crvPhotons.GetPhotons().end());
+      }
+    }
+
     for(auto p=photonMap.begin(); p!=photonMap.end(); ++p)
     {
       crvPhotonsCollection->emplace_back(p->first.first,p->first.second,p->second);
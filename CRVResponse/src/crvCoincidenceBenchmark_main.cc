@@ -0,0 +1,146 @@
+//
+// Stress test of the CRV coincidence search with synthetic high-rate noise.
+//
+//   crvCoincidenceBenchmark [noiseHits] [tracks] [events]
+//
+// Each event has noiseHits random hits (random counter, layer, time and PEs, with the
+// pulse of the other SiPM of the counter most of the time) spread over one sector type
+// made of two sectors with different time differences and useFourLayers flags, plus
+// tracks crossing all four layers.  The binned and the exhaustive searches are run
+// with and without pulse overlaps, and with three adjacent counters accepted;
+// the coincidences must be identical (including their order).
+//
+// Original Author: Ralf Ehrlich
+
+#include "CRVResponse/inc/CrvCoincidenceFinder.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+  const int    nCounters    = 256;    //per layer, counters [0,128) belong to the first sector
+  const double counterWidth = 51.3;   //mm
+  const double layerOffset  = 42.0;   //mm
+  const double layerPitch   = 21.0;   //mm
+  const double timeStart    = 500.0;  //ns
+  const double timeEnd      = 1750.0; //ns
+
+  void FillHit(mu2eCrv::CrvCoincidenceFinder::Hit &hit, int layer, int counter, double time, float PEs, double pulseLength)
+  {
+    hit._time=time;
+    hit._timePulseStart=time-0.3*pulseLength;
+    hit._timePulseEnd=time+0.7*pulseLength;
+    hit._PEs=PEs;
+    hit._layer=layer;
+    hit._counter=counter;
+    hit._x=counter*counterWidth+(layer%2)*layerOffset;
+    hit._y=layer*layerPitch;
+    bool firstSector=counter<nCounters/2;
+    hit._PEthreshold=firstSector?16:22;
+    hit._adjacentPulseTimeDifference=firstSector?10:5;
+    hit._maxTimeDifference=firstSector?20:10;
+    hit._useFourLayers=!firstSector && counter%3==0;
+  }
+
+  void MakeEvent(std::mt19937 &engine, size_t noiseHits, size_t tracks, std::vector<mu2eCrv::CrvCoincidenceFinder::Hit> &hits)
+  {
+    std::uniform_real_distribution<double> flat(0.0,1.0);
+    std::exponential_distribution<double>  noisePEs(1.0/8.0);
+    std::normal_distribution<double>       jitter(0.0,2.0);
+    mu2eCrv::CrvCoincidenceFinder::Hit hit;
+
+    hits.clear();
+    while(hits.size()<noiseHits)
+    {
+      int layer=4*flat(engine);
+      int counter=nCounters*flat(engine);
+      double time=timeStart+(timeEnd-timeStart)*flat(engine);
+      double pulseLength=10.0+20.0*flat(engine);
+      FillHit(hit,layer,counter,time,1.0f+noisePEs(engine),pulseLength);
+      hits.push_back(hit);
+      if(flat(engine)<0.7)  //pulse of the other SiPM
+      {
+        FillHit(hit,layer,counter,time+jitter(engine),1.0f+noisePEs(engine),pulseLength+jitter(engine));
+        hits.push_back(hit);
+      }
+    }
+
+    for(size_t iTrack=0; iTrack<tracks; iTrack++)
+    {
+      double time=timeStart+(timeEnd-timeStart)*flat(engine);
+      double x0=(nCounters-8)*counterWidth*flat(engine);
+      double slope=4.0*flat(engine)-2.0;
+      for(int layer=0; layer<4; layer++)
+      {
+        if(flat(engine)<0.1) continue;  //inefficient layer
+        double x=x0+slope*layer*layerPitch;
+        int counter=(x-(layer%2)*layerOffset)/counterWidth+0.5;
+        if(counter<0 || counter>=nCounters) continue;
+        FillHit(hit,layer,counter,time+jitter(engine),20.0f+10.0f*flat(engine),20.0);
+        hits.push_back(hit);
+      }
+    }
+
+    std::shuffle(hits.begin(),hits.end(),engine);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  const size_t noiseHits = argc > 1 ? std::strtoul(argv[1],nullptr,10) : 2000;
+  const size_t tracks    = argc > 2 ? std::strtoul(argv[2],nullptr,10) : 20;
+  const size_t events    = argc > 3 ? std::strtoul(argv[3],nullptr,10) : 10;
+
+  typedef std::chrono::steady_clock clock;
+  int mismatches=0;
+  for(int usePulseOverlaps=0; usePulseOverlaps<2; usePulseOverlaps++)
+  {
+    mu2eCrv::CrvCoincidenceFinder finder(usePulseOverlaps, 2.0, 7.0, 2.0, true);
+
+    std::mt19937 engine(12345);
+    std::vector<mu2eCrv::CrvCoincidenceFinder::Hit> hits;
+    std::vector<std::vector<size_t> > binned, exhaustive;
+    double tBinned=0, tExhaustive=0;
+    size_t nHits=0, nCoincidences=0;
+    for(size_t iEvent=0; iEvent<events; iEvent++)
+    {
+      MakeEvent(engine,noiseHits,tracks,hits);
+      binned.clear();
+      exhaustive.clear();
+
+      auto t0 = clock::now();
+      finder.FindCoincidences(hits,binned);
+      auto t1 = clock::now();
+      finder.FindCoincidencesExhaustive(hits,exhaustive);
+      auto t2 = clock::now();
+
+      tBinned+=std::chrono::duration<double,std::milli>(t1-t0).count();
+      tExhaustive+=std::chrono::duration<double,std::milli>(t2-t1).count();
+      nHits+=hits.size();
+      nCoincidences+=exhaustive.size();
+      if(binned!=exhaustive)
+      {
+        mismatches++;
+        std::cout<<"event "<<iEvent<<" (usePulseOverlaps "<<usePulseOverlaps<<"): "
+                 <<binned.size()<<" binned vs. "<<exhaustive.size()<<" exhaustive coincidences differ"<<std::endl;
+      }
+    }
+
+    std::cout<<"usePulseOverlaps "<<usePulseOverlaps<<": "<<events<<" events, "<<nHits/events<<" hits/event, "
+             <<nCoincidences/double(events)<<" coincidences/event"<<std::endl;
+    std::cout<<"  binned:     "<<tBinned/events<<" ms/event"<<std::endl;
+    std::cout<<"  exhaustive: "<<tExhaustive/events<<" ms/event"<<std::endl;
+  }
+
+  if(mismatches>0)
+  {
+    std::cout<<mismatches<<" events with different coincidences"<<std::endl;
+    return 1;
+  }
+  return 0;
+}
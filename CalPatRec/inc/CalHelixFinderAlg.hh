@@ -23,6 +23,8 @@
 //#include "CalPatRec/inc/CalHelixPoint.hh"
 #include "CalPatRec/inc/CalHelixFinderData.hh"
 
+#include <chrono>
+
 class TH1F;
 
 namespace fhicl {
@@ -86,6 +88,20 @@ namespace mu2e {
     };
 
     SaveResults_t        _results[6];      // diagnostic buffers
+//-----------------------------------------------------------------------------
+// work done and time spent by the last findHelix call, times in ms
+// budgetExceeded: 0:no, 1:findTrack calls, 2:hits tested, 3:wall clock
+//-----------------------------------------------------------------------------
+    struct Timing_t {
+      float              tripletSearch;     // searchBestTriplet
+      float              refine;            // rest of doPatternRecognition
+      float              total;             // findHelix
+      int                nFindTrackCalls;
+      int                nHitsTested;
+      int                budgetExceeded;
+    };
+
+    Timing_t             _timing;
 
     int                  fUseDefaultDfDz;
 
@@ -157,6 +173,15 @@ namespace mu2e {
     float    _dfdzErr;                 // error on dfdz by ::findDfDz
     float    _minarea2;
 //-----------------------------------------------------------------------------
+// per-findHelix work budget, 0 means unlimited. Once it is used up the triplet
+// search stops and the best candidate found so far is refined and returned
+//-----------------------------------------------------------------------------
+    int       _maxFindTrackCalls;       // max number of triplet seeds tried
+    int       _maxHitsTested;           // max number of straw hits tested as seeds
+    float     _maxTime;                 // max wall clock time, ms
+
+    std::chrono::steady_clock::time_point _tStart;
+//-----------------------------------------------------------------------------
 // checkpoints, used for debugging
 //-----------------------------------------------------------------------------
     int       _findTrackLoopIndex;
@@ -169,6 +194,10 @@ namespace mu2e {
     virtual ~CalHelixFinderAlg();
                                         // cached bfield accessor
     float bz() const;
+                                        // ms since the start of the current findHelix call
+    float elapsedTime() const;
+                                        // checks the work budget, sets _timing.budgetExceeded
+    bool  budgetExceeded();
 
     void   calculateDfDz    (float phi0, float phi1, float z0,  float z1, float &dfdz);
     void   calculateDphiDz_2(CalHelixFinderData& Helix,HitInfo_t HitIndex, int NHits, float X0, float Y0, float& DphiDz);
@@ -46,6 +46,17 @@ namespace mu2e {
       double  chi2d_line_loop0[kMaxSeeds];
       double  chi2d_line_loop1[kMaxSeeds];
       int     loopId[kMaxSeeds];
+//-----------------------------------------------------------------------------
+// timing: per event and per time peak (summed over the helicities), times in ms
+//-----------------------------------------------------------------------------
+      double  tEvent;
+      int     tpNHits       [kMaxSeeds];
+      int     nFindTrack    [kMaxSeeds];
+      int     nHitsTested   [kMaxSeeds];
+      int     budgetExceeded[kMaxSeeds];
+      double  tTriplet      [kMaxSeeds];
+      double  tRefine       [kMaxSeeds];
+      double  tTotal        [kMaxSeeds];
       int maxSeeds() { return kMaxSeeds; }
     };
 
@@ -73,6 +84,14 @@ namespace mu2e {
       TH1F*  chi2d_line_loop0[2];
       TH1F*  chi2d_line_loop1[2];
       TH1F*  loopId[2];
+      TH1F*  tEvent;
+      TH1F*  tTriplet;
+      TH1F*  tRefine;
+      TH1F*  tTotal;
+      TH2F*  tTotalVsNHits;
+      TH1F*  nFindTrack;
+      TH1F*  nHitsTested;
+      TH1F*  budgetExceeded;
     };
 
   }
@@ -178,7 +178,10 @@ namespace mu2e {
     _chi2xyMax          (pset.get<float>        ("chi2xyMax"              )),
     _chi2zphiMax        (pset.get<float>        ("chi2zphiMax"            )),
     _chi2hel3DMax       (pset.get<float>        ("chi2hel3DMax"           )),
-    _dfdzErr            (pset.get<float>        ("dfdzErr"                )){
+    _dfdzErr            (pset.get<float>        ("dfdzErr"                )),
+    _maxFindTrackCalls  (pset.get<int>          ("maxFindTrackCalls"      )),
+    _maxHitsTested      (pset.get<int>          ("maxHitsTested"          )),
+    _maxTime            (pset.get<float>        ("maxTime"                )){
 
     float minarea(pset.get<float>("minArea"));
     _minarea2    = minarea*minarea;    
@@ -208,6 +211,23 @@ namespace mu2e {
     return _bz;
   }
 
+//-----------------------------------------------------------------------------
+  float CalHelixFinderAlg::elapsedTime() const {
+    return std::chrono::duration<float,std::milli>(std::chrono::steady_clock::now()-_tStart).count();
+  }
+
+//-----------------------------------------------------------------------------
+// once exceeded, the budget stays exceeded until the next findHelix call
+//-----------------------------------------------------------------------------
+  bool CalHelixFinderAlg::budgetExceeded() {
+    if (_timing.budgetExceeded == 0) {
+      if      ((_maxFindTrackCalls > 0) && (_timing.nFindTrackCalls >= _maxFindTrackCalls)) _timing.budgetExceeded = 1;
+      else if ((_maxHitsTested     > 0) && (_timing.nHitsTested     >= _maxHitsTested    )) _timing.budgetExceeded = 2;
+      else if ((_maxTime           > 0) && (elapsedTime()           >= _maxTime          )) _timing.budgetExceeded = 3;
+    }
+    return (_timing.budgetExceeded != 0);
+  }
+
   void CalHelixFinderAlg::setCaloCluster(CalHelixFinderData& Helix) {
     //check presence of a cluster
     const CaloCluster* cl = Helix._timeCluster->caloCluster().get();
@@ -246,6 +266,8 @@ namespace mu2e {
     // fCaloX    = tpos.x();
     // fCaloY    = tpos.y();
     // fCaloZ    = tpos.z();
+    _tStart = std::chrono::steady_clock::now();
+    _timing = Timing_t{0., 0., 0., 0, 0, 0};
 //-----------------------------------------------------------------------------
 //  compute the allowed radial range for this fit
 //-----------------------------------------------------------------------------
@@ -266,6 +288,8 @@ namespace mu2e {
 //-----------------------------------------------------------------------------
     bool retval = fitHelix(Helix);
 
+    _timing.total = elapsedTime();
+
     return retval;
   }
 
@@ -2017,6 +2041,7 @@ namespace mu2e {
 	for (int i=0; i<nhits; ++i){   
 	  if (Helix._nStrawHits > (nSh - nHitsTested))   continue;	  
 	  if ((nSh - nHitsTested) < _minNHits        )   continue;	  
+	  if (budgetExceeded())                          return;
 	  //clear the info of the tmp object used to test the triplet
 	  TmpHelix.clearResults();
 
@@ -2025,6 +2050,9 @@ namespace mu2e {
 
 	  nHitsTested += Helix._chHitsToProcess[panelz->idChBegin + i].nStrawHits();
 
+	  _timing.nFindTrackCalls += 1;
+	  _timing.nHitsTested     += Helix._chHitsToProcess[panelz->idChBegin + i].nStrawHits();
+
 	  //compare tripletHelix with bestTripletHelix
 	  //2019-02-08: gianipez chanceg the logic;
 	  //2019-02-15: gianipez put the old logic back. FIXME!
@@ -2073,6 +2101,8 @@ namespace mu2e {
       searchBestTriplet(Helix, tripletHelix, useMPVdfdz);
    }
 
+    _timing.tripletSearch = elapsedTime();
+
     if (_debug == 0){
       _debug  = _debug2;
       _debug2 = 0;
@@ -2139,6 +2169,13 @@ namespace mu2e {
     }
 
     rc = doLinearFitPhiZ(Helix, HitInfo_t(0,0,-1), useIntelligentWeight);
+//-----------------------------------------------------------------------------
+// the second rescue pass is skipped if the time budget is already used up
+//-----------------------------------------------------------------------------
+    if (rc && (_maxTime > 0) && (elapsedTime() >= _maxTime)) {
+      if (_timing.budgetExceeded == 0) _timing.budgetExceeded = 3;
+      rc = false;
+    }
 
     if (rc) {
       usePhiResid = 1;
@@ -2171,6 +2208,7 @@ namespace mu2e {
     filterUsingPatternRecognition(Helix);
 
   PATTERN_RECOGNITION_END:;
+    _timing.refine = elapsedTime() - _timing.tripletSearch;
 //-----------------------------------------------------------------------------
 // if running in the diagnostics mode, save state of the Xyzp (this is a deep copy)
 //-----------------------------------------------------------------------------
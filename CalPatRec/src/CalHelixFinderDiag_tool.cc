@@ -19,6 +19,8 @@
 
 #include "Mu2eUtilities/inc/SimParticleTimeOffset.hh"
 
+#include <algorithm>
+
 namespace mu2e {
 
   using namespace CalHelixFinderTypes;
@@ -99,6 +101,14 @@ int CalHelixFinderDiag::bookHistograms(art::ServiceHandle<art::TFileService>& Tf
   _hist.npoints_loop1 = Tfs->make<TH1F>("npointsloop1", "XY npoints: loop 1; nhits"           , 101, -0.5, 100.5);
   _hist.loopId[0]     = Tfs->make<TH1F>("loopAll"   , "loopId; loopId"                           , 10, 0, 10); 
   _hist.loopId[1]     = Tfs->make<TH1F>("loopGood"  , "loopId: nhits>15: loopId"                 , 10, 0, 10); 
+  _hist.tEvent        = Tfs->make<TH1F>("tevent"    , "time per event; t [ms]"                   , 1000, 0, 100);
+  _hist.tTriplet      = Tfs->make<TH1F>("ttriplet"  , "triplet search time per time peak; t [ms]" , 1000, 0, 50);
+  _hist.tRefine       = Tfs->make<TH1F>("trefine"   , "refinement time per time peak; t [ms]"    , 1000, 0, 50);
+  _hist.tTotal        = Tfs->make<TH1F>("ttotal"    , "findHelix time per time peak; t [ms]"     , 1000, 0, 50);
+  _hist.tTotalVsNHits = Tfs->make<TH2F>("ttotvsnh"  , "findHelix time vs N(hits); nhits; t [ms]" , 101, -0.5, 100.5, 500, 0, 50);
+  _hist.nFindTrack    = Tfs->make<TH1F>("nfindtrk"  , "N(findTrack calls) per time peak"         , 201, -0.5, 200.5);
+  _hist.nHitsTested   = Tfs->make<TH1F>("nhtested"  , "N(straw hits tested) per time peak"       , 201, -0.5, 200.5);
+  _hist.budgetExceeded= Tfs->make<TH1F>("budget"    , "budget exceeded: 1:iterations 2:hits 3:time", 4, -0.5, 3.5);
   return 0;
 }
 
@@ -126,6 +136,19 @@ int CalHelixFinderDiag::bookHistograms(art::ServiceHandle<art::TFileService>& Tf
     _hist.nTimePeaks->Fill(_data->nTimePeaks);
     _hist.nseeds[0]->Fill(_data->nseeds[0]);
     _hist.nseeds[1]->Fill(_data->nseeds[1]);
+    _hist.tEvent->Fill(_data->tEvent);
+
+    int ntp = std::min(_data->nTimePeaks,(int) Data_t::kMaxSeeds);
+    for (int i=0; i<ntp; i++) {
+      if (_data->nFindTrack[i] < 0)                 continue;  // time peak not processed
+      _hist.tTriplet      ->Fill(_data->tTriplet[i]);
+      _hist.tRefine       ->Fill(_data->tRefine [i]);
+      _hist.tTotal        ->Fill(_data->tTotal  [i]);
+      _hist.tTotalVsNHits ->Fill(_data->tpNHits [i],_data->tTotal[i]);
+      _hist.nFindTrack    ->Fill(_data->nFindTrack [i]);
+      _hist.nHitsTested   ->Fill(_data->nHitsTested[i]);
+      _hist.budgetExceeded->Fill(_data->budgetExceeded[i]);
+    }
 
     for (int i=0; i<_data->nseeds[0]; i++) {
       _hist.ntclhits[0]->Fill(_data->ntclhits[i]);
@@ -43,6 +43,8 @@
 #include "TSystem.h"
 #include "TInterpreter.h"
 
+#include <chrono>
+
 using namespace std;
 using namespace boost::accumulators;
 using CLHEP::HepVector;
@@ -229,6 +231,7 @@ namespace mu2e {
     // _data.nseeds[1] = 0;
     _iev            = event.id().event();
     int   nGoodTClusterHits(0);
+    auto  tEventStart = std::chrono::steady_clock::now();
 
     if ((_debugLevel > 0) && (_iev%_printfreq) == 0) printf("[%s] : START event number %8i\n", oname,_iev);
 
@@ -260,7 +263,20 @@ namespace mu2e {
     for (int ipeak=0; ipeak<_data.nTimePeaks; ipeak++) {
       const TimeCluster* tc = &_timeclcol->at(ipeak);
       nGoodTClusterHits     = goodHitsTimeCluster(tc);
+
+      bool diagTp = (_diagLevel > 0) && (ipeak < _data.maxSeeds());
+      if (diagTp) {
+	_data.tpNHits       [ipeak] = nGoodTClusterHits;
+	_data.nFindTrack    [ipeak] = -1;
+	_data.nHitsTested   [ipeak] = 0;
+	_data.budgetExceeded[ipeak] = 0;
+	_data.tTriplet      [ipeak] = 0;
+	_data.tRefine       [ipeak] = 0;
+	_data.tTotal        [ipeak] = 0;
+      }
+
       if ( nGoodTClusterHits < _minNHitsTimeCluster)         continue;
+      if (diagTp) _data.nFindTrack[ipeak] = 0;
 
       //      HelixSeed          helix_seed;
       std::vector<HelixSeed>          helix_seed_vec;
@@ -293,11 +309,25 @@ namespace mu2e {
 	tmpResult._helicity       = _hels[i];
 
 	int rc = _hfinder.findHelix(tmpResult);
+
+	if (diagTp) {
+	  const CalHelixFinderAlg::Timing_t& tm = _hfinder._timing;
+	  _data.nFindTrack [ipeak] += tm.nFindTrackCalls;
+	  _data.nHitsTested[ipeak] += tm.nHitsTested;
+	  _data.tTriplet   [ipeak] += tm.tripletSearch;
+	  _data.tRefine    [ipeak] += tm.refine;
+	  _data.tTotal     [ipeak] += tm.total;
+	  if (tm.budgetExceeded != 0) _data.budgetExceeded[ipeak] = tm.budgetExceeded;
+	}
 	
 	if (!rc)                         continue;
 	HelixSeed     tmp_helix_seed;
 
 	initHelixSeed(tmp_helix_seed, tmpResult);
+//-----------------------------------------------------------------------------
+// flag helices found with a truncated search
+//-----------------------------------------------------------------------------
+	if (_hfinder._timing.budgetExceeded != 0) tmp_helix_seed._status.merge(TrkFitFlag::BudgetExceeded);
 	helix_seed_vec.push_back(tmp_helix_seed);
       }
       
@@ -414,7 +444,10 @@ namespace mu2e {
 //--------------------------------------------------------------------------------
 // fill histograms
 //--------------------------------------------------------------------------------
-    if (_diagLevel > 0) _hmanager->fillHistograms(&_data);
+    if (_diagLevel > 0) {
+      _data.tEvent = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-tEventStart).count();
+      _hmanager->fillHistograms(&_data);
+    }
 //-----------------------------------------------------------------------------
 // put reconstructed tracks into the event record
 //-----------------------------------------------------------------------------
@@ -0,0 +1,59 @@
+#! /bin/bash
+#
+# Per-event time of CalHelixFinderDe with and without a work budget.
+#
+# Usage: calHelixFinderTiming.sh <digi file> [nevents] [maxFindTrackCalls] [maxHitsTested] [maxTime(ms)]
+#
+# The job CalPatRec/test/calHelixFinderTiming.fcl is run twice on the first
+# nevents events of the file, first with the budget disabled and then with the
+# given limits (0: unlimited).  The first event, which includes initialization,
+# is dropped.  For each run the mean, 99th percentile and maximum of the
+# CalHelixFinderDe time per event are printed, as well as the number of helices
+# found with the budget exceeded.  Requires sqlite3.
+#
+
+input=${1:?"Usage: $0 <digi file> [nevents] [maxFindTrackCalls] [maxHitsTested] [maxTime(ms)]"}
+nevents=${2:-1000}
+maxcalls=${3:-100}
+maxhits=${4:-0}
+maxtime=${5:-0}
+module=CalHelixFinderDe
+
+runjob() {
+  local tag=$1
+  local fcl=calHelixFinderTiming_${tag}.fcl
+  cat > $fcl <<EOT
+#include "CalPatRec/test/calHelixFinderTiming.fcl"
+services.TimeTracker.dbOutput.filename : "calHelixFinderTiming_${tag}.db"
+physics.filters.${module}.HelixFinderAlg.maxFindTrackCalls : $2
+physics.filters.${module}.HelixFinderAlg.maxHitsTested     : $3
+physics.filters.${module}.HelixFinderAlg.maxTime           : $4
+physics.filters.${module}.diagLevel                        : 1
+services.TFileService.fileName                             : "calHelixFinderTiming_${tag}.root"
+EOT
+  mu2e -c $fcl -s $input -n $nevents > calHelixFinderTiming_${tag}.log 2>&1
+  local ret=$?
+  if [ $ret -ne 0 ]; then
+    echo "mu2e failed with status $ret; see calHelixFinderTiming_${tag}.log" >&2
+    exit $ret
+  fi
+}
+
+summary() {
+  local tag=$1
+  sqlite3 calHelixFinderTiming_${tag}.db \
+    "select Time from TimeModule where ModuleLabel='$module' order by Run, SubRun, Event;" | \
+    tail -n +2 | sort -g | \
+    awk -v tag=$tag '{ t[NR]=$1*1000; s+=$1*1000 }
+      END { if (NR == 0) { print tag ": no events"; exit }
+            i99 = int(0.99*NR); if (i99 < 1) i99 = 1
+            printf "%-8s %8d %12.3f %12.3f %12.3f\n", tag, NR, s/NR, t[i99], t[NR] }'
+}
+
+runjob nobudget 0 0 0        || exit 1
+runjob budget $maxcalls $maxhits $maxtime || exit 1
+
+printf "%-8s %8s %12s %12s %12s\n" run events "mean(ms)" "p99(ms)" "max(ms)"
+summary nobudget
+summary budget
+echo "time peaks with the budget exceeded: see histogram $module/budget in calHelixFinderTiming_budget.root"
@@ -0,0 +1,112 @@
+#ifndef CaloMC_CaloShowerStepBuilder_hh
+#define CaloMC_CaloShowerStepBuilder_hh
+//
+// Compress the calorimeter StepPointMCs into CaloShowerSteps, see CaloShowerStepMaker for the description.
+// The StepPointMCs are first collected by SimParticle ancestor, one collection at a time, then compressed.
+// Only the quantities used by the compression are copied, so the input collection can be dropped after
+// addSteps; Mu2eG4 uses this to add the steps of each G4 track as soon as the track is finished.
+// The SimParticles are reached through a lookup, so that the same code can run in Mu2eG4 before the
+// SimParticleCollection is in the event.
+//
+#include "MCDataProducts/inc/StepPointMCCollection.hh"
+#include "MCDataProducts/inc/SimParticle.hh"
+#include "MCDataProducts/inc/SimParticlePtrCollection.hh"
+#include "MCDataProducts/inc/CaloShowerStep.hh"
+#include "canvas/Persistency/Common/Ptr.h"
+#include "CLHEP/Vector/ThreeVector.h"
+
+#include <functional>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace mu2e {
+
+   class Calorimeter;
+
+   class CaloShowerStepBuilder
+   {
+       public:
+           using SimPtr      = art::Ptr<SimParticle>;
+           using SimLookup   = std::function<const SimParticle*(const SimPtr&)>;  // 0 if the SimParticle is not available
+           using InsideCheck = std::function<bool(const SimParticle&)>;         // does the SimParticle start inside the calorimeter
+
+           // optional diagnostic hooks: for each compressed ancestor and each ShowerStep bucket
+           using AncestorMonitor = std::function<void(const SimPtr&, const std::set<SimPtr>&)>;
+           using BucketMonitor   = std::function<void(int, float, const SimPtr&)>;
+
+           struct Summary
+           {
+               Summary() : totalEdep_(0.0),totalStep_(0),totalSim_(0),totalChk_(0),nCompress_(0),ncompressInfo_(0) {};
+               void reset() {totalEdep_=0.0;totalStep_=totalSim_=totalChk_=nCompress_=ncompressInfo_=0;}
+
+               float     totalEdep_;
+               unsigned  totalStep_,totalSim_,totalChk_,nCompress_,ncompressInfo_;
+           };
+
+           CaloShowerStepBuilder(unsigned numZSlices, double deltaTime, bool compressData, double eDepThreshold, int diagLevel = 0);
+
+           // reset the event content; without an InsideCheck the SimParticle start position is checked
+           void beginEvent(const Calorimeter& cal, InsideCheck inside = InsideCheck());
+           void addSteps(const StepPointMCCollection& steps, const SimLookup& sims);
+           void makeShowerSteps(CaloShowerStepCollection& caloShowerSteps, SimParticlePtrCollection& simsToKeep);
+
+           void setMonitors(AncestorMonitor ancestorMonitor, BucketMonitor bucketMonitor) {ancestorMonitor_ = ancestorMonitor; bucketMonitor_ = bucketMonitor;}
+           const Summary& summary() const {return summary_;}
+
+
+       private:
+           // the part of a StepPointMC used by the compression
+           struct StepInfo
+           {
+               explicit StepInfo(const StepPointMC& step) :
+                  sim_(step.simParticle()),volumeId_(step.volumeId()),time_(step.time()),totalEDep_(step.totalEDep()),
+                  visibleEDep_(step.visibleEDep()),momentum_(step.momentum().mag()),position_(step.position())
+               {}
+
+               SimPtr            sim_;
+               int               volumeId_;
+               double            time_,totalEDep_,visibleEDep_,momentum_;
+               CLHEP::Hep3Vector position_;
+           };
+
+           class CompressUtil
+           {
+               public:
+                   const std::vector<StepInfo>& steps() const {return steps_;}
+                   const std::set<SimPtr>&      sims()  const {return sims_;}
+
+                   void fill(const StepPointMC& step, const std::vector<SimPtr>& sims)
+                   {
+                       steps_.emplace_back(step);
+                       for (const auto& sim: sims) sims_.insert(sim);
+                   }
+
+               private:
+                   std::vector<StepInfo> steps_;
+                   std::set<SimPtr>      sims_;
+           };
+
+           bool isInsideCalorimeter(const SimParticle& sim) const;
+           void compressSteps(CaloShowerStepCollection&, int, const SimPtr&, std::vector<const StepInfo*>&);
+
+           int                                 numZSlices_;
+           double                              deltaTime_;
+           bool                                compressData_;
+           double                              eDepThreshold_;
+           int                                 diagLevel_;
+
+           const Calorimeter*                  cal_;
+           InsideCheck                         inside_;
+           double                              zSliceSize_;
+           std::map<SimPtr,CompressUtil>       ancestorsMap_;
+           std::unordered_map<SimPtr,SimPtr>   simToAncestorMap_;
+           Summary                             summary_;
+           AncestorMonitor                     ancestorMonitor_;
+           BucketMonitor                       bucketMonitor_;
+   };
+
+}
+
+#endif
@@ -3,6 +3,10 @@
 // Individual photo-electrons are generated for each readout, including photo-statistic fluctuations
 // Simulate digitization procedure and produce CaloDigis. 
 //
+// CaloShowerROs are bucketed by SiPM ID once per event, and only the readouts receiving photo-electrons are
+// synthesized. Readouts without hits are either simulated exactly as before (emptyChannelNoise: "full", which 
+// keeps the output bit-identical for a fixed seed), receive only salt and pepper noise ("saltAndPepper"), or 
+// are skipped entirely ("none").
 //
 #include "art/Framework/Core/EDProducer.h"
 #include "art/Framework/Core/ModuleMacros.h"
@@ -44,6 +48,7 @@
 #include <map>
 #include <vector>
 #include <numeric>
+#include <algorithm>
 
 
 namespace mu2e {
@@ -69,6 +74,7 @@ namespace mu2e {
              fhicl::Atom<double>        endTimeBuffer        { Name("endTimeBuffer"),          Comment("Number of extra timestamps after end of pulse") }; 
              fhicl::Atom<unsigned>      bufferDigi           { Name("bufferDigi"),             Comment("Number of timeStamps for the buffer digi") }; 
              fhicl::Atom<int>           pulseIntegralSteps   { Name("pulseIntegralSteps"),     Comment("Numer of time sub-division for CaloPulseChape") }; 
+             fhicl::Atom<std::string>   emptyChannelNoise    { Name("emptyChannelNoise"),      Comment("Noise for readouts without hits: full, saltAndPepper or none"),"full" }; 
              fhicl::Atom<int>           diagLevel            { Name("diagLevel"),              Comment("Diag Level"),0 };
          };
          
@@ -87,7 +93,12 @@ namespace mu2e {
             addNoise_          (config().addNoise()),
             generateSpotNoise_ (config().generateSpotNoise()),
             noiseGenerator_    (config().noise_gen_conf(), engine_, 0),
-            diagLevel_         (config().diagLevel())
+            emptyChannelNoise_ (parseEmptyChannelNoise(config().emptyChannelNoise())),
+            diagLevel_         (config().diagLevel()),
+            waveform_          (),
+            roOffsets_         (),
+            roFill_            (),
+            roIndices_         ()
          {
              produces<CaloDigiCollection>();
          }
@@ -96,7 +107,12 @@ namespace mu2e {
          void beginRun(art::Run& aRun) override;
 
     private:       
+       enum class EmptyChannelNoise {full, saltAndPepper, none};
+
+       static EmptyChannelNoise parseEmptyChannelNoise(const std::string&);
+
        void makeDigitization  (const CaloShowerROCollection&, CaloDigiCollection&);
+       void bucketROHits      (int nWaveforms, const CaloShowerROCollection&);
        void fillROHits        (int iRO, std::vector<double>& waveform, const CaloShowerROCollection&, const ConditionsHandle<CalorimeterCalibrations>&);
        void generateNoise     (std::vector<double>& waveform, int iRO, const ConditionsHandle<CalorimeterCalibrations>&);
        void buildOutputDigi   (int iRO, std::vector<double>& waveform, int pedestal, CaloDigiCollection&);
@@ -120,10 +136,25 @@ namespace mu2e {
        bool                    generateSpotNoise_;
        CaloNoiseSimGenerator   noiseGenerator_;
        const Calorimeter*      calorimeter_;
+       EmptyChannelNoise       emptyChannelNoise_;
        int                     diagLevel_;
+       std::vector<double>     waveform_;
+       std::vector<unsigned>   roOffsets_;
+       std::vector<unsigned>   roFill_;
+       std::vector<unsigned>   roIndices_;
   };
 
 
+  //-----------------------------------------------------------------------------
+  CaloDigiMaker::EmptyChannelNoise CaloDigiMaker::parseEmptyChannelNoise(const std::string& mode)
+  {
+      if (mode == "full")          return EmptyChannelNoise::full;
+      if (mode == "saltAndPepper") return EmptyChannelNoise::saltAndPepper;
+      if (mode == "none")          return EmptyChannelNoise::none;
+      throw cet::exception("CATEGORY")<<"[CaloDigiMaker] Unrecognized emptyChannelNoise option "<<mode;
+  }
+
+
   //-----------------------------------------------------------------------------
   void CaloDigiMaker::beginRun(art::Run& aRun)
   {
@@ -166,29 +197,62 @@ namespace mu2e {
       int nWaveforms   = calorimeter_->nCrystal()*calorimeter_->caloInfo().getInt("nSiPMPerCrystal");
       int waveformSize = (mbtime_ - blindTime_ + endTimeBuffer_) / digiSampling_; 
       
+      bucketROHits(nWaveforms, CaloShowerROs);
+      waveform_.resize(waveformSize);
+
+      // A readout without photo-electrons and without noise stays at zero and never passes the peak threshold
       for (int iRO=0;iRO<nWaveforms;++iRO)
       {
-          std::vector<double> waveform(waveformSize,0.0);
-          fillROHits(iRO, waveform, CaloShowerROs, calorimeterCalibrations);
-          if (addNoise_ &&  generateSpotNoise_) generateNoise(waveform, iRO, calorimeterCalibrations);
-          if (addNoise_ && !generateSpotNoise_) noiseGenerator_.addFullNoise(waveform, false);
-          buildOutputDigi(iRO, waveform, noiseGenerator_.pedestal(), caloDigiColl);
+          bool hasHits = roOffsets_[iRO+1] > roOffsets_[iRO];
+          if (!hasHits && (!addNoise_ || emptyChannelNoise_ == EmptyChannelNoise::none)) continue;
+
+          std::fill(waveform_.begin(),waveform_.end(),0.0);
+          fillROHits(iRO, waveform_, CaloShowerROs, calorimeterCalibrations);
+          
+          if (addNoise_)
+          {
+              if      (!hasHits && emptyChannelNoise_ == EmptyChannelNoise::saltAndPepper) noiseGenerator_.addSaltAndPepper(waveform_);
+              else if (generateSpotNoise_)                                                   generateNoise(waveform_, iRO, calorimeterCalibrations);
+              else                                                                           noiseGenerator_.addFullNoise(waveform_, false);
+          }
+          buildOutputDigi(iRO, waveform_, noiseGenerator_.pedestal(), caloDigiColl);
+      }
+  }
+
+
+  // Sort the CaloShowerRO indices by SiPM ID in one pass (counting sort), keeping the collection order within 
+  // each SiPM so the waveform sums are performed in the same order as a full scan of the collection
+  //----------------------------------------------------------------------------------------------------------
+  void CaloDigiMaker::bucketROHits(int nWaveforms, const CaloShowerROCollection& CaloShowerROs)
+  {
+      roOffsets_.assign(nWaveforms+1,0);
+      for (const auto& CaloShowerRO : CaloShowerROs)
+      {
+          int SiPMID = CaloShowerRO.SiPMID();
+          if (SiPMID >= 0 && SiPMID < nWaveforms) ++roOffsets_[SiPMID+1];
+      }
+      std::partial_sum(roOffsets_.begin(),roOffsets_.end(),roOffsets_.begin());
+
+      roIndices_.resize(roOffsets_.back());
+      roFill_.assign(roOffsets_.begin(),roOffsets_.end()-1);
+      for (unsigned i=0;i<CaloShowerROs.size();++i)
+      {
+          int SiPMID = CaloShowerROs[i].SiPMID();
+          if (SiPMID >= 0 && SiPMID < nWaveforms) roIndices_[roFill_[SiPMID]++] = i;
       }
   }
 
 
-  // Note: If all CaloShowerRO are ordered by SiPM ID -> loop can be more efficient by storing the counter value
-  // Not sure if this is the case with the bkg mixing
   //----------------------------------------------------------------------------------------------------------
   void CaloDigiMaker::fillROHits(int iRO, std::vector<double>& waveform, const CaloShowerROCollection& CaloShowerROs,
                                  const ConditionsHandle<CalorimeterCalibrations>& calorimeterCalibrations)
   {
+      if (roOffsets_[iRO+1] == roOffsets_[iRO]) return;
       double scaleFactor = calorimeterCalibrations->MeV2ADC(iRO)/calorimeterCalibrations->peMeV(iRO);
 
-      for (const auto& CaloShowerRO : CaloShowerROs)
+      for (unsigned idx=roOffsets_[iRO]; idx<roOffsets_[iRO+1]; ++idx)
       {
-          int SiPMID = CaloShowerRO.SiPMID();
-          if (SiPMID != iRO) continue;
+          const auto& CaloShowerRO = CaloShowerROs[roIndices_[idx]];
           for (const float PEtime : CaloShowerRO.PETime())
           {        
               float       time           = PEtime - blindTime_;         
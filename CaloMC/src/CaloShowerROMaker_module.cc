@@ -94,6 +94,7 @@ namespace mu2e {
              fhicl::Atom<bool>               PEStatCorrection         { Name("PEStatCorrection"),         Comment("Include PE Poisson fluctuations") };
              fhicl::Atom<bool>               addTravelTime            { Name("addTravelTime"),            Comment("Include light propagation time") };
              fhicl::Atom<int>                diagLevel                { Name("diagLevel"),                Comment("Diag Level"),0 };
+             fhicl::Sequence<art::InputTag>  caloShowerROOverlays     { Name("caloShowerROOverlays"),     Comment("Pre-digitized CaloShowerRO and CaloShowerSim frames to add to the output"), std::vector<art::InputTag>{} };
          };
 
          explicit CaloShowerROMaker(const art::EDProducer::Table<Config>& config) :
@@ -112,6 +113,11 @@ namespace mu2e {
              // the following consumes statements are necessary because SimParticleTimeOffset::updateMap calls getValidHandle.
              for (auto const& tag : config().caloShowerStepCollection()) crystalShowerTokens_.push_back(consumes<CaloShowerStepCollection>(tag));
              for (auto const& tag : config().timeOffsets().inputs()) consumes<SimParticleTimeMap>(tag);
+             for (auto const& tag : config().caloShowerROOverlays())
+             {
+                 overlayROTokens_.push_back(consumes<CaloShowerROCollection>(tag));
+                 overlaySimTokens_.push_back(consumes<CaloShowerSimCollection>(tag));
+             }
              produces<CaloShowerROCollection>();
              produces<CaloShowerSimCollection>();
          }
@@ -130,6 +136,8 @@ namespace mu2e {
          void  dumpCaloShowerSim (const CaloShowerSimCollection& caloShowerSims);
 
          std::vector<art::ProductToken<CaloShowerStepCollection>> crystalShowerTokens_;
+         std::vector<art::ProductToken<CaloShowerROCollection>>   overlayROTokens_;
+         std::vector<art::ProductToken<CaloShowerSimCollection>>  overlaySimTokens_;
          SimParticleTimeOffset   toff_;
          float                   blindTime_;
          float                   mbtime_;
@@ -190,6 +198,18 @@ namespace mu2e {
       
       makeReadoutHits(newCrystalShowerTokens, *CaloShowerROs, *caloShowerSims);
 
+      // Overlay pre-digitized frames, their PE times are already folded in the microbunch
+      for (const auto& token : overlayROTokens_)
+      {
+          const auto& ROs = *event.getValidHandle(token);
+          CaloShowerROs->insert(CaloShowerROs->end(), ROs.begin(), ROs.end());
+      }
+      for (const auto& token : overlaySimTokens_)
+      {
+          const auto& sims = *event.getValidHandle(token);
+          caloShowerSims->insert(caloShowerSims->end(), sims.begin(), sims.end());
+      }
+
       // Add the output hit collection to the event
       event.put(std::move(CaloShowerROs));
       event.put(std::move(caloShowerSims));
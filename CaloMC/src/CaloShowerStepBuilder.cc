@@ -0,0 +1,173 @@
+#include "CaloMC/inc/CaloShowerStepBuilder.hh"
+#include "CaloMC/inc/ShowerStepUtil.hh"
+#include "CalorimeterGeom/inc/Calorimeter.hh"
+
+#include "CLHEP/Vector/ThreeVector.h"
+
+#include <algorithm>
+#include <iostream>
+
+
+namespace mu2e {
+
+   CaloShowerStepBuilder::CaloShowerStepBuilder(unsigned numZSlices, double deltaTime, bool compressData, double eDepThreshold, int diagLevel) :
+      numZSlices_(numZSlices),
+      deltaTime_(deltaTime),
+      compressData_(compressData),
+      eDepThreshold_(eDepThreshold),
+      diagLevel_(diagLevel),
+      cal_(nullptr),
+      inside_(),
+      zSliceSize_(0),
+      ancestorsMap_(),
+      simToAncestorMap_(),
+      summary_()
+   {}
+
+
+   //------------------------------------------------------------------------------------------------------------------
+   void CaloShowerStepBuilder::beginEvent(const Calorimeter& cal, InsideCheck inside)
+   {
+       cal_        = &cal;
+       inside_     = inside;
+       zSliceSize_ = cal.caloInfo().getDouble("crystalZLength")/float(numZSlices_)+1e-5;
+       ancestorsMap_.clear();
+       simToAncestorMap_.clear();
+       summary_.reset();
+   }
+
+
+   //------------------------------------------------------------------------------------------------------------------
+   // Collect the StepPointMC's produced by each SimParticle Ancestor
+   void CaloShowerStepBuilder::addSteps(const StepPointMCCollection& steps, const SimLookup& sims)
+   {
+       for (const auto& step : steps)
+       {
+           SimPtr sim = step.simParticle();
+           const SimParticle* simp = sims(sim);
+
+           std::vector<SimPtr> inspectedSims;
+           while (simp != nullptr && simp->hasParent() && isInsideCalorimeter(*simp) )
+           {
+               //simparticle starting in one section and ending in another one see note in CaloShowerStepMaker
+               if (!cal_->geomUtil().isContainedSection(simp->startPosition(),simp->endPosition()) ) break;
+
+               const auto alreadyInspected = simToAncestorMap_.find(sim);
+               if (alreadyInspected != simToAncestorMap_.end()) {sim = alreadyInspected->second; break;}
+
+               inspectedSims.push_back(sim);
+               sim  = simp->parent();
+               simp = sims(sim);
+           }
+
+           for (const SimPtr& inspectedSim : inspectedSims) simToAncestorMap_[inspectedSim] = sim;
+           ancestorsMap_[sim].fill(step,inspectedSims);
+
+           summary_.totalEdep_ += step.totalEDep();
+       }
+       summary_.totalStep_ += steps.size();
+   }
+
+
+   //---------------------------------------------------------------------------------------------------------------
+   //Loop over ancestor simParticles, check if they are compressible, and produce the corresponding caloShowerStepMC
+   void CaloShowerStepBuilder::makeShowerSteps(CaloShowerStepCollection& caloShowerSteps, SimParticlePtrCollection& simsToKeep)
+   {
+       std::set<SimPtr> SimsToKeepUnique;
+       for (const auto& iter : ancestorsMap_)
+       {
+           const SimPtr&       sim  = iter.first;
+           const CompressUtil& info = iter.second;
+
+           summary_.totalSim_ += info.sims().size();
+
+           std::map<int,std::vector<const StepInfo*>> crystalMap;
+           for (const StepInfo& step : info.steps()) crystalMap[step.volumeId_].push_back(&step);
+
+           for (const auto& iterCrystal : crystalMap)
+           {
+               int crid = iterCrystal.first;
+               std::vector<const StepInfo*> steps = iterCrystal.second;
+
+               //Filter very small energy deposits at this stage
+               double eDep(0);
+               for (const auto& step : steps) eDep += step->totalEDep_;
+               if (eDep < eDepThreshold_) continue;
+
+               if (compressData_)
+               {
+                   SimsToKeepUnique.insert(sim);
+                   compressSteps(caloShowerSteps, crid, sim, steps);
+                   if (ancestorMonitor_) ancestorMonitor_(sim,info.sims());
+               }
+               else
+               {
+                   std::map<SimPtr, std::vector<const StepInfo*>> newSimStepMap;
+                   for (const StepInfo* step : steps) newSimStepMap[step->sim_].push_back(step);
+                   for (auto& iter : newSimStepMap)
+                   {
+                       compressSteps(caloShowerSteps, crid, iter.first, iter.second);
+                       SimsToKeepUnique.insert(iter.first);
+                   }
+               }
+           }
+           ++summary_.ncompressInfo_;
+           if (compressData_) ++summary_.nCompress_;
+       }
+
+       //dump the unique set of SimParticles to keep into final vector
+       simsToKeep.assign(SimsToKeepUnique.begin(),SimsToKeepUnique.end());
+   }
+
+
+   //-------------------------------------------------------------------------------------------------------------------------
+   bool CaloShowerStepBuilder::isInsideCalorimeter(const SimParticle& sim) const
+   {
+       if (inside_) return inside_(sim);
+       return cal_->geomUtil().isInsideCalorimeter(sim.startPosition());
+   }
+
+
+   //-------------------------------------------------------------------------------------------------------------------------------
+   void CaloShowerStepBuilder::compressSteps(CaloShowerStepCollection& caloShowerSteps, int volId, const SimPtr& sim,
+                                             std::vector<const StepInfo*>& steps)
+   {
+      auto sortFunctor = [](const StepInfo* a, const StepInfo* b) {return a->time_ < b->time_;};
+      std::sort(steps.begin(), steps.end(), sortFunctor);
+
+      ShowerStepUtil buffer(numZSlices_, ShowerStepUtil::weight_type::energy );
+
+      for (const StepInfo* step : steps)
+      {
+          CLHEP::Hep3Vector pos  = cal_->geomUtil().mu2eToCrystal(volId,step->position_);
+          int               idx  = int(std::max(1e-6,pos.z())/zSliceSize_);
+
+          if (buffer.entries(idx)>0 && (step->time_-buffer.t0(idx) > deltaTime_) )
+          {
+              if (bucketMonitor_) bucketMonitor_(idx,buffer.energyG4(idx),sim);
+              if (diagLevel_ > 2) {std::cout<<"[CaloShowerStepBuilder::compressSteps] inserted  "; buffer.printBucket(idx);}
+              summary_.totalChk_ += buffer.entries(idx);
+
+              caloShowerSteps.push_back(CaloShowerStep(volId, sim, buffer.entries(idx), buffer.time(idx), buffer.energyG4(idx),
+                                                       buffer.energyVis(idx),buffer.pIn(idx),buffer.pos(idx)));
+              buffer.reset(idx);
+          }
+
+          buffer.add(idx, step->totalEDep_, step->visibleEDep_, step->time_, step->momentum_, pos);
+      }
+
+      //do not forget to flush the final buffer(s) :-)
+      for (unsigned i=0;i<buffer.nBuckets();++i)
+      {
+          if (buffer.entries(i) == 0) continue;
+
+          if (bucketMonitor_) bucketMonitor_(i,buffer.energyG4(i),sim);
+          if (diagLevel_ > 2) {std::cout<<"[CaloShowerStepBuilder::compressSteps] inserted ";  buffer.printBucket(i);}
+          summary_.totalChk_ += buffer.entries(i);
+
+          caloShowerSteps.push_back(CaloShowerStep(volId, sim,  buffer.entries(i), buffer.time(i), buffer.energyG4(i),
+                                                   buffer.energyVis(i),buffer.pIn(i),buffer.pos(i)));
+      }
+   }
+
+}
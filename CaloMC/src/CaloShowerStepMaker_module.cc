@@ -28,7 +28,7 @@
 
 #include "CalorimeterGeom/inc/Calorimeter.hh"
 #include "GeometryService/inc/GeomHandle.hh"
-#include "CaloMC/inc/ShowerStepUtil.hh"
+#include "CaloMC/inc/CaloShowerStepBuilder.hh"
 #include "MCDataProducts/inc/PtrStepPointMCVectorCollection.hh"
 #include "MCDataProducts/inc/StepPointMCCollection.hh"
 #include "MCDataProducts/inc/SimParticlePtrCollection.hh"
@@ -51,44 +51,6 @@
 
 
 
-namespace {
-
-   class CaloCompressUtil 
-   {
-       public:
-           CaloCompressUtil() : steps_(), sims_(), procs_() {}
-
-           const std::vector<const mu2e::StepPointMC*>& steps()        const {return steps_;}
-           const std::set<art::Ptr<mu2e::SimParticle>>& sims()         const {return sims_;}
-           const std::set<int>&                         processCodes() const {return procs_;}
-
-           void fill(const mu2e::StepPointMC* step, std::vector<art::Ptr<mu2e::SimParticle>> sims)
-           {
-               steps_.push_back(step);
-               procs_.insert(step->endProcessCode());               
-               for (const auto& sim: sims) sims_.insert(sim); 
-           }
-
-        private:
-           std::vector<const mu2e::StepPointMC*> steps_;
-           std::set<art::Ptr<mu2e::SimParticle>> sims_;
-           std::set<int>                         procs_;                              
-   };
-
-
-   struct diagSummary
-   {
-       diagSummary() : totalEdep_(0.0),totalStep_(0),totalSim_(0),totalChk_(0),nCompress_(0),ncompressInfo_(0) {};
-       void reset() {totalEdep_=0.0;totalStep_=totalSim_=totalChk_=nCompress_=ncompressInfo_=0;}
-
-       float     totalEdep_;
-       unsigned  totalStep_,totalSim_,totalChk_,nCompress_,ncompressInfo_;
-   };
-
-} 
-
-
-
 namespace mu2e {
 
   class CaloShowerStepMaker : public art::EDProducer 
@@ -122,10 +84,8 @@ namespace mu2e {
          using SimStepMap   = std::map<SimPtr,std::vector<const StepPointMC*>>;
          
          void makeCompressedHits       (const HandleVector&, CaloShowerStepCollection&, SimParticlePtrCollection&);
-         void collectStepBySimAncestor (const Calorimeter&, const PhysicalVolumeMultiHelper&, const HandleVector&, std::map<SimPtr,CaloCompressUtil>&);
          void collectStepBySim         (const HandleVector&, SimStepMap&);
-         bool isInsideCalorimeter      (const Calorimeter& cal, const PhysicalVolumeMultiHelper&, const SimPtr&);
-         void compressSteps            (const Calorimeter&, CaloShowerStepCollection&, int, const SimPtr&, std::vector<const StepPointMC*>&);
+         bool isInsideCalorimeter      (const PhysicalVolumeMultiHelper&, const SimParticle&);
          void fillHisto1               (const Calorimeter&, const SimPtr&, const std::set<SimPtr>&);
          void fillHisto2               (int, float, const SimPtr&);
          void dumpAllInfo              (const HandleVector&, const Calorimeter&);
@@ -142,9 +102,7 @@ namespace mu2e {
          double                                   eDepThreshold_;
          int                                      diagLevel_;
          const PhysicalVolumeInfoMultiCollection* vols_;
-         double                                   zSliceSize_;
-
-         diagSummary                              diagSummary_;
+         CaloShowerStepBuilder                    builder_;
          TH2F*                                    hStartPos_;
          TH2F*                                    hStopPos_;
          TH1F*                                    hStopPos2_;
@@ -170,8 +128,7 @@ namespace mu2e {
      eDepThreshold_        (config().eDepThreshold()),  
      diagLevel_            (config().diagLevel()),
      vols_(),
-     zSliceSize_(0),
-     diagSummary_()
+     builder_(numZSlices_, deltaTime_, compressData_, eDepThreshold_, diagLevel_)
      {           
          consumesMany<StepPointMCCollection>();
          produces<CaloShowerStepCollection>();
@@ -223,7 +180,6 @@ namespace mu2e {
   //
   void CaloShowerStepMaker::produce(art::Event& event)
   {
-      diagSummary_.reset();
       if (diagLevel_ > 0) std::cout << "[CaloShowerStepMaker::produce] begin" << std::endl;
 
       auto caloShowerStepMCs = std::make_unique<CaloShowerStepCollection>();
@@ -253,71 +209,33 @@ namespace mu2e {
       PhysicalVolumeMultiHelper vi(*vols_);
 
       const Calorimeter& cal = *(GeomHandle<Calorimeter>());
-      zSliceSize_            = cal.caloInfo().getDouble("crystalZLength")/float(numZSlices_)+1e-5;
+
+      CaloShowerStepBuilder::InsideCheck inside;
+      if (usePhysVol_) inside = [this,&vi](const SimParticle& sim) {return isInsideCalorimeter(vi,sim);};
+      builder_.beginEvent(cal,inside);
+      if (diagLevel_ > 1) builder_.setMonitors([this,&cal](const SimPtr& sim, const std::set<SimPtr>& sims) {fillHisto1(cal,sim,sims);},
+                                               [this](int idx, float edep, const SimPtr& sim) {fillHisto2(idx,edep,sim);});
 
 
       //-----------------------------------------------------------------
       // Collect the StepPointMC's produced by each SimParticle Ancestor
-      std::map<SimPtr,CaloCompressUtil> crystalAncestorsMap;
-      collectStepBySimAncestor(cal,vi,crystalStepsHandle,crystalAncestorsMap);
+      auto sims = [](const SimPtr& sim) {return sim.get();};
+      for (const auto& handle : crystalStepsHandle) builder_.addSteps(*handle,sims);
       
       if (diagLevel_ > 2) dumpAllInfo(crystalStepsHandle,cal);
 
 
       //---------------------------------------------------------------------------------------------------------------
       //Loop over ancestor simParticles, check if they are compressible, and produce the corresponding caloShowerStepMC
-
-      std::set<SimPtr> SimsToKeepUnique;
-      for (const auto& iter : crystalAncestorsMap )
-      {
-          const SimPtr&           sim  = iter.first;
-          const CaloCompressUtil& info = iter.second;
-
-          diagSummary_.totalSim_ += info.sims().size();
-
-          std::map<int,std::vector<const StepPointMC*>> crystalMap;
-          for (const StepPointMC* step : info.steps()) crystalMap[step->volumeId()].push_back(step);
-
-          for (const auto& iterCrystal : crystalMap)
-          {
-              int crid = iterCrystal.first;
-              std::vector<const StepPointMC*> steps = iterCrystal.second;
-              
-              //Filter very small energy deposits at this stage
-              double eDep(0);
-              for (const auto& step : steps) eDep += step->totalEDep();
-              if (eDep < eDepThreshold_) continue;
-
-              if (compressData_)
-              {
-                  SimsToKeepUnique.insert(sim);
-                  compressSteps(cal, caloShowerStepMCs, crid, sim, steps);
-                  if (diagLevel_ > 1) fillHisto1(cal,sim,info.sims());
-              }
-              else
-              {
-                  std::map<SimPtr, std::vector<const StepPointMC*>> newSimStepMap;
-                  for (const StepPointMC* step : steps) newSimStepMap[step->simParticle()].push_back(step);
-                  for (auto& iter : newSimStepMap)
-                  {
-                      compressSteps(cal, caloShowerStepMCs, crid, iter.first, iter.second);
-                      SimsToKeepUnique.insert(iter.first);
-                  }
-              }
-          }
-          ++diagSummary_.ncompressInfo_;
-          if (compressData_) ++diagSummary_.nCompress_;
-      }
-      
-      //dump the unique set of SimParticles to keep into final vector
-      simsToKeep.assign(SimsToKeepUnique.begin(),SimsToKeepUnique.end());
+      builder_.makeShowerSteps(caloShowerStepMCs,simsToKeep);
 
       //---------------------------------------------------------------------------------------------------------------
       // Final diag info      
+      const auto& diagSummary = builder_.summary();
       if (diagLevel_ > 1) 
       {
-          hEtot_->Fill(diagSummary_.totalEdep_);
-          hStot_->Fill(diagSummary_.totalStep_);
+          hEtot_->Fill(diagSummary.totalEdep_);
+          hStot_->Fill(diagSummary.totalStep_);
           std::cout<<"CaloShowerStepMaker summary"<<std::endl;
           
           std::set<int> volIds{};
@@ -334,60 +252,19 @@ namespace mu2e {
       }      
       
       if (diagLevel_ > 0) 
-        std::cout << "[CaloShowerStepMaker::makeCompressedHits] compressed "<<diagSummary_.nCompress_<<" / "<<diagSummary_.ncompressInfo_<<" incoming SimParticles"<<std::endl
+        std::cout << "[CaloShowerStepMaker::makeCompressedHits] compressed "<<diagSummary.nCompress_<<" / "<<diagSummary.ncompressInfo_<<" incoming SimParticles"<<std::endl
                   << "[CaloShowerStepMaker::makeCompressedHits] keeping "<<simsToKeep.size()<<" SimParticles"<<std::endl
-                  << "[CaloShowerStepMaker::makeCompressedHits] Total sims init: " <<diagSummary_.totalSim_<<std::endl
+                  << "[CaloShowerStepMaker::makeCompressedHits] Total sims init: " <<diagSummary.totalSim_<<std::endl
                   << "[CaloShowerStepMaker::makeCompressedHits] Total caloShower steps: " <<caloShowerStepMCs.size()<<std::endl
-                  << "[CaloShowerStepMaker::makeCompressedHits] Total energy deposited / number of stepPointMC: " <<diagSummary_.totalEdep_<<" / "<<diagSummary_.totalStep_<<std::endl
-                  << "[CaloShowerStepMaker::makeCompressedHits] Total stepPointMCs seen: " <<diagSummary_.totalChk_<<std::endl;
-  }
-
-
-  //------------------------------------------------------------------------------------------------------------------
-  void CaloShowerStepMaker::collectStepBySimAncestor(const Calorimeter& cal, const PhysicalVolumeMultiHelper& vi,
-                                                     const HandleVector& stepsHandles, std::map<SimPtr,CaloCompressUtil>& ancestorsMap)
-  {
-     std::unordered_map<SimPtr,SimPtr> simToAncestorMap;
-     for (HandleVector::const_iterator i=stepsHandles.begin(), e=stepsHandles.end(); i != e; ++i )
-     {
-         const art::Handle<StepPointMCCollection>& handle(*i);
-         const StepPointMCCollection& steps(*handle);
-         for (const auto& step : steps )
-         {
-             SimPtr sim = step.simParticle();
-
-             SimParticlePtrCollection inspectedSims;
-             while (sim->hasParent() && isInsideCalorimeter(cal, vi, sim) )
-             {
-                 //simparticle starting in one section and ending in another one see note above
-                 if (!cal.geomUtil().isContainedSection(sim->startPosition(),sim->endPosition()) ) break;
-
-                 const auto alreadyInspected = simToAncestorMap.find(sim);
-                 if (alreadyInspected != simToAncestorMap.end()) {sim = alreadyInspected->second; break;}
-
-                 inspectedSims.push_back(sim);
-                 sim = sim->parent();
-             }
-
-             for (const SimPtr& inspectedSim : inspectedSims) simToAncestorMap[inspectedSim] = sim;
-             ancestorsMap[sim].fill(&step,inspectedSims);
-
-             diagSummary_.totalEdep_ += step.totalEDep();             
-         }
-         diagSummary_.totalStep_ += steps.size();
-      }   
+                  << "[CaloShowerStepMaker::makeCompressedHits] Total energy deposited / number of stepPointMC: " <<diagSummary.totalEdep_<<" / "<<diagSummary.totalStep_<<std::endl
+                  << "[CaloShowerStepMaker::makeCompressedHits] Total stepPointMCs seen: " <<diagSummary.totalChk_<<std::endl;
   }
 
 
-
-
-
   //-------------------------------------------------------------------------------------------------------------------------
-  bool CaloShowerStepMaker::isInsideCalorimeter(const Calorimeter& cal, const PhysicalVolumeMultiHelper& vi, 
-                                                const art::Ptr<SimParticle>& thisSimPtr)
+  bool CaloShowerStepMaker::isInsideCalorimeter(const PhysicalVolumeMultiHelper& vi, const SimParticle& sim)
   {
-      if (usePhysVol_) return mapPhysVol_.find(&vi.startVolume(*thisSimPtr)) != mapPhysVol_.end();   
-      return cal.geomUtil().isInsideCalorimeter(thisSimPtr->startPosition());
+      return mapPhysVol_.find(&vi.startVolume(sim)) != mapPhysVol_.end();   
   }
 
   //-----------------------------------------------------------------------------------------------------------------------------------------------
@@ -403,48 +280,6 @@ namespace mu2e {
   }
 
 
-  //-------------------------------------------------------------------------------------------------------------------------------
-  void CaloShowerStepMaker::compressSteps(const Calorimeter& cal, CaloShowerStepCollection &caloShowerStepMCs,
-                                          int volId, const SimPtr& sim, std::vector<const StepPointMC*>& steps)
-  {
-     auto sortFunctor = [](const StepPointMC* a, const StepPointMC* b) {return a->time() < b->time();};
-     std::sort(steps.begin(), steps.end(), sortFunctor);
-
-     ShowerStepUtil buffer(numZSlices_, ShowerStepUtil::weight_type::energy );
-
-     for (const StepPointMC* step : steps)
-     {
-         CLHEP::Hep3Vector pos  = cal.geomUtil().mu2eToCrystal(volId,step->position());
-         int               idx  = int(std::max(1e-6,pos.z())/zSliceSize_);
-
-         if (buffer.entries(idx)>0 && (step->time()-buffer.t0(idx) > deltaTime_) )
-         {
-             if (diagLevel_ > 1) {fillHisto2(idx,buffer.energyG4(idx),sim);}
-             if (diagLevel_ > 2) {std::cout<<"[CaloShowerStepMaker::compressSteps] inserted  "; buffer.printBucket(idx);}
-             diagSummary_.totalChk_ += buffer.entries(idx);
- 
-             caloShowerStepMCs.push_back(CaloShowerStep(volId, sim, buffer.entries(idx), buffer.time(idx), buffer.energyG4(idx), 
-                                                        buffer.energyVis(idx),buffer.pIn(idx),buffer.pos(idx)));
-             buffer.reset(idx);
-         }
-
-         buffer.add(idx, step->totalEDep(), step->visibleEDep(), step->time(), step->momentum().mag(), pos);
-     }
-
-     //do not forget to flush the final buffer(s) :-)
-     for (unsigned i=0;i<buffer.nBuckets();++i)
-     {
-         if (buffer.entries(i) == 0) continue;
-
-         if (diagLevel_ > 1) {fillHisto2(i,buffer.energyG4(i),sim);}
-         if (diagLevel_ > 2) {std::cout<<"[CaloShowerStepMaker::compressSteps] inserted ";  buffer.printBucket(i);}
-         diagSummary_.totalChk_ += buffer.entries(i);
-
-         caloShowerStepMCs.push_back(CaloShowerStep(volId, sim,  buffer.entries(i), buffer.time(i), buffer.energyG4(i), 
-                                                    buffer.energyVis(i),buffer.pIn(i),buffer.pos(i)));
-     }
-  }
-
   //-------------------------------------------------------------------------------------------------------------
   void CaloShowerStepMaker::fillHisto1(const Calorimeter& cal, const art::Ptr<SimParticle>& sim, const std::set<art::Ptr<SimParticle>>& infoSims)
   {
@@ -26,6 +26,8 @@
 #include "art_root_io/TFileService.h"
 
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "MCDataProducts/inc/StrawDigiMCCollection.hh"
 #include "MCDataProducts/inc/CrvDigiMC.hh"
@@ -41,7 +43,6 @@
 #include "Mu2eUtilities/inc/compressSimParticleCollection.hh"
 #include "MCDataProducts/inc/GenParticleCollection.hh"
 #include "MCDataProducts/inc/SimParticleTimeMap.hh"
-#include "MCDataProducts/inc/SimParticleRemapping.hh"
 #include "DataProducts/inc/IndexMap.hh"
 #include "MCDataProducts/inc/CrvCoincidenceClusterMCCollection.hh"
 #include "MCDataProducts/inc/PrimaryParticle.hh"
@@ -50,40 +51,160 @@
 namespace mu2e {
   class CompressDigiMCs;
 
-  typedef std::set<art::Ptr<SimParticle> > SimParticleSet;
+  // codes stored in place of a new index
+  struct PtrRemapCode {
+    static constexpr int notSet = -1;  // not copied
+    static constexpr int nullPtr = -2; // "copied" as a null Ptr
+  };
 
-  class SimParticleSelector {
+  // the new index of an old key, for dense keys (vector indexed by key)...
+  inline int remapLookup(const std::vector<int>& indices, size_t key) {
+    return key < indices.size() ? indices[key] : PtrRemapCode::notSet;
+  }
+  inline bool remapStore(std::vector<int>& indices, size_t key, int index) {
+    if (key >= indices.size()) {
+      indices.resize(key+1, PtrRemapCode::notSet);
+    }
+    bool added = indices[key] == PtrRemapCode::notSet;
+    indices[key] = index;
+    return added;
+  }
+  // ...and for sparse keys (hash map)
+  inline int remapLookup(const std::unordered_map<size_t,int>& indices, size_t key) {
+    auto it = indices.find(key);
+    return it == indices.end() ? PtrRemapCode::notSet : it->second;
+  }
+  inline bool remapStore(std::unordered_map<size_t,int>& indices, size_t key, int index) {
+    return indices.insert_or_assign(key, index).second;
+  }
+
+  // Maps an old object, by the (ProductID, key) of its art::Ptr, to the index of its
+  // copy in the new collection (or its new key for SimParticles).  Each input product
+  // has its own Indices container: a vector indexed by key for the steps, whose keys
+  // are dense, or a hash map for the SimParticles, whose keys are sparse (they start at
+  // large offsets for each simulation stage and mixed frame).  There are only a few
+  // input products, so they are found by a linear search, and the containers are kept
+  // from event to event so that their storage is reused.
+  template <typename Indices>
+  class PtrRemap : public PtrRemapCode {
   public:
-    SimParticleSelector(const SimParticleSet& simPartSet) {
-      for (const auto& i_simPart : simPartSet) {
-        cet::map_vector_key key = cet::map_vector_key(i_simPart.key());
-        m_keys.insert(key);
+    PtrRemap() : m_nUsed(0), m_last(0) {}
+
+    // forget the previous event but keep the storage
+    void clear() {
+      m_nUsed = 0;
+      m_last = 0;
+    }
+
+    bool hasProduct(const art::ProductID& pid) const {
+      return findProduct(pid) != nullptr;
+    }
+
+    int get(const art::ProductID& pid, size_t key) const {
+      const Product* product = findProduct(pid);
+      return product == nullptr ? notSet : remapLookup(product->indices, key);
+    }
+
+    template<typename T>
+    bool has(const art::Ptr<T>& ptr) const {
+      return get(ptr.id(), ptr.key()) != notSet;
+    }
+
+    void set(const art::ProductID& pid, size_t key, int index) {
+      Product& product = useProduct(pid);
+      if (remapStore(product.indices, key, index)) {
+        ++product.nSet;
       }
     }
 
-    bool operator[]( cet::map_vector_key key ) const {
-      return m_keys.find(key) != m_keys.end();
+    // the number of keys that have been set for this product
+    size_t size(const art::ProductID& pid) const {
+      const Product* product = findProduct(pid);
+      return product == nullptr ? 0 : product->nSet;
     }
 
-    const std::set<cet::map_vector_key>& keys() const {
-      return m_keys;
+    const Indices& indices(const art::ProductID& pid) const {
+      static const Indices none;
+      const Product* product = findProduct(pid);
+      return product == nullptr ? none : product->indices;
     }
 
-    void clear() {
-      m_keys.clear();
+    // The Ptr to the copy of an old object, throws if it was not copied
+    template<typename T>
+    art::Ptr<T> newPtr(const art::Ptr<T>& oldPtr, const art::ProductID& newPID, const art::EDProductGetter* newGetter) const {
+      int index = get(oldPtr.id(), oldPtr.key());
+      if (index == notSet) {
+        throw cet::exception("CompressDigiMCs") << "No copy was made of the object with ProductID "
+                                                << oldPtr.id() << " and key " << oldPtr.key() << std::endl;
+      }
+      if (index == nullPtr) {
+        return art::Ptr<T>();
+      }
+      return art::Ptr<T>(newPID, index, newGetter);
+    }
+
+  private:
+    struct Product {
+      art::ProductID pid;
+      Indices indices;
+      size_t nSet;
+    };
+
+    const Product* findProduct(const art::ProductID& pid) const {
+      for (size_t i = 0; i < m_nUsed; ++i) {
+        if (m_products[i].pid == pid) {
+          return &m_products[i];
+        }
+      }
+      return nullptr;
+    }
+
+    Product& useProduct(const art::ProductID& pid) {
+      if (m_last < m_nUsed && m_products[m_last].pid == pid) {
+        return m_products[m_last];
+      }
+      for (size_t i = 0; i < m_nUsed; ++i) {
+        if (m_products[i].pid == pid) {
+          m_last = i;
+          return m_products[i];
+        }
+      }
+      if (m_nUsed == m_products.size()) {
+        m_products.emplace_back();
+      }
+      Product& product = m_products[m_nUsed];
+      product.pid = pid;
+      product.indices.clear();
+      product.nSet = 0;
+      m_last = m_nUsed++;
+      return product;
+    }
+
+    std::vector<Product> m_products;
+    size_t m_nUsed;
+    size_t m_last;
+  };
+
+  typedef PtrRemap<std::vector<int> > PtrIndexRemap;
+  typedef PtrRemap<std::unordered_map<size_t,int> > PtrKeyRemap;
+
+  // Selects the SimParticles that have a new key for compressSimParticleCollection
+  class SimParticleSelector {
+  public:
+    SimParticleSelector(const std::unordered_map<size_t,int>& newKeys) : m_newKeys(newKeys) { }
+
+    bool operator[]( cet::map_vector_key key ) const {
+      return m_newKeys.find(key.asUint()) != m_newKeys.end();
     }
 
   private:
-    std::set<cet::map_vector_key> m_keys;
+    const std::unordered_map<size_t,int>& m_newKeys;
 
   };
 
   typedef std::string InstanceLabel;
   typedef std::map<cet::map_vector_key, cet::map_vector_key> KeyRemap;
-  typedef std::map<art::Ptr<mu2e::StepPointMC>, art::Ptr<mu2e::StepPointMC> > StepPointMCRemap;
   typedef std::map<art::Ptr<mu2e::StrawGasStep>, art::Ptr<mu2e::StrawGasStep> > StrawGasStepRemap;
-  typedef std::map<art::Ptr<mu2e::CaloShowerStep>, art::Ptr<mu2e::CaloShowerStep> > CaloShowerStepRemap;
-  typedef std::map<art::Ptr<mu2e::CrvStep>, art::Ptr<mu2e::CrvStep> > CrvStepRemap;
 }
 
 
@@ -135,9 +256,10 @@ public:
   art::Ptr<StrawGasStep> copyStrawGasStep(const mu2e::StrawGasStep& old_step);
   art::Ptr<CrvStep> copyCrvStep(const mu2e::CrvStep& old_step);
   art::Ptr<mu2e::CaloShowerStep> copyCaloShowerStep(const mu2e::CaloShowerStep& old_calo_shower_step);
-  void copyCaloShowerSim(const mu2e::CaloShowerSim& old_calo_shower_sim, const CaloShowerStepRemap& remap);
-  void copyCaloShowerRO(const mu2e::CaloShowerRO& old_calo_shower_step_ro, const CaloShowerStepRemap& remap);
+  void copyCaloShowerSim(const mu2e::CaloShowerSim& old_calo_shower_sim);
+  void copyCaloShowerRO(const mu2e::CaloShowerRO& old_calo_shower_step_ro);
   void keepSimParticle(const art::Ptr<SimParticle>& sim_ptr);
+  art::Ptr<SimParticle> newSimPtr(const art::Ptr<SimParticle>& old_sim_ptr) const;
   void copyCaloClusterMC(const mu2e::CaloClusterMC& old_calo_cluster_mc);
   art::Ptr<CaloHitMC> copyCaloHitMC(const mu2e::CaloHitMC& old_calo_hit_mc);
   void copyCrvCoincClusterMC(const mu2e::CrvCoincidenceClusterMC& old_crv_coinc_cluster_mc);
@@ -197,12 +319,15 @@ private:
   const art::EDProductGetter* _newGenParticleGetter;
   art::ProductID _newCaloShowerStepsPID;
   const art::EDProductGetter* _newCaloShowerStepGetter;
-  std::map<art::ProductID, const art::EDProductGetter*> _oldCaloShowerStepGetter;
   art::ProductID _newCaloHitMCsPID;
   const art::EDProductGetter* _newCaloHitMCGetter;
 
   // record the SimParticles that we are keeping so we can use compressSimParticleCollection to do all the work for us
-  std::map<art::ProductID, SimParticleSet> _simParticlesToKeep;
+  // (the old key until the collections are compressed, then the new key)
+  PtrKeyRemap _simParticlesToKeep;
+
+  // where the steps were copied to
+  PtrIndexRemap _caloShowerStepRemap;
 
   std::vector<InstanceLabel> _newStepPointMCInstances;
 
@@ -223,9 +348,8 @@ private:
 
   // For CrvDigiMCs, there's a chance that the same StepPointMC will go into multiple CrvDigiMCs
   // This module didn't take this into account initially and so the same StepPointMC was being written out multiple times
-  // This std::set is used to make sure that this doesn't happen
-  std::set<art::Ptr<CrvStep> > _crvStepsSeen;
-  std::map<art::Ptr<CrvStep>, art::Ptr<CrvStep> > _crvStepsMap;
+  // This remap is used to make sure that this doesn't happen
+  PtrIndexRemap _crvStepRemap;
 
   bool _noCompression;
 };
@@ -328,13 +452,14 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
   // Create all the new collections, ProductIDs and product getters for the SimParticles and GenParticles
   // There is one for each background frame plus one for the primary event
   unsigned int n_gen_particles_to_keep = 0;
+  _simParticlesToKeep.clear();
+  _crvStepRemap.clear();
+  _caloShowerStepRemap.clear();
   for (std::vector<art::InputTag>::const_iterator i_tag = _simParticleTags.begin(); i_tag != _simParticleTags.end(); ++i_tag) {
     const auto& oldSimParticles = event.getValidHandle<SimParticleCollection>(*i_tag);
     art::ProductID i_product_id = oldSimParticles.id();
     const art::EDProductGetter* i_product_getter = event.productGetter(i_product_id);
 
-    _simParticlesToKeep[i_product_id].clear();
-
     if (_keepAllGenParticles || _noCompression) {
       // Add all the SimParticles that are also GenParticles
       for (const auto& i_oldSimParticle : *oldSimParticles) {
@@ -426,9 +551,6 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
 
 
   if (_crvDigiMCTag != "") {
-    _crvStepsSeen.clear();
-    _crvStepsMap.clear();
-
     event.getByLabel(_crvDigiMCTag, _crvDigiMCsHandle);
     const auto& crvDigiMCs = *_crvDigiMCsHandle;
     for (size_t i = 0; i < crvDigiMCs.size(); ++i) {
@@ -452,19 +574,18 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
   // Two possible compressions for calorimeter
   // The first just takes the CaloShowerSteps, CaloShowerSims and CaloShowerROs and reassigns Ptrs (i.e. no actual compression....)
   if (_caloShowerStepTags.size() != 0) {
-    CaloShowerStepRemap caloShowerStepRemap;
     _newCaloShowerSteps = std::unique_ptr<CaloShowerStepCollection>(new CaloShowerStepCollection);
     _newCaloShowerStepsPID = event.getProductID<CaloShowerStepCollection>();
     _newCaloShowerStepGetter = event.productGetter(_newCaloShowerStepsPID);
     for (std::vector<art::InputTag>::const_iterator i_tag = _caloShowerStepTags.begin(); i_tag != _caloShowerStepTags.end(); ++i_tag) {
       const auto& oldCaloShowerSteps = event.getValidHandle<CaloShowerStepCollection>(*i_tag);
       art::ProductID i_product_id = oldCaloShowerSteps.id();
-      _oldCaloShowerStepGetter[i_product_id] = event.productGetter(i_product_id);
 
+      _newCaloShowerSteps->reserve(_newCaloShowerSteps->size() + oldCaloShowerSteps->size());
       for (CaloShowerStepCollection::const_iterator i_caloShowerStep = oldCaloShowerSteps->begin(); i_caloShowerStep != oldCaloShowerSteps->end(); ++i_caloShowerStep) {
-        art::Ptr<mu2e::CaloShowerStep> oldShowerStepPtr(i_product_id,  i_caloShowerStep - oldCaloShowerSteps->begin(), _oldCaloShowerStepGetter[i_product_id]);
         art::Ptr<mu2e::CaloShowerStep> newShowerStepPtr = copyCaloShowerStep(*i_caloShowerStep);
-        caloShowerStepRemap[oldShowerStepPtr] = newShowerStepPtr;
+        int newIndex = newShowerStepPtr.isNull() ? PtrRemapCode::nullPtr : newShowerStepPtr.key();
+        _caloShowerStepRemap.set(i_product_id, i_caloShowerStep - oldCaloShowerSteps->begin(), newIndex);
       }
     }
 
@@ -472,14 +593,14 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
     event.getByLabel(_caloShowerSimTag, _caloShowerSimsHandle);
     const auto& caloShowerSims = *_caloShowerSimsHandle;
     for (const auto& i_caloShowerSim : caloShowerSims) {
-      copyCaloShowerSim(i_caloShowerSim, caloShowerStepRemap);
+      copyCaloShowerSim(i_caloShowerSim);
     }
 
     _newCaloShowerROs = std::unique_ptr<CaloShowerROCollection>(new CaloShowerROCollection);
     event.getByLabel(_caloShowerROTag, _CaloShowerROsHandle);
     const auto& CaloShowerROs = *_CaloShowerROsHandle;
     for (const auto& i_CaloShowerRO : CaloShowerROs) {
-      copyCaloShowerRO(i_CaloShowerRO, caloShowerStepRemap);
+      copyCaloShowerRO(i_CaloShowerRO);
     }
   }
 
@@ -509,54 +630,39 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
   for (std::vector<art::InputTag>::const_iterator i_tag = _extraStepPointMCTags.begin(); i_tag != _extraStepPointMCTags.end(); ++i_tag) {
     const auto& stepPointMCs = event.getValidHandle<StepPointMCCollection>(*i_tag);
     for (const auto& stepPointMC : *stepPointMCs) {
-      for (const auto& simPartsToKeep : _simParticlesToKeep) {
-        const art::ProductID& oldProdID = simPartsToKeep.first;
-        if (stepPointMC.simParticle().id() != oldProdID) {
-          continue;
-        }
-        if (!_noCompression) { // if we want to compress
-          const SimParticleSet& alreadyKeptSimParts = simPartsToKeep.second;
-          for (const auto& alreadyKeptSimPart : alreadyKeptSimParts) {
-            if (stepPointMC.simParticle() == alreadyKeptSimPart) {
-              copyStepPointMC(stepPointMC, (*i_tag).instance() );
-            }
-          }
-        }
-        else { // if we don't want to compress
+      if (!_noCompression) { // if we want to compress
+        if (_simParticlesToKeep.has(stepPointMC.simParticle())) {
           copyStepPointMC(stepPointMC, (*i_tag).instance() );
         }
       }
+      else if (_simParticlesToKeep.hasProduct(stepPointMC.simParticle().id())) { // if we don't want to compress
+        copyStepPointMC(stepPointMC, (*i_tag).instance() );
+      }
     }
   }
 
   // Now compress the SimParticleCollections into their new collections
-  KeyRemap* keyRemap = new KeyRemap;
-  SimParticleRemapping remap;
+  KeyRemap keyRemap;
   unsigned int keep_size = 0;
   for (std::vector<art::InputTag>::const_iterator i_tag = _simParticleTags.begin(); i_tag != _simParticleTags.end(); ++i_tag) {
-    keyRemap->clear();
+    keyRemap.clear();
     const auto& oldSimParticles = event.getValidHandle<SimParticleCollection>(*i_tag);
     art::ProductID i_product_id = oldSimParticles.id();
-    SimParticleSelector simPartSelector(_simParticlesToKeep[i_product_id]);
-    keep_size += _simParticlesToKeep[i_product_id].size();
+    SimParticleSelector simPartSelector(_simParticlesToKeep.indices(i_product_id));
+    keep_size += _simParticlesToKeep.size(i_product_id);
     if (_rekeySimParticleCollection) {
       compressSimParticleCollection(_newSimParticlesPID, _newSimParticleGetter, *oldSimParticles,
-                                    simPartSelector, *_newSimParticles, keyRemap);
+                                    simPartSelector, *_newSimParticles, &keyRemap);
+
+      // Replace the old keys we kept with the new ones
+      for (const auto& i_keyPair : keyRemap) {
+        _simParticlesToKeep.set(i_product_id, i_keyPair.first.asUint(), i_keyPair.second.asUint());
+      }
     }
     else {
       compressSimParticleCollection(_newSimParticlesPID, _newSimParticleGetter, *oldSimParticles,
                                     simPartSelector, *_newSimParticles);
     }
-
-    // Fill out the SimParticleRemapping
-    for (const auto& i_keptSimPart : _simParticlesToKeep[i_product_id]) {
-      cet::map_vector_key oldKey = cet::map_vector_key(i_keptSimPart.key());
-      cet::map_vector_key newKey = oldKey;
-      if (_rekeySimParticleCollection) {
-        newKey = keyRemap->at(oldKey);
-      }
-      remap[i_keptSimPart] = art::Ptr<SimParticle>(_newSimParticlesPID, newKey.asUint(), _newSimParticleGetter);
-    }
   }
   if (keep_size != _newSimParticles->size()) {
     throw cet::exception("CompressDigiMCs") << "Number of SimParticles in output collection ("
@@ -589,10 +695,8 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
     SimParticleTimeMap& i_newTimeMap = *_newSimParticleTimeMaps.at(i_element);
     for (const auto& timeMapPair : i_oldTimeMap) {
       art::Ptr<SimParticle> oldSimPtr = timeMapPair.first;
-      const auto& newSimPtrIter = remap.find(oldSimPtr);
-      if (newSimPtrIter != remap.end()) {
-        art::Ptr<SimParticle> newSimPtr = newSimPtrIter->second;
-        i_newTimeMap[newSimPtr] = timeMapPair.second;
+      if (_simParticlesToKeep.has(oldSimPtr)) {
+        i_newTimeMap[newSimPtr(oldSimPtr)] = timeMapPair.second;
       }
     }
   }
@@ -600,30 +704,26 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
    // Update the StepPointMCs
   for (const auto& i_instance : _newStepPointMCInstances) {
     for (auto& i_stepPointMC : *_newStepPointMCs.at(i_instance)) {
-      art::Ptr<SimParticle> newSimPtr = remap.at(i_stepPointMC.simParticle());
-      i_stepPointMC.simParticle() = newSimPtr;
+      i_stepPointMC.simParticle() = newSimPtr(i_stepPointMC.simParticle());
     }
   }
  
   // Update the StrawGasSteps
   for (auto& i_strawGasStep : *_newStrawGasSteps) {
-    art::Ptr<SimParticle> newSimPtr = remap.at(i_strawGasStep.simParticle());
-    i_strawGasStep.simParticle() = newSimPtr;
+    i_strawGasStep.simParticle() = newSimPtr(i_strawGasStep.simParticle());
   }
 
   // Update the CrvSteps
   if (_crvDigiMCTag != "") {
     for (auto& i_crvStep : *_newCrvSteps) {
-      art::Ptr<SimParticle> newSimPtr = remap.at(i_crvStep.simParticle());
-      i_crvStep.simParticle() = newSimPtr;
+      i_crvStep.simParticle() = newSimPtr(i_crvStep.simParticle());
     }
   }
 
   if (_caloShowerStepTags.size() != 0) {
     // Update the CaloShowerSteps
     for (auto& i_caloShowerStep : *_newCaloShowerSteps) {
-      art::Ptr<SimParticle> newSimPtr = remap.at(i_caloShowerStep.simParticle());
-      i_caloShowerStep.setSimParticle(newSimPtr);
+      i_caloShowerStep.setSimParticle(newSimPtr(i_caloShowerStep.simParticle()));
     }
   }
 
@@ -632,7 +732,7 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
   if (_caloClusterMCTag != "") {
     for (auto& i_caloHitMC : *_newCaloHitMCs) {
       for (auto& i_caloMCEDep : i_caloHitMC.energyDeposits()) {
-        i_caloMCEDep.resetSim(remap.at(i_caloMCEDep.sim()));
+        i_caloMCEDep.resetSim(newSimPtr(i_caloMCEDep.sim()));
       }
     }
   }
@@ -640,41 +740,35 @@ void mu2e::CompressDigiMCs::produce(art::Event & event)
   // Update the CrvDigiMCs
   for (auto& i_crvDigiMC : *_newCrvDigiMCs) {
     art::Ptr<SimParticle> oldSimPtr = i_crvDigiMC.GetSimParticle();
-    art::Ptr<SimParticle> newSimPtr;
     if (oldSimPtr.isNonnull()) { // if the old CrvDigiMC doesn't have a null ptr for the SimParticle...
-      newSimPtr = remap.at(oldSimPtr);
+      i_crvDigiMC.setSimParticle(newSimPtr(oldSimPtr));
     }
     else {
-      newSimPtr = art::Ptr<SimParticle>();
+      i_crvDigiMC.setSimParticle(art::Ptr<SimParticle>());
     }
-    i_crvDigiMC.setSimParticle(newSimPtr);
   }
   // Update CrvCoincClusterMCs if needs be
   if (_crvCoincClusterMCTag != "") {
     for (auto& i_crvCoincClusterMC : *_newCrvCoincClusterMCs) {
       for (auto& i_pulseInfo : i_crvCoincClusterMC.GetModifiablePulses()) {
-        art::Ptr<SimParticle> oldSimPtr = i_pulseInfo._simParticle;
-        art::Ptr<SimParticle> newSimPtr = remap.at(oldSimPtr);
-        i_pulseInfo._simParticle = newSimPtr;
+        i_pulseInfo._simParticle = newSimPtr(i_pulseInfo._simParticle);
       }
 
-      art::Ptr<SimParticle> oldSimPtr = i_crvCoincClusterMC.GetMostLikelySimParticle();
-      art::Ptr<SimParticle> newSimPtr = remap.at(oldSimPtr);
-      i_crvCoincClusterMC.SetMostLikelySimParticle(newSimPtr);
+      i_crvCoincClusterMC.SetMostLikelySimParticle(newSimPtr(i_crvCoincClusterMC.GetMostLikelySimParticle()));
     }
   }
   // Update PrimaryParticle if needs be
   if (_primaryParticleTag != "") {
     for (auto& i_simPartPtr : _newPrimaryParticle->modifySimParticles()) {
-      i_simPartPtr = remap.at(i_simPartPtr);
+      i_simPartPtr = newSimPtr(i_simPartPtr);
     }
   }
   // Create new MC Trajectory collection
   if (_mcTrajectoryTag != "") {
     for (const auto& i_mcTrajectory : *_mcTrajectoriesHandle) {
       art::Ptr<SimParticle> oldSimPtr = i_mcTrajectory.first;
-      if (remap.find(oldSimPtr) != remap.end()) {
-        _newMCTrajectories->insert(std::pair<art::Ptr<SimParticle>, mu2e::MCTrajectory>(remap.at(oldSimPtr), i_mcTrajectory.second));
+      if (_simParticlesToKeep.has(oldSimPtr)) {
+        _newMCTrajectories->insert(std::pair<art::Ptr<SimParticle>, mu2e::MCTrajectory>(newSimPtr(oldSimPtr), i_mcTrajectory.second));
       }
     }
   }
@@ -755,13 +849,13 @@ void mu2e::CompressDigiMCs::copyCrvDigiMC(const mu2e::CrvDigiMC& old_crv_digi_mc
   std::vector<art::Ptr<CrvStep> > newStepPtrs;
   for (const auto& i_step_mc : old_crv_digi_mc.GetCrvSteps()) {
     if (i_step_mc.isAvailable()) {
-      if (_crvStepsSeen.insert(i_step_mc).second == true) { // if we have inserted this CrvStepPtrs (i.e. it hasn't already been seen)
+      if (!_crvStepRemap.has(i_step_mc)) { // if we haven't already seen this CrvStep
         art::Ptr<CrvStep> newStepPtr = copyCrvStep(*i_step_mc);
         newStepPtrs.push_back(newStepPtr);
-        _crvStepsMap[i_step_mc] = newStepPtr;
+        _crvStepRemap.set(i_step_mc.id(), i_step_mc.key(), newStepPtr.key());
       }
       else {
-        newStepPtrs.push_back(_crvStepsMap.at(i_step_mc));
+        newStepPtrs.push_back(_crvStepRemap.newPtr(i_step_mc, _newCrvStepsPID, _newCrvStepGetter));
       }
     }
     else { // this is a null Ptr but it should be added anyway to keep consistency (expected for CrvDigis)
@@ -797,15 +891,16 @@ art::Ptr<mu2e::CaloShowerStep> mu2e::CompressDigiMCs::copyCaloShowerStep(const m
   }
 }
 
-void mu2e::CompressDigiMCs::copyCaloShowerSim(const mu2e::CaloShowerSim& old_calo_shower_sim, const CaloShowerStepRemap& remap) {
+void mu2e::CompressDigiMCs::copyCaloShowerSim(const mu2e::CaloShowerSim& old_calo_shower_sim) {
 
   art::Ptr<SimParticle> oldSimPtr = old_calo_shower_sim.sim();
   keepSimParticle(oldSimPtr);
 
   const auto& caloShowerStepPtrs = old_calo_shower_sim.caloShowerSteps();
   std::vector<art::Ptr<CaloShowerStep> > newCaloShowerStepPtrs;
+  newCaloShowerStepPtrs.reserve(caloShowerStepPtrs.size());
   for (const auto& i_caloShowerStepPtr : caloShowerStepPtrs) {
-    newCaloShowerStepPtrs.push_back(remap.at(i_caloShowerStepPtr));
+    newCaloShowerStepPtrs.push_back(_caloShowerStepRemap.newPtr(i_caloShowerStepPtr, _newCaloShowerStepsPID, _newCaloShowerStepGetter));
   }
 
   CaloShowerSim new_calo_shower_sim = old_calo_shower_sim;
@@ -814,11 +909,11 @@ void mu2e::CompressDigiMCs::copyCaloShowerSim(const mu2e::CaloShowerSim& old_cal
   _newCaloShowerSims->push_back(new_calo_shower_sim);
 }
 
-void mu2e::CompressDigiMCs::copyCaloShowerRO(const mu2e::CaloShowerRO& old_calo_shower_step_ro, const CaloShowerStepRemap& remap) {
+void mu2e::CompressDigiMCs::copyCaloShowerRO(const mu2e::CaloShowerRO& old_calo_shower_step_ro) {
 
   const auto& caloShowerStepPtr = old_calo_shower_step_ro.caloShowerStep();
   CaloShowerRO new_calo_shower_step_ro = old_calo_shower_step_ro;
-  new_calo_shower_step_ro.setCaloShowerStep(remap.at(caloShowerStepPtr));
+  new_calo_shower_step_ro.setCaloShowerStep(_caloShowerStepRemap.newPtr(caloShowerStepPtr, _newCaloShowerStepsPID, _newCaloShowerStepGetter));
 
   _newCaloShowerROs->push_back(new_calo_shower_step_ro);
 }
@@ -895,17 +990,18 @@ art::Ptr<mu2e::CrvStep> mu2e::CompressDigiMCs::copyCrvStep(const mu2e::CrvStep&
 
 void mu2e::CompressDigiMCs::keepSimParticle(const art::Ptr<SimParticle>& sim_ptr) {
 
-  // Also need to add all the parents too
-  _simParticlesToKeep[sim_ptr.id()].insert(sim_ptr);
-  art::Ptr<SimParticle> childPtr = sim_ptr;
-  art::Ptr<SimParticle> parentPtr = childPtr->parent();
-
-  while (parentPtr.isNonnull()) {
-    _simParticlesToKeep[sim_ptr.id()].insert(parentPtr);
-    childPtr = parentPtr;
-    parentPtr = parentPtr->parent();
+  // Also need to add all the parents too.  We can stop at the first one
+  // we are already keeping because its parents were added along with it
+  art::Ptr<SimParticle> keepPtr = sim_ptr;
+  while (keepPtr.isNonnull() && _simParticlesToKeep.get(sim_ptr.id(), keepPtr.key()) == PtrRemapCode::notSet) {
+    _simParticlesToKeep.set(sim_ptr.id(), keepPtr.key(), keepPtr.key());
+    keepPtr = keepPtr->parent();
   }
 }
 
+art::Ptr<mu2e::SimParticle> mu2e::CompressDigiMCs::newSimPtr(const art::Ptr<SimParticle>& old_sim_ptr) const {
+  return _simParticlesToKeep.newPtr(old_sim_ptr, _newSimParticlesPID, _newSimParticleGetter);
+}
+
 
 DEFINE_ART_MODULE(mu2e::CompressDigiMCs)
@@ -2,6 +2,9 @@
 #define DbService_DbEngine_hh
 
 #include <shared_mutex>
+#include <mutex>
+#include <atomic>
+#include <set>
 #include <chrono>
 
 #include "DbService/inc/DbReader.hh"
@@ -10,8 +13,10 @@
 #include "DbTables/inc/DbVersion.hh"
 #include "DbTables/inc/DbTableCollection.hh"
 #include "DbTables/inc/DbCache.hh"
+#include "DbTables/inc/DbDiskCache.hh"
 #include "DbTables/inc/DbValCache.hh"
 #include "DbTables/inc/DbLiveTable.hh"
+#include "DbTables/inc/DbSnapshot.hh"
 
 
 namespace mu2e {
@@ -19,7 +24,9 @@ namespace mu2e {
   public:
 
     DbEngine():_verbose(0),_saveCsv(true),_initialized(false),
-	       _lockWaitTime(0),_lockTime(0) {}
+	       _lockWaitTime(0),_lockTime(0),_prefetch(false),
+	       _nPrefetched(0),_nPrefetchUsed(0),_nPrefetchMissed(0),
+	       _nSnapshotRead(0) {}
     // the big read of the IOV structure is done in beginJob
     int beginJob();
     int endJob();
@@ -33,15 +40,32 @@ namespace mu2e {
     void setVerbose(int verbose = 0) { _verbose = verbose; }
     // whether to save the csv text content when loading a table
     void setSaveCsv(bool saveCsv) { _saveCsv = saveCsv; }
+    // whether prefetch will be called, so that the tables in use are recorded
+    void setPrefetch(bool prefetch) { _prefetch = prefetch; }
+    // maximum bytes of calibration tables kept in memory, 0 is no limit
+    void setCacheMaxBytes(size_t maxBytes) { _cache.setMaxBytes(maxBytes); }
+    // directory of table text shared by the jobs on a node, 
+    // call after setDbId
+    void setDiskCache(std::string const& dir);
+    // read the val tables and the calibration tables from a local
+    // snapshot file (see dbTool export-snapshot) instead of the database,
+    // call after setVersion
+    void setSnapshot(std::string const& fileName);
     // these should only be called in single-threaded startup
     std::shared_ptr<DbValCache>& valCache() {return _vcache;}
     std::vector<int> gids() { return _gids; }
     DbReader& reader() { return _reader; }
+    // the cid's of all the intervals in the calibration set, after beginJob
+    std::set<int> cids() const;
     // these are the only methods that can be called from threads, 
     // such as DbHandle, after the single-threaded configuration
     DbLiveTable update(int tid, uint32_t run, uint32_t subrun);
     int tidByName(std::string const& name);
     std::string nameByTid(int tid);
+    // read the tables requested so far for this run/subrun
+    // into the cache, typically from a background task.  Returns the
+    // interval over which none of these tables changes
+    DbIoV prefetch(uint32_t run, uint32_t subrun);
 
   private:
 
@@ -60,6 +84,12 @@ namespace mu2e {
     void lazyBeginJob();
     // find a table cid in the fast lookup structure
     Row findTable(int tid, uint32_t run, uint32_t subrun);
+    // read a table from the database into the cache
+    // can only be called inside a write lock
+    int readTable(int tid, int cid, DbTable::cptr_t& ptr);
+    // make and fill a table from the snapshot, the disk cache or the
+    // database, without touching the memory cache or the locks
+    int fetchTable(DbReader& reader, int tid, int cid, DbTable::ptr_t& ptr);
 
 
     DbId _id;
@@ -69,6 +99,7 @@ namespace mu2e {
     bool _saveCsv;
     DbTableCollection _override;
     DbCache _cache;
+    DbDiskCache _diskCache;
     std::shared_ptr<DbValCache> _vcache;
     bool _initialized;
     // a join of relevant tables, int is tid, Row is above
@@ -82,7 +113,24 @@ namespace mu2e {
     // count the time locked
     std::chrono::microseconds _lockWaitTime;
     std::chrono::microseconds _lockTime;
-    
+
+    // tables requested so far, and prefetched tables not yet used
+    bool _prefetch;
+    std::mutex _prefetchMutex;
+    std::set<int> _usedTids;
+    std::set<int> _prefetchedCids;
+    // the prefetch reads with their own connection, outside _mutex,
+    // one prefetch at a time
+    std::mutex _prefetchReadMutex;
+    DbReader _prefetchReader;
+    std::atomic<int> _nPrefetched;
+    std::atomic<int> _nPrefetchUsed;
+    std::atomic<int> _nPrefetchMissed;
+
+    // local copy of the tables, if any
+    std::shared_ptr<DbSnapshot> _snapshot;
+    std::atomic<int> _nSnapshotRead;
+
   };
 }
 #endif
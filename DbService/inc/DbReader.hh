@@ -45,6 +45,8 @@ namespace mu2e {
     // this keeps the socket open between url's, so it is more efficient
     int multiQuery(std::vector<QueryForm>& qfv);
 
+    // the csv text of a table, not yet filled into it
+    int queryByCid(std::string& csv, DbTable const& table, int cid);
     int fillTableByCid(DbTable::ptr_t ptr, int cid);
     int fillValTables(DbValCache& vcache);
 
@@ -10,8 +10,10 @@
 #include "art/Framework/Services/Registry/ServiceTable.h" 
 #include "art/Framework/Services/Registry/ActivityRegistry.h"
 #include "art/Framework/Services/Registry/ServiceMacros.h"
+#include "art/Framework/Principal/SubRun.h"
 #include "cetlib_except/exception.h"
 #include "DbService/inc/DbEngine.hh"
+#include "tbb/task_group.h"
 
 
 
@@ -39,6 +41,14 @@ namespace mu2e {
 	  Comment("read the DB immedatiately, not on first use")};
       fhicl::OptionalAtom<int> cacheLifetime{Name("cacheLifetime"), 
 	  Comment("if >0, read IoV from cache, but renew each lifetime s")};
+      fhicl::Atom<bool> prefetch{Name("prefetch"), 
+	  Comment("when the source reads a subrun, read its tables, and those valid after their interval of validity, in the background"),false};
+      fhicl::Atom<int> maxCacheMemory{Name("maxCacheMemory"), 
+	  Comment("maximum MB of calibration tables kept in memory, least recently used are dropped, 0 means no limit"),0};
+      fhicl::OptionalAtom<std::string> cacheDir{Name("cacheDir"), 
+	  Comment("directory where the jobs on a node share the tables read from the DB")};
+      fhicl::OptionalAtom<std::string> snapshot{Name("snapshot"), 
+	  Comment("local snapshot file from dbTool export-snapshot, used instead of the DB")};
     };
 
     // this line is required by art to allow the command line help print
@@ -51,6 +61,7 @@ namespace mu2e {
     // Functions registered for callbacks.
     void postBeginJob();
     void postEndJob();
+    void postSourceSubRun(art::SubRun const& subrun);
 
     // how the DbHandle interacts with this service
     DbEngine& engine() {return _engine;}
@@ -67,6 +78,8 @@ namespace mu2e {
 
     DbVersion _version;
     DbEngine _engine;
+    // background reads of the tables for upcoming subruns
+    tbb::task_group _prefetchTasks;
 
   };
 
@@ -68,6 +68,8 @@ namespace mu2e {
     int commitPurpose();
     int commitVersion();
 
+    int exportSnapshot();
+
     int findPidVid(std::string purpose, std::string version, int& pid, int& vid);
     int testUrl();
 
@@ -24,6 +24,14 @@ int mu2e::DbEngine::beginJob() {
   _reader.setVerbose(_verbose);
   _reader.setTimeVerbose(_verbose);
   _reader.setSaveCsv(_saveCsv);
+  if(_prefetch) {
+    // prefetch failures are left for update to report
+    _prefetchReader.setDbId(_id);
+    _prefetchReader.setVerbose(_verbose);
+    _prefetchReader.setTimeVerbose(_verbose);
+    _prefetchReader.setSaveCsv(_saveCsv);
+    _prefetchReader.setAbortOnFail(false);
+  }
 
   // this is used to assign nominal tid's and cid's to tables that
   // are read in through a file, and are not declared in the database
@@ -60,7 +68,11 @@ int mu2e::DbEngine::beginJob() {
 
   if(!_vcache) { // if not already provided, create and fil it
     _vcache = std::make_shared<DbValCache>();
-    _reader.fillValTables(*_vcache);
+    if(_snapshot) {
+      _snapshot->fillValCache(*_vcache);
+    } else {
+      _reader.fillValTables(*_vcache);
+    }
   }
   DbValCache const& vcache = * _vcache;
 
@@ -321,9 +333,15 @@ mu2e::DbLiveTable mu2e::DbEngine::update(int tid, uint32_t run,
     auto row = findTable(tid, run, subrun);
     cid = row.cid();
     iov = row.iov();
-    if(_cache.hasTable(row.cid())) ptr = _cache.get(row.cid());
+    if(cid>=0) ptr = _cache.get(cid);
   } // read lock goes out of scope
 
+  if(_prefetch) {
+    std::lock_guard lock(_prefetchMutex);
+    _usedTids.insert(tid);
+    if(ptr && _prefetchedCids.erase(cid)>0) _nPrefetchUsed++;
+  }
+
   // if no cid now, then table can't be found - have to stop
   if(cid<0) {
     throw cet::exception("DBENGINE_UPDATE_FAILED") 
@@ -342,14 +360,14 @@ mu2e::DbLiveTable mu2e::DbEngine::update(int tid, uint32_t run,
     
     // have to check if some other thread loaded it 
     // since the above read attempt
-    if(_cache.hasTable(cid)) {
-      ptr = _cache.get(cid);
+    ptr = _cache.get(cid,false);
+    if(ptr) {
+      if(_prefetch) {
+	std::lock_guard lock(_prefetchMutex);
+	if(_prefetchedCids.erase(cid)>0) _nPrefetchUsed++;
+      }
     } else {
-      auto const& tabledef = _vcache->valTables().row(tid);
-      // this makes the memory
-      auto ncptr = DbTableFactory::newTable(tabledef.name());
-      // the actual http read
-      int rc = _reader.fillTableByCid(ncptr,cid);
+      int rc = readTable(tid,cid,ptr);
 
       // reader does not abort, so do it here
       if(rc!=0) {
@@ -360,11 +378,7 @@ mu2e::DbLiveTable mu2e::DbEngine::update(int tid, uint32_t run,
 	  <<", cid ="<< cid 
 	  <<", rc ="<< rc << "\n";
       }
-
-      // make it const
-      ptr = std::const_pointer_cast<const mu2e::DbTable,mu2e::DbTable>(ncptr);
-      // push to cache
-      _cache.add(cid,ptr);
+      if(_prefetch) _nPrefetchMissed++;
     }
 
     auto etime = std::chrono::high_resolution_clock::now();
@@ -390,6 +404,153 @@ mu2e::DbLiveTable mu2e::DbEngine::update(int tid, uint32_t run,
 
 }
 
+// read a table from the database into the cache
+// can only be called inside a write lock
+int mu2e::DbEngine::readTable(int tid, int cid, DbTable::cptr_t& ptr) {
+  DbTable::ptr_t ncptr;
+  int rc = fetchTable(_reader,tid,cid,ncptr);
+  if(rc!=0) return rc;
+
+  // make it const
+  ptr = std::const_pointer_cast<const mu2e::DbTable,mu2e::DbTable>(ncptr);
+  // push to cache
+  _cache.add(cid,ptr);
+  return 0;
+}
+
+// make and fill a table, the snapshot, disk cache and val tables
+// are not changed after beginJob, so no lock is needed
+int mu2e::DbEngine::fetchTable(DbReader& reader, int tid, int cid, 
+			       DbTable::ptr_t& ncptr) {
+  if(_snapshot && _snapshot->hasTable(cid)) {
+    // made and filled from the mapped file
+    ncptr = _snapshot->table(cid);
+    if(_saveCsv) ncptr->toCsv();
+    _nSnapshotRead++;
+  } else {
+    auto const& tabledef = _vcache->valTables().row(tid);
+    // this makes the memory
+    ncptr = DbTableFactory::newTable(tabledef.name());
+    int rc = 0;
+    if(_diskCache.active()) {
+      // the text from the node's shared cache, 
+      // or from an http read that is then shared
+      std::string csv;
+      rc = _diskCache.get(cid,csv,[&reader,&ncptr,cid](std::string& text) {
+	  return reader.queryByCid(text,*ncptr,cid); });
+      if(rc!=0) return rc;
+      ncptr->fill(csv,_saveCsv);
+    } else {
+      // the actual http read
+      rc = reader.fillTableByCid(ncptr,cid);
+      if(rc!=0) return rc;
+    }
+  }
+  return 0;
+}
+
+void mu2e::DbEngine::setSnapshot(std::string const& fileName) {
+  if(_initialized) {
+    throw cet::exception("DBENGINE_LATE_SNAPSHOT") << 
+      "DbEngine::setSnapshot engine already initialized\n";
+  }
+  _snapshot = std::make_shared<DbSnapshot>();
+  _snapshot->open(fileName);
+  if(_snapshot->purpose()!=_version.purpose()) {
+    throw cet::exception("DBENGINE_SNAPSHOT_MISMATCH") 
+      << "DbEngine::setSnapshot snapshot " << fileName 
+      << " was made for purpose " << _snapshot->purpose() 
+      << " but " << _version.purpose() << " was requested\n";
+  }
+  if(_verbose>0) {
+    std::cout << "DbEngine using snapshot " << fileName 
+	      << " of " << _snapshot->purpose() << " " 
+	      << _snapshot->version() << " with " 
+	      << _snapshot->cids().size() << " tables" << std::endl;
+  }
+}
+
+void mu2e::DbEngine::setDiskCache(std::string const& dir) {
+  if(_id.name().empty()) {
+    throw cet::exception("DBENGINE_DBID NOT_SET") 
+      << "DbEngine::setDiskCache found the DbId was not set\n";
+  }
+  _diskCache.setDirectory(dir,_id.name());
+  if(_verbose>0) {
+    std::cout << "DbEngine using shared table cache " 
+	      << _diskCache.directory() << std::endl;
+  }
+}
+
+std::set<int> mu2e::DbEngine::cids() const {
+  std::set<int> cids;
+  for(auto const& p : _lookup) {
+    for(auto const& r : p.second) cids.insert(r.cid());
+  }
+  return cids;
+}
+
+mu2e::DbIoV mu2e::DbEngine::prefetch(uint32_t run, uint32_t subrun) {
+
+  lazyBeginJob(); // initialize if needed
+
+  std::lock_guard readLock(_prefetchReadMutex); // one prefetch at a time
+
+  std::set<int> tids;
+  {
+    std::lock_guard lock(_prefetchMutex);
+    tids = _usedTids;
+  }
+
+  DbIoV valid;
+  valid.setMax();
+  for(auto tid : tids) {
+    // override tables are always in memory
+    bool overridden = false;
+    for(auto const& oltab : _override) {
+      if(oltab.tid()==tid && oltab.iov().inInterval(run,subrun)) {
+	overridden = true;
+	valid.overlap(oltab.iov());
+      }
+    }
+    if(overridden) continue;
+
+    int cid = -1;
+    {
+      std::shared_lock lock(_mutex); // shared read lock
+      auto row = findTable(tid, run, subrun);
+      cid = row.cid();
+      if(cid<0) continue;
+      valid.overlap(row.iov());
+      if(_cache.hasTable(cid)) continue;
+    }
+
+    // the slow read is done without the engine lock, so update
+    // is not blocked; failures are left for update to report
+    DbTable::ptr_t ncptr;
+    if(fetchTable(_prefetchReader,tid,cid,ncptr)!=0) continue;
+    DbTable::cptr_t ptr = 
+      std::const_pointer_cast<const mu2e::DbTable,mu2e::DbTable>(ncptr);
+
+    auto stime = std::chrono::high_resolution_clock::now();
+    std::unique_lock lock(_mutex); // write lock, only to insert
+    auto mtime = std::chrono::high_resolution_clock::now();
+    _lockWaitTime += std::chrono::duration_cast<std::chrono::microseconds>
+                                               ( mtime - stime );
+    if(!_cache.hasTable(cid)) {
+      _cache.add(cid,ptr);
+      _nPrefetched++;
+      std::lock_guard plock(_prefetchMutex);
+      _prefetchedCids.insert(cid);
+    }
+    auto etime = std::chrono::high_resolution_clock::now();
+    _lockTime += std::chrono::duration_cast<std::chrono::microseconds>
+                                               ( etime - mtime );
+  }
+
+  return valid;
+}
+
 // find a table by cid in the fast lookup structure
 // can only be called inside a read lock
 mu2e::DbEngine::Row mu2e::DbEngine::findTable(
@@ -495,6 +656,19 @@ int mu2e::DbEngine::endJob() {
 	      <<" s" << std::endl;
     std::cout << "    cache memory   : "<<_cache.size()<<" b" << std::endl;
     std::cout << "    valcache memory: "<<_vcache->size()<<" b" << std::endl;
+    if(_snapshot) {
+      std::cout << "    tables read from snapshot: "<< _nSnapshotRead 
+		<< std::endl;
+    }
+  }
+  if(_verbose>0 || _cache.maxBytes()>0 || _diskCache.active()) {
+    _cache.printStats(std::cout);
+    if(_diskCache.active()) _diskCache.printStats(std::cout);
+  }
+  if(_prefetch) {
+    std::cout << "DbEngine prefetched tables: "<< _nPrefetched <<", used: "
+	      << _nPrefetchUsed <<", read on demand: "
+	      << _nPrefetchMissed << std::endl;
   }
   return 0;
 }
@@ -70,10 +70,15 @@ int mu2e::DbReader::multiQuery(std::vector<QueryForm>& qfv) {
 
 
 
+int mu2e::DbReader::queryByCid(std::string& csv, DbTable const& table, 
+				int cid) {
+  std::string where="cid:eq:"+std::to_string(cid);
+  return query(csv,table.query(),table.dbname(),where);
+}
+
 int mu2e::DbReader::fillTableByCid(DbTable::ptr_t ptr, int cid) {
   std::string csv;
-  std::string where="cid:eq:"+std::to_string(cid);
-  int rc = query(csv,ptr->query(),ptr->dbname(),where);
+  int rc = queryByCid(csv,*ptr,cid);
   if(rc!=0) return rc;
   ptr->fill(csv,_saveCsv);
   return 0;
@@ -15,6 +15,9 @@ namespace mu2e {
     // register callbacks
     iRegistry.sPostBeginJob.watch(this, &DbService::postBeginJob);
     iRegistry.sPostEndJob.watch (this, &DbService::postEndJob );
+    if(_config.prefetch()) {
+      iRegistry.sPostSourceSubRun.watch (this, &DbService::postSourceSubRun );
+    }
 
     if(_verbose>0) {
       std::cout << "DbService: purpose = " 
@@ -28,6 +31,10 @@ namespace mu2e {
 		<< std::endl;
       std::cout << "DbService: dbName = " 
 		<< config().dbName() << std::endl;
+      std::string snapshot;
+      if(config().snapshot(snapshot)) {
+	std::cout << "DbService: snapshot = " << snapshot << std::endl;
+      }
       std::vector<std::string> files;
       config().textFile(files);
       std::cout << "DbService: textFile =" ;
@@ -42,10 +49,22 @@ namespace mu2e {
     // the engine which will read db, hold calibrations, deliver them
     _engine.setVerbose(_verbose);
     _engine.setSaveCsv(_config.saveCsv());
+    _engine.setPrefetch(_config.prefetch());
 
     DbIdList idList; // read file of db connection details
     _engine.setDbId( idList.getDbId(_config.dbName()) );
     _engine.setVersion( _version );
+    // limit the tables in memory, and share the DB reads between jobs
+    _engine.setCacheMaxBytes( size_t(_config.maxCacheMemory())*1000000 );
+    std::string cacheDir;
+    if(_config.cacheDir(cacheDir)) _engine.setDiskCache(cacheDir);
+
+    // a local snapshot replaces the database reads for the tables it holds
+    std::string snapshot;
+    if(_config.snapshot(snapshot)) {
+      ConfigFileLookupPolicy snapshotFile;
+      _engine.setSnapshot( snapshotFile(snapshot) );
+    }
 
     // if there were text files containing calibrations,
     // then read them and tell the engine to let them override IOV
@@ -85,7 +104,9 @@ namespace mu2e {
 
   }
 
-  DbService::~DbService() {}
+  DbService::~DbService() {
+    _prefetchTasks.wait();
+  }
 
   /********************************************************/
   void DbService::postBeginJob(){
@@ -95,10 +116,34 @@ namespace mu2e {
 
   /********************************************************/
   void DbService::postEndJob(){
+    _prefetchTasks.wait();
     // just print summaries according to verbosity
     _engine.endJob();
   }
 
+  /********************************************************/
+  void DbService::postSourceSubRun(art::SubRun const& subrun){
+    // the source has read a new subrun, its events will follow.
+    // Read its tables, and those valid after the end of their common
+    // interval of validity, which is the next place the tables change,
+    // while the events are processed
+    uint32_t run = subrun.run();
+    uint32_t sr = subrun.subRun();
+    _prefetchTasks.run([this,run,sr]{
+	try {
+	  DbIoV iov = _engine.prefetch(run,sr);
+	  uint32_t nextRun, nextSubrun;
+	  if(iov.inInterval(run,sr) && iov.next(nextRun,nextSubrun)) {
+	    _engine.prefetch(nextRun,nextSubrun);
+	  }
+	} catch (std::exception const& e) {
+	  // the tables will be read when they are needed
+	  if(_verbose>1) std::cout << "DbService::postSourceSubRun prefetch failed: "
+				   << e.what() << std::endl;
+	}
+      });
+  }
+
 }
 
 DEFINE_ART_SERVICE(mu2e::DbService)
@@ -8,6 +8,7 @@
 #include "DbService/inc/DbTool.hh"
 #include "DbService/inc/DbIdList.hh"
 #include "DbTables/inc/DbTableFactory.hh"
+#include "DbTables/inc/DbSnapshot.hh"
 
 mu2e::DbTool::DbTool():_verbose(0),_pretty(false),_admin(false) {
 }
@@ -34,6 +35,8 @@ int mu2e::DbTool::run() {
   if(_action=="commit-purpose") return commitPurpose();
   if(_action=="commit-version") return commitVersion();
 
+  if(_action=="export-snapshot") return exportSnapshot();
+
   if(_action=="test-url") return testUrl();
   
   std::cout << "error: could not parse action : "<< _args[0]<< std::endl;
@@ -1542,6 +1545,57 @@ int mu2e::DbTool::commitVersion() {
 }
 
 
+// ****************************************  exportSnapshot
+
+int mu2e::DbTool::exportSnapshot() {
+  int rc = 0;
+
+  map_ss args;
+  args["purpose"] = "";
+  args["version"] = "";
+  args["file"] = "";
+  if( (rc = getArgs(args)) ) return rc;
+
+  if(args["purpose"].empty() || args["version"].empty() 
+     || args["file"].empty()) {
+    std::cout << "export-snapshot requires purpose, version and file" 
+	      <<std::endl;
+    return 1;
+  }
+
+  DbVersion version(args["purpose"],args["version"]);
+
+  // let the engine find the intervals of this calibration set,
+  // exactly as a job would
+  DbEngine engine;
+  engine.setVerbose(_verbose);
+  engine.setDbId(_id);
+  engine.setVersion(version);
+  engine.setCache(std::make_shared<DbValCache>(_valcache));
+  engine.beginJob();
+
+  DbSnapshot::table_map tables;
+  for(auto cid : engine.cids()) {
+    auto const& cr = _valcache.valCalibrations().row(cid);
+    auto ptr = DbTableFactory::newTable(_valcache.valTables().row(cr.tid()).name());
+    rc = _reader.fillTableByCid(ptr,cid);
+    if(rc!=0) return rc;
+    tables[cid] = ptr;
+  }
+
+  DbSnapshot::write(args["file"],version,_valcache,tables);
+
+  if(_verbose>0) {
+    std::size_t nbytes = 0;
+    for(auto const& p : tables) nbytes += p.second->size();
+    std::cout << "export-snapshot: wrote " << tables.size() 
+	      << " calibration tables (" << nbytes << " b) of "
+	      << version.to_string() << " to " << args["file"] << std::endl;
+  }
+
+  return 0;
+}
+
 // ****************************************  testUrl
 
 int mu2e::DbTool::testUrl() {
@@ -1676,6 +1730,8 @@ int mu2e::DbTool::help() {
       "    commit-list : declare a new list of table types for a version\n"
       "    commit-purpose : declare a new calibration set purpose\n"
       "    commit-version : declare a new version of a calibration set purpose\n"
+      "    \n"
+      "    export-snapshot : write a calibration set to a local binary file\n"
       " \n"
       " arguments that are lists of integers may have the form:\n"
       "    int   example: --cid 234\n"
@@ -1934,6 +1990,25 @@ int mu2e::DbTool::help() {
       "  dbTool commit-extension --purpose PRODUCTION --version v1_1 \\\n"
       "     --gid 4,5,6\n"
       << std::endl;
+  } else if(_action=="export-snapshot") {
+    std::cout << 
+      " \n"
+      " dbTool export-snapshot [OPTIONS]\n"
+      " \n"
+      " Write the Val tables and all the calibration tables of a\n"
+      " purpose/version to one binary file.  DbService reads it, \n"
+      " instead of the database, with the snapshot parameter.\n"
+      " The tables are read by cid, so the file is reproducible.\n"
+      " \n"
+      " [OPTIONS]\n"
+      "    --purpose TEXT : purpose name (required)\n"
+      "    --version TEXT : the version, as in DbService (required)\n"
+      "    --file TEXT : the output file (required)\n"
+      "  \n"
+      "  Example:\n"
+      "  dbTool export-snapshot --purpose PRODUCTION --version v1_1 \\\n"
+      "     --file PRODUCTION_v1_1.dbsnap\n"
+      << std::endl;
   }
   return 0;
 }
@@ -0,0 +1,204 @@
+//
+// Compare the time to load conditions tables from their csv text,
+// as DbReader does with the database reply, and from a binary snapshot.
+//
+//   dbSnapshotBenchmark [snapshotFile] [repeat]
+//
+// Without a file (or with "-"), a synthetic snapshot with tables of each
+// kind is written to dbSnapshotBenchmark.dbsnap and used.  The csv text is
+// made once from the snapshot tables, then the Val tables and all the
+// calibration tables are filled from csv and from the snapshot
+// (including opening the file) repeat times.
+//
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include "DbTables/inc/DbSnapshot.hh"
+#include "DbTables/inc/DbTableFactory.hh"
+
+using namespace mu2e;
+
+namespace {
+
+  const char* defaultFile = "dbSnapshotBenchmark.dbsnap";
+
+  // a few hundred tables of a large binary table, a small binary
+  // table and a table with string columns
+  void writeSynthetic(std::string const& fileName, int ncid) {
+    std::vector<std::string> names = {"TrkPreampStraw","TrkDelayPanel","TstCalib2"};
+    std::string tcsv, ccsv, icsv;
+    DbSnapshot::table_map tables;
+    for(size_t t=0; t<names.size(); t++) {
+      int tid = t+1;
+      tcsv += std::to_string(tid)+","+names[t]+",x.x,2019-01-01 00:00:00,mu2e\n";
+      for(int i=0; i<ncid; i++) {
+	int cid = 100*tid + i;
+	ccsv += std::to_string(cid)+","+std::to_string(tid)+",2019-01-01 00:00:00,mu2e\n";
+	icsv += std::to_string(cid)+","+std::to_string(cid)+","
+	  +std::to_string(1000+i)+",0,"+std::to_string(1000+i)+",999999,"
+	  +"2019-01-01 00:00:00,mu2e\n";
+	auto ptr = DbTableFactory::newTable(names[t]);
+	std::string csv;
+	std::size_t nrow = ptr->nrowFix()>0 ? ptr->nrowFix() : 500;
+	for(std::size_t r=0; r<nrow; r++) {
+	  std::string v = std::to_string(0.001*(r+i));
+	  if(t==2) {
+	    csv += std::to_string(r)+",\"status "+v+"\"\n";
+	  } else if(t==1) {
+	    csv += std::to_string(r)+","+v+"\n";
+	  } else {
+	    csv += std::to_string(r)+","+v+","+v+","+v+","+v+","+v+"\n";
+	  }
+	}
+	ptr->fill(csv,false);
+	tables[cid] = ptr;
+      }
+    }
+
+    DbValCache vcache;
+    ValTables vt;
+    vt.fill(tcsv);
+    vcache.setValTables(vt);
+    ValCalibrations vc;
+    vc.fill(ccsv);
+    vcache.setValCalibrations(vc);
+    ValIovs vi;
+    vi.fill(icsv);
+    vcache.setValIovs(vi);
+
+    DbSnapshot::write(fileName,DbVersion("BENCHMARK","v1_0"),vcache,tables);
+  }
+
+  template<typename T>
+  void fillVal(T& table, std::map<std::string,std::string>& csv, std::size_t& nrow) {
+    table.fill(csv[table.name()],false);
+    nrow += table.nrow();
+  }
+
+  // as DbReader::fillValTables does with the database reply
+  std::size_t fillValCsv(std::map<std::string,std::string>& csv, DbValCache& vcache) {
+    std::size_t nrow = 0;
+    ValTables tables;
+    fillVal(tables,csv,nrow);
+    vcache.setValTables(tables);
+    ValCalibrations calibrations;
+    fillVal(calibrations,csv,nrow);
+    vcache.setValCalibrations(calibrations);
+    ValIovs iovs;
+    fillVal(iovs,csv,nrow);
+    vcache.setValIovs(iovs);
+    ValGroups groups;
+    fillVal(groups,csv,nrow);
+    vcache.setValGroups(groups);
+    ValGroupLists grouplists;
+    fillVal(grouplists,csv,nrow);
+    vcache.setValGroupLists(grouplists);
+    ValPurposes purposes;
+    fillVal(purposes,csv,nrow);
+    vcache.setValPurposes(purposes);
+    ValLists lists;
+    fillVal(lists,csv,nrow);
+    vcache.setValLists(lists);
+    ValTableLists tablelists;
+    fillVal(tablelists,csv,nrow);
+    vcache.setValTableLists(tablelists);
+    ValVersions versions;
+    fillVal(versions,csv,nrow);
+    vcache.setValVersions(versions);
+    ValExtensions extensions;
+    fillVal(extensions,csv,nrow);
+    vcache.setValExtensions(extensions);
+    ValExtensionLists extensionlists;
+    fillVal(extensionlists,csv,nrow);
+    vcache.setValExtensionLists(extensionlists);
+    return nrow;
+  }
+
+  std::string toCsv(DbTable const& table) {
+    std::ostringstream ss;
+    for(std::size_t i=0; i<table.nrow(); i++) {
+      table.rowToCsv(ss,i);
+      ss << "\n";
+    }
+    return ss.str();
+  }
+
+}
+
+int main(int argc, char** argv) {
+
+  std::string fileName = argc > 1 ? argv[1] : "-";
+  int repeat = argc > 2 ? std::atoi(argv[2]) : 10;
+
+  if(fileName=="-") {
+    fileName = defaultFile;
+    writeSynthetic(fileName,100);
+  }
+
+  // the csv text of each table, as it would come from the database
+  std::map<std::string,std::string> valCsv;
+  std::vector<std::pair<std::string,std::string> > calCsv;
+  std::size_t nrows = 0;
+  {
+    DbSnapshot snapshot;
+    snapshot.open(fileName);
+    DbValCache vcache;
+    snapshot.fillValCache(vcache);
+    for(auto const& name : {"ValTables","ValCalibrations","ValIovs",
+	  "ValGroups","ValGroupLists","ValPurposes","ValLists",
+	  "ValTableLists","ValVersions","ValExtensions","ValExtensionLists"}) {
+      auto const& table = vcache.asTable(name);
+      valCsv[name] = toCsv(table);
+      nrows += table.nrow();
+    }
+    for(auto cid : snapshot.cids()) {
+      auto ptr = snapshot.table(cid);
+      calCsv.emplace_back(ptr->name(),toCsv(*ptr));
+      nrows += ptr->nrow();
+    }
+  }
+
+  typedef std::chrono::steady_clock clock;
+  double tCsv = 0, tSnapshot = 0;
+  std::size_t nCsv = 0, nSnapshot = 0;
+  for(int irep=0; irep<repeat; irep++) {
+
+    auto t0 = clock::now();
+    DbValCache csvcache;
+    nCsv += fillValCsv(valCsv,csvcache);
+    for(auto const& p : calCsv) {
+      auto ptr = DbTableFactory::newTable(p.first);
+      ptr->fill(p.second,false);
+      nCsv += ptr->nrow();
+    }
+    auto t1 = clock::now();
+
+    DbSnapshot snapshot;
+    snapshot.open(fileName);
+    DbValCache vcache;
+    snapshot.fillValCache(vcache);
+    for(auto const& p : valCsv) nSnapshot += vcache.asTable(p.first).nrow();
+    for(auto cid : snapshot.cids()) nSnapshot += snapshot.table(cid)->nrow();
+    auto t2 = clock::now();
+
+    tCsv += std::chrono::duration<double,std::milli>(t1-t0).count();
+    tSnapshot += std::chrono::duration<double,std::milli>(t2-t1).count();
+  }
+
+  std::cout << fileName << ": " << valCsv.size() << " Val tables and "
+	    << calCsv.size() << " calibration tables, " << nrows << " rows"
+	    << std::endl;
+  std::cout << "  csv fill: " << tCsv/repeat << " ms" << std::endl;
+  std::cout << "  snapshot: " << tSnapshot/repeat << " ms" << std::endl;
+
+  if(nCsv!=nSnapshot) {
+    std::cout << "row counts differ: " << nCsv << " from csv, "
+	      << nSnapshot << " from the snapshot" << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -55,6 +55,12 @@ namespace mu2e {
 
     virtual void clear() override { baseClear(); _rows.clear(); }
 
+    // the rows are plain data, so they can be saved as binary
+    bool hasBinaryRows() const override { return true; }
+    std::string rowsToBinary() const override { return binaryFromRows(_rows); }
+    void fillBinary(const char* data, std::size_t nbytes) override {
+      rowsFromBinary(_rows,data,nbytes); }
+
   private:
     std::vector<Row> _rows;
   };
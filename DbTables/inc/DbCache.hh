@@ -1,9 +1,18 @@
 #ifndef DbTables_DbCache_hh
 #define DbTables_DbCache_hh
 
+//
+// The calibration tables in memory, by cid.  The size of the tables
+// is accounted, and if a maximum is set, the least recently used tables
+// are dropped when it is exceeded (the tables already handed out
+// stay alive with their handles).  Calls are thread safe.
+//
+
 #include <iostream>
 #include <iomanip>
 #include <map>
+#include <list>
+#include <mutex>
 #include "DbTables/inc/DbTable.hh"
 
 namespace mu2e {
@@ -11,21 +20,50 @@ namespace mu2e {
   class DbCache {
   public:
 
-    typedef std::map<int,mu2e::DbTable::cptr_t> table_map;
+    DbCache():_maxBytes(0),_bytes(0),_nHit(0),_nMiss(0),
+	      _nEvicted(0),_bytesEvicted(0),_bytesAdded(0) {}
 
     void add(int cid, mu2e::DbTable::cptr_t const& ptr);
 
-    bool hasTable(int cid) { return _tables.find(cid)!=_tables.end(); }
+    bool hasTable(int cid);
     
-    mu2e::DbTable::cptr_t get(int cid);
+    // null if not cached.  countUse=false for a second look that 
+    // should not count as a hit or miss
+    mu2e::DbTable::cptr_t get(int cid, bool countUse=true);
+
+    // maximum bytes of the tables kept, 0 means no limit
+    void setMaxBytes(size_t maxBytes);
+    size_t maxBytes() const { return _maxBytes; }
 
-    void clear() { _tables.clear(); }
+    void clear();
+    // drop least recently used tables until the size is below target
     int purge(const size_t target=200000000);
     size_t size();
-    void print() const;
+    void print();
+    // hits, misses and bytes
+    void printStats(std::ostream& os);
 
   private:
-    table_map _tables;
+
+    struct Entry {
+      mu2e::DbTable::cptr_t ptr;
+      size_t bytes;
+      std::list<int>::iterator lru;
+    };
+
+    // call with the lock
+    int evict(const size_t target);
+
+    std::mutex _mutex;
+    std::map<int,Entry> _tables;
+    std::list<int> _lru; // cids, most recently used first
+    size_t _maxBytes;
+    size_t _bytes;
+    size_t _nHit;
+    size_t _nMiss;
+    size_t _nEvicted;
+    size_t _bytesEvicted;
+    size_t _bytesAdded;
 
   };
 
@@ -0,0 +1,58 @@
+#ifndef DbTables_DbDiskCache_hh
+#define DbTables_DbDiskCache_hh
+
+//
+// A directory of calibration table text, one file per cid, which the
+// jobs on a node share so a table is fetched from the database once.
+// The first job needing a cid takes a file lock for it, fetches the text,
+// writes it to a temporary file and renames it into place, so readers
+// never see part of a file and the other jobs wait for the lock and
+// then read the file.  Cids are specific to a database, so the
+// files are kept in a subdirectory for each database.
+//
+
+#include <string>
+#include <functional>
+#include <atomic>
+#include <iostream>
+
+namespace mu2e {
+
+  class DbDiskCache {
+  public:
+
+    typedef std::function<int(std::string&)> fetch_t;
+
+    DbDiskCache():_nHit(0),_nMiss(0),_nFailed(0),
+		  _bytesRead(0),_bytesWritten(0) {}
+
+    // create the directory, if needed.  Empty dir turns the cache off
+    void setDirectory(std::string const& dir, std::string const& dbName);
+    bool active() const { return !_dir.empty(); }
+    std::string const& directory() const { return _dir; }
+
+    // get the table text for this cid, from the directory or,
+    // if it is not there, from fetch, and save it for the other jobs.
+    // Returns the fetch return code
+    int get(int cid, std::string& csv, fetch_t const& fetch);
+
+    void printStats(std::ostream& os) const;
+
+  private:
+
+    std::string fileName(int cid) const;
+    bool readFile(std::string const& fn, std::string& csv);
+    bool writeFile(std::string const& fn, std::string const& csv);
+
+    std::string _dir;
+    std::atomic<size_t> _nHit;
+    std::atomic<size_t> _nMiss;
+    std::atomic<size_t> _nFailed; // could not write
+    std::atomic<size_t> _bytesRead;
+    std::atomic<size_t> _bytesWritten;
+
+  };
+
+}
+
+#endif
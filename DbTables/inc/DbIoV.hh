@@ -61,6 +61,19 @@ namespace mu2e {
     uint32_t endRun() const {return _endRun;}
     uint32_t endSubrun() const {return _endSubrun;}
 
+    // the first run:subrun after the end of the interval, false if it is open-ended
+    bool next(uint32_t& run, uint32_t& subrun) const {
+      if(_endRun>=maxr && _endSubrun>=maxsr) return false;
+      if(_endSubrun>=maxsr) {
+        run = _endRun+1;
+        subrun = 0;
+      } else {
+        run = _endRun;
+        subrun = _endSubrun+1;
+      }
+      return true;
+    }
+
     uint32_t maxRun() { return maxr; }
     uint32_t maxSubrun() { return maxsr; }
 
@@ -0,0 +1,104 @@
+#ifndef DbTables_DbSnapshot_hh
+#define DbTables_DbSnapshot_hh
+
+//
+// A local, binary copy of the conditions needed for one purpose/version:
+// the Val* tables and the calibration tables (by cid) they refer to.
+// It is written by "dbTool export-snapshot" and read by DbEngine
+// (DbService snapshot parameter) so a job can start without the database.
+//
+// The file is memory-mapped.  Tables with plain-data rows
+// (DbTable::hasBinaryRows) are stored as the image of their rows and
+// are copied back directly.  The other tables (those with string
+// columns) are stored as columns already split, so
+// they are filled by addRow without the csv line and column parsing.
+// The numbers are in the byte order of the machine that wrote the file,
+// which is checked when reading.
+//
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include "DbTables/inc/DbTable.hh"
+#include "DbTables/inc/DbValCache.hh"
+#include "DbTables/inc/DbVersion.hh"
+
+namespace mu2e {
+
+  class DbSnapshot {
+  public:
+
+    typedef std::map<int,DbTable::cptr_t> table_map; // by cid
+
+    DbSnapshot():_data(nullptr),_nbytes(0) {}
+    ~DbSnapshot() { close(); }
+    // holds the file mapping, so it is not copyable
+    DbSnapshot(DbSnapshot const&) = delete;
+    DbSnapshot& operator=(DbSnapshot const&) = delete;
+
+    // write the val tables and calibration tables to a file
+    static void write(std::string const& fileName, DbVersion const& version,
+		      DbValCache const& vcache, table_map const& tables);
+
+    // map the file and index its tables, throws on a bad file
+    void open(std::string const& fileName);
+    void close();
+    bool isOpen() const { return _data!=nullptr; }
+    std::string const& fileName() const { return _fileName; }
+
+    // the purpose and version the snapshot was exported for
+    std::string const& purpose() const { return _purpose; }
+    std::string const& version() const { return _version; }
+
+    // fill the Val* tables
+    void fillValCache(DbValCache& vcache) const;
+    // the calibration tables
+    std::vector<int> cids() const;
+    bool hasTable(int cid) const { return _cids.find(cid)!=_cids.end(); }
+    int tid(int cid) const;
+    // make and fill a new table, null if the cid is not in the snapshot
+    DbTable::ptr_t table(int cid) const;
+
+    // file layout version
+    static constexpr uint32_t formatVersion = 1;
+
+  private:
+
+    // how the rows of a table are stored
+    enum Encoding : uint32_t { binaryRows=0, splitColumns=1 };
+
+    // fixed-size part of the header of each table in the file
+    struct EntryHeader {
+      int32_t tid;      // -1 for the Val tables
+      int32_t cid;      // -1 for the Val tables
+      uint32_t encoding;
+      uint32_t nameSize;
+      uint64_t nrow;
+      uint64_t ncol;
+      uint64_t nbytes;  // size of the row data
+    };
+
+    struct Entry {
+      EntryHeader header;
+      std::string name;
+      const char* data; // the row data, in the mapped file
+    };
+
+    static void writeTable(std::string& buf, DbTable const& table,
+			   int tid, int cid);
+    void fillTable(Entry const& entry, DbTable& table) const;
+    void fillValTable(DbTable& table) const;
+
+    std::string _fileName;
+    const char* _data;
+    std::size_t _nbytes;
+    std::string _purpose;
+    std::string _version;
+    std::map<std::string,Entry> _vals; // by name
+    std::map<int,Entry> _cids;
+
+  };
+
+}
+#endif
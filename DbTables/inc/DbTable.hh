@@ -6,6 +6,8 @@
 #include <memory>
 #include <sstream>
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 namespace mu2e {
 
@@ -52,6 +54,22 @@ namespace mu2e {
     virtual void clear() =0;
     void baseClear() { _csv.clear(); }
 
+    // tables whose rows are plain data can be saved and restored as
+    // the memory image of the rows, see DbSnapshot - overridden by derived class
+    virtual bool hasBinaryRows() const { return false; }
+    virtual std::string rowsToBinary() const;
+    virtual void fillBinary(const char* data, std::size_t nbytes);
+
+  protected:
+    // helpers for the binary image of a vector of rows
+    template<typename ROW>
+    static std::string binaryFromRows(std::vector<ROW> const& rows);
+    template<typename ROW>
+    void rowsFromBinary(std::vector<ROW>& rows, 
+			const char* data, std::size_t nbytes);
+    // throws if nbytes is not a whole number of rows, or not nrowFix rows
+    void checkBinarySize(std::size_t nbytes, std::size_t rowSize) const;
+
   private:
     std::string _name;
     std::string _dbname;
@@ -59,6 +77,31 @@ namespace mu2e {
     std::string _csv;
   };
 
+  template<typename ROW>
+  std::string DbTable::binaryFromRows(std::vector<ROW> const& rows) {
+    static_assert(std::is_trivially_copyable<ROW>::value,
+		  "DbTable binary rows must be trivially copyable");
+    return std::string(reinterpret_cast<const char*>(rows.data()),
+		       rows.size()*sizeof(ROW));
+  }
+
+  // the data does not need to be aligned, rows are copied one at a time
+  template<typename ROW>
+  void DbTable::rowsFromBinary(std::vector<ROW>& rows, 
+			       const char* data, std::size_t nbytes) {
+    static_assert(std::is_trivially_copyable<ROW>::value,
+		  "DbTable binary rows must be trivially copyable");
+    checkBinarySize(nbytes,sizeof(ROW));
+    std::size_t n = nbytes/sizeof(ROW);
+    rows.clear();
+    rows.reserve(n);
+    typename std::aligned_storage<sizeof(ROW),alignof(ROW)>::type buf;
+    for(std::size_t i=0; i<n; i++) {
+      std::memcpy(&buf,data+i*sizeof(ROW),sizeof(ROW));
+      rows.push_back(*reinterpret_cast<ROW*>(&buf));
+    }
+    _csv.clear();
+  }
 
 }
 #endif
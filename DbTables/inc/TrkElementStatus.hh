@@ -63,6 +63,12 @@ namespace mu2e {
 
     void clear() override { baseClear(); _rows.clear(); }
 
+    // the rows are plain data, so they can be saved as binary
+    bool hasBinaryRows() const override { return true; }
+    std::string rowsToBinary() const override { return binaryFromRows(_rows); }
+    void fillBinary(const char* data, std::size_t nbytes) override {
+      rowsFromBinary(_rows,data,nbytes); }
+
   private:
     StrawIdMask _sidmask; // defines matching for this element
     StrawStatus _statusmask; // status bits allowed for this element
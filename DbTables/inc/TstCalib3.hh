@@ -89,6 +89,15 @@ namespace mu2e {
 
     virtual void clear() override { baseClear(); _rows.clear(); _chanIndex.clear();}
 
+    // the rows are plain data, so they can be saved as binary
+    bool hasBinaryRows() const override { return true; }
+    std::string rowsToBinary() const override { return binaryFromRows(_rows); }
+    void fillBinary(const char* data, std::size_t nbytes) override {
+      rowsFromBinary(_rows,data,nbytes);
+      _chanIndex.clear();
+      for(std::size_t i=0; i<_rows.size(); i++) _chanIndex[_rows[i].channel()] = i;
+    }
+
   private:
     std::vector<Row> _rows;
     std::map<int,std::size_t> _chanIndex;
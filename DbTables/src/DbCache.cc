@@ -2,36 +2,100 @@
 #include "DbTables/inc/DbCache.hh"
 
 void mu2e::DbCache::add(int cid, mu2e::DbTable::cptr_t const& ptr) { 
-  _tables[cid] = ptr;
+  std::lock_guard lock(_mutex);
+  auto it = _tables.find(cid);
+  if(it != _tables.end()) {
+    _bytes -= it->second.bytes;
+    _lru.erase(it->second.lru);
+    _tables.erase(it);
+  }
+  _lru.push_front(cid);
+  size_t bytes = ptr->size();
+  _tables[cid] = Entry{ptr,bytes,_lru.begin()};
+  _bytes += bytes;
+  _bytesAdded += bytes;
+  // the new table stays, even if it is larger than the limit
+  if(_maxBytes>0 && _bytes>_maxBytes) evict(_maxBytes);
 }
 
-mu2e::DbTable::cptr_t mu2e::DbCache::get(int cid) {
+bool mu2e::DbCache::hasTable(int cid) {
+  std::lock_guard lock(_mutex);
+  return _tables.find(cid)!=_tables.end();
+}
+
+mu2e::DbTable::cptr_t mu2e::DbCache::get(int cid, bool countUse) {
+  std::lock_guard lock(_mutex);
   auto it = _tables.find(cid);
   if(it != _tables.end()) {
-    return it->second;
+    // move to the front of the lru list
+    _lru.splice(_lru.begin(),_lru,it->second.lru);
+    if(countUse) _nHit++;
+    return it->second.ptr;
   } else {
+    if(countUse) _nMiss++;
     return mu2e::DbTable::cptr_t(nullptr);
   }
 }
 
+void mu2e::DbCache::setMaxBytes(size_t maxBytes) {
+  std::lock_guard lock(_mutex);
+  _maxBytes = maxBytes;
+  if(_maxBytes>0 && _bytes>_maxBytes) evict(_maxBytes);
+}
+
+void mu2e::DbCache::clear() {
+  std::lock_guard lock(_mutex);
+  _tables.clear();
+  _lru.clear();
+  _bytes = 0;
+}
+
 int mu2e::DbCache::purge(const size_t target) {
-  // loop over tables, remove oldest
-  size_t current = size();
-  if(current<1.1*target) return 0;
+  std::lock_guard lock(_mutex);
+  return evict(target);
+}
 
-  return 0;
+// remove the least recently used, but not the most recent
+int mu2e::DbCache::evict(const size_t target) {
+  int n = 0;
+  while(_bytes>target && _lru.size()>1) {
+    auto it = _tables.find(_lru.back());
+    _bytes -= it->second.bytes;
+    _bytesEvicted += it->second.bytes;
+    _nEvicted++;
+    _tables.erase(it);
+    _lru.pop_back();
+    n++;
+  }
+  return n;
 }
 
 size_t mu2e::DbCache::size() {
-  size_t s=0;
-  for(auto const& t : _tables) s += t.second->size();
-  return s;
+  std::lock_guard lock(_mutex);
+  return _bytes;
 }
 
 
-void mu2e::DbCache::print() const {
-  for(auto t: _tables) {
+void mu2e::DbCache::print() {
+  std::lock_guard lock(_mutex);
+  for(auto const& t: _tables) {
     std::cout << std::setw(6) << t.first << " " 
-	      << std::setw(15) << t.second->name() << std::endl;
+	      << std::setw(15) << t.second.ptr->name() << std::endl;
+  }
+}
+
+void mu2e::DbCache::printStats(std::ostream& os) {
+  std::lock_guard lock(_mutex);
+  size_t n = _nHit + _nMiss;
+  os << "DbCache: " << _nHit << " hits, " << _nMiss << " misses";
+  if(n>0) {
+    auto prec = os.precision(3);
+    os << ", hit ratio " << double(_nHit)/n;
+    os.precision(prec);
   }
+  os << std::endl;
+  os << "    " << _tables.size() << " tables, " << _bytes << " b cached";
+  if(_maxBytes>0) os << " (max " << _maxBytes << " b)";
+  os << ", " << _bytesAdded << " b added, " << _nEvicted 
+     << " tables (" << _bytesEvicted << " b) evicted" << std::endl;
 }
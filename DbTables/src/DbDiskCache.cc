@@ -0,0 +1,105 @@
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "cetlib_except/exception.h"
+#include "DbTables/inc/DbDiskCache.hh"
+
+void mu2e::DbDiskCache::setDirectory(std::string const& dir, 
+				     std::string const& dbName) {
+  _dir.clear();
+  if(dir.empty()) return;
+
+  std::string path = dir + "/" + dbName;
+  // make each level of the path, group writable so jobs of
+  // different users can share it
+  size_t pos = 0;
+  do {
+    pos = path.find('/',pos+1);
+    std::string sub = path.substr(0,pos);
+    if(::mkdir(sub.c_str(),0775)!=0 && errno!=EEXIST) {
+      throw cet::exception("DBDISKCACHE_BAD_DIRECTORY")
+	<< "DbDiskCache::setDirectory could not create " << sub << "\n";
+    }
+  } while(pos != std::string::npos);
+  _dir = path;
+}
+
+std::string mu2e::DbDiskCache::fileName(int cid) const {
+  return _dir + "/" + std::to_string(cid) + ".csv";
+}
+
+int mu2e::DbDiskCache::get(int cid, std::string& csv, fetch_t const& fetch) {
+
+  std::string fn = fileName(cid);
+  if(readFile(fn,csv)) {
+    _nHit++;
+    return 0;
+  }
+
+  // only one job fetches a cid, the others wait here
+  int fd = ::open((fn+".lock").c_str(),O_RDWR|O_CREAT,0664);
+  if(fd>=0) ::flock(fd,LOCK_EX);
+
+  int rc = 0;
+  if(readFile(fn,csv)) { // another job fetched it while we waited
+    _nHit++;
+  } else {
+    _nMiss++;
+    rc = fetch(csv);
+    if(rc==0 && !writeFile(fn,csv)) _nFailed++;
+  }
+
+  if(fd>=0) {
+    ::flock(fd,LOCK_UN);
+    ::close(fd);
+  }
+  return rc;
+}
+
+bool mu2e::DbDiskCache::readFile(std::string const& fn, std::string& csv) {
+  std::ifstream in(fn,std::ios::binary);
+  if(!in.is_open()) return false;
+  std::ostringstream ss;
+  ss << in.rdbuf();
+  if(in.bad()) return false;
+  csv = ss.str();
+  _bytesRead += csv.size();
+  return true;
+}
+
+// write a temporary file unique to this process and thread,
+// then move it into place
+bool mu2e::DbDiskCache::writeFile(std::string const& fn, std::string const& csv) {
+  static std::atomic<unsigned> count(0);
+  std::string tmp = fn + ".tmp." + std::to_string(::getpid()) 
+    + "." + std::to_string(count++);
+  std::ofstream out(tmp,std::ios::binary|std::ios::trunc);
+  out.write(csv.data(),csv.size());
+  out.close();
+  if(!out || std::rename(tmp.c_str(),fn.c_str())!=0) {
+    std::remove(tmp.c_str());
+    return false;
+  }
+  _bytesWritten += csv.size();
+  return true;
+}
+
+void mu2e::DbDiskCache::printStats(std::ostream& os) const {
+  size_t n = _nHit + _nMiss;
+  os << "DbDiskCache " << _dir << ": " << _nHit << " hits, " 
+     << _nMiss << " misses";
+  if(n>0) {
+    auto prec = os.precision(3);
+    os << ", hit ratio " << double(_nHit)/n;
+    os.precision(prec);
+  }
+  os << std::endl;
+  os << "    " << _bytesRead << " b read, " << _bytesWritten << " b written";
+  if(_nFailed>0) os << ", " << _nFailed << " tables could not be written";
+  os << std::endl;
+}
@@ -0,0 +1,346 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "cetlib_except/exception.h"
+#include "DbTables/inc/DbSnapshot.hh"
+#include "DbTables/inc/DbTableFactory.hh"
+#include "DbTables/inc/DbUtil.hh"
+
+namespace {
+
+  const char snapshotMagic[8] = {'M','U','2','E','D','B','S','N'};
+  const uint32_t byteOrderMark = 0x01020304;
+
+  struct FileHeader {
+    char magic[8];
+    uint32_t format;
+    uint32_t byteOrder;
+    uint32_t ntables;
+    uint32_t purposeSize;
+    uint32_t versionSize;
+    uint32_t reserved;
+  };
+
+  const std::vector<std::string> valTableNames = {
+    "ValTables","ValCalibrations","ValIovs","ValGroups","ValGroupLists",
+    "ValPurposes","ValLists","ValTableLists","ValVersions",
+    "ValExtensions","ValExtensionLists" };
+
+  // keep every block 8-byte aligned in the file
+  void pad(std::string& buf) {
+    while(buf.size()%8!=0) buf.push_back('\0');
+  }
+
+  template<typename T>
+  void append(std::string& buf, T const& value) {
+    buf.append(reinterpret_cast<const char*>(&value),sizeof(T));
+  }
+
+}
+
+constexpr uint32_t mu2e::DbSnapshot::formatVersion;
+
+void mu2e::DbSnapshot::write(std::string const& fileName,
+			     DbVersion const& version,
+			     DbValCache const& vcache,
+			     table_map const& tables) {
+
+  std::string purpose = version.purpose();
+  // major/minor/extension, -1 if not specified
+  std::string vstr = std::to_string(version.major()) + "/"
+    + std::to_string(version.minor()) + "/"
+    + std::to_string(version.extension());
+
+  std::string buf;
+  FileHeader fh;
+  std::memcpy(fh.magic,snapshotMagic,sizeof(fh.magic));
+  fh.format = formatVersion;
+  fh.byteOrder = byteOrderMark;
+  fh.ntables = valTableNames.size() + tables.size();
+  fh.purposeSize = purpose.size();
+  fh.versionSize = vstr.size();
+  fh.reserved = 0;
+  append(buf,fh);
+  buf.append(purpose);
+  buf.append(vstr);
+  pad(buf);
+
+  for(auto const& name : valTableNames) {
+    writeTable(buf,vcache.asTable(name),-1,-1);
+  }
+  for(auto const& p : tables) {
+    int cid = p.first;
+    int tid = vcache.valCalibrations().row(cid).tid();
+    writeTable(buf,*p.second,tid,cid);
+  }
+
+  // write to a temporary and rename, so a reader never sees part of a file
+  std::string tmpName = fileName + ".tmp";
+  std::ofstream os(tmpName,std::ios::binary|std::ios::trunc);
+  os.write(buf.data(),buf.size());
+  os.close();
+  if(!os || std::rename(tmpName.c_str(),fileName.c_str())!=0) {
+    std::remove(tmpName.c_str());
+    throw cet::exception("DBSNAPSHOT_WRITE_FAILED")
+      << "DbSnapshot::write could not write " << fileName << "\n";
+  }
+
+}
+
+void mu2e::DbSnapshot::writeTable(std::string& buf, DbTable const& table,
+				  int tid, int cid) {
+
+  EntryHeader eh;
+  eh.tid = tid;
+  eh.cid = cid;
+  eh.nameSize = table.name().size();
+  eh.nrow = table.nrow();
+  eh.ncol = 0;
+
+  std::string data;
+  if(table.hasBinaryRows()) {
+    eh.encoding = binaryRows;
+    data = table.rowsToBinary();
+  } else {
+    // offsets of the columns in a pool of the column text
+    eh.encoding = splitColumns;
+    std::vector<std::string> lines;
+    if(!table.csv().empty()) {
+      lines = DbUtil::splitCsvLines(table.csv());
+    } else {
+      for(std::size_t i=0; i<table.nrow(); i++) {
+	std::ostringstream ss;
+	table.rowToCsv(ss,i);
+	lines.emplace_back(ss.str());
+      }
+    }
+    std::vector<uint32_t> offsets;
+    std::string pool;
+    for(auto const& line : lines) {
+      auto columns = DbUtil::splitCsv(line);
+      if(eh.ncol==0) eh.ncol = columns.size();
+      if(columns.size()!=eh.ncol) {
+	throw cet::exception("DBSNAPSHOT_BAD_COLUMN_COUNT")
+	  << "DbSnapshot::write found " << columns.size()
+	  << " columns when " << eh.ncol << " was seen in previous rows of "
+	  << table.name() << "\n";
+      }
+      for(auto const& c : columns) {
+	offsets.push_back(pool.size());
+	pool.append(c);
+      }
+    }
+    offsets.push_back(pool.size());
+    eh.nrow = lines.size();
+    data.append(reinterpret_cast<const char*>(offsets.data()),
+		offsets.size()*sizeof(uint32_t));
+    data.append(pool);
+  }
+  eh.nbytes = data.size();
+
+  append(buf,eh);
+  buf.append(table.name());
+  pad(buf);
+  buf.append(data);
+  pad(buf);
+
+}
+
+void mu2e::DbSnapshot::open(std::string const& fileName) {
+
+  close();
+
+  int fd = ::open(fileName.c_str(),O_RDONLY);
+  if(fd<0) {
+    throw cet::exception("DBSNAPSHOT_OPEN_FAILED")
+      << "DbSnapshot::open could not open " << fileName << "\n";
+  }
+  struct stat st;
+  void* addr = MAP_FAILED;
+  if(fstat(fd,&st)==0 && st.st_size>0) {
+    addr = mmap(nullptr,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+  }
+  ::close(fd); // the mapping stays valid
+  if(addr==MAP_FAILED) {
+    throw cet::exception("DBSNAPSHOT_OPEN_FAILED")
+      << "DbSnapshot::open could not map " << fileName << "\n";
+  }
+  _fileName = fileName;
+  _data = static_cast<const char*>(addr);
+  _nbytes = st.st_size;
+
+  // walk through the file, checking every block is inside it
+  std::size_t pos = 0;
+  auto take = [this,&pos](std::size_t n) {
+    if(n>_nbytes || pos>_nbytes-n) {
+      std::string fn = _fileName;
+      close();
+      throw cet::exception("DBSNAPSHOT_BAD_FILE")
+	<< "DbSnapshot::open file is truncated or corrupt: " << fn << "\n";
+    }
+    const char* p = _data + pos;
+    pos += n;
+    return p;
+  };
+  auto align = [&pos]() { pos = (pos+7)/8*8; };
+
+  FileHeader fh;
+  std::memcpy(&fh,take(sizeof(fh)),sizeof(fh));
+  if(std::memcmp(fh.magic,snapshotMagic,sizeof(fh.magic))!=0 ||
+     fh.byteOrder!=byteOrderMark || fh.format!=formatVersion) {
+    close();
+    throw cet::exception("DBSNAPSHOT_BAD_FILE")
+      << "DbSnapshot::open " << fileName << " is not a snapshot of format "
+      << formatVersion << " written with this byte order\n";
+  }
+  _purpose.assign(take(fh.purposeSize),fh.purposeSize);
+  _version.assign(take(fh.versionSize),fh.versionSize);
+  align();
+
+  for(uint32_t i=0; i<fh.ntables; i++) {
+    Entry entry;
+    std::memcpy(&entry.header,take(sizeof(EntryHeader)),sizeof(EntryHeader));
+    entry.name.assign(take(entry.header.nameSize),entry.header.nameSize);
+    align();
+    entry.data = take(entry.header.nbytes);
+    align();
+    if(entry.header.encoding==splitColumns &&
+       entry.header.nbytes < (entry.header.nrow*entry.header.ncol+1)*sizeof(uint32_t)) {
+      std::string fn = _fileName;
+      close();
+      throw cet::exception("DBSNAPSHOT_BAD_FILE")
+	<< "DbSnapshot::open bad column index for table " << entry.name
+	<< " in " << fn << "\n";
+    }
+    if(entry.header.cid<0) {
+      _vals[entry.name] = entry;
+    } else {
+      _cids[entry.header.cid] = entry;
+    }
+  }
+
+}
+
+void mu2e::DbSnapshot::close() {
+  if(_data) munmap(const_cast<char*>(_data),_nbytes);
+  _data = nullptr;
+  _nbytes = 0;
+  _vals.clear();
+  _cids.clear();
+}
+
+void mu2e::DbSnapshot::fillValCache(DbValCache& vcache) const {
+  ValTables tables;
+  fillValTable(tables);
+  vcache.setValTables(tables);
+  ValCalibrations calibrations;
+  fillValTable(calibrations);
+  vcache.setValCalibrations(calibrations);
+  ValIovs iovs;
+  fillValTable(iovs);
+  vcache.setValIovs(iovs);
+  ValGroups groups;
+  fillValTable(groups);
+  vcache.setValGroups(groups);
+  ValGroupLists grouplists;
+  fillValTable(grouplists);
+  vcache.setValGroupLists(grouplists);
+  ValPurposes purposes;
+  fillValTable(purposes);
+  vcache.setValPurposes(purposes);
+  ValLists lists;
+  fillValTable(lists);
+  vcache.setValLists(lists);
+  ValTableLists tablelists;
+  fillValTable(tablelists);
+  vcache.setValTableLists(tablelists);
+  ValVersions versions;
+  fillValTable(versions);
+  vcache.setValVersions(versions);
+  ValExtensions extensions;
+  fillValTable(extensions);
+  vcache.setValExtensions(extensions);
+  ValExtensionLists extensionlists;
+  fillValTable(extensionlists);
+  vcache.setValExtensionLists(extensionlists);
+}
+
+std::vector<int> mu2e::DbSnapshot::cids() const {
+  std::vector<int> cids;
+  for(auto const& p : _cids) cids.push_back(p.first);
+  return cids;
+}
+
+int mu2e::DbSnapshot::tid(int cid) const {
+  auto ii = _cids.find(cid);
+  if(ii==_cids.end()) return -1;
+  return ii->second.header.tid;
+}
+
+mu2e::DbTable::ptr_t mu2e::DbSnapshot::table(int cid) const {
+  auto ii = _cids.find(cid);
+  if(ii==_cids.end()) return DbTable::ptr_t();
+  auto ptr = DbTableFactory::newTable(ii->second.name);
+  fillTable(ii->second,*ptr);
+  return ptr;
+}
+
+void mu2e::DbSnapshot::fillValTable(DbTable& table) const {
+  auto ii = _vals.find(table.name());
+  if(ii==_vals.end()) {
+    throw cet::exception("DBSNAPSHOT_MISSING_TABLE")
+      << "DbSnapshot::fillValCache did not find " << table.name()
+      << " in " << _fileName << "\n";
+  }
+  fillTable(ii->second,table);
+}
+
+void mu2e::DbSnapshot::fillTable(Entry const& entry, DbTable& table) const {
+
+  table.clear();
+  EntryHeader const& eh = entry.header;
+
+  if(eh.encoding==binaryRows) {
+    if(!table.hasBinaryRows()) {
+      throw cet::exception("DBSNAPSHOT_BAD_ENCODING")
+	<< "DbSnapshot found binary rows for table " << table.name()
+	<< ", which cannot be filled from binary\n";
+    }
+    table.fillBinary(entry.data,eh.nbytes);
+    return;
+  }
+
+  const char* pool = entry.data + (eh.nrow*eh.ncol+1)*sizeof(uint32_t);
+  std::size_t poolSize = eh.nbytes - (eh.nrow*eh.ncol+1)*sizeof(uint32_t);
+  std::vector<std::string> columns(eh.ncol);
+  uint32_t start,end;
+  std::memcpy(&start,entry.data,sizeof(uint32_t));
+  std::size_t k = 0;
+  for(std::size_t irow=0; irow<eh.nrow; irow++) {
+    for(auto& c : columns) {
+      k++;
+      std::memcpy(&end,entry.data+k*sizeof(uint32_t),sizeof(uint32_t));
+      if(end<start || end>poolSize) {
+	throw cet::exception("DBSNAPSHOT_BAD_FILE")
+	  << "DbSnapshot found a bad column offset in table "
+	  << table.name() << "\n";
+      }
+      c.assign(pool+start,end-start);
+      start = end;
+    }
+    table.addRow(columns);
+  }
+
+  if(table.nrowFix()>0 && table.nrow()!=table.nrowFix()) {
+    throw cet::exception("DBTABLE_BAD_ROW_COUNT")
+      << "DbSnapshot row count is "
+      << std::to_string(table.nrow()) << " but "
+      << std::to_string(table.nrowFix()) << " is required while filling "
+      << table.name() << "\n";
+  }
+
+}
@@ -56,3 +56,30 @@ void mu2e::DbTable::rowToCsv(std::ostringstream& stream, size_t irow) const {
   throw cet::exception("DBTABLE_FUNCTION_NOT_IMPLEMENTED") 
     << "DbTable::rowToCsv must be overridden ";
 }
+
+std::string mu2e::DbTable::rowsToBinary() const {
+  throw cet::exception("DBTABLE_FUNCTION_NOT_IMPLEMENTED") 
+    << "DbTable::rowsToBinary not available for " << name() << "\n";
+}
+
+void mu2e::DbTable::fillBinary(const char* data, std::size_t nbytes) {
+  throw cet::exception("DBTABLE_FUNCTION_NOT_IMPLEMENTED") 
+    << "DbTable::fillBinary not available for " << name() << "\n";
+}
+
+void mu2e::DbTable::checkBinarySize(std::size_t nbytes, 
+				    std::size_t rowSize) const {
+  if(nbytes%rowSize!=0) {
+    throw cet::exception("DBTABLE_BAD_BINARY_SIZE") 
+      << "DbTable::fillBinary found " << nbytes 
+      << " bytes, which is not a multiple of the row size "
+      << rowSize << " while filling " << name() << "\n";
+  }
+  if(nrowFix()>0 && nbytes/rowSize!=nrowFix()) {
+    throw cet::exception("DBTABLE_BAD_ROW_COUNT") 
+      << "DbTable::fillBinary row count is "
+      << std::to_string(nbytes/rowSize) << " but "
+      << std::to_string(nrowFix()) << " is required while filling "
+      << name() << "\n";
+  }
+}
@@ -35,10 +35,14 @@
 #include "MCDataProducts/inc/CaloShowerStep.hh"
 #include "MCDataProducts/inc/StrawGasStep.hh"
 #include "MCDataProducts/inc/CrvStep.hh"
+#include "MCDataProducts/inc/CaloShowerRO.hh"
+#include "MCDataProducts/inc/CaloShowerSim.hh"
+#include "MCDataProducts/inc/CrvPhotons.hh"
 #include "MCDataProducts/inc/ExtMonFNALSimHitCollection.hh"
 #include "MCDataProducts/inc/ProtonBunchIntensity.hh"
 #include "MCDataProducts/inc/SimParticleTimeMap.hh"
 #include "MCDataProducts/inc/PhysicalVolumeInfoMultiCollection.hh"
+#include "TrackerMC/inc/StrawCluster.hh"
 
 
 
@@ -95,6 +99,13 @@ namespace mu2e {
       fhicl::Table<CollectionMixerConfig> protonTimeMapMixer { fhicl::Name("protonTimeMapMixer") };
       fhicl::Table<CollectionMixerConfig> eventIDMixer { fhicl::Name("eventIDMixer") };
 
+      // Pre-digitized background frames.  Their Ptrs point to the steps
+      // mixed by the step mixers above, from the same input events.
+      fhicl::Table<CollectionMixerConfig> strawClusterMixer { fhicl::Name("strawClusterMixer") };
+      fhicl::Table<CollectionMixerConfig> caloShowerROMixer { fhicl::Name("caloShowerROMixer") };
+      fhicl::Table<CollectionMixerConfig> caloShowerSimMixer { fhicl::Name("caloShowerSimMixer") };
+      fhicl::Table<CollectionMixerConfig> crvPhotonsMixer { fhicl::Name("crvPhotonsMixer") };
+
       fhicl::OptionalTable<VolumeInfoMixerConfig> volumeInfoMixer { fhicl::Name("volumeInfoMixer") };
     };
 
@@ -149,6 +160,22 @@ namespace mu2e {
                      art::EventIDSequence& out,
                      art::PtrRemapper const& remap);
 
+    bool mixStrawClusters(std::vector<TrackerMC::StrawClusterCollection const*> const& in,
+                          TrackerMC::StrawClusterCollection& out,
+                          art::PtrRemapper const& remap);
+
+    bool mixCaloShowerROs(std::vector<CaloShowerROCollection const*> const& in,
+                          CaloShowerROCollection& out,
+                          art::PtrRemapper const& remap);
+
+    bool mixCaloShowerSims(std::vector<CaloShowerSimCollection const*> const& in,
+                           CaloShowerSimCollection& out,
+                           art::PtrRemapper const& remap);
+
+    bool mixCrvPhotons(std::vector<CrvPhotonsCollection const*> const& in,
+                       CrvPhotonsCollection& out,
+                       art::PtrRemapper const& remap);
+
 
     //----------------
     bool mixVolumeInfos(std::vector<PhysicalVolumeInfoMultiCollection const*> const& in,
@@ -167,6 +194,11 @@ namespace mu2e {
     typedef GenParticleCollection::size_type GenOffset;
     std::vector<GenOffset> genOffsets_;
 
+    // pointed to by the pre-digitized frames
+    std::vector<CaloShowerStepCollection::size_type> caloStepOffsets_;
+    std::vector<StrawGasStepCollection::size_type> strawStepOffsets_;
+    std::vector<CrvStepCollection::size_type> crvStepOffsets_;
+
     void updateSimParticle(SimParticle& particle, SPOffset offset, art::PtrRemapper const& remap);
 
     typedef std::map<cet::map_vector_key,PhysicalVolumeInfo> VolumeMap;
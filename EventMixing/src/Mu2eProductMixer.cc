@@ -22,21 +22,28 @@ namespace mu2e {
   //----------------------------------------------------------------
   namespace {
 
-    // newEntryIndex is an address in the output (flattened)
-    // collection and the offsets are those that were recorded by the
-    // flattenCollections() call
-    template<typename IndexType, typename OFFSETS>
-    typename OFFSETS::size_type
-    getInputEventIndex(IndexType newEntryIndex, const OFFSETS& offsets) {
-      auto ub = std::upper_bound(offsets.begin(), offsets.end(), newEntryIndex);
-      if(ub == offsets.begin()) {
-        throw cet::exception("RANGE")<<"getInputEventIndex(): newEntryIndex="
-                                     <<newEntryIndex
-                                     <<" is below the first offset="
-                                     <<*offsets.begin()
-                                     <<std::endl;
+    // Copy the entries of all input collections to the output in a
+    // single pass, fixing each copy with the index of its input event
+    // while it is hot in cache.
+    // If offsets are requested, they are those of flattenCollections().
+    template<typename COLL, typename FIX>
+    void mixEntries(std::vector<COLL const*> const& in, COLL& out, FIX fix,
+                    std::vector<typename COLL::size_type>* offsets = nullptr) {
+      typename COLL::size_type n = out.size();
+      for(const auto& c: in) {
+        if(c != nullptr) n += c->size();
+      }
+      out.reserve(n);
+      if(offsets) offsets->clear();
+
+      for(typename std::vector<COLL const*>::size_type ie = 0; ie < in.size(); ++ie) {
+        if(offsets) offsets->push_back(out.size());
+        if(in[ie] == nullptr) continue;
+        for(const auto& entry: *in[ie]) {
+          out.push_back(entry);
+          fix(out.back(), ie);
+        }
       }
-      return std::distance(offsets.begin(), --ub);
     }
   }
 
@@ -100,6 +107,29 @@ namespace mu2e {
         (e.inTag, e.resolvedInstanceName(), &Mu2eProductMixer::mixEventIDs, *this);
     }
 
+    //----------------------------------------------------------------
+    // Pre-digitized frames, declared after the steps they point to
+
+    for(const auto& e: conf.strawClusterMixer().mixingMap()) {
+      helper.declareMixOp
+        (e.inTag, e.resolvedInstanceName(), &Mu2eProductMixer::mixStrawClusters, *this);
+    }
+
+    for(const auto& e: conf.caloShowerROMixer().mixingMap()) {
+      helper.declareMixOp
+        (e.inTag, e.resolvedInstanceName(), &Mu2eProductMixer::mixCaloShowerROs, *this);
+    }
+
+    for(const auto& e: conf.caloShowerSimMixer().mixingMap()) {
+      helper.declareMixOp
+        (e.inTag, e.resolvedInstanceName(), &Mu2eProductMixer::mixCaloShowerSims, *this);
+    }
+
+    for(const auto& e: conf.crvPhotonsMixer().mixingMap()) {
+      helper.declareMixOp
+        (e.inTag, e.resolvedInstanceName(), &Mu2eProductMixer::mixCrvPhotons, *this);
+    }
+
     //----------------------------------------------------------------
     // VolumeInfo handling
 
@@ -161,12 +191,14 @@ namespace mu2e {
   {
     art::flattenCollections(in, out, simOffsets_ );
 
-    // Update the Ptrs inside each SimParticle
+    // Update the Ptrs inside each SimParticle.  The output is ordered
+    // by key, and the keys of each input event start at its offset,
+    // so the input event index only moves forward.
+    SPOffsets::size_type ie = 0;
     for(auto& entry: out) {
-      auto key = entry.first;
-      auto& particle = entry.second;
-      auto ie = getInputEventIndex(key.asUint(), simOffsets_);
-      updateSimParticle(particle, ie, remap);
+      auto key = entry.first.asUint();
+      while(ie+1 < simOffsets_.size() && key >= simOffsets_[ie+1]) ++ie;
+      updateSimParticle(entry.second, ie, remap);
     }
     return true;
   }
@@ -205,14 +237,10 @@ namespace mu2e {
                                          StepPointMCCollection& out,
                                          art::PtrRemapper const& remap)
   {
-    std::vector<StepPointMCCollection::size_type> stepOffsets;
-    art::flattenCollections(in, out, stepOffsets);
-
-    for(StepPointMCCollection::size_type i=0; i<out.size(); ++i) {
-      auto ie = getInputEventIndex(i, stepOffsets);
-      auto& step = out[i];
-      step.simParticle() = remap(step.simParticle(), simOffsets_[ie]);
-    }
+    mixEntries(in, out,
+               [this,&remap](StepPointMC& step, SPOffsets::size_type ie) {
+                 step.simParticle() = remap(step.simParticle(), simOffsets_[ie]);
+               });
 
     return true;
   }
@@ -224,16 +252,19 @@ namespace mu2e {
   {
     // flattenCollections() does not seem to preserve enough info to remap ptrs in the output map.
     // Follow the pattern, including the nullptr checks, but add custom remapping code.
+    // The remapped keys of successive input events come in increasing order,
+    // so each entry is inserted with a hint at the end of the map.
 
     for(std::vector<MCTrajectoryCollection const*>::size_type ieIndex = 0; ieIndex < in.size(); ++ieIndex) {
       if (in[ieIndex] != nullptr) {
         for(const auto & orig : *in[ieIndex]) {
-          auto res = out.insert(std::make_pair(remap(orig.first, simOffsets_[ieIndex]),
-                                               MCTrajectory(remap(orig.second.sim(), simOffsets_[ieIndex]),
-                                                            orig.second.points())
-                                               ));
+          const auto oldSize = out.size();
+          out.emplace_hint(out.end(),
+                           remap(orig.first, simOffsets_[ieIndex]),
+                           MCTrajectory(remap(orig.second.sim(), simOffsets_[ieIndex]),
+                                        orig.second.points()));
 
-          if(!res.second) {
+          if(out.size() == oldSize) {
             throw cet::exception("BUG")<<"mixMCTrajectories(): failed to insert an entry, ieIndex="<<ieIndex
                                        <<", orig ptr = "<<orig.first
                                        <<std::endl;
@@ -250,14 +281,11 @@ namespace mu2e {
                                             CaloShowerStepCollection& out,
                                             art::PtrRemapper const& remap)
   {
-    std::vector<CaloShowerStepCollection::size_type> stepOffsets;
-    art::flattenCollections(in, out, stepOffsets);
-
-    for(CaloShowerStepCollection::size_type i=0; i<out.size(); ++i) {
-      auto ie = getInputEventIndex(i, stepOffsets);
-      auto& step = out[i];
-      step.setSimParticle( remap(step.simParticle(), simOffsets_[ie]) );
-    }
+    mixEntries(in, out,
+               [this,&remap](CaloShowerStep& step, SPOffsets::size_type ie) {
+                 step.setSimParticle( remap(step.simParticle(), simOffsets_[ie]) );
+               },
+               &caloStepOffsets_);
 
     return true;
   }
@@ -267,14 +295,11 @@ namespace mu2e {
                                           StrawGasStepCollection& out,
                                           art::PtrRemapper const& remap)
   {
-    std::vector<StrawGasStepCollection::size_type> stepOffsets;
-    art::flattenCollections(in, out, stepOffsets);
-
-    for(StrawGasStepCollection::size_type i=0; i<out.size(); ++i) {
-      auto ie = getInputEventIndex(i, stepOffsets);
-      auto& step = out[i];
-      step.simParticle() = remap(step.simParticle(), simOffsets_[ie]);
-    }
+    mixEntries(in, out,
+               [this,&remap](StrawGasStep& step, SPOffsets::size_type ie) {
+                 step.simParticle() = remap(step.simParticle(), simOffsets_[ie]);
+               },
+               &strawStepOffsets_);
 
     return true;
   }
@@ -283,14 +308,11 @@ namespace mu2e {
                                           CrvStepCollection& out,
                                           art::PtrRemapper const& remap)
   {
-    std::vector<CrvStepCollection::size_type> stepOffsets;
-    art::flattenCollections(in, out, stepOffsets);
-
-    for(CrvStepCollection::size_type i=0; i<out.size(); ++i) {
-      auto ie = getInputEventIndex(i, stepOffsets);
-      auto& step = out[i];
-      step.simParticle() = remap(step.simParticle(), simOffsets_[ie]);
-    }
+    mixEntries(in, out,
+               [this,&remap](CrvStep& step, SPOffsets::size_type ie) {
+                 step.simParticle() = remap(step.simParticle(), simOffsets_[ie]);
+               },
+               &crvStepOffsets_);
 
     return true;
   }
@@ -300,14 +322,10 @@ namespace mu2e {
                                           ExtMonFNALSimHitCollection& out,
                                           art::PtrRemapper const& remap)
   {
-    std::vector<ExtMonFNALSimHitCollection::size_type> stepOffsets;
-    art::flattenCollections(in, out, stepOffsets);
-
-    for(ExtMonFNALSimHitCollection::size_type i=0; i<out.size(); ++i) {
-      auto ie = getInputEventIndex(i, stepOffsets);
-      auto& step = out[i];
-      step.setSimParticle( remap(step.simParticle(), simOffsets_[ie]) );
-    }
+    mixEntries(in, out,
+               [this,&remap](ExtMonFNALSimHit& hit, SPOffsets::size_type ie) {
+                 hit.setSimParticle( remap(hit.simParticle(), simOffsets_[ie]) );
+               });
 
     return true;
   }
@@ -350,6 +368,65 @@ namespace mu2e {
     return true;
   }
 
+  //----------------------------------------------------------------
+  bool Mu2eProductMixer::mixStrawClusters(std::vector<TrackerMC::StrawClusterCollection const*> const& in,
+                                          TrackerMC::StrawClusterCollection& out,
+                                          art::PtrRemapper const& remap)
+  {
+    mixEntries(in, out,
+               [this,&remap](TrackerMC::StrawCluster& clust, SPOffsets::size_type ie) {
+                 clust.setStrawGasStep( remap(clust.strawGasStep(), strawStepOffsets_.at(ie)) );
+               });
+
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  bool Mu2eProductMixer::mixCaloShowerROs(std::vector<CaloShowerROCollection const*> const& in,
+                                          CaloShowerROCollection& out,
+                                          art::PtrRemapper const& remap)
+  {
+    mixEntries(in, out,
+               [this,&remap](CaloShowerRO& ro, SPOffsets::size_type ie) {
+                 ro.setCaloShowerStep( remap(ro.caloShowerStep(), caloStepOffsets_.at(ie)) );
+               });
+
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  bool Mu2eProductMixer::mixCaloShowerSims(std::vector<CaloShowerSimCollection const*> const& in,
+                                           CaloShowerSimCollection& out,
+                                           art::PtrRemapper const& remap)
+  {
+    mixEntries(in, out,
+               [this,&remap](CaloShowerSim& sim, SPOffsets::size_type ie) {
+                 CaloShowerSim::StepPtrs steps;
+                 steps.reserve(sim.caloShowerSteps().size());
+                 for(const auto& step: sim.caloShowerSteps()) {
+                   steps.emplace_back(remap(step, caloStepOffsets_.at(ie)));
+                 }
+                 sim.setCaloShowerSteps(steps);
+               });
+
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  bool Mu2eProductMixer::mixCrvPhotons(std::vector<CrvPhotonsCollection const*> const& in,
+                                       CrvPhotonsCollection& out,
+                                       art::PtrRemapper const& remap)
+  {
+    mixEntries(in, out,
+               [this,&remap](CrvPhotons& photons, SPOffsets::size_type ie) {
+                 for(auto& photon: photons.GetPhotons()) {
+                   photon._step = remap(photon._step, crvStepOffsets_.at(ie));
+                 }
+               });
+
+    return true;
+  }
+
   //----------------------------------------------------------------
   bool Mu2eProductMixer::mixVolumeInfos(std::vector<PhysicalVolumeInfoMultiCollection const*> const &in,
                                         PhysicalVolumeInfoMultiCollection& out,
@@ -45,6 +45,9 @@ namespace mu2e {
         std::vector<BFMapType> _innerTypes;
         std::vector<BFMapType> _outerTypes;
 
+        // Verify the payload checksum when opening .bfmap files.
+        bool _verifyMappedChecksums;
+
         // Load a series of parametric magnetic field maps.
         void loadParam(BFieldManager::MapContainerType* whichMap,
                        const BFieldConfig::FileSequenceType& files,
@@ -84,12 +87,24 @@ namespace mu2e {
         // Read a G4BL map that was stored using writeG4BLBinary.
         void readG4BLBinary(const std::string& headerFilename, BFGridMap& bfmap);
 
+        // Create a new magnetic field map from a memory-mappable .bfmap file written from a map
+        // of the given type.
+        void loadMapped(BFieldManager::MapContainerType* whichMap,
+                        const std::string& key,
+                        const std::string& resolvedFileName,
+                        BFMapType mapType,
+                        double scaleFactor,
+                        BFInterpolationStyle interpStyle);
+
         // Read a CSV with values for parametric map.
         void readParamFile(const std::string& filename, BFParamMap& bfmap);
 
         // Write an existing BFMap in binary format.
         void writeG4BLBinary(const BFGridMap& bf, const std::string& outputfile);
 
+        // Write an existing BFMap in the memory-mappable .bfmap format.
+        void writeMappedBinary(const BFGridMap& bf, const std::string& outputfile);
+
         // Compute the size of the array needed to hold the raw data of the field map.
         int computeArraySize(int fd, const std::string& filename);
 
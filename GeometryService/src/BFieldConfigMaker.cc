@@ -43,6 +43,13 @@ namespace mu2e {
     BFieldConfigMaker::BFieldConfigMaker(const SimpleConfig& config, const Beamline& beamg)
         : bfconf_(new BFieldConfig()) {
         bfconf_->writeBinaries_ = config.getBool("bfield.writeG4BLBinaries", false);
+        bfconf_->binaryFormat_ = config.getString("bfield.binaryFormat", "G4BL");
+        bfconf_->verifyMappedChecksums_ = config.getBool("bfield.verifyMappedChecksums", false);
+        if (bfconf_->binaryFormat_ != "G4BL" && bfconf_->binaryFormat_ != "mapped") {
+            throw cet::exception("GEOM")
+                << "Unknown value of bfield.binaryFormat: " << bfconf_->binaryFormat_
+                << ".  Valid values are G4BL and mapped.\n";
+        }
         bfconf_->verbosityLevel_ = config.getInt("bfield.verbosityLevel");
         bfconf_->flipBFieldMaps_ = config.getBool("bfield.flipMaps", false);
 
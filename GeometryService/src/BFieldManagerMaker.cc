@@ -32,6 +32,7 @@
 #include "BFieldGeom/inc/BFInterpolationStyle.hh"
 #include "BFieldGeom/inc/BFieldConfig.hh"
 #include "BFieldGeom/inc/BFieldManager.hh"
+#include "BFieldGeom/inc/BFMapFile.hh"
 #include "BFieldGeom/inc/DiskRecord.hh"
 #include "GeneralUtilities/inc/MinMax.hh"
 #include "GeometryService/inc/BFieldManagerMaker.hh"
@@ -65,6 +66,14 @@ namespace mu2e {
             }
             return file;
         }
+
+        // Maps written by writeMappedBinary are recognized by their extension, whatever the
+        // format of the map they were written from.
+        bool isMappedFile(const std::string& file) {
+            static const std::string ext(".bfmap");
+            return file.size() >= ext.size() &&
+                   file.compare(file.size() - ext.size(), ext.size(), ext) == 0;
+        }
     }  // namespace
 
     //
@@ -81,7 +90,9 @@ namespace mu2e {
     }
 
     BFieldManagerMaker::BFieldManagerMaker(const BFieldConfig& config)
-        : _resolveFullPath(), _bfmgr(new BFieldManager()) {
+        : _resolveFullPath(),
+          _bfmgr(new BFieldManager()),
+          _verifyMappedChecksums(config.verifyMappedChecksums()) {
         bfieldVerbosityLevel = config.verbosityLevel();
 
         // break potential mapTypeList into two vectors... kind of ugly right now.
@@ -99,9 +110,15 @@ namespace mu2e {
         if (config.mapType() == BFMapType::GMC) {
             // Add the field maps.
             for (unsigned i = 0; i < config.gmcDimensions().size(); ++i) {
-                readGMCMap(basename(config.outerMapFiles()[i]),
-                           _resolveFullPath(config.outerMapFiles()[i]), config.gmcDimensions()[i],
-                           config.scaleFactor(), config.interpolationStyle());
+                const std::string mapkey = basename(config.outerMapFiles()[i]);
+                const std::string resolvedFileName = _resolveFullPath(config.outerMapFiles()[i]);
+                if (isMappedFile(resolvedFileName)) {
+                    loadMapped(&_bfmgr->outerMaps_, mapkey, resolvedFileName, BFMapType::GMC,
+                               config.scaleFactor(), config.interpolationStyle());
+                } else {
+                    readGMCMap(mapkey, resolvedFileName, config.gmcDimensions()[i],
+                               config.scaleFactor(), config.interpolationStyle());
+                }
             }
 
         } else if (config.mapType() == BFMapType::G4BL) {
@@ -139,17 +156,38 @@ namespace mu2e {
         }
 
         if (config.writeBinaries()) {
+            const bool mapped = (config.binaryFormat() == "mapped");
             for (BFieldManager::MapContainerType::const_iterator i = _bfmgr->getInnerMaps().begin();
                  i != _bfmgr->getInnerMaps().end(); ++i) {
-                writeG4BLBinary(dynamic_cast<const BFGridMap&>(**i), (*i)->getKey() + ".bin");
+                if (mapped) {
+                    writeMappedBinary(dynamic_cast<const BFGridMap&>(**i), (*i)->getKey() + ".bfmap");
+                } else {
+                    writeG4BLBinary(dynamic_cast<const BFGridMap&>(**i), (*i)->getKey() + ".bin");
+                }
             }
 
             for (BFieldManager::MapContainerType::const_iterator i = _bfmgr->getOuterMaps().begin();
                  i != _bfmgr->getOuterMaps().end(); ++i) {
-                writeG4BLBinary(dynamic_cast<const BFGridMap&>(**i), (*i)->getKey() + ".bin");
+                if (mapped) {
+                    writeMappedBinary(dynamic_cast<const BFGridMap&>(**i), (*i)->getKey() + ".bfmap");
+                } else {
+                    writeG4BLBinary(dynamic_cast<const BFGridMap&>(**i), (*i)->getKey() + ".bin");
+                }
             }
         }
 
+        // Repack the grid maps into the layout used for field lookups; this
+        // releases the memory used while reading the maps, so it must come after
+        // the maps have been flipped and written out.
+        for (auto const& m : _bfmgr->getInnerMaps()) {
+            if (auto gm = std::dynamic_pointer_cast<BFGridMap>(m))
+                gm->packField();
+        }
+        for (auto const& m : _bfmgr->getOuterMaps()) {
+            if (auto gm = std::dynamic_pointer_cast<BFGridMap>(m))
+                gm->packField();
+        }
+
         // For debug purposes: print the field in the target region
         if (bfieldVerbosityLevel > 0) {
             CLHEP::Hep3Vector b = _bfmgr->getBField(CLHEP::Hep3Vector(3900.0, 0.0, -6550.0));
@@ -356,11 +394,14 @@ namespace mu2e {
             BFMapType indivMapType(BFMapType::PARAM);
             if (!mapTypeList.empty())
                 indivMapType = mapTypeList[i];
+            const std::string resolvedFileName = _resolveFullPath(files[i]);
             if (indivMapType == BFMapType::PARAM) {
-                loadParam(mapContainer, mapkey, _resolveFullPath(files[i]), scaleFactor);
+                loadParam(mapContainer, mapkey, resolvedFileName, scaleFactor);
+            } else if (isMappedFile(resolvedFileName)) {
+                loadMapped(mapContainer, mapkey, resolvedFileName, BFMapType::G4BL, scaleFactor,
+                           interpStyle);
             } else {
-                loadG4BL(mapContainer, mapkey, _resolveFullPath(files[i]), scaleFactor,
-                         interpStyle);
+                loadG4BL(mapContainer, mapkey, resolvedFileName, scaleFactor, interpStyle);
             }
         }
     }
@@ -379,8 +420,14 @@ namespace mu2e {
             }
 
             const std::string mapkey = basename(*i);
+            const std::string resolvedFileName = _resolveFullPath(*i);
 
-            loadG4BL(mapContainer, mapkey, _resolveFullPath(*i), scaleFactor, interpStyle);
+            if (isMappedFile(resolvedFileName)) {
+                loadMapped(mapContainer, mapkey, resolvedFileName, BFMapType::G4BL, scaleFactor,
+                           interpStyle);
+            } else {
+                loadG4BL(mapContainer, mapkey, resolvedFileName, scaleFactor, interpStyle);
+            }
         }
     }
 
@@ -418,6 +465,8 @@ namespace mu2e {
             _bfmgr->addBFGridMap(mapContainer, key, dim[0], X0[0], dX[0], dim[1], X0[1], dX[1],
                                  dim[2], X0[2], dX[2], BFMapType::G4BL, scaleFactor, interpStyle);
         dsmap->_flipy = extendYFound;
+        dsmap->_field = Container3D<CLHEP::Hep3Vector>(dim[0], dim[1], dim[2]);
+        dsmap->_isDefined = Container3D<bool>(dim[0], dim[1], dim[2], false);
         // Fill the map from the disk file.
         if (resolvedFileName.find(".header") != string::npos) {
             readG4BLBinary(resolvedFileName, *dsmap);
@@ -426,6 +475,34 @@ namespace mu2e {
         }
     }
 
+    // Create a map whose field values are memory-mapped from a .bfmap file.
+    // The grid description is taken from the file itself; there is no header to parse.
+    void BFieldManagerMaker::loadMapped(BFieldManager::MapContainerType* mapContainer,
+                                        const std::string& key,
+                                        const std::string& resolvedFileName,
+                                        BFMapType mapType,
+                                        double scaleFactor,
+                                        BFInterpolationStyle interpStyle) {
+        auto file = std::make_shared<const BFMapFile>(resolvedFileName);
+        const BFMapFileHeader& h = file->header();
+
+        if (_verifyMappedChecksums && !file->verifyPayload()) {
+            throw cet::exception("GEOM")
+                << "BFieldManagerMaker: payload checksum mismatch in " << resolvedFileName << "\n";
+        }
+
+        if (bfieldVerbosityLevel > 1) {
+            std::cout << "BFieldManagerMaker: mapping " << resolvedFileName << " (written as "
+                      << h.key << ") grid " << h.nx << " x " << h.ny << " x " << h.nz
+                      << std::endl;
+        }
+
+        auto bfmap = _bfmgr->addBFGridMap(mapContainer, key, h.nx, h.xmin, h.dx, h.ny, h.ymin,
+                                          h.dy, h.nz, h.zmin, h.dz, mapType, scaleFactor,
+                                          interpStyle);
+        bfmap->useMappedFile(file);
+    }
+
     //
     // Read one magnetic field map file in MECO GMC format.
     //
@@ -552,6 +629,8 @@ namespace mu2e {
             &_bfmgr->outerMaps_, mapKey, nx, mmX.min(), (mmX.max() - mmX.min()) / (nx - 1), ny,
             mmY.min(), (mmY.max() - mmY.min()) / (ny - 1), nz, mmZ.min(),
             (mmZ.max() - mmZ.min()) / (nz - 1), BFMapType::GMC, scaleFactor, interpStyle);
+        bfmap->_field = Container3D<CLHEP::Hep3Vector>(nx, ny, nz);
+        bfmap->_isDefined = Container3D<bool>(nx, ny, nz, false);
 
         // Store grid points and field values into 3D arrays
         for (vector<DiskRecord>::const_iterator i = data.begin(), e = data.end(); i != e; ++i) {
@@ -878,8 +957,19 @@ namespace mu2e {
         // A marker to catch endian mismatch on readback.
         unsigned int deadbeef(0XDEADBEEF);
 
+        // The field values, in the order of Container3D.
+        std::vector<CLHEP::Hep3Vector> field;
+        field.reserve(nPoints);
+        for (int ix = 0; ix < bf.nx(); ++ix) {
+            for (int iy = 0; iy < bf.ny(); ++iy) {
+                for (int iz = 0; iz < bf.nz(); ++iz) {
+                    field.push_back(bf.fieldAt(ix, iy, iz));
+                }
+            }
+        }
+
         // Address of the first element in the big array.
-        CLHEP::Hep3Vector const* fieldAddr = &bf._field.get(0, 0, 0);
+        CLHEP::Hep3Vector const* fieldAddr = field.data();
 
         // Open the output file.
         mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
@@ -923,6 +1013,59 @@ namespace mu2e {
 
     }  // end BFieldManagerMaker::writeG4BLBinary
 
+    void BFieldManagerMaker::writeMappedBinary(const BFGridMap& bf, const std::string& outputfile) {
+        cout << "Writing Magnetic field map in mapped binary format to file: " << outputfile
+             << endl;
+
+        BFMapFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        header.nx = bf.nx();
+        header.ny = bf.ny();
+        header.nz = bf.nz();
+        header.xmin = bf.xmin();
+        header.ymin = bf.ymin();
+        header.zmin = bf.zmin();
+        header.dx = bf.dx();
+        header.dy = bf.dy();
+        header.dz = bf.dz();
+
+        std::vector<unsigned char> defined(header.nPoints(), 1);
+        bool allDefined(true);
+        for (int ix = 0; ix < bf.nx(); ++ix) {
+            for (int iy = 0; iy < bf.ny(); ++iy) {
+                for (int iz = 0; iz < bf.nz(); ++iz) {
+                    if (!bf.isDefined(ix, iy, iz)) {
+                        defined[bf.index(ix, iy, iz)] = 0;
+                        allDefined = false;
+                    }
+                }
+            }
+        }
+        header.flags = (bf.flipy() ? BFMapFileHeader::flipYFlag : 0) |
+                       (allDefined ? BFMapFileHeader::allDefinedFlag : 0);
+        std::strncpy(header.key, bf.getKey().c_str(), BFMapFileHeader::keySize - 1);
+
+        // The map is written before it is packed, so collect the components here.
+        const std::size_t nPoints = header.nPoints();
+        std::vector<double> field(3 * nPoints);
+        for (int ix = 0; ix < bf.nx(); ++ix) {
+            for (int iy = 0; iy < bf.ny(); ++iy) {
+                for (int iz = 0; iz < bf.nz(); ++iz) {
+                    const std::size_t i = bf.index(ix, iy, iz);
+                    const CLHEP::Hep3Vector b = bf.fieldAt(ix, iy, iz);
+                    field[i] = b.x();
+                    field[nPoints + i] = b.y();
+                    field[2 * nPoints + i] = b.z();
+                }
+            }
+        }
+
+        writeBFMapFile(outputfile, header, field.data(), field.data() + nPoints,
+                       field.data() + 2 * nPoints, defined.data());
+
+        cout << "Writing complete for file: " << outputfile << endl;
+    }
+
     // Compute the size of the array needed to hold the raw data of the field map.
     int BFieldManagerMaker::computeArraySize(int fd, const string& filename) {
         // Get the file size, in bytes, ( info.st_size ).
@@ -950,8 +1093,15 @@ namespace mu2e {
         return nrecords;
     }
 
+    // Called before packField().  A memory-mapped map is read-only, so it is
+    // flipped through the sign applied to its field values, which fieldAt() and
+    // therefore the binaries written from the map include.
     void BFieldManagerMaker::flipMap(BFGridMap& bf) {
         std::cout << "Flipping B field vector in map " << bf.getKey() << std::endl;
+        if (bf.isMapped()) {
+            bf._fieldSign = -bf._fieldSign;
+            return;
+        }
         for (int ix = 0; ix < bf.nx(); ++ix) {
             for (int iy = 0; iy < bf.ny(); ++iy) {
                 for (int iz = 0; iz < bf.nz(); ++iz) {
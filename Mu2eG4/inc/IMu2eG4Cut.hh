@@ -35,6 +35,7 @@
 #define Mu2eG4_IMu2eG4Cut_hh
 
 #include <memory>
+#include <vector>
 
 class G4Step;
 class G4Track;
@@ -51,6 +52,20 @@ namespace mu2e {
   class SimParticleHelper;
   class Mu2eG4ResourceLimits;
 
+  // Cut decisions that depend only on the G4 volume of the track, indexed
+  // by G4VPhysicalVolume::GetInstanceID().  Volumes beyond the end of the
+  // table get the "others" decision, tracks without a volume (possible in
+  // the stacking action) the "noVolume" one.
+  struct Mu2eG4VolumeTable {
+    std::vector<char> decisions;
+    bool others = false;
+    bool noVolume = false;
+
+    bool decision(int instanceID) const {
+      return (instanceID >= 0 && unsigned(instanceID) < decisions.size()) ? decisions[instanceID] : others;
+    }
+  };
+
   class IMu2eG4Cut {
   public:
 
@@ -70,6 +85,14 @@ namespace mu2e {
     // delete data if we don't need it (needed because of G4InternalFiltering)
     virtual void deleteCutsData() = 0;
 
+    // Whether this cut, or any cut it is made of, writes out steps.
+    virtual bool writesSteps() const = 0;
+
+    // The cut as a per-volume table if it depends on nothing but the
+    // volume and writes nothing, otherwise nullptr.  Available after
+    // finishConstruction().
+    virtual const Mu2eG4VolumeTable* volumeTable() const = 0;
+
     // Put the data products into the event.
     //virtual void put(art::Event& event) = 0;
 
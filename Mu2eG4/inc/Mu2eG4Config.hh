@@ -73,6 +73,38 @@ namespace mu2e {
       bool enabled() const { return !times().empty(); }
     };
 
+    // Build the StrawGasSteps from the tracker StepPointMCs at the end of the G4 event;
+    // the parameters are those of MakeStrawGasSteps.
+    struct StrawGasSteps_ {
+      using Name = fhicl::Name;
+      using Comment = fhicl::Comment;
+      fhicl::Atom<bool> keepStepPointMCs {Name("keepStepPointMCs"),
+          Comment("Also write the tracker StepPointMCs, e.g. to validate against MakeStrawGasSteps"), false};
+      fhicl::Atom<bool> combineDeltas {Name("CombineDeltas"),
+          Comment("Compress short delta-rays into the primary step.\n"
+                  "The tracker StepPointMCs are then kept until the end of the G4 event instead of\n"
+                  "being aggregated at the end of each track"), false};
+      fhicl::Atom<float> maxDeltaLength {Name("MaxDeltaLength"), Comment("In mm"), 0.5};
+      fhicl::Atom<float> minionBG {Name("minionBetaGamma"), 0.5};
+      fhicl::Atom<float> minionKE {Name("minionKineticEnergy"), Comment("In MeV"), 20.0};
+      fhicl::Atom<float> curlRatio {Name("CurlRatio"), 1.0};
+      fhicl::Atom<float> lineRatio {Name("LineRatio"), 10.0};
+      fhicl::Atom<unsigned> startSize {Name("StartSize"), 4};
+    };
+
+    // Build the CaloShowerSteps from the calorimeter StepPointMCs at the end of the G4 event;
+    // the parameters are those of CaloShowerStepMaker, which is run with usePhysVolInfo=false.
+    struct CaloShowerSteps_ {
+      using Name = fhicl::Name;
+      using Comment = fhicl::Comment;
+      fhicl::Atom<bool> keepStepPointMCs {Name("keepStepPointMCs"),
+          Comment("Also write the calorimeter StepPointMCs, e.g. to validate against CaloShowerStepMaker"), false};
+      fhicl::Atom<unsigned> numZSlices {Name("numZSlices"), 20};
+      fhicl::Atom<float> deltaTime {Name("deltaTime"), 0.2};
+      fhicl::Atom<bool> compressData {Name("compressData"), true};
+      fhicl::Atom<double> eDepThreshold {Name("eDepThreshold"), 0.};
+    };
+
     struct SDConfig_ {
       using Name = fhicl::Name;
       using Comment = fhicl::Comment;
@@ -91,6 +123,13 @@ namespace mu2e {
       fhicl::Sequence<std::string> sensitiveVolumes {Name("sensitiveVolumes"), {}};
       fhicl::Sequence<std::string> preSimulatedHits {Name("preSimulatedHits"), {}};
 
+      fhicl::OptionalTable<StrawGasSteps_> strawGasSteps {Name("strawGasSteps"),
+          Comment("Write StrawGasSteps instead of the tracker StepPointMCs.")
+          };
+      fhicl::OptionalTable<CaloShowerSteps_> caloShowerSteps {Name("caloShowerSteps"),
+          Comment("Write CaloShowerSteps instead of the calorimeter StepPointMCs.")
+          };
+
       // FIXME: why is this necessary?
       fhicl::Sequence<std::string> inputs {Name("inputs"), {}};
       fhicl::Atom<double> cutMomentumMin {Name("cutMomentumMin"), 0.};
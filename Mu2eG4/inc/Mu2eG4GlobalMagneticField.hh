@@ -44,7 +44,7 @@ namespace mu2e {
     // Non-owning pointer to the field map object (it is owned by the geometry service).
     const BFieldManager* _map;
 
-    // A copy of the bfield cache manager - must be thread local.
+    // A copy of the bfield cache manager; the lookup hints are kept per thread.
     BFCacheManager _cm;
 
   };
@@ -20,6 +20,9 @@
 #include "MCDataProducts/inc/MCTrajectoryCollection.hh"
 #include "MCDataProducts/inc/SimParticleRemapping.hh"
 #include "MCDataProducts/inc/ExtMonFNALSimHitCollection.hh"
+#include "MCDataProducts/inc/StrawGasStep.hh"
+#include "MCDataProducts/inc/CaloShowerStep.hh"
+#include "MCDataProducts/inc/SimParticlePtrCollection.hh"
 
 
 // C++ includes
@@ -57,6 +60,19 @@ namespace mu2e {
 
     }
 
+    void insertStrawGasSteps(std::unique_ptr<StrawGasStepCollection> steps, std::string instance_name) {
+      strawGasSteps = std::move(steps);
+      strawGasStepsName = instance_name;
+    }
+
+    void insertCaloShowerSteps(std::unique_ptr<CaloShowerStepCollection> steps,
+                               std::unique_ptr<SimParticlePtrCollection> sims,
+                               std::string instance_name) {
+      caloShowerSteps = std::move(steps);
+      caloShowerSims = std::move(sims);
+      caloShowerStepsName = instance_name;
+    }
+
     /////////////////////////////////////////////////////////////
     /////////////////////////////////////////////////////////////
     // functions to move the data into the art::Event
@@ -95,6 +111,13 @@ namespace mu2e {
 
     std::unordered_map< std::string, std::unique_ptr<StepPointMCCollection> > sensitiveDetectorSteps;
 
+    // aggregated SD steps, see SensitiveDetectorHelper
+    std::unique_ptr<StrawGasStepCollection> strawGasSteps;
+    std::string strawGasStepsName;
+    std::unique_ptr<CaloShowerStepCollection> caloShowerSteps;
+    std::unique_ptr<SimParticlePtrCollection> caloShowerSims;
+    std::string caloShowerStepsName;
+
     std::unique_ptr<IMu2eG4Cut> stackingCuts;
     std::unique_ptr<IMu2eG4Cut> steppingCuts;
     std::unique_ptr<IMu2eG4Cut> commonCuts;
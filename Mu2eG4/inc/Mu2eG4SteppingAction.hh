@@ -96,8 +96,9 @@ namespace mu2e {
 
     // MCTrajectory point filtering cuts
     const Mu2eG4TrajectoryControl* trajectoryControl_;
-    typedef std::map<const G4VPhysicalVolume*, double> VolumeCutMap;
-    VolumeCutMap mcTrajectoryVolumePtDistances_;
+    // Per-volume distance cuts indexed by G4VPhysicalVolume::GetInstanceID(),
+    // holding the default distance for volumes without a specific cut.
+    std::vector<double> mcTrajectoryVolumePtDistances_;
     // Store trajectory parameters at each G4Step; cleared at beginOfTrack time.
     std::vector<MCTrajectoryPoint> _trajectory;
 
@@ -32,6 +32,7 @@ namespace mu2e {
   class Mu2eG4SteppingAction;
   class Mu2eG4PerThreadStorage;
   class PhysicalVolumeHelper;
+  class SensitiveDetectorHelper;
   namespace Mu2eG4Config { class Top; }
 
 
@@ -41,6 +42,7 @@ namespace mu2e {
 
     Mu2eG4TrackingAction(const Mu2eG4Config::Top& conf,
                    Mu2eG4SteppingAction *,
+                   SensitiveDetectorHelper *sensitiveDetectorHelper,
                    Mu2eG4PerThreadStorage *pts);
 
     // These methods are required by G4
@@ -107,6 +109,9 @@ namespace mu2e {
     // Non-owning pointer to stepping action; lifetime of pointee is one run.
     Mu2eG4SteppingAction * _steppingAction;
 
+    // Non-owning pointer to the SD helper, which aggregates the steps of each finished track.
+    SensitiveDetectorHelper * _sensitiveDetectorHelper;
+
     // Non-owning pointer to the information about physical processes;
     // lifetime of pointee is one run.
     PhysicsProcessInfo *  _processInfo;
@@ -121,6 +126,9 @@ namespace mu2e {
     // trajectory information to the output data product.
     void swapTrajectory( const G4Track* trk );
 
+    // Hand the end of a track and the SimParticles to the SD helper.
+    void aggregateSDSteps( const G4Track* trk );
+
   };
 
 } // end namespace mu2e
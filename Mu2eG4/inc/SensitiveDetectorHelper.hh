@@ -13,13 +13,21 @@
 #include "MCDataProducts/inc/StepInstanceName.hh"
 #include "Mu2eG4/inc/ExtMonFNALPixelSD.hh"
 #include "Mu2eG4/inc/Mu2eG4Config.hh"
+#include "TrackerMC/inc/StrawGasStepBuilder.hh"
+#include "CaloMC/inc/CaloShowerStepBuilder.hh"
+#include "ProditionsService/inc/ProditionsHandle.hh"
+#include "TrackerConditions/inc/TrackerStatus.hh"
 
 // From the art tool chain
+#include "canvas/Persistency/Provenance/RunID.h"
+#include "cetlib/map_vector.h"
 #include "cetlib/maybe_ref.h"
 
 // From C++ and STL
 #include <map>
 #include <memory>
+#include <optional>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -53,7 +61,12 @@ namespace mu2e {
     void updateSensitiveDetectors(PhysicsProcessInfo& info,
                                   const SimParticleHelper& spHelper);
 
-    // add the SD data into the PerThreadStorage
+    // Aggregate the tracker and calorimeter StepPointMCs of a finished G4 track, if so configured,
+    // and release them; to be called at the end of each track, finished or suspended.
+    void afterG4Track(cet::map_vector_key trackKey, bool finished, const StrawGasStepBuilder::SimLookup& sims);
+
+    // add the SD data into the PerThreadStorage; the tracker and calorimeter StepPointMCs
+    // are replaced by their aggregated steps if so configured
     void insertSDDataIntoPerThreadStorage(Mu2eG4PerThreadStorage* per_thread_store);
 
     //filter the event data here to cut down on execution time
@@ -114,6 +127,33 @@ namespace mu2e {
     // Return all of the instances names of the data products to be produced.
     std::vector<std::string> stepInstanceNamesToBeProduced() const;
 
+    // Aggregation of the tracker and calorimeter StepPointMCs, see Mu2eG4Config::SDConfig_
+    std::optional<StrawGasStepBuilder> strawGasStepBuilder_;
+    bool combineDeltas_ = false;
+    bool keepTrackerSteps_ = true;
+    std::optional<ProditionsHandle<TrackerStatus> > trackerStatusHandle_;
+    const TrackerStatus* trackerStatus_ = nullptr;
+    const Tracker* tracker_ = nullptr;
+    art::RunID strawGasStepRun_;
+    std::optional<CaloShowerStepBuilder> caloShowerStepBuilder_;
+    bool keepCaloSteps_ = true;
+
+    // Results of the aggregation of finished tracks during the current event, see note 4.
+    StrawGasStepCollection trackGasSteps_;
+    StepPointMCCollection  keptTrackerSteps_;
+    StepPointMCCollection  keptCaloSteps_;
+    StepPointMCCollection  deferredCaloSteps_;
+    std::set<cet::map_vector_key> suspendedTracks_;
+    size_t                 nAggregatedTrackerSteps_ = 0;
+    bool                   aggregatedMomentumPassed_ = false;
+
+    // Move the steps of one track out of an SD collection, updating the filter information.
+    StepPointMCCollection takeTrackSteps(StepInstance& instance, cet::map_vector_key trackKey);
+    bool hasSuspendedAncestor(const art::Ptr<SimParticle>& sim, const StrawGasStepBuilder::SimLookup& sims) const;
+
+    void makeStrawGasSteps(Mu2eG4PerThreadStorage* per_thread_store, StepPointMCCollection& steps);
+    void makeCaloShowerSteps(Mu2eG4PerThreadStorage* per_thread_store, StepPointMCCollection& steps);
+
     // Separate handling as this detector does not produced StepPointMCs
     bool extMonPixelsEnabled_;
     ExtMonFNALPixelSD* extMonFNALPixelSD_ = nullptr;
@@ -0,0 +1,199 @@
+// Compare the StrawGasSteps and CaloShowerSteps written by Mu2eG4
+// (SDConfig.strawGasSteps and SDConfig.caloShowerSteps) with those made
+// from the StepPointMCs by MakeStrawGasSteps and CaloShowerStepMaker.
+// Both sides use the same algorithm, so the steps must agree up to the
+// order in the collections.  Any difference throws.
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <tuple>
+#include <vector>
+
+#include "cetlib_except/exception.h"
+
+#include "fhiclcpp/types/Atom.h"
+#include "fhiclcpp/types/OptionalAtom.h"
+
+#include "art/Framework/Core/EDAnalyzer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+#include "MCDataProducts/inc/StrawGasStep.hh"
+#include "MCDataProducts/inc/CaloShowerStep.hh"
+#include "MCDataProducts/inc/SimParticlePtrCollection.hh"
+
+namespace mu2e {
+
+  //================================================================
+  class CompareAggregatedSteps: public art::EDAnalyzer {
+  public:
+
+    struct Config {
+      using Name=fhicl::Name;
+      using Comment=fhicl::Comment;
+
+      fhicl::OptionalAtom<art::InputTag> strawGasSteps { Name("strawGasSteps"), Comment("StrawGasSteps from Mu2eG4") };
+      fhicl::OptionalAtom<art::InputTag> strawGasStepsReference { Name("strawGasStepsReference"), Comment("StrawGasSteps from MakeStrawGasSteps") };
+      fhicl::OptionalAtom<art::InputTag> caloShowerSteps { Name("caloShowerSteps"), Comment("CaloShowerSteps and SimParticlePtrs from Mu2eG4") };
+      fhicl::OptionalAtom<art::InputTag> caloShowerStepsReference { Name("caloShowerStepsReference"), Comment("CaloShowerSteps and SimParticlePtrs from CaloShowerStepMaker") };
+      fhicl::Atom<double> tolerance { Name("tolerance"), Comment("Relative tolerance on the floating point content"), 1.e-6 };
+    };
+
+    using Parameters = art::EDAnalyzer::Table<Config>;
+    explicit CompareAggregatedSteps(const Parameters& conf);
+
+    void analyze(const art::Event& event) override;
+    void endJob() override;
+
+  private:
+    art::InputTag sgs_, sgsRef_, css_, cssRef_;
+    bool compareTracker_ = false;
+    bool compareCalo_ = false;
+    double tolerance_;
+    unsigned long nStrawGasSteps_ = 0;
+    unsigned long nCaloShowerSteps_ = 0;
+
+    bool close(double a, double b) const {
+      return std::abs(a-b) <= tolerance_*std::max(std::abs(a), std::abs(b));
+    }
+    bool close(const XYZVec& a, const XYZVec& b) const {
+      return close(a.x(), b.x()) && close(a.y(), b.y()) && close(a.z(), b.z());
+    }
+    bool close(const CLHEP::Hep3Vector& a, const CLHEP::Hep3Vector& b) const {
+      return close(a.x(), b.x()) && close(a.y(), b.y()) && close(a.z(), b.z());
+    }
+
+    void compareStrawGasSteps(const art::Event& event);
+    void compareCaloShowerSteps(const art::Event& event);
+  };
+
+  //================================================================
+  CompareAggregatedSteps::CompareAggregatedSteps(const Parameters& conf)
+    : art::EDAnalyzer{conf}
+    , tolerance_(conf().tolerance())
+  {
+    compareTracker_ = conf().strawGasSteps(sgs_) && conf().strawGasStepsReference(sgsRef_);
+    compareCalo_ = conf().caloShowerSteps(css_) && conf().caloShowerStepsReference(cssRef_);
+
+    if(!compareTracker_ && !compareCalo_) {
+      throw cet::exception("BADCONFIG")<<"CompareAggregatedSteps: nothing to compare, "
+                                       <<"specify a pair of StrawGasStep or CaloShowerStep collections\n";
+    }
+  }
+
+  //================================================================
+  void CompareAggregatedSteps::analyze(const art::Event& event) {
+    if(compareTracker_) compareStrawGasSteps(event);
+    if(compareCalo_) compareCaloShowerSteps(event);
+  }
+
+  //================================================================
+  void CompareAggregatedSteps::compareStrawGasSteps(const art::Event& event) {
+    auto const& steps = *event.getValidHandle<StrawGasStepCollection>(sgs_);
+    auto const& ref = *event.getValidHandle<StrawGasStepCollection>(sgsRef_);
+
+    if(steps.size() != ref.size()) {
+      throw cet::exception("SIM")<<"CompareAggregatedSteps: "<<event.id()<<": "
+                                 <<steps.size()<<" StrawGasSteps in "<<sgs_<<" vs "
+                                 <<ref.size()<<" in "<<sgsRef_<<"\n";
+    }
+
+    auto order = [](const StrawGasStep* a, const StrawGasStep* b) {
+      return std::make_tuple(a->strawId().asUint16(), a->simParticle().key(), a->time())
+        < std::make_tuple(b->strawId().asUint16(), b->simParticle().key(), b->time());
+    };
+    std::vector<const StrawGasStep*> s1, s2;
+    for(const auto& s : steps) s1.push_back(&s);
+    for(const auto& s : ref) s2.push_back(&s);
+    std::stable_sort(s1.begin(), s1.end(), order);
+    std::stable_sort(s2.begin(), s2.end(), order);
+
+    for(unsigned i=0; i<s1.size(); ++i) {
+      const StrawGasStep& a = *s1[i];
+      const StrawGasStep& b = *s2[i];
+      const bool same = (a.strawId() == b.strawId())
+        && (a.simParticle() == b.simParticle())
+        && (a.stepType()._stype == b.stepType()._stype)
+        && close(a.ionizingEdep(), b.ionizingEdep())
+        && close(a.stepLength(), b.stepLength())
+        && close(a.width(), b.width())
+        && close(a.time(), b.time())
+        && close(a.startPosition(), b.startPosition())
+        && close(a.endPosition(), b.endPosition())
+        && close(a.momentum(), b.momentum());
+      if(!same) {
+        throw cet::exception("SIM")<<"CompareAggregatedSteps: "<<event.id()<<": StrawGasSteps differ\n"
+                                   <<sgs_<<": "<<a<<"\n"<<sgsRef_<<": "<<b<<"\n";
+      }
+    }
+
+    nStrawGasSteps_ += steps.size();
+  }
+
+  //================================================================
+  void CompareAggregatedSteps::compareCaloShowerSteps(const art::Event& event) {
+    auto const& steps = *event.getValidHandle<CaloShowerStepCollection>(css_);
+    auto const& ref = *event.getValidHandle<CaloShowerStepCollection>(cssRef_);
+
+    if(steps.size() != ref.size()) {
+      throw cet::exception("SIM")<<"CompareAggregatedSteps: "<<event.id()<<": "
+                                 <<steps.size()<<" CaloShowerSteps in "<<css_<<" vs "
+                                 <<ref.size()<<" in "<<cssRef_<<"\n";
+    }
+
+    auto order = [](const CaloShowerStep* a, const CaloShowerStep* b) {
+      return std::make_tuple(a->volumeG4ID(), a->simParticle().key(), a->time())
+        < std::make_tuple(b->volumeG4ID(), b->simParticle().key(), b->time());
+    };
+    std::vector<const CaloShowerStep*> s1, s2;
+    for(const auto& s : steps) s1.push_back(&s);
+    for(const auto& s : ref) s2.push_back(&s);
+    std::stable_sort(s1.begin(), s1.end(), order);
+    std::stable_sort(s2.begin(), s2.end(), order);
+
+    for(unsigned i=0; i<s1.size(); ++i) {
+      const CaloShowerStep& a = *s1[i];
+      const CaloShowerStep& b = *s2[i];
+      const bool same = (a.volumeG4ID() == b.volumeG4ID())
+        && (a.simParticle() == b.simParticle())
+        && (a.nCompress() == b.nCompress())
+        && close(a.time(), b.time())
+        && close(a.energyDepG4(), b.energyDepG4())
+        && close(a.energyDepBirks(), b.energyDepBirks())
+        && close(a.momentumIn(), b.momentumIn())
+        && close(a.position(), b.position());
+      if(!same) {
+        std::ostringstream os;
+        os<<css_<<": ";
+        a.print(os);
+        os<<cssRef_<<": ";
+        b.print(os);
+        throw cet::exception("SIM")<<"CompareAggregatedSteps: "<<event.id()<<": CaloShowerSteps differ\n"<<os.str();
+      }
+    }
+
+    // The SimParticles to keep are written in the same (Ptr) order by both
+    auto const& sims = *event.getValidHandle<SimParticlePtrCollection>(css_);
+    auto const& simsRef = *event.getValidHandle<SimParticlePtrCollection>(cssRef_);
+    if(sims != simsRef) {
+      throw cet::exception("SIM")<<"CompareAggregatedSteps: "<<event.id()<<": "
+                                 <<"SimParticlePtrCollections differ: "<<sims.size()<<" in "<<css_
+                                 <<" vs "<<simsRef.size()<<" in "<<cssRef_<<"\n";
+    }
+
+    nCaloShowerSteps_ += steps.size();
+  }
+
+  //================================================================
+  void CompareAggregatedSteps::endJob() {
+    mf::LogInfo("Summary")<<"CompareAggregatedSteps: identical "
+                          <<nStrawGasSteps_<<" StrawGasSteps and "
+                          <<nCaloShowerSteps_<<" CaloShowerSteps\n";
+  }
+
+  //================================================================
+} // namespace mu2e
+
+DEFINE_ART_MODULE(mu2e::CompareAggregatedSteps);
@@ -72,6 +72,7 @@ namespace mu2e {
 
     Mu2eG4TrackingAction* trackingAction = new Mu2eG4TrackingAction(conf_,
                                                         steppingAction,
+                                                        sensitiveDetectorHelper_,
                                                         perThreadStorage_);
     SetUserAction(trackingAction);
 
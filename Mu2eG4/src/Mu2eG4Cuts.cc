@@ -18,6 +18,7 @@
 #include "Geant4/G4Track.hh"
 #include "Geant4/G4Step.hh"
 #include "Geant4/G4VProcess.hh"
+#include "Geant4/G4VPhysicalVolume.hh"
 
 #include "Mu2eG4/inc/IMu2eG4Cut.hh"
 #include "Mu2eG4/inc/Mu2eG4ResourceLimits.hh"
@@ -44,6 +45,8 @@ namespace mu2e {
       virtual void beginEvent(const art::Event& evt, const SimParticleHelper& spHelper) override;
       virtual void put(art::Event& event) override;
       virtual void deleteCutsData() override;
+      virtual bool writesSteps() const override { return !steppingOutputName_.empty(); }
+      virtual const Mu2eG4VolumeTable* volumeTable() const override { return nullptr; }
 
     protected:
       explicit IOHelper(const fhicl::ParameterSet& pset, const Mu2eG4ResourceLimits& mu2elimits)
@@ -148,6 +151,55 @@ namespace mu2e {
     }
 
 
+    //================================================================
+    bool volumeDecision(const Mu2eG4VolumeTable& table, const G4Track* trk) {
+      const auto vol = trk->GetVolume();
+      return vol ? table.decision(vol->GetInstanceID()) : table.noVolume;
+    }
+
+    // Merge the cuts of a union or intersection that depend only on the
+    // volume into one table, and list the rest in their original order.
+    // Only done if none of the cuts writes steps, otherwise the order of
+    // evaluation matters.  Returns false if there is nothing to merge.
+    bool compileSequence(const std::vector<std::unique_ptr<IMu2eG4Cut> >& cuts,
+                         bool isUnion,
+                         Mu2eG4VolumeTable& table,
+                         std::vector<IMu2eG4Cut*>& others)
+    {
+      others.clear();
+      for(const auto& cut: cuts) {
+        if(cut->writesSteps()) {
+          return false;
+        }
+      }
+
+      auto combine = [isUnion](bool a, bool b) { return isUnion ? (a || b) : (a && b); };
+
+      // Start from the neutral element
+      table = Mu2eG4VolumeTable();
+      table.others = table.noVolume = !isUnion;
+      bool merged = false;
+
+      for(const auto& cut: cuts) {
+        const Mu2eG4VolumeTable *vt = cut->volumeTable();
+        if(vt) {
+          std::vector<char> decisions(std::max(table.decisions.size(), vt->decisions.size()));
+          for(unsigned i=0; i<decisions.size(); ++i) {
+            decisions[i] = combine(table.decision(i), vt->decision(i));
+          }
+          table.decisions.swap(decisions);
+          table.others = combine(table.others, vt->others);
+          table.noVolume = combine(table.noVolume, vt->noVolume);
+          merged = true;
+        }
+        else {
+          others.emplace_back(cut.get());
+        }
+      }
+
+      return merged;
+    }
+
     //================================================================
     class Union: virtual public IMu2eG4Cut,
                  public IOHelper
@@ -162,14 +214,25 @@ namespace mu2e {
       virtual void put(art::Event&  evt) override;
       virtual void deleteCutsData() override;
       virtual void finishConstruction(const CLHEP::Hep3Vector& mu2eOriginInWorld) override;
+      virtual bool writesSteps() const override;
+      virtual const Mu2eG4VolumeTable* volumeTable() const override;
 
       explicit Union(const fhicl::ParameterSet& pset, const Mu2eG4ResourceLimits& lim);
     private:
       std::vector<std::unique_ptr<IMu2eG4Cut> > cuts_;
+
+      // Set by finishConstruction(): the volume-only cuts merged into a
+      // table, and the remaining ones
+      bool compiled_;
+      bool useTable_;
+      Mu2eG4VolumeTable volumeTable_;
+      std::vector<IMu2eG4Cut*> otherCuts_;
     };
 
     Union::Union(const fhicl::ParameterSet& pset, const Mu2eG4ResourceLimits& lim)
       : IOHelper(pset, lim)
+      , compiled_(false)
+      , useTable_(false)
     {
       PSVector pars = pset.get<PSVector>("pars");
       for(const auto& p: pars) {
@@ -178,6 +241,17 @@ namespace mu2e {
     }
 
     bool Union::steppingActionCut(const G4Step *step) {
+      if(useTable_) {
+        bool result = volumeDecision(volumeTable_, step->GetTrack());
+        for(auto i = otherCuts_.begin(); !result && i != otherCuts_.end(); ++i) {
+          result = (*i)->steppingActionCut(step);
+        }
+        if(result && steppingOutput_) {
+          addHit(step);
+        }
+        return result;
+      }
+
       bool result = false;
       for(const auto& cut : cuts_) {
         if(cut->steppingActionCut(step)) {
@@ -192,6 +266,14 @@ namespace mu2e {
     }
 
     bool Union::stackingActionCut(const G4Track *trk) {
+      if(useTable_) {
+        bool result = volumeDecision(volumeTable_, trk);
+        for(auto i = otherCuts_.begin(); !result && i != otherCuts_.end(); ++i) {
+          result = (*i)->stackingActionCut(trk);
+        }
+        return result;
+      }
+
       bool result = false;
       for(const auto& cut : cuts_) {
         if(cut->stackingActionCut(trk)) {
@@ -214,6 +296,23 @@ namespace mu2e {
       for(auto& cut: cuts_) {
         cut->finishConstruction(mu2eOriginInWorld);
       }
+      // This is called at the start of every event, the geometry does not change
+      if(!compiled_) {
+        compiled_ = true;
+        useTable_ = compileSequence(cuts_, true, volumeTable_, otherCuts_);
+      }
+    }
+
+    bool Union::writesSteps() const {
+      bool result = IOHelper::writesSteps();
+      for(const auto& cut: cuts_) {
+        result = result || cut->writesSteps();
+      }
+      return result;
+    }
+
+    const Mu2eG4VolumeTable* Union::volumeTable() const {
+      return (useTable_ && otherCuts_.empty() && !IOHelper::writesSteps()) ? &volumeTable_ : nullptr;
     }
 
     void Union::beginEvent(const art::Event& evt, const SimParticleHelper& spHelper) {
@@ -252,14 +351,25 @@ namespace mu2e {
       virtual void put(art::Event& evt) override;
       virtual void deleteCutsData() override;
       virtual void finishConstruction(const CLHEP::Hep3Vector& mu2eOriginInWorld) override;
+      virtual bool writesSteps() const override;
+      virtual const Mu2eG4VolumeTable* volumeTable() const override;
 
       explicit Intersection(const fhicl::ParameterSet& pset, const Mu2eG4ResourceLimits& lim);
     private:
       std::vector<std::unique_ptr<IMu2eG4Cut> > cuts_;
+
+      // Set by finishConstruction(): the volume-only cuts merged into a
+      // table, and the remaining ones
+      bool compiled_;
+      bool useTable_;
+      Mu2eG4VolumeTable volumeTable_;
+      std::vector<IMu2eG4Cut*> otherCuts_;
     };
 
     Intersection::Intersection(const fhicl::ParameterSet& pset, const Mu2eG4ResourceLimits& lim)
       : IOHelper(pset, lim)
+      , compiled_(false)
+      , useTable_(false)
     {
       PSVector pars = pset.get<PSVector>("pars");
       for(const auto& p: pars) {
@@ -268,6 +378,17 @@ namespace mu2e {
     }
 
     bool Intersection::steppingActionCut(const G4Step *step) {
+      if(useTable_) {
+        bool result = volumeDecision(volumeTable_, step->GetTrack());
+        for(auto i = otherCuts_.begin(); result && i != otherCuts_.end(); ++i) {
+          result = (*i)->steppingActionCut(step);
+        }
+        if(result && steppingOutput_) {
+          addHit(step);
+        }
+        return result;
+      }
+
       bool result = true;
       for(const auto& cut : cuts_) {
         if(!cut->steppingActionCut(step)) {
@@ -283,6 +404,14 @@ namespace mu2e {
     }
 
     bool Intersection::stackingActionCut(const G4Track *trk) {
+      if(useTable_) {
+        bool result = volumeDecision(volumeTable_, trk);
+        for(auto i = otherCuts_.begin(); result && i != otherCuts_.end(); ++i) {
+          result = (*i)->stackingActionCut(trk);
+        }
+        return result;
+      }
+
       bool result = true;
       for(const auto& cut : cuts_) {
         if(!cut->stackingActionCut(trk)) {
@@ -305,6 +434,23 @@ namespace mu2e {
       for(auto& cut: cuts_) {
         cut->finishConstruction(mu2eOriginInWorld);
       }
+      // This is called at the start of every event, the geometry does not change
+      if(!compiled_) {
+        compiled_ = true;
+        useTable_ = compileSequence(cuts_, false, volumeTable_, otherCuts_);
+      }
+    }
+
+    bool Intersection::writesSteps() const {
+      bool result = IOHelper::writesSteps();
+      for(const auto& cut: cuts_) {
+        result = result || cut->writesSteps();
+      }
+      return result;
+    }
+
+    const Mu2eG4VolumeTable* Intersection::volumeTable() const {
+      return (useTable_ && otherCuts_.empty() && !IOHelper::writesSteps()) ? &volumeTable_ : nullptr;
     }
 
     void Intersection::beginEvent(const art::Event& evt, const SimParticleHelper& spHelper) {
@@ -446,13 +592,14 @@ namespace mu2e {
 
       explicit VolumeCut(const fhicl::ParameterSet& pset, bool negate, const Mu2eG4ResourceLimits& lim);
       virtual void finishConstruction(const CLHEP::Hep3Vector& mu2eOriginInWorld) override;
+      virtual const Mu2eG4VolumeTable* volumeTable() const override;
     private:
       std::vector<std::string> volnames_;
       bool negate_;
 
-      // cached pointers to physical volumes on the list
-      typedef std::set<const G4VPhysicalVolume*> KillerVolumesCache;
-      KillerVolumesCache killerVolumes_;
+      // the decision for each physical volume, filled once
+      bool tableFilled_;
+      Mu2eG4VolumeTable table_;
 
       bool cut_impl(const G4Track* trk);
     };
@@ -461,26 +608,36 @@ namespace mu2e {
       : IOHelper(pset, lim)
       , volnames_(pset.get<std::vector<std::string> >("pars"))
       , negate_(negate)
-    {}
+      , tableFilled_(false)
+    {
+      table_.others = negate_;
+      // Volume is not defined when we are called from the stacking action.
+      // This protection is important for the negated case.
+      table_.noVolume = false;
+    }
 
     void VolumeCut::finishConstruction(const CLHEP::Hep3Vector& mu2eOriginInWorld) {
       IOHelper::finishConstruction(mu2eOriginInWorld);
-      for(const auto& vol: volnames_) {
-        killerVolumes_.insert(getPhysicalVolumeOrThrow(vol));
+      // This is called at the start of every event, the geometry does not change
+      if(!tableFilled_) {
+        tableFilled_ = true;
+        std::vector<int> ids;
+        for(const auto& vol: volnames_) {
+          ids.emplace_back(getPhysicalVolumeOrThrow(vol)->GetInstanceID());
+        }
+        table_.decisions.assign(ids.empty() ? 0 : 1 + *std::max_element(ids.begin(), ids.end()), negate_);
+        for(const auto id: ids) {
+          table_.decisions[id] = !negate_;
+        }
       }
     }
 
+    const Mu2eG4VolumeTable* VolumeCut::volumeTable() const {
+      return writesSteps() ? nullptr : &table_;
+    }
+
     bool VolumeCut::cut_impl(const G4Track* trk) {
-      bool result = false;
-      const auto vol = trk->GetVolume();
-      // Volume is not defined when we are called from the stacking action.
-      // This protection is important for the negated case.
-      if(vol) {
-        KillerVolumesCache::const_iterator p = killerVolumes_.find(vol);
-        result = ( p != killerVolumes_.end() );
-        if(negate_) result = !result;
-      }
-      return result;
+      return volumeDecision(table_, trk);
     }
 
     bool VolumeCut::steppingActionCut(const G4Step *step) {
@@ -712,18 +869,29 @@ namespace mu2e {
       virtual bool steppingActionCut(const G4Step  *step);
       virtual bool stackingActionCut(const G4Track *trk);
 
+      virtual const Mu2eG4VolumeTable* volumeTable() const override;
+
       explicit Constant(bool val, const Mu2eG4ResourceLimits& lim);
       explicit Constant(const fhicl::ParameterSet& pset, const Mu2eG4ResourceLimits& lim);
     private:
       bool value_;
+      Mu2eG4VolumeTable table_; // the same value everywhere
     };
 
     Constant::Constant(const fhicl::ParameterSet& pset, const Mu2eG4ResourceLimits& lim)
       : IOHelper(pset, lim)
       , value_{pset.get<bool>("value")}
-    {}
+    {
+      table_.others = table_.noVolume = value_;
+    }
+
+    Constant::Constant(bool val, const Mu2eG4ResourceLimits& lim) : IOHelper(fhicl::ParameterSet(), lim), value_(val) {
+      table_.others = table_.noVolume = value_;
+    }
 
-    Constant::Constant(bool val, const Mu2eG4ResourceLimits& lim) : IOHelper(fhicl::ParameterSet(), lim), value_(val) {}
+    const Mu2eG4VolumeTable* Constant::volumeTable() const {
+      return writesSteps() ? nullptr : &table_;
+    }
 
     bool Constant::steppingActionCut(const G4Step *step) {
       if(steppingOutput_) {
@@ -71,6 +71,32 @@ namespace mu2e {
   //----------------------------------------------------------------
   void Mu2eG4PerThreadStorage::putSensitiveDetectorData() {
     putStepPointMCCollections(std::move(sensitiveDetectorSteps));
+
+    // The aggregated steps hold the same SimParticle Ptrs as the StepPointMCs
+    art::ProductID simPartId(artEvent->getProductID<SimParticleCollection>());
+    art::EDProductGetter const* simProductGetter = artEvent->productGetter(simPartId);
+
+    if(strawGasSteps) {
+      for(auto& step : *strawGasSteps) {
+        step.simParticle() = art::Ptr<SimParticle>(step.simParticle().id(),
+                                                   step.simParticle().key(),
+                                                   simProductGetter);
+      }
+      artEvent->put(std::move(strawGasSteps), strawGasStepsName);
+    }
+
+    if(caloShowerSteps) {
+      for(auto& step : *caloShowerSteps) {
+        step.setSimParticle(art::Ptr<SimParticle>(step.simParticle().id(),
+                                                  step.simParticle().key(),
+                                                  simProductGetter));
+      }
+      for(auto& sim : *caloShowerSims) {
+        sim = art::Ptr<SimParticle>(sim.id(), sim.key(), simProductGetter);
+      }
+      artEvent->put(std::move(caloShowerSteps), caloShowerStepsName);
+      artEvent->put(std::move(caloShowerSims), caloShowerStepsName);
+    }
   }
 
   //----------------------------------------------------------------
@@ -117,6 +143,9 @@ namespace mu2e {
     simRemapping = nullptr;
     extMonFNALHits = nullptr;
     sensitiveDetectorSteps.clear();
+    strawGasSteps = nullptr;
+    caloShowerSteps = nullptr;
+    caloShowerSims = nullptr;
 
     stackingCuts->deleteCutsData();
     steppingCuts->deleteCutsData();
@@ -11,6 +11,7 @@
 #include "messagefacility/MessageLogger/MessageLogger.h"
 
 #include "Geant4/G4Step.hh"
+#include "Geant4/G4VPhysicalVolume.hh"
 #include "Geant4/G4Threading.hh"
 
 // Mu2e includes
@@ -93,10 +94,14 @@ namespace mu2e {
 
     // We have to wait until G4 geometry is constructed
     // to get phys volume pointers that are used in the
-    // volume to cut value map.
+    // per-volume cut value table.
+    mcTrajectoryVolumePtDistances_.clear();
     for(const auto& spec: trajectoryControl_->perVolumeMinDistance()) {
-      auto vol = getPhysicalVolumeOrThrow(spec.first);
-      mcTrajectoryVolumePtDistances_[vol] = spec.second;
+      const int id = getPhysicalVolumeOrThrow(spec.first)->GetInstanceID();
+      if(unsigned(id) >= mcTrajectoryVolumePtDistances_.size()) {
+        mcTrajectoryVolumePtDistances_.resize(id+1, trajectoryControl_->defaultMinPointDistance());
+      }
+      mcTrajectoryVolumePtDistances_[id] = spec.second;
     }
   }
 
@@ -317,9 +322,9 @@ namespace mu2e {
 
   double Mu2eG4SteppingAction::mcTrajectoryMinDistanceCut(const G4VPhysicalVolume* vol) const {
 
-    const auto it = mcTrajectoryVolumePtDistances_.find(vol);
-    return (it != mcTrajectoryVolumePtDistances_.end()) ?
-      it->second : trajectoryControl_->defaultMinPointDistance();
+    const int id = vol ? vol->GetInstanceID() : -1;
+    return (id >= 0 && unsigned(id) < mcTrajectoryVolumePtDistances_.size()) ?
+      mcTrajectoryVolumePtDistances_[id] : trajectoryControl_->defaultMinPointDistance();
   }
 
 } // end namespace mu2e
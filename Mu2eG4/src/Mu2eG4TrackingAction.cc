@@ -36,6 +36,7 @@
 #include "Mu2eG4/inc/Mu2eG4ResourceLimits.hh"
 #include "Mu2eG4/inc/Mu2eG4TrajectoryControl.hh"
 #include "Mu2eG4/inc/Mu2eG4PerThreadStorage.hh"
+#include "Mu2eG4/inc/SensitiveDetectorHelper.hh"
 #include "MCDataProducts/inc/SimParticleCollection.hh"
 #include "MCDataProducts/inc/ProcessCode.hh"
 #include "Mu2eUtilities/inc/compressSimParticleCollection.hh"
@@ -64,6 +65,7 @@ namespace mu2e {
 
   Mu2eG4TrackingAction::Mu2eG4TrackingAction(const Mu2eG4Config::Top& conf,
                                  Mu2eG4SteppingAction * steppingAction,
+                                 SensitiveDetectorHelper * sensitiveDetectorHelper,
                                  Mu2eG4PerThreadStorage *pts):
     _debugList(conf.debug().trackingActionEventList()),
     _physVolHelper(0),
@@ -78,6 +80,7 @@ namespace mu2e {
     _nKilledByFieldPropagator(0),
     _rangeToIgnore(conf.physics().rangeToIgnore()),
     _steppingAction(steppingAction),
+    _sensitiveDetectorHelper(sensitiveDetectorHelper),
     _processInfo(0),
     _printTrackTiming(conf.debug().printTrackTiming()),
     _stepLimitKillerVerbose(conf.debug().stepLimitKillerVerbose())
@@ -216,6 +219,9 @@ namespace mu2e {
 
     swapTrajectory(trk);
 
+    // Aggregate the SD steps of this track, if so configured.
+    aggregateSDSteps(trk);
+
     // Any other clean up.
     _steppingAction->EndOfTrack();
 
@@ -669,5 +675,25 @@ namespace mu2e {
 
   }//swapTrajectory
 
+  // The steps of a suspended track are aggregated when it is resumed and finished;
+  // see note 4 in SensitiveDetectorHelper.cc.
+  void Mu2eG4TrackingAction::aggregateSDSteps(const G4Track* trk){
+
+    if ( _sensitiveDetectorHelper == nullptr ) return;
+
+    // The SimParticles of this event are still in the transient map.
+    const art::ProductID simPartId = perThreadObjects_->simParticleHelper->productID();
+    auto sims = [this, simPartId](const art::Ptr<SimParticle>& sim) -> const SimParticle* {
+      if ( sim.id() != simPartId ) return nullptr;
+      map_type::const_iterator i(_transientMap.find(key_type(sim.key())));
+      return i == _transientMap.end() ? nullptr : &i->second;
+    };
+
+    _sensitiveDetectorHelper->afterG4Track(perThreadObjects_->simParticleHelper->particleKeyFromG4TrackID(trk->GetTrackID()),
+                                           trk->GetTrackStatus() != fSuspend,
+                                           sims);
+
+  }//aggregateSDSteps
+
 
 } // end namespace mu2e
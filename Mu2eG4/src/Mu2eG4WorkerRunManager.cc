@@ -182,6 +182,7 @@ namespace mu2e {
 
     trackingAction_ = new Mu2eG4TrackingAction(conf_,
                                          steppingAction_,
+                                         &sensitiveDetectorHelper_,
                                          perThreadObjects_.get());
     SetUserAction(trackingAction_);
 
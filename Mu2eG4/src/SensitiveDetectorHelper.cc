@@ -17,6 +17,28 @@
 //    to transfer it into the unique_ptr that will be given to the event.  This is
 //    a very small CPU time penalty but it saves us from doing any explicit memory management.
 //
+// 3) Optionally the tracker and calorimeter StepPointMCs are aggregated into StrawGasSteps and
+//    CaloShowerSteps at the end of the G4 event, using the algorithms of MakeStrawGasSteps and
+//    CaloShowerStepMaker, and only the aggregated steps are written.  The SimParticles are taken
+//    from the transient SimParticleCollection of the event.  The tracking action copies the
+//    SimParticles of earlier simulation stages into it, with reseated Ptrs, so the calorimeter
+//    ancestor search follows the same chain as in CaloShowerStepMaker.
+//
+// 4) So that the StepPointMCs do not pile up during the G4 event, the tracking action calls
+//    afterG4Track at the end of each track, and the tracker and calorimeter steps of that track
+//    are aggregated and dropped right away.  The SimParticles are then taken from the transient
+//    map of the tracking action.  G4 tracks one particle at a time, so the SD collections only
+//    hold the steps of the current track, plus those of suspended tracks, which are left for
+//    later.  Each (straw, SimParticle) group is therefore complete when it is aggregated, and
+//    sorting the StrawGasSteps by straw and SimParticle gives the order of the aggregation at
+//    the end of the event.  Combining delta-rays needs all of the tracker steps of the event,
+//    so with CombineDeltas the tracker steps are kept until the end of the event.  The filters
+//    see the aggregated steps through nAggregatedTrackerSteps_ and aggregatedMomentumPassed_.
+//    The calorimeter ancestor search uses the end position of the SimParticles, which is not
+//    final for a suspended track.  The calorimeter steps of a track with a suspended ancestor
+//    are therefore deferred to the end of the event.  The kept StepPointMCs are in the order in
+//    which the steps were aggregated, so CaloShowerStepMaker sees the same sequence.
+//
 
 // From Mu2e
 #include "Mu2eG4/inc/SensitiveDetectorHelper.hh"
@@ -26,6 +48,12 @@
 #include "Mu2eG4Helper/inc/Mu2eG4Helper.hh"
 #include "Mu2eG4/inc/Mu2eG4PerThreadStorage.hh"
 #include "GeometryService/inc/GeometryService.hh"
+#include "GeometryService/inc/GeomHandle.hh"
+#include "GeometryService/inc/DetectorSystem.hh"
+#include "TrackerGeom/inc/Tracker.hh"
+#include "CalorimeterGeom/inc/Calorimeter.hh"
+#include "BFieldGeom/inc/BFieldManager.hh"
+#include "MCDataProducts/inc/SimParticleCollection.hh"
 
 // From art and its tool chain
 #include "art/Framework/Principal/Event.h"
@@ -37,12 +65,25 @@
 #include "Geant4/G4SDManager.hh"
 #include "Geant4/G4Threading.hh"
 
+#include <algorithm>
+#include <iterator>
 #include <map>
 
 using namespace std;
 
 namespace mu2e {
 
+  namespace {
+    // The SimParticles of this simulation stage, see note 3.
+    std::function<const SimParticle*(const art::Ptr<SimParticle>&)> simLookup(const Mu2eG4PerThreadStorage* per_thread_store) {
+      const SimParticleCollection& simParts = *per_thread_store->simPartCollection;
+      const art::ProductID simPartId = per_thread_store->simParticleHelper->productID();
+      return [&simParts, simPartId](const art::Ptr<SimParticle>& sim) -> const SimParticle* {
+        return sim.id() == simPartId ? simParts.getOrNull(cet::map_vector_key(sim.key())) : nullptr;
+      };
+    }
+  }
+
   //================================================================
   SensitiveDetectorHelper::SensitiveDetectorHelper(const Mu2eG4Config::SDConfig_& conf)
     :
@@ -121,6 +162,38 @@ namespace mu2e {
       }//if
     }//for
 
+    //----------------
+    // Aggregated tracker and calorimeter steps.  See note 3.
+    Mu2eG4Config::StrawGasSteps_ sgsconf;
+    if(conf.strawGasSteps(sgsconf)) {
+      if(!enabled(StepInstanceName::tracker)) {
+        throw cet::exception("CONFIG")<<"SensitiveDetectorHelper: strawGasSteps requires the tracker SD to be enabled\n";
+      }
+      strawGasStepBuilder_.emplace(sgsconf.maxDeltaLength(), sgsconf.minionBG(), sgsconf.minionKE(),
+                                   sgsconf.curlRatio(), sgsconf.lineRatio(), sgsconf.startSize(), verbosityLevel_);
+      combineDeltas_ = sgsconf.combineDeltas();
+      keepTrackerSteps_ = sgsconf.keepStepPointMCs();
+    }
+
+    Mu2eG4Config::CaloShowerSteps_ cssconf;
+    if(conf.caloShowerSteps(cssconf)) {
+      if(!enabled(StepInstanceName::calorimeter)) {
+        throw cet::exception("CONFIG")<<"SensitiveDetectorHelper: caloShowerSteps requires the calorimeter SD to be enabled\n";
+      }
+      caloShowerStepBuilder_.emplace(cssconf.numZSlices(), cssconf.deltaTime(), cssconf.compressData(),
+                                     cssconf.eDepThreshold(), verbosityLevel_);
+      keepCaloSteps_ = cssconf.keepStepPointMCs();
+    }
+
+    // The SimParticles of pre-simulated hits are not in the transient collection
+    for(const auto& tag : preSimulatedHits_) {
+      if((strawGasStepBuilder_ && tag.instance() == StepInstanceName(StepInstanceName::tracker).name()) ||
+         (caloShowerStepBuilder_ && tag.instance() == StepInstanceName(StepInstanceName::calorimeter).name())) {
+        throw cet::exception("CONFIG")<<"SensitiveDetectorHelper: preSimulatedHits = "<<tag
+                                      <<" can not be used with aggregated steps for the same detector\n";
+      }
+    }
+
     //----------------
 
     for(const auto& i : conf.inputs()) {
@@ -171,6 +244,30 @@ namespace mu2e {
   // Create new data products.  To be called at start of each event.
   void SensitiveDetectorHelper::createProducts(const art::Event& event,
                                                const SimParticleHelper& spHelper){
+    //----------------
+    // Conditions for the aggregated tracker steps
+    if(strawGasStepBuilder_) {
+      if(!trackerStatusHandle_) {
+        trackerStatusHandle_.emplace();
+      }
+      if(event.id().runID() != strawGasStepRun_) {
+        strawGasStepBuilder_->beginRun(*GeomHandle<Tracker>(), *GeomHandle<BFieldManager>(), *GeomHandle<DetectorSystem>());
+        strawGasStepRun_ = event.id().runID();
+      }
+      tracker_ = GeomHandle<Tracker>().get();
+      trackerStatus_ = &trackerStatusHandle_->get(event.id());
+    }
+    if(caloShowerStepBuilder_) {
+      caloShowerStepBuilder_->beginEvent(*GeomHandle<Calorimeter>());
+    }
+    trackGasSteps_.clear();
+    keptTrackerSteps_.clear();
+    keptCaloSteps_.clear();
+    deferredCaloSteps_.clear();
+    suspendedTracks_.clear();
+    nAggregatedTrackerSteps_ = 0;
+    aggregatedMomentumPassed_ = false;
+
     //----------------
     // Read in pre-simulated hits that we want to merge into the outputs
 
@@ -251,6 +348,82 @@ namespace mu2e {
   }
 
 
+  void SensitiveDetectorHelper::afterG4Track(cet::map_vector_key trackKey, bool finished,
+                                             const StrawGasStepBuilder::SimLookup& sims){
+
+    // See note 4.
+    if(!finished) {
+      suspendedTracks_.insert(trackKey);
+      return;
+    }
+    suspendedTracks_.erase(trackKey);
+
+    if(strawGasStepBuilder_ && !combineDeltas_) {
+      StepPointMCCollection steps(takeTrackSteps(stepInstances_.at(StepInstanceName::tracker), trackKey));
+      if(!steps.empty()) {
+        strawGasStepBuilder_->makeSteps(*tracker_, trackerStatus_, steps, false, sims, trackGasSteps_);
+        nAggregatedTrackerSteps_ += steps.size();
+        if(keepTrackerSteps_) {
+          keptTrackerSteps_.insert(keptTrackerSteps_.end(), steps.begin(), steps.end());
+        }
+      }
+    }
+
+    if(caloShowerStepBuilder_) {
+      StepPointMCCollection steps(takeTrackSteps(stepInstances_.at(StepInstanceName::calorimeter), trackKey));
+      if(!steps.empty()) {
+        if(hasSuspendedAncestor(steps.front().simParticle(), sims)) {
+          deferredCaloSteps_.insert(deferredCaloSteps_.end(), steps.begin(), steps.end());
+        }
+        else {
+          caloShowerStepBuilder_->addSteps(steps, sims);
+          if(keepCaloSteps_) {
+            keptCaloSteps_.insert(keptCaloSteps_.end(), steps.begin(), steps.end());
+          }
+        }
+      }
+    }
+  }
+
+
+  // The whole parent chain is checked, which covers every SimParticle the ancestor search reads.
+  bool SensitiveDetectorHelper::hasSuspendedAncestor(const art::Ptr<SimParticle>& sim,
+                                                     const StrawGasStepBuilder::SimLookup& sims) const{
+    if(suspendedTracks_.empty()) return false;
+    for(const SimParticle* simp = sims(sim); simp != nullptr; simp = simp->hasParent() ? sims(simp->parent()) : nullptr) {
+      if(suspendedTracks_.count(simp->id()) > 0) return true;
+    }
+    return false;
+  }
+
+
+  StepPointMCCollection SensitiveDetectorHelper::takeTrackSteps(StepInstance& instance,
+                                                                cet::map_vector_key trackKey){
+    StepPointMCCollection steps;
+    StepPointMCCollection& p(instance.p);
+    if(p.empty()) return steps;
+
+    // Steps of suspended tracks stay in the collection, see note 4.
+    auto first = std::stable_partition(p.begin(), p.end(), [trackKey](const StepPointMC& step) {
+        return step.simParticle().key() != trackKey.asUint();
+      });
+    steps.assign(std::make_move_iterator(first), std::make_move_iterator(p.end()));
+    p.erase(first, p.end());
+
+    if(!aggregatedMomentumPassed_ &&
+       std::find(stepInstancesForMomentumCut_.begin(), stepInstancesForMomentumCut_.end(), instance.stepName)
+       != stepInstancesForMomentumCut_.end()) {
+      for(const auto& hit : steps) {
+        if(hit.momentum().mag() > cutMomentumMin_) {
+          aggregatedMomentumPassed_ = true;
+          break;
+        }
+      }
+    }
+    return steps;
+  }
+
+
   void SensitiveDetectorHelper::insertSDDataIntoPerThreadStorage(Mu2eG4PerThreadStorage* per_thread_store){
 
     for ( InstanceMap::iterator i=stepInstances_.begin();
@@ -258,6 +431,16 @@ namespace mu2e {
       unique_ptr<StepPointMCCollection> p(new StepPointMCCollection);
       StepInstance& instance(i->second);
       std::swap( instance.p, *p);
+
+      if(strawGasStepBuilder_ && i->first == StepInstanceName::tracker) {
+        makeStrawGasSteps(per_thread_store, *p);
+        if(!keepTrackerSteps_) continue;
+      }
+      if(caloShowerStepBuilder_ && i->first == StepInstanceName::calorimeter) {
+        makeCaloShowerSteps(per_thread_store, *p);
+        if(!keepCaloSteps_) continue;
+      }
+
       per_thread_store->insertSDStepPointMC(std::move(p), instance.stepName);
     }
 
@@ -269,9 +452,58 @@ namespace mu2e {
   }
 
 
+  // On input the steps not yet aggregated; on output all of the tracker steps of the event.
+  void SensitiveDetectorHelper::makeStrawGasSteps(Mu2eG4PerThreadStorage* per_thread_store,
+                                                  StepPointMCCollection& steps){
+    unique_ptr<StrawGasStepCollection> sgsc(new StrawGasStepCollection);
+    if(combineDeltas_) {
+      strawGasStepBuilder_->makeSteps(*tracker_, trackerStatus_, steps,
+                                      true, simLookup(per_thread_store), *sgsc);
+    }
+    else {
+      // See note 4.
+      strawGasStepBuilder_->makeSteps(*tracker_, trackerStatus_, steps,
+                                      false, simLookup(per_thread_store), trackGasSteps_);
+      std::swap(*sgsc, trackGasSteps_);
+      std::sort(sgsc->begin(), sgsc->end(), [](const StrawGasStep& a, const StrawGasStep& b) {
+          if(a.strawId() != b.strawId()) return a.strawId() < b.strawId();
+          return a.simParticle().key() < b.simParticle().key();
+        });
+      if(keepTrackerSteps_) {
+        keptTrackerSteps_.insert(keptTrackerSteps_.end(), steps.begin(), steps.end());
+        std::swap(keptTrackerSteps_, steps);
+        keptTrackerSteps_.clear();
+      }
+    }
+    per_thread_store->insertStrawGasSteps(std::move(sgsc), StepInstanceName(StepInstanceName::tracker).name());
+  }
+
+
+  // On input the steps not yet aggregated; on output all of the calorimeter steps of the event.
+  void SensitiveDetectorHelper::makeCaloShowerSteps(Mu2eG4PerThreadStorage* per_thread_store,
+                                                    StepPointMCCollection& steps){
+    unique_ptr<CaloShowerStepCollection> cssc(new CaloShowerStepCollection);
+    unique_ptr<SimParticlePtrCollection> sims(new SimParticlePtrCollection);
+    // the deferred steps first, see note 4
+    deferredCaloSteps_.insert(deferredCaloSteps_.end(), steps.begin(), steps.end());
+    std::swap(deferredCaloSteps_, steps);
+    deferredCaloSteps_.clear();
+    caloShowerStepBuilder_->addSteps(steps, simLookup(per_thread_store));
+    caloShowerStepBuilder_->makeShowerSteps(*cssc, *sims);
+    if(keepCaloSteps_) {
+      keptCaloSteps_.insert(keptCaloSteps_.end(), steps.begin(), steps.end());
+      std::swap(keptCaloSteps_, steps);
+      keptCaloSteps_.clear();
+    }
+    per_thread_store->insertCaloShowerSteps(std::move(cssc), std::move(sims),
+                                            StepInstanceName(StepInstanceName::calorimeter).name());
+  }
+
+
   bool SensitiveDetectorHelper::filterStepPointMomentum(){
 
-    bool passed = false;
+    // The steps already aggregated, see note 4.
+    bool passed = aggregatedMomentumPassed_;
 
     for ( InstanceMap::iterator i=stepInstances_.begin();
           i != stepInstances_.end(); ++i ) {
@@ -326,7 +558,7 @@ namespace mu2e {
 
     for ( InstanceMap::iterator i=stepInstances_.begin();
           i != stepInstances_.end(); ++i ) {
-      if (i->second.stepName == "tracker" && i->second.p.size() >= minTrackerStepPoints_) {
+      if (i->second.stepName == "tracker" && i->second.p.size() + nAggregatedTrackerSteps_ >= minTrackerStepPoints_) {
         passed = true;
       }
     }//for stepInstances
@@ -364,9 +596,20 @@ namespace mu2e {
   void SensitiveDetectorHelper::declareProducts(art::ProducesCollector& collector) {
 
     vector<string> const& instanceNames = stepInstanceNamesToBeProduced();
+    const string trackerName(StepInstanceName(StepInstanceName::tracker).name());
+    const string caloName(StepInstanceName(StepInstanceName::calorimeter).name());
     for(const auto& name: instanceNames) {
+      if(strawGasStepBuilder_ && !keepTrackerSteps_ && name == trackerName) continue;
+      if(caloShowerStepBuilder_ && !keepCaloSteps_ && name == caloName) continue;
       collector.produces<StepPointMCCollection>(name);
     }
+    if(strawGasStepBuilder_) {
+      collector.produces<StrawGasStepCollection>(trackerName);
+    }
+    if(caloShowerStepBuilder_) {
+      collector.produces<CaloShowerStepCollection>(caloName);
+      collector.produces<SimParticlePtrCollection>(caloName);
+    }
     if(extMonPixelsEnabled_)
       collector.produces<ExtMonFNALSimHitCollection>();
   }
@@ -4,9 +4,15 @@
 #include <tuple>
 #include <string>
 #include <set>
+#include <vector>
+#include <unordered_map>
+#include <map>
+#include <functional>
 #include <shared_mutex>
 #include <mutex>
+#include <atomic>
 #include <chrono>
+#include <iostream>
 
 #include "canvas/Persistency/Provenance/EventID.h"
 #include "DbTables/inc/DbIoV.hh"
@@ -17,24 +23,30 @@ namespace mu2e {
 
   protected:
 
-    // lock for threaded access
+    // lock for threaded access to the cache index
     std::shared_mutex _mutex;
+    // the handles held by the concrete classes are not thread safe,
+    // so the calls to the concrete class are made under this lock
+    std::mutex _makeMutex;
 
     // count the time waiting and locked
     std::chrono::microseconds _lockWaitTime;
     std::chrono::microseconds _lockTime;
 
 
-  public: 
+  public:
     typedef std::shared_ptr<ProditionsCache> ptr;
     typedef std::tuple<ProditionsEntity::ptr,DbIoV> ret_t;
     typedef ProditionsEntity::set_t set_t;
 
     ProditionsCache(std::string name, int verbose=0):
-      _name(name),_verbose(verbose),_initialized(false) {}
+      _lockWaitTime(0),_lockTime(0),
+      _name(name),_verbose(verbose),_initialized(false),
+      _maxEntries(0),_tick(0),_nFound(0),_nMade(0),_nEvicted(0),
+      _nPrefetched(0),_nPrefetchUsed(0) {}
     virtual ~ProditionsCache() {}
 
-    // the following are provided by the 
+    // the following are provided by the
     // concrete class
     //virtual std::string const& name() const =0 ;
     std::string const& name() const { return _name;}
@@ -49,76 +61,136 @@ namespace mu2e {
     // make a new entity, the data object itself
     virtual ProditionsEntity::ptr makeEntity(art::EventID const& eid) =0;
 
+    // maximum number of entities kept, the least recently
+    // used are dropped first, 0 means no limit
+    void setMaxEntries(size_t n) { _maxEntries = n; }
+    size_t maxEntries() const { return _maxEntries; }
+
     // this is the main call to the cache asking for an existing
     // entity, creating and cacheing a new entity as needed
     ret_t update(art::EventID const& eid) {
-      // do lazy initialization, don't bother with 
-      // read lock since a bool can't be partially constructed
-      if(!_initialized) {
-	//gain write lock
-	auto stime = std::chrono::high_resolution_clock::now();
-	std::unique_lock lock(_mutex); // write lock
-	auto mtime = std::chrono::high_resolution_clock::now();
-	auto dt = std::chrono::duration_cast<std::chrono::microseconds>
-                                               ( mtime - stime );
-	 _lockWaitTime += dt;
-	// check if another thread initialized while we were
-	// waiting for write lock
-	if(!_initialized) {
-	  // derived class creates database and service dependencies
-	  initialize(); 
-	  _initialized = true;
-	}
-	auto etime = std::chrono::high_resolution_clock::now();
-	dt = std::chrono::duration_cast<std::chrono::microseconds>
-                                               ( etime - mtime );
-	_lockTime += dt;  // time we spent write locked
-      } // end initialize, write lock out of scope, released
+      return get(eid,false);
+    }
 
-      // gain shared read lock to find what 
-      // set of tables are needed
-      bool made = false;
-      set_t cids;
+    // make the entity for this event, if not already cached, so that
+    // later updates find it ready.  Can be called from a background task.
+    // Returns the interval of validity of the entity
+    DbIoV prefetch(art::EventID const& eid) {
+      return std::get<1>(get(eid,true));
+    }
+
+    // put this object, with dependent set of CID's, in the cache
+    void push(ProditionsEntity::ptr const& p) {
+      std::unique_lock lock(_mutex);
+      insert(p->getCids(),p,nullptr,false);
+    }
+
+    // is the object, with this set of CID's,
+    // which uniquely identifies it, in the cache?
+    ProditionsEntity::ptr  find(set_t const& s) {
+      return find(s,false);
+    }
+
+    // summary of the cache use and the time spent in locks
+    void printStats(std::ostream& os) const {
+      os << "ProditionsCache " << _name << ": "
+	 << _nMade << " made, " << _nFound << " found, "
+	 << _nEvicted << " evicted, " << _cache.size() << " cached";
+      if(_maxEntries>0) os << " (max " << _maxEntries << ")";
+      os << std::endl;
+      if(_nPrefetched>0) {
+	os << "    prefetched: " << _nPrefetched << " made, "
+	   << _nPrefetchUsed << " used, " << _nMade << " made on demand"
+	   << std::endl;
+      }
+      os << "    Total time waiting for locks: "
+	 << _lockWaitTime.count()*1.0e-6 << " s" << std::endl;
+      os << "    Total time in locks: "
+	 << _lockTime.count()*1.0e-6 << " s" << std::endl;
+    }
+
+  private:
+
+    ret_t get(art::EventID const& eid, bool prefetching) {
+
+      uint32_t run = eid.run();
+      uint32_t subrun = eid.subRun();
+
+      // an entity is valid for all the run/subruns of the
+      // intervals it was found for, so look there first.
+      // This does not call the concrete class, and does not
+      // wait for another thread making a new entity
       ProditionsEntity::ptr p;
       DbIoV iov;
-      { // start read lock scope
+      if(_initialized) {
 	std::shared_lock lock(_mutex);
-	// get the set of nubers that identifies the data
-	cids = makeSet(eid);
-	// look for it in the cache
-	p = find(cids);
-	if(p) { // also grab the iov while under this read lock
-	  iov = makeIov(eid);
+	p = findByRun(run,subrun,iov,prefetching);
+      }
+      if(p) {
+	if(prefetching) return std::make_tuple(p,iov);
+	++_nFound;
+	if(_verbose>1) {
+	  std::cout<< "ProditionsCache::update return cached "<< name() << std::endl;
 	}
-      } // end read lock lifetime
-      
-      // if it was not found in cache, make it
-      if(!p) {
-	//gain write lock
-	auto stime = std::chrono::high_resolution_clock::now();
-	std::unique_lock lock(_mutex); // write lock
-	auto mtime = std::chrono::high_resolution_clock::now();
-	auto dt = std::chrono::duration_cast<std::chrono::microseconds>
+	return std::make_tuple(p,iov);
+      }
+
+      // the entity (or its interval) needs to come from the concrete class,
+      // threads asking for the same entity wait here until it is made
+      auto stime = std::chrono::high_resolution_clock::now();
+      std::unique_lock makeLock(_makeMutex);
+      auto mtime = std::chrono::high_resolution_clock::now();
+      _lockWaitTime += std::chrono::duration_cast<std::chrono::microseconds>
                                                ( mtime - stime );
-	 _lockWaitTime += dt;
-	 // need to check again in case another thread made it
-	 // between read lock and write lock
-	 p = find(cids);
-	 if(!p) {
-	   p = makeEntity(eid); // make the data entity
-	   p->addCids(cids); // label it
-	   push(p); // put in the cache
-	   made = true;
-	   if(_verbose>2) p->print(std::cout);
-	 }
-	 iov = makeIov(eid); // new or old, iov is now valid
-	 auto etime = std::chrono::high_resolution_clock::now();
-	 dt = std::chrono::duration_cast<std::chrono::microseconds>
+
+      // do lazy initialization
+      if(!_initialized) {
+	// derived class creates database and service dependencies
+	initialize();
+	_initialized = true;
+      }
+
+      // check again in case another thread made it
+      // while we were waiting for the lock
+      {
+	std::shared_lock lock(_mutex);
+	p = findByRun(run,subrun,iov,prefetching);
+      }
+
+      bool made = false;
+      if(!p) {
+	// get the set of nubers that identifies the data
+	set_t cids = makeSet(eid);
+	iov = makeIov(eid);
+	{
+	  std::shared_lock lock(_mutex);
+	  p = find(cids,prefetching);
+	}
+	if(!p) {
+	  // make the data entity, the cache index is not locked
+	  p = makeEntity(eid);
+	  p->addCids(cids); // label it
+	  made = true;
+	  if(_verbose>2) p->print(std::cout);
+	}
+	// put it in the cache, or add the interval to the existing entry
+	std::unique_lock lock(_mutex);
+	insert(cids,p,&iov,made && prefetching);
+      }
+
+      auto etime = std::chrono::high_resolution_clock::now();
+      _lockTime += std::chrono::duration_cast<std::chrono::microseconds>
                                                ( etime - mtime );
-	_lockTime += dt;  // time we spent write locked
+      if(prefetching) {
+	if(made) ++_nPrefetched;
+	return std::make_tuple(p,iov);
+      }
+      if(made) {
+	++_nMade;
+      } else {
+	++_nFound;
+      }
 
-      } // endif not in cache, write lock now destroyed
-      
       if(_verbose>1) {
 	if(made) {
 	  std::cout<< "ProditionsCache::update made new "<< name() << std::endl;
@@ -129,27 +201,116 @@ namespace mu2e {
 
       return std::make_tuple(p,iov);
 
-    } // end update
+    } // end get
 
-    // put this object, with dependent set of CID's, in the cache
-    void push(ProditionsEntity::ptr const& p) {
-      _cache.emplace_back(p);
+    struct CidHash {
+      size_t operator()(set_t const& s) const {
+	size_t h = s.size();
+	for(auto cid : s) h ^= std::hash<int>()(cid) + 0x9e3779b9 + (h<<6) + (h>>2);
+	return h;
+      }
+    };
+
+    struct Entry {
+      ProditionsEntity::ptr entity;
+      std::vector<DbIoV> iovs; // intervals the entity was found for
+      std::atomic<uint64_t> lastUsed{0};
+      std::atomic<bool> prefetched{false}; // made by prefetch, not yet used
+    };
+    typedef std::unordered_map<set_t,Entry,CidHash> cache_t;
+    typedef std::pair<uint32_t,uint32_t> runSubrun_t;
+    // the elements of the unordered_map stay in place when it rehashes
+    typedef std::map<runSubrun_t,std::pair<DbIoV,cache_t::value_type*> > iovIndex_t;
+
+    // the intervals of the entities don't overlap, since the set of
+    // cid's is unique for a run/subrun, so only the interval starting
+    // last before the run/subrun can contain it.  Call with at least the read lock
+    ProditionsEntity::ptr findByRun(uint32_t run, uint32_t subrun, DbIoV& iov,
+				    bool prefetching) {
+      auto ii = _iovIndex.upper_bound(runSubrun_t(run,subrun));
+      if(ii==_iovIndex.begin()) return ProditionsEntity::ptr();
+      --ii;
+      if(!ii->second.first.inInterval(run,subrun)) return ProditionsEntity::ptr();
+      iov = ii->second.first;
+      return use(ii->second.second->second,prefetching);
     }
 
-    // is the object, with this set of CID's, 
-    // which uniquely identifies it, in the cache?
-    ProditionsEntity::ptr  find(set_t const& s) {
-      for(auto const& ii : _cache) {
-	if(ii->getCids()==s) return ii;
+    // call with at least the read lock
+    ProditionsEntity::ptr find(set_t const& s, bool prefetching) {
+      auto ii = _cache.find(s);
+      if(ii==_cache.end()) return ProditionsEntity::ptr();
+      return use(ii->second,prefetching);
+    }
+
+    ProditionsEntity::ptr use(Entry& entry, bool prefetching) {
+      if(prefetching) return entry.entity; // does not count as use
+      entry.lastUsed = ++_tick;
+      if(entry.prefetched.exchange(false)) ++_nPrefetchUsed;
+      return entry.entity;
+    }
+
+    // call with the write lock
+    void insert(set_t const& cids, ProditionsEntity::ptr const& p, DbIoV const* iov,
+		bool prefetched) {
+      auto ii = &*_cache.try_emplace(cids).first;
+      Entry& entry = ii->second;
+      if(!entry.entity) entry.entity = p;
+      entry.lastUsed = ++_tick;
+      if(prefetched) entry.prefetched = true;
+      if(iov && ( iov->startRun()<iov->endRun() ||
+		  ( iov->startRun()==iov->endRun() && iov->startSubrun()<=iov->endSubrun() ) ) ) {
+	runSubrun_t start(iov->startRun(),iov->startSubrun());
+	auto jj = _iovIndex.find(start);
+	if(jj==_iovIndex.end() || jj->second.second!=ii) {
+	  if(jj!=_iovIndex.end()) removeIov(jj); // superseded interval
+	  _iovIndex[start] = std::make_pair(*iov,ii);
+	  entry.iovs.emplace_back(*iov);
+	}
+      }
+
+      // drop the least recently used entities, the handles
+      // still holding them keep them alive
+      while(_maxEntries>0 && _cache.size()>_maxEntries) {
+	auto oldest = _cache.begin();
+	for(auto kk = _cache.begin(); kk!=_cache.end(); ++kk) {
+	  if(kk->second.lastUsed < oldest->second.lastUsed) oldest = kk;
+	}
+	for(auto const& jv : oldest->second.iovs) {
+	  _iovIndex.erase(runSubrun_t(jv.startRun(),jv.startSubrun()));
+	}
+	if(_verbose>1) {
+	  std::cout<< "ProditionsCache::update dropped "<< name() << std::endl;
+	}
+	_cache.erase(oldest);
+	++_nEvicted;
       }
-      return ProditionsEntity::ptr();
     }
-    
-  private:
+
+    // remove an interval from the index and from its entity
+    void removeIov(iovIndex_t::iterator jj) {
+      auto& iovs = jj->second.second->second.iovs;
+      for(auto kk = iovs.begin(); kk!=iovs.end(); ++kk) {
+	if(kk->startRun()==jj->first.first && kk->startSubrun()==jj->first.second) {
+	  iovs.erase(kk);
+	  break;
+	}
+      }
+      _iovIndex.erase(jj);
+    }
+
     std::string _name;
     int _verbose;
-    bool _initialized;
-    std::vector<ProditionsEntity::ptr> _cache;
+    std::atomic<bool> _initialized;
+    size_t _maxEntries;
+    std::atomic<uint64_t> _tick;
+    std::atomic<size_t> _nFound;
+    std::atomic<size_t> _nMade;
+    std::atomic<size_t> _nEvicted;
+    std::atomic<size_t> _nPrefetched;
+    std::atomic<size_t> _nPrefetchUsed;
+    cache_t _cache;
+    // intervals of validity of the cached entities, by start run/subrun
+    iovIndex_t _iovIndex;
 
   };
 
@@ -15,9 +15,12 @@ namespace mu2e
   class KKBField : public KinKal::BFieldMap {
     public:
       using Grad = ROOT::Math::SMatrix<double,3>; // field gradient: ie dBi/d(x,y,z)
-    // construct from BField object and system translator.  
-    // This should be a single BField map valid in the detector system, to avoid making continuous translations FIXME!
-      KKBField(BFieldManager const& bfmgr, DetectorSystem const& det) : bfmgr_(bfmgr), det_(det) {}
+    // construct from BField object and system translator.  The detector system is only a translation
+    // of the Mu2e system, so keep its origin and translate the points directly.
+    // By default the gradient is the numerical derivative (2 field lookups per direction).  If
+    // numericalGrad is false it comes from the map interpolation, in one lookup.
+      KKBField(BFieldManager const& bfmgr, DetectorSystem const& det, bool numericalGrad=true) : 
+	bfmgr_(bfmgr), origin_(det.getOrigin()), numericalGrad_(numericalGrad) {}
       virtual ~KKBField() {}
       // KinKal BField interface
       // return value of the field at a poin
@@ -26,14 +29,15 @@ namespace mu2e
       virtual Grad fieldGrad(VEC3 const& position) const override;
       // return the BFieldMap derivative at a given point along a given velocity, WRT time
       virtual VEC3 fieldDeriv(VEC3 const& position, VEC3 const& velocity) const override;
+      // field and its gradient, grad[j] = dB/dx_j, from one map lookup
+      VEC3 fieldAndGrad(VEC3 const& position, VEC3 grad[3]) const;
     private:
+      CLHEP::Hep3Vector toMu2e(VEC3 const& position) const {
+	return CLHEP::Hep3Vector(position.x()+origin_.x(),position.y()+origin_.y(),position.z()+origin_.z()); }
+      VEC3 numericalDeriv(VEC3 const& position, VEC3 const& velocity) const;
       BFieldManager const& bfmgr_;
-      DetectorSystem const& det_;
+      CLHEP::Hep3Vector origin_; // detector system origin in the Mu2e system
+      bool numericalGrad_;
   };
 }
 #endif
-
-
-
-
-
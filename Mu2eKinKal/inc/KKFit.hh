@@ -74,10 +74,10 @@ namespace mu2e {
       // construct from fit configuration objects
       explicit KKFit(KKFitConfig const& fitconfig);
       // helper functions used to create components of the fit
-      void makeStrawHits(Tracker const& tracker,StrawResponse const& strawresponse, KKBField const& kkbf, StrawMaterial const& smat,
+      void makeStrawHits(Tracker const& tracker,StrawResponse const& strawresponse, KinKal::BFieldMap const& kkbf, StrawMaterial const& smat,
 	  PKTRAJ const& ptraj, ComboHitCollection const& chcol, StrawHitIndexCollection const& strawHitIdxs,
 	  KKSTRAWHITCOL& hits, KKSTRAWXINGCOL& exings) const;
-      void addStrawHits(Tracker const& tracker,StrawResponse const& strawresponse, KKBField const& kkbf, StrawMaterial const& smat,
+      void addStrawHits(Tracker const& tracker,StrawResponse const& strawresponse, KinKal::BFieldMap const& kkbf, StrawMaterial const& smat,
 	  KKTRK& kktrk, ComboHitCollection const& chcol, KKSTRAWHITCOL& hits, KKSTRAWXINGCOL& exings) const;
       void addStraws(Tracker const& tracker, StrawMaterial const& smat, KKTRK& kktrk, KKSTRAWXINGCOL& exings) const;
       void makeCaloHit(CCPtr const& cluster, Calorimeter const& calo, PKTRAJ const& pktraj, KKCALOHITCOL& hits) const;
@@ -139,7 +139,7 @@ namespace mu2e {
  {
   }
 
-  template <class KTRAJ> void KKFit<KTRAJ>::makeStrawHits(Tracker const& tracker,StrawResponse const& strawresponse,KKBField const& kkbf, StrawMaterial const& smat,
+  template <class KTRAJ> void KKFit<KTRAJ>::makeStrawHits(Tracker const& tracker,StrawResponse const& strawresponse,KinKal::BFieldMap const& kkbf, StrawMaterial const& smat,
       PKTRAJ const& ptraj, ComboHitCollection const& chcol, StrawHitIndexCollection const& strawHitIdxs,
       KKSTRAWHITCOL& hits, KKSTRAWXINGCOL& exings) const {
     // initialize hits as null (no drift).  Drift is turned on when updating
@@ -197,7 +197,7 @@ namespace mu2e {
     }
   }
 
-  template <class KTRAJ> void KKFit<KTRAJ>::addStrawHits(Tracker const& tracker,StrawResponse const& strawresponse, KKBField const& kkbf, StrawMaterial const& smat,
+  template <class KTRAJ> void KKFit<KTRAJ>::addStrawHits(Tracker const& tracker,StrawResponse const& strawresponse, KinKal::BFieldMap const& kkbf, StrawMaterial const& smat,
       KKTRK& kktrk, ComboHitCollection const& chcol,
       KKSTRAWHITCOL& hits, KKSTRAWXINGCOL& exings) const {
     // initialize hits as null (no drift).  Drift is turned on when updating
@@ -8,6 +8,7 @@
 #include "Mu2eKinKal/inc/KKStrawHit.hh"
 #include "Mu2eKinKal/inc/KKStrawXing.hh"
 #include "Mu2eKinKal/inc/KKCaloHit.hh"
+#include <memory>
 namespace mu2e {
 
   using KinKal::Config;
@@ -33,6 +34,9 @@ namespace mu2e {
       // construct from configuration, fit environment, and hits and materials
       KKTrack(Config const& config, BFieldMap const& bfield, KTRAJ const& seedtraj, PDGCode::type tpart,
 	KKSTRAWHITCOL const& strawhits, KKCALOHITCOL const& calohits, KKSTRAWXINGCOL const& strawxings);
+      // same, for a field specific to this track: the track keeps it alive
+      KKTrack(Config const& config, std::shared_ptr<const BFieldMap> const& bfield, KTRAJ const& seedtraj, PDGCode::type tpart,
+	KKSTRAWHITCOL const& strawhits, KKCALOHITCOL const& calohits, KKSTRAWXINGCOL const& strawxings);
       // extend the track according to new configuration, hits, and/or exings
       void extendTrack(Config const& config, 
 	KKSTRAWHITCOL const& strawhits, KKCALOHITCOL const& calohits, KKSTRAWXINGCOL const& strawxings);
@@ -47,6 +51,7 @@ namespace mu2e {
       KKSTRAWHITCOL strawhits_;  // straw hits used in this fit
       KKCALOHITCOL calohits_;  // calo hits used in this fit
       KKSTRAWXINGCOL strawxings_;  // straw material crossings used in this fit
+      std::shared_ptr<const BFieldMap> bfield_; // field owned by this track, if any
       // utility function to convert to generic types
       void convertTypes( KKSTRAWHITCOL const& strawhits, KKCALOHITCOL const& calohits, KKSTRAWXINGCOL const& strawxings,
 	  MEASCOL& hits, EXINGCOL& exings);
@@ -61,6 +66,12 @@ namespace mu2e {
     this->fit(hits,exings);
   }
 
+  template <class KTRAJ> KKTrack<KTRAJ>::KKTrack(Config const& config, std::shared_ptr<const BFieldMap> const& bfield, KTRAJ const& seedtraj, PDGCode::type tpart,
+      KKSTRAWHITCOL const& strawhits, KKCALOHITCOL const& calohits, KKSTRAWXINGCOL const& strawxings) :
+    KKTrack(config,*bfield,seedtraj,tpart,strawhits,calohits,strawxings) {
+    bfield_ = bfield;
+  }
+
   template <class KTRAJ> void KKTrack<KTRAJ>::convertTypes( KKSTRAWHITCOL const& strawhits, KKCALOHITCOL const& calohits, KKSTRAWXINGCOL const& strawxings,
       MEASCOL& hits, EXINGCOL& exings) {
     hits.reserve(strawhits_.size() + calohits_.size());
@@ -0,0 +1,93 @@
+#ifndef Mu2eKinKal_KKTrajBField_hh
+#define Mu2eKinKal_KKTrajBField_hh
+//
+//  BField along a trajectory for KinKal.  The field and its gradient are tabulated at nodes along
+//  a seed trajectory, and the field at a point near the trajectory is the first order expansion
+//  about the closest node.  The node spacing adapts to the field: a step is accepted when the expansion
+//  from either end predicts the full map field at the other end within the tolerance.  Points
+//  further than one step from the closest node, or anywhere before the tabulation, use the full map.
+//  The nodes follow one trajectory, so each track needs its own object, which must live as long as the track.
+//
+#include "Mu2eKinKal/inc/KKBField.hh"
+#include "KinKal/General/TimeRange.hh"
+#include <algorithm>
+#include <vector>
+
+namespace mu2e
+{
+  class KKTrajBField : public KinKal::BFieldMap {
+    public:
+      using Grad = KKBField::Grad;
+      // tolerance on the field (Tesla), minimum and maximum step along the trajectory (mm)
+      KKTrajBField(KKBField const& kkbf, double tolerance, double minstep, double maxstep) :
+	kkbf_(kkbf), tol_(tolerance), minstep_(minstep), maxstep_(maxstep) {}
+      virtual ~KKTrajBField() {}
+      // KinKal BField interface
+      virtual VEC3 fieldVect(VEC3 const& position) const override;
+      virtual Grad fieldGrad(VEC3 const& position) const override;
+      virtual VEC3 fieldDeriv(VEC3 const& position, VEC3 const& velocity) const override;
+      // replace the nodes by nodes along this trajectory over the given time range
+      template <class KTRAJ> void tabulate(KTRAJ const& traj, KinKal::TimeRange const& range);
+      void clear() { nodes_.clear(); }
+      // statistics: nodes of the last tabulation, queries answered from the nodes and from the map
+      size_t nNodes() const { return nodes_.size(); }
+      unsigned long nCached() const { return ncached_; }
+      unsigned long nFull() const { return nfull_; }
+      unsigned long nTabulated() const { return ntab_; }
+    private:
+      struct Node {
+	VEC3 pos_; // node position
+	VEC3 field_; // field at the node
+	VEC3 grad_[3]; // dB/dx_j at the node
+	double reach_; // distance from the node within which the expansion is used
+	Node(VEC3 const& pos, KKBField const& kkbf) : pos_(pos), reach_(0.0) { field_ = kkbf.fieldAndGrad(pos,grad_); }
+	VEC3 field(VEC3 const& position) const {
+	  VEC3 dpos = position - pos_;
+	  return field_ + grad_[0]*dpos.X() + grad_[1]*dpos.Y() + grad_[2]*dpos.Z(); }
+      };
+      // does the expansion about n0 predict the field at n1 within the tolerance, and with a margin?
+      bool predicts(Node const& n0, Node const& n1, double margin=1.0) const {
+	return (n0.field(n1.pos_)-n1.field_).R() < tol_*margin && (n1.field(n0.pos_)-n0.field_).R() < tol_*margin; }
+      // closest node if the position is within its reach, otherwise null
+      Node const* findNode(VEC3 const& position) const;
+      KKBField const& kkbf_;
+      double tol_, minstep_, maxstep_;
+      std::vector<Node> nodes_; // in increasing z
+      mutable unsigned long ncached_ = 0, nfull_ = 0;
+      unsigned long ntab_ = 0;
+  };
+
+  template <class KTRAJ> void KKTrajBField::tabulate(KTRAJ const& traj, KinKal::TimeRange const& range) {
+    nodes_.clear();
+    // speed along the trajectory, from a short chord
+    static const double dtspeed(0.01); // ns
+    double speed = (traj.position3(range.begin()+dtspeed)-traj.position3(range.begin())).R()/dtspeed;
+    if(speed <= 0.0) return;
+    double time = range.begin();
+    double step = maxstep_;
+    nodes_.emplace_back(traj.position3(time),kkbf_);
+    while(time < range.end()){
+      double dt = std::min(step/speed,range.end()-time);
+      Node next(traj.position3(time+dt),kkbf_);
+      bool good = predicts(nodes_.back(),next);
+      if(!good && step > minstep_){
+	step = std::max(0.5*step,minstep_);
+	continue;
+      }
+      // the expansion is used up to the accepted step from either node; at the minimum step it is
+      // only used at the node itself if the prediction fails
+      double reach = good ? (next.pos_ - nodes_.back().pos_).R() : 0.0;
+      nodes_.back().reach_ = std::max(nodes_.back().reach_,reach);
+      next.reach_ = reach;
+      nodes_.push_back(next);
+      time += dt;
+      if(predicts(nodes_[nodes_.size()-2],nodes_.back(),0.25)) step = std::min(2.0*step,maxstep_);
+    }
+    ntab_ += nodes_.size();
+    // the node search needs z to increase along the nodes
+    if(nodes_.size() > 1 && nodes_.front().pos_.Z() > nodes_.back().pos_.Z()) std::reverse(nodes_.begin(),nodes_.end());
+    for(size_t inode=1;inode < nodes_.size(); ++inode)
+      if(!(nodes_[inode].pos_.Z() > nodes_[inode-1].pos_.Z())){ nodes_.clear(); break; }
+  }
+}
+#endif
@@ -4,28 +4,40 @@ namespace mu2e {
   using SVEC3 = KinKal::SVEC3;
 
   VEC3 KKBField::fieldVect(VEC3 const& position) const {
-    // change coordinates to mu2e; the map should be native in detector coordinates FIXME!
-    CLHEP::Hep3Vector vpoint(position.x(),position.y(),position.z());
-    CLHEP::Hep3Vector vpoint_mu2e = det_.toMu2e(vpoint);
-    CLHEP::Hep3Vector field = bfmgr_.getBField(vpoint_mu2e);
+    CLHEP::Hep3Vector field = bfmgr_.getBField(toMu2e(position));
     return VEC3(field.x(),field.y(),field.z());
   }
       
+  VEC3 KKBField::fieldAndGrad(VEC3 const& position, VEC3 grad[3]) const {
+    if(numericalGrad_){
+      grad[0] = numericalDeriv(position,VEC3(1.0,0.0,0.0));
+      grad[1] = numericalDeriv(position,VEC3(0.0,1.0,0.0));
+      grad[2] = numericalDeriv(position,VEC3(0.0,0.0,1.0));
+      return fieldVect(position);
+    }
+    CLHEP::Hep3Vector field, cgrad[3];
+    bfmgr_.getBFieldAndGradWithStatus(toMu2e(position),field,cgrad);
+    for(unsigned irow=0;irow<3;++irow) grad[irow] = VEC3(cgrad[irow].x(),cgrad[irow].y(),cgrad[irow].z());
+    return VEC3(field.x(),field.y(),field.z());
+  }
+
   Grad KKBField::fieldGrad(VEC3 const& position) const {
     Grad retval;
-    auto dBdx = fieldDeriv(position,VEC3(1.0,0.0,0.0));
-    auto dBdy = fieldDeriv(position,VEC3(0.0,1.0,0.0));
-    auto dBdz = fieldDeriv(position,VEC3(0.0,0.0,1.0));
-    SVEC3 dBdxv(dBdx.X(),dBdx.Y(), dBdx.Z());
-    SVEC3 dBdyv(dBdy.X(),dBdy.Y(), dBdy.Z());
-    SVEC3 dBdzv(dBdz.X(),dBdz.Y(), dBdz.Z());
-    retval.Place_in_row(dBdxv,0,0);
-    retval.Place_in_row(dBdyv,1,0);
-    retval.Place_in_row(dBdzv,2,0);
+    VEC3 grad[3];
+    fieldAndGrad(position,grad);
+    for(unsigned irow=0;irow<3;++irow)
+      retval.Place_in_row(SVEC3(grad[irow].X(),grad[irow].Y(),grad[irow].Z()),irow,0);
     return retval;
   }
-// numerical derivatives for now: TODO!
+
   VEC3 KKBField::fieldDeriv(VEC3 const& position, VEC3 const& velocity) const {
+    if(numericalGrad_) return numericalDeriv(position,velocity);
+    VEC3 grad[3];
+    fieldAndGrad(position,grad);
+    return grad[0]*velocity.X() + grad[1]*velocity.Y() + grad[2]*velocity.Z();
+  }
+
+  VEC3 KKBField::numericalDeriv(VEC3 const& position, VEC3 const& velocity) const {
     static double dt(0.01); // 10 psec
     VEC3 start = fieldVect(position);
     VEC3 end = fieldVect(position + velocity*dt);
@@ -0,0 +1,59 @@
+#include "Mu2eKinKal/inc/KKTrajBField.hh"
+namespace mu2e {
+  using SVEC3 = KinKal::SVEC3;
+
+  KKTrajBField::Node const* KKTrajBField::findNode(VEC3 const& position) const {
+    if(nodes_.empty())return 0;
+    // the nodes bracketing the point in z; the closest of those in space
+    auto upper = std::lower_bound(nodes_.begin(),nodes_.end(),position.Z(),
+	[](Node const& node, double z){ return node.pos_.Z() < z; });
+    Node const* best(0);
+    double dmin(0.0);
+    if(upper != nodes_.end()){
+      best = &*upper;
+      dmin = (position - upper->pos_).R();
+    }
+    if(upper != nodes_.begin()){
+      auto lower = upper - 1;
+      double dist = (position - lower->pos_).R();
+      if(best == 0 || dist < dmin){
+	best = &*lower;
+	dmin = dist;
+      }
+    }
+    return dmin <= best->reach_ ? best : 0;
+  }
+
+  VEC3 KKTrajBField::fieldVect(VEC3 const& position) const {
+    Node const* node = findNode(position);
+    if(node){
+      ++ncached_;
+      return node->field(position);
+    }
+    ++nfull_;
+    return kkbf_.fieldVect(position);
+  }
+
+  KKTrajBField::Grad KKTrajBField::fieldGrad(VEC3 const& position) const {
+    Node const* node = findNode(position);
+    if(node == 0){
+      ++nfull_;
+      return kkbf_.fieldGrad(position);
+    }
+    ++ncached_;
+    Grad retval;
+    for(unsigned irow=0;irow<3;++irow)
+      retval.Place_in_row(SVEC3(node->grad_[irow].X(),node->grad_[irow].Y(),node->grad_[irow].Z()),irow,0);
+    return retval;
+  }
+
+  VEC3 KKTrajBField::fieldDeriv(VEC3 const& position, VEC3 const& velocity) const {
+    Node const* node = findNode(position);
+    if(node == 0){
+      ++nfull_;
+      return kkbf_.fieldDeriv(position,velocity);
+    }
+    ++ncached_;
+    return node->grad_[0]*velocity.X() + node->grad_[1]*velocity.Y() + node->grad_[2]*velocity.Z();
+  }
+}
@@ -55,10 +55,12 @@
 #include "Mu2eKinKal/inc/KKStrawXing.hh"
 #include "Mu2eKinKal/inc/KKCaloHit.hh"
 #include "Mu2eKinKal/inc/KKBField.hh"
+#include "Mu2eKinKal/inc/KKTrajBField.hh"
 // root
 #include "TH1F.h"
 #include "TTree.h"
 // C++
+#include <chrono>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -120,6 +122,12 @@ namespace mu2e {
       fhicl::Atom<bool> saveAll { Name("SaveAllFits"), Comment("Save all fits, whether they suceed or not"),false };
       fhicl::Atom<bool> saveFull { Name("SaveFullFit"), Comment("Save all helix segments associated with the fit"), false};
       fhicl::Sequence<float> zsave { Name("ZSavePositions"), Comment("Z positions to sample and save the fit result helices"), std::vector<float>()};
+      fhicl::Atom<bool> numericalBGrad { Name("NumericalBFieldGradient"), Comment("Use numerical BField derivatives; if false, use the gradient of the map interpolation"), true};
+      fhicl::Atom<bool> timeFits { Name("TimeFits"), Comment("Time the fit of each track and print the average at the end of the job"), false};
+      fhicl::Atom<bool> trajBField { Name("TrajFieldCache"), Comment("Tabulate the BField along the seed trajectory of each track, and interpolate it during the fit"), false};
+      fhicl::Atom<double> trajBFieldTol { Name("TrajFieldTolerance"), Comment("Maximum difference between the tabulated and map fields (Tesla)"), 1.0e-4};
+      fhicl::Atom<double> trajBFieldMinStep { Name("TrajFieldMinStep"), Comment("Minimum step between field nodes along the trajectory (mm)"), 10.0};
+      fhicl::Atom<double> trajBFieldMaxStep { Name("TrajFieldMaxStep"), Comment("Maximum step between field nodes along the trajectory (mm)"), 200.0};
     };
 
     struct GlobalConfig {
@@ -138,6 +146,7 @@ namespace mu2e {
     virtual ~LoopHelixFit();
     void beginRun(art::Run& run) override;
     void produce(art::Event& event) override;
+    void endJob() override;
     private:
     // utility functions
     KTRAJ makeSeedTraj(HelixSeed const& hseed) const;
@@ -149,6 +158,10 @@ namespace mu2e {
     TrkFitFlag goodhelix_;
     bool extend_, saveall_, savefull_;
     std::vector<float> zsave_;
+    bool numericalBGrad_, timeFits_, trajBField_;
+    double trajBFieldTol_, trajBFieldMinStep_, trajBFieldMaxStep_;
+    unsigned nfit_; // number of tracks fit, and their total fit time
+    double fittime_;
     ProditionsHandle<StrawResponse> strawResponse_h_;
     ProditionsHandle<Tracker> alignedTracker_h_;
     int print_;
@@ -158,6 +171,7 @@ namespace mu2e {
     double mass_; // particle mass
     int charge_; // particle charge
     std::unique_ptr<KKBField> kkbf_;
+    unsigned long ntabnodes_, ncachedb_, nfullb_; // trajectory field nodes and queries, summed over tracks
     Config config_; // initial fit configuration object
     Config exconfig_; // extension configuration object
   };
@@ -171,6 +185,14 @@ namespace mu2e {
     saveall_(settings().modSettings().saveAll()),
     savefull_(settings().modSettings().saveFull()),
     zsave_(settings().modSettings().zsave()),
+    numericalBGrad_(settings().modSettings().numericalBGrad()),
+    timeFits_(settings().modSettings().timeFits()),
+    trajBField_(settings().modSettings().trajBField()),
+    trajBFieldTol_(settings().modSettings().trajBFieldTol()),
+    trajBFieldMinStep_(settings().modSettings().trajBFieldMinStep()),
+    trajBFieldMaxStep_(settings().modSettings().trajBFieldMaxStep()),
+    nfit_(0), fittime_(0.0),
+    ntabnodes_(0), ncachedb_(0), nfullb_(0),
     print_(settings().modSettings().printLevel()),
     kkfit_(settings().mu2eFitSettings()),
     kkmat_(settings().matSettings()),
@@ -180,6 +202,8 @@ namespace mu2e {
     // test: only 1 of saveFull and zsave should be set
     if((savefull_ && zsave_.size() > 0) || ((!savefull_) && zsave_.size() == 0))
       throw cet::exception("RECO")<<"mu2e::LoopHelixFit:Segment saving configuration error"<< endl;
+    if(trajBField_ && (trajBFieldMinStep_ <= 0.0 || trajBFieldMaxStep_ < trajBFieldMinStep_))
+      throw cet::exception("RECO")<<"mu2e::LoopHelixFit:Trajectory field step configuration error"<< endl;
     // collection handling
     for(const auto& hseedtag : settings().modSettings().helixSeedCollections()) { hseedCols_.emplace_back(consumes<HelixSeedCollection>(hseedtag)); }
     produces<KKLoopHelixCollection>();
@@ -205,7 +229,7 @@ namespace mu2e {
     // create KKBField
     GeomHandle<BFieldManager> bfmgr;
     GeomHandle<DetectorSystem> det;
-    kkbf_ = std::move(std::make_unique<KKBField>(*bfmgr,*det));
+    kkbf_ = std::move(std::make_unique<KKBField>(*bfmgr,*det,numericalBGrad_));
   }
 
   void LoopHelixFit::produce(art::Event& event ) {
@@ -237,7 +261,13 @@ namespace mu2e {
 	// check helicity.  The test on the charge and helicity 
 	if(hseed.status().hasAllProperties(goodhelix_) ){
 	  // construt the seed trajectory
+	  auto fitstart = std::chrono::steady_clock::now();
 	  KTRAJ seedtraj = makeSeedTraj(hseed);
+	  // the field used by the hits and the track.  The trajectory field belongs to this track, and is
+	  // tabulated once the time range is known; until then it is the full map
+	  std::shared_ptr<KKTrajBField> kktbf;
+	  if(trajBField_)kktbf = std::make_shared<KKTrajBField>(*kkbf_,trajBFieldTol_,trajBFieldMinStep_,trajBFieldMaxStep_);
+	  KinKal::BFieldMap const& bfield = kktbf ? static_cast<KinKal::BFieldMap const&>(*kktbf) : *kkbf_;
 	  // wrap the seed traj in a Piecewise traj: needed to satisfy PTOCA interface
 	  PKTRAJ pseedtraj(seedtraj);
 	  // first, we need to unwind the combohits.  We use this also to find the time range
@@ -249,15 +279,20 @@ namespace mu2e {
 	  KKSTRAWXINGCOL strawxings;
 	  strawhits.reserve(hhits.size());
 	  strawxings.reserve(hhits.size());
-	  kkfit_.makeStrawHits(*tracker, *strawresponse, *kkbf_, kkmat_.strawMaterial(), pseedtraj, chcol, strawHitIdxs, strawhits, strawxings);
+	  kkfit_.makeStrawHits(*tracker, *strawresponse, bfield, kkmat_.strawMaterial(), pseedtraj, chcol, strawHitIdxs, strawhits, strawxings);
 	  // optionally (and if present) add the CaloCluster hit
 	  // verify the cluster looks physically reasonable before adding it TODO!  Or, let the KKCaloHit updater do it
 	  KKCALOHITCOL calohits;
 	  if (kkfit_.useCalo() && hseed.caloCluster())kkfit_.makeCaloHit(hseed.caloCluster(),*calo_h, pseedtraj, calohits);
 	  // set the seed range given the hit TPOCA values
 	  seedtraj.range() = kkfit_.range(strawhits,calohits,strawxings);
-	  // create and fit the track  
-	  auto kktrk = make_unique<KKTRK>(config_,*kkbf_,seedtraj,kkfit_.fitParticle(),strawhits,calohits,strawxings);
+	  // create and fit the track.  The track owns the trajectory field
+	  std::unique_ptr<KKTRK> kktrk;
+	  if(kktbf){
+	    kktbf->tabulate(seedtraj,seedtraj.range());
+	    kktrk = make_unique<KKTRK>(config_,std::shared_ptr<const KinKal::BFieldMap>(kktbf),seedtraj,kkfit_.fitParticle(),strawhits,calohits,strawxings);
+	  } else
+	    kktrk = make_unique<KKTRK>(config_,bfield,seedtraj,kkfit_.fitParticle(),strawhits,calohits,strawxings);
 	  if(print_ > 1){
 	    std::cout << "Seed Helix parameters " << hseed.helix() << std::endl;
 	    seedtraj.print(std::cout,print_);
@@ -278,7 +313,7 @@ namespace mu2e {
 	      KKSTRAWHITCOL addstrawhits;
 	      KKCALOHITCOL addcalohits;
 	      KKSTRAWXINGCOL addstrawxings;
-	      kkfit_.addStrawHits(*tracker, *strawresponse, *kkbf_, kkmat_.strawMaterial(), *kktrk, chcol, addstrawhits, addstrawxings );
+	      kkfit_.addStrawHits(*tracker, *strawresponse, bfield, kkmat_.strawMaterial(), *kktrk, chcol, addstrawhits, addstrawxings );
 	      if(kkfit_.useCalo())kkfit_.addCaloHit(*calo_h, *kktrk, cc_H, addcalohits);
 	      if(kkfit_.addMaterial())kkfit_.addStraws(*tracker, kkmat_.strawMaterial(), *kktrk, addstrawxings);
 	      kktrk->extendTrack(exconfig_,addstrawhits,addcalohits,addstrawxings);
@@ -295,6 +330,15 @@ namespace mu2e {
 	      }
 	    }
 	  }
+	  if(timeFits_){
+	    ++nfit_;
+	    fittime_ += std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-fitstart).count();
+	  }
+	  if(kktbf){
+	    ntabnodes_ += kktbf->nTabulated();
+	    ncachedb_ += kktbf->nCached();
+	    nfullb_ += kktbf->nFull();
+	  }
 	  if(save || saveall_){
 	    // convert KKTrk into KalSeeds for persistence
 	    auto const& fittraj = kktrk->fitTraj();
@@ -332,6 +376,15 @@ namespace mu2e {
     event.put(move(kkseedassns));
   }
 
+  void LoopHelixFit::endJob() {
+    if(timeFits_ && nfit_ > 0) 
+      std::cout << moduleDescription().moduleLabel() << ": " << nfit_ << " tracks fit, " 
+	<< fittime_/nfit_ << " ms per track" << (numericalBGrad_ ? " with numerical BField derivatives" : " with the map BField gradient") << std::endl;
+    if(trajBField_)
+      std::cout << moduleDescription().moduleLabel() << ": " << ntabnodes_ << " trajectory field nodes, "
+	<< ncachedb_ << " field queries from the nodes and " << nfullb_ << " from the map during the fits" << std::endl;
+  }
+
   KTRAJ LoopHelixFit::makeSeedTraj(HelixSeed const& hseed) const {
     // compute the magnetic field at the helix center.  We only want the z compontent, as the helix fit assumes B points along Z
     auto const& shelix = hseed.helix();
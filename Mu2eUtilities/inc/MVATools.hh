@@ -8,6 +8,9 @@
 #include <xercesc/util/PlatformUtils.hpp>
 #include <xercesc/parsers/XercesDOMParser.hpp>
 #include <xercesc/dom/DOMDocument.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 
@@ -15,6 +18,9 @@
 namespace mu2e 
 {
 
+  // Evaluates a TMVA MLP network.  The weights are read once per weights file
+  // and shared by all instances; evaluation is const and re-entrant, so one
+  // instance can be used from several threads.
   class MVATools
   {
      public:
@@ -32,36 +38,46 @@ namespace mu2e
        void     initMVA();
        float    evalMVA(const std::vector<float>&,  const MVAMask& vmask=0xffffffff) const;
        float    evalMVA(const std::vector<double>&, const MVAMask& vmask=0xffffffff) const;
+       // evaluate nvec feature vectors of nvar values each, stored one after the other
+       void     evalMVA(const float* features, size_t nvec, size_t nvar, float* scores,
+                        const MVAMask& vmask=0xffffffff) const;
        void     showMVA() const;
        
-       const std::vector<std::string>& titles() const { return title_;}     
-       const std::vector<std::string>& labels() const { return label_;}     
+       const std::vector<std::string>& titles() const;
+       const std::vector<std::string>& labels() const;
  
  
     private:       
        enum   aType {null, tanh, sigmoid, relu};
+
+       // network description read from the weights file
+       struct Network
+       {
+          std::vector<float>         wgts;
+          std::vector<unsigned>      links;
+          unsigned                   maxNeurons = 0;
+          aType                      activeType = aType::null;
+          bool                       oldMVA = false;
+          bool                       isNorm = false;
+          std::vector<float>         voffset;
+          std::vector<float>         vscale;
+          std::vector<std::string>   title;
+          std::vector<std::string>   label;
+          std::string                activationTypeString = "none";
+       };
        
-       void   getGen(xercesc::DOMDocument* xmlDoc);
-       void   getOpts(xercesc::DOMDocument* xmlDoc);
-       void   getNorm(xercesc::DOMDocument* xmlDoc);
-       void   getWgts(xercesc::DOMDocument* xmlDoc);
-       float  activation(float arg) const;
+       void   getGen(xercesc::DOMDocument* xmlDoc, Network& net) const;
+       void   getOpts(xercesc::DOMDocument* xmlDoc, Network& net) const;
+       void   getNorm(xercesc::DOMDocument* xmlDoc, Network& net) const;
+       void   getWgts(xercesc::DOMDocument* xmlDoc, Network& net) const;
+       void   activation(float* y, size_t n) const;
+
+       // networks already read, by weights file name
+       static std::mutex& cacheMutex();
+       static std::map<std::string,std::weak_ptr<const Network> >& networkCache();
 
-       mutable std::vector<float> x_;
-       mutable std::vector<float> y_;
-       mutable std::vector<float> fv_;      
-       std::vector<float>         wgts_;
-       std::vector<unsigned>      links_;
-       unsigned                   maxNeurons_;
-       aType                      activeType_;
-       bool                       oldMVA_;
-       bool                       isNorm_;       
-       std::vector<float>         voffset_;
-       std::vector<float>         vscale_;
-       std::vector<std::string>   title_;
-       std::vector<std::string>   label_;
-       std::string                activationTypeString_;
-       std::string                mvaWgtsFile_;
+       std::shared_ptr<const Network> net_;
+       std::string                    mvaWgtsFile_;
 
   public:
        void   getCalib(std::map<float, float>& effCalib);
@@ -39,6 +39,16 @@ namespace mu2e {
     }
     
     inline size_t   size(){ return _vec.size(); }
+
+    // remove all the entries, keeping the allocated space for reuse
+    inline void     clear(){
+      _vec.clear();
+      _needsSorting     = true;
+      _weightedMedian   = 0;
+      _unweightedMedian = 0;
+      _totalWeight      = 0;
+    }
+    inline void     reserve(size_t n){ _vec.reserve(n); }
   private:
     
     std::vector<MedianData>  _vec; 
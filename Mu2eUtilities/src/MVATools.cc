@@ -38,19 +38,7 @@ namespace mu2e
 {
 
   MVATools::MVATools(const Config& config) :
-    x_(),
-    y_(),
-    fv_(),
-    wgts_(),
-    maxNeurons_(0),
-    activeType_(aType::null),
-    oldMVA_(false),
-    isNorm_(false),
-    voffset_(),
-    vscale_(),
-    title_(),
-    label_(),
-    activationTypeString_("none"),
+    net_(),
     mvaWgtsFile_()
   {
      ConfigFileLookupPolicy configFile;
@@ -59,19 +47,7 @@ namespace mu2e
   }
 
   MVATools::MVATools(fhicl::ParameterSet const& pset) :
-    x_(),
-    y_(),
-    fv_(),
-    wgts_(),
-    maxNeurons_(0),
-    activeType_(aType::null),
-    oldMVA_(false),
-    isNorm_(false),
-    voffset_(),
-    vscale_(),
-    title_(),
-    label_(),
-    activationTypeString_("none"),
+    net_(),
     mvaWgtsFile_()
   {
      ConfigFileLookupPolicy configFile;
@@ -80,19 +56,7 @@ namespace mu2e
   }
 
   MVATools::MVATools(const std::string& xmlfilename) :
-    x_(),
-    y_(),
-    fv_(),
-    wgts_(), 
-    maxNeurons_(0), 
-    activeType_(aType::null),
-    oldMVA_(false),
-    isNorm_(false),
-    voffset_(), 
-    vscale_(), 
-    title_(), 
-    label_(),
-    activationTypeString_("none"),
+    net_(),
     mvaWgtsFile_() { 
 
     ConfigFileLookupPolicy configFile;
@@ -100,24 +64,55 @@ namespace mu2e
   }
 
 
-  MVATools::~MVATools() {
-    XMLPlatformUtils::Terminate();
+  MVATools::~MVATools() {}
+
+  std::mutex& MVATools::cacheMutex() {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+  std::map<std::string,std::weak_ptr<const MVATools::Network> >& MVATools::networkCache() {
+    static std::map<std::string,std::weak_ptr<const Network> > cache;
+    return cache;
   }
 
   void MVATools::initMVA()
   {
-    if (wgts_.size()>0) throw cet::exception("RECO")<<"mu2e::MVATools: already initialized" << std::endl;
+    // calling again is harmless: the network is already in place
+    if (net_) return;
 
+    // the lock also serializes the use of xerces
+    std::lock_guard<std::mutex> lock(cacheMutex());
+    auto& cache = networkCache();
+    auto icache = cache.find(mvaWgtsFile_);
+    if (icache != cache.end()) net_ = icache->second.lock();
+    if (net_) return;
+
+    auto net = std::make_shared<Network>();
     xercesc::DOMDocument* xmlDoc = getXmlDoc();
-    getGen(xmlDoc);
-    getOpts(xmlDoc);
-    getNorm(xmlDoc);
-    getWgts(xmlDoc);
+    getGen(xmlDoc,*net);
+    getOpts(xmlDoc,*net);
+    getNorm(xmlDoc,*net);
+    getWgts(xmlDoc,*net);
 
     xmlDoc->release();
+    XMLPlatformUtils::Terminate();
+
+    net_ = net;
+    cache[mvaWgtsFile_] = net_;
   }
 
-  void MVATools::getGen(xercesc::DOMDocument* xmlDoc)
+  const std::vector<std::string>& MVATools::titles() const {
+    static const std::vector<std::string> none;
+    return net_ ? net_->title : none;
+  }
+
+  const std::vector<std::string>& MVATools::labels() const {
+    static const std::vector<std::string> none;
+    return net_ ? net_->label : none;
+  }
+
+  void MVATools::getGen(xercesc::DOMDocument* xmlDoc, Network& net) const
   {
       XMLCh* ATT_GENERAL = XMLString::transcode("GeneralInfo");
       XMLCh* ATT_INFO = XMLString::transcode("Info");
@@ -151,7 +146,7 @@ namespace mu2e
 	  {
  	     std::string code = value.substr(value.find("[")+1,value.find("]")-value.find("[")-1);
 	     int iversion = atoi(code.c_str());
-             if (iversion < 262657) oldMVA_ = true;
+             if (iversion < 262657) net.oldMVA = true;
 	  }
       }
 
@@ -161,7 +156,7 @@ namespace mu2e
       XMLString::release(&TAG_VALUE);
   }
 
-  void MVATools::getOpts(xercesc::DOMDocument* xmlDoc)
+  void MVATools::getOpts(xercesc::DOMDocument* xmlDoc, Network& net) const
   {
       XMLCh* ATT_OPTION = XMLString::transcode("Option");
       XMLCh* TAG_NAME = XMLString::transcode("name");
@@ -193,28 +188,28 @@ namespace mu2e
           if (label.find("NeuronType") != std::string::npos)
 	  {
 	     std::string val(value);
-	     if (val.find("tanh") != std::string::npos)    activeType_ = aType::tanh;
-	     if (val.find("sigmoid") != std::string::npos) activeType_ = aType::sigmoid;
-	     if (val.find("ReLU") != std::string::npos)    activeType_ = aType::relu;
-             activationTypeString_ = val;
+	     if (val.find("tanh") != std::string::npos)    net.activeType = aType::tanh;
+	     if (val.find("sigmoid") != std::string::npos) net.activeType = aType::sigmoid;
+	     if (val.find("ReLU") != std::string::npos)    net.activeType = aType::relu;
+             net.activationTypeString = val;
 	  }
           if (label.find("VarTransform") != std::string::npos)
 	  {
 	     std::string val(value);
-	     if (modified.find("Yes") != std::string::npos) isNorm_ = true;
-	     if (isNorm_ && val.find("N") == std::string::npos)
+	     if (modified.find("Yes") != std::string::npos) net.isNorm = true;
+	     if (net.isNorm && val.find("N") == std::string::npos)
                throw cet::exception("RECO")<<"mu2e::MVATools: unknown normalization mode" << std::endl;
 	  }
       }
 
-      if (activeType_ == aType::null) throw cet::exception("RECO")<<"mu2e::MVATools: unknown activation function" << std::endl;
+      if (net.activeType == aType::null) throw cet::exception("RECO")<<"mu2e::MVATools: unknown activation function" << std::endl;
 
       XMLString::release(&ATT_OPTION);
       XMLString::release(&TAG_NAME);
       XMLString::release(&TAG_MODIFIED);
   }
 
-  void MVATools::getNorm(xercesc::DOMDocument* xmlDoc)
+  void MVATools::getNorm(xercesc::DOMDocument* xmlDoc, Network& net) const
   {
       XMLCh* TAG_VARIABLE = XMLString::transcode("Variable");
       XMLCh* ATT_MIN = XMLString::transcode("Min");
@@ -250,10 +245,10 @@ namespace mu2e
 
             XMLString::release( &attValue ) ;
          }
-         voffset_.push_back(vmin);
-         vscale_.push_back(2.0/(vmax-vmin));
-         title_.push_back(title);
-         label_.push_back(label);
+         net.voffset.push_back(vmin);
+         net.vscale.push_back(2.0/(vmax-vmin));
+         net.title.push_back(title);
+         net.label.push_back(label);
       }
 
       XMLString::release(&TAG_VARIABLE);
@@ -298,7 +293,7 @@ namespace mu2e
   }
 
 
-  void MVATools::getWgts(xercesc::DOMDocument* xmlDoc)
+  void MVATools::getWgts(xercesc::DOMDocument* xmlDoc, Network& net) const
   {
       XMLCh* ATT_NSYNAPSES = XMLString::transcode("NSynapses");
       XMLCh* ATT_INDEX = XMLString::transcode("Index");
@@ -334,7 +329,7 @@ namespace mu2e
 
           if (iLayer != iCurrentLayer)
 	  {
-              if (iCurrentLayer > -1) links_.push_back(nNeurons);
+              if (iCurrentLayer > -1) net.links.push_back(nNeurons);
 	      iCurrentLayer=iLayer;
               nNeurons=0;
 	  }
@@ -358,8 +353,8 @@ namespace mu2e
       // we also need the number of synapses / layer, which is given by the number of neurons in the next layer -1 to remove bias neuron
       //
       std::vector<unsigned> layerToNeurons(1,0),synapsessPerLayer;
-      for (const auto& val : links_)    layerToNeurons.push_back(val+layerToNeurons.back());
-      for (size_t i=1;i<links_.size();++i) synapsessPerLayer.push_back(links_[i]-1);
+      for (const auto& val : net.links)    layerToNeurons.push_back(val+layerToNeurons.back());
+      for (size_t i=1;i<net.links.size();++i) synapsessPerLayer.push_back(net.links[i]-1);
       synapsessPerLayer.push_back(1);
 
       for (unsigned iLayer=1;iLayer < layerToNeurons.size(); ++iLayer)
@@ -367,13 +362,11 @@ namespace mu2e
 	  for (unsigned iOut=0;iOut<synapsessPerLayer[iLayer-1];++iOut)
 	  {
 	     std::vector<float> temp;
-	     for (unsigned iIn=layerToNeurons[iLayer-1];iIn<layerToNeurons[iLayer];++iIn) wgts_.push_back(wtemp[iIn][iOut]);
+	     for (unsigned iIn=layerToNeurons[iLayer-1];iIn<layerToNeurons[iLayer];++iIn) net.wgts.push_back(wtemp[iIn][iOut]);
 	  }
       }
 
-      maxNeurons_ = *std::max_element(links_.begin(),links_.end());
-      x_ = std::vector<float>(maxNeurons_,0.0f);
-      y_ = std::vector<float>(maxNeurons_,0.0f);
+      net.maxNeurons = *std::max_element(net.links.begin(),net.links.end());
 
       XMLString::release(&ATT_INDEX);
       XMLString::release(&ATT_NSYNAPSES);
@@ -381,6 +374,7 @@ namespace mu2e
   
   void MVATools::getCalib(std::map<float, float>& effCalib) {
 
+    std::lock_guard<std::mutex> lock(cacheMutex());
     xercesc::DOMDocument* xmlDoc = getXmlDoc();
 
     XMLCh* TAG_CALIBRATION = XMLString::transcode("Calib");
@@ -423,86 +417,149 @@ namespace mu2e
     XMLString::release(&ATT_EFF);
     XMLString::release(&ATT_CUT);
     xmlDoc->release();
+    XMLPlatformUtils::Terminate();
   }
 
 
   float MVATools::evalMVA(const std::vector<double >& v, const MVAMask& mask) const
   {
-     for (size_t i=0;i<v.size();++i)  fv_[i] = static_cast<float>(v[i]);
-     return evalMVA(fv_,mask);
+     thread_local std::vector<float> fv;
+     fv.assign(v.begin(),v.end());
+     return evalMVA(fv,mask);
   }
 
   float MVATools::evalMVA(const std::vector<float>& v, const MVAMask& mask) const
   {
+     float score(0.0);
+     evalMVA(v.data(),1,v.size(),&score,mask);
+     return score;
+  }
 
-      // Normalize the input data and add the bias node, skip masked values
-      size_t ival(0);
-      for (size_t ivar=0; ivar < v.size(); ivar++)
-      {
-         if ( mask & (1<<ivar) )
-         {
-	    x_[ival]= isNorm_ ? (v[ivar]-voffset_[ival])*vscale_[ival] - 1.0 : v[ivar];
-	    ++ival;
-         }
+  void MVATools::evalMVA(const float* features, size_t nvec, size_t nvar, float* scores, const MVAMask& mask) const
+  {
+      if (!net_) throw cet::exception("RECO")<<"mu2e::MVATools: evaluation before initMVA, weights " << mvaWgtsFile_ << std::endl;
+      const Network& net = *net_;
+      const std::vector<unsigned>& links = net.links;
+
+      size_t nsel(0);
+      for (size_t ivar=0; ivar < nvar; ivar++) if ( mask & (1<<ivar) ) ++nsel;
+      if (nsel != links[0]-1)
+	throw cet::exception("RECO")<<"mu2e::MVATools: mismatch input dimension (ival = " << nsel << ") and network architecture (links_[0]-1 = " << links[0]-1 << ")" << std::endl;
+
+      // Vectors are processed in blocks. Within a block the neuron values are stored
+      // neuron by neuron, so the inner loops run over the vectors of the block.
+      // The sums are accumulated in the same order as for a single vector.
+      constexpr size_t blockSize = 64;
+      thread_local std::vector<float> xbuf, ybuf;
+      if (xbuf.size() < net.maxNeurons*blockSize) {
+        xbuf.resize(net.maxNeurons*blockSize);
+        ybuf.resize(net.maxNeurons*blockSize);
       }
-      x_[ival] = 1.0;
 
-      if (ival != links_[0]-1)
-	throw cet::exception("RECO")<<"mu2e::MVATools: mismatch input dimension (ival = " << ival << ") and network architecture (links_[0]-1 = " << links_[0]-1 << ")" << std::endl;
+      for (size_t first=0; first < nvec; first += blockSize)
+      {
+          const size_t nb = std::min(blockSize,nvec-first);
+          float* x = xbuf.data();
+          float* y = ybuf.data();
 
+          // Normalize the input data and add the bias node, skip masked values
+          for (size_t ib=0; ib < nb; ++ib)
+          {
+             const float* v = features + (first+ib)*nvar;
+             size_t ival(0);
+             for (size_t ivar=0; ivar < nvar; ivar++)
+             {
+                if ( mask & (1<<ivar) )
+                {
+	           x[ival*nb+ib] = net.isNorm ? (v[ivar]-net.voffset[ival])*net.vscale[ival] - 1.0 : v[ivar];
+	           ++ival;
+                }
+             }
+             x[ival*nb+ib] = 1.0;
+          }
 
-      //perform feed forward calculation up to the last hidden layer
-      unsigned idxWeight(0);
-      for (unsigned k=0;k<links_.size()-1;++k)
-      {
-          //the number of synpases is given by the number of neurons in the next layer -1 (do not count bias neuron!)
-          for (unsigned j=0;j<links_[k+1]-1;++j)
+          //perform feed forward calculation up to the last hidden layer
+          unsigned idxWeight(0);
+          for (unsigned k=0;k<links.size()-1;++k)
           {
-	     y_[j]=0.0f;
-	     for (unsigned i=0;i<links_[k];++i) y_[j] += wgts_[i+idxWeight]*x_[i];
-             y_[j] = activation(y_[j]);
-             idxWeight += links_[k];
+              //the number of synpases is given by the number of neurons in the next layer -1 (do not count bias neuron!)
+              const unsigned nout = links[k+1]-1;
+              for (unsigned j=0;j<nout;++j)
+              {
+                 float* yj = y + j*nb;
+                 const float* w = &net.wgts[idxWeight];
+                 for (size_t ib=0; ib < nb; ++ib) yj[ib] = 0.0f;
+                 for (unsigned i=0;i<links[k];++i)
+                 {
+                    const float wi = w[i];
+                    const float* xi = x + i*nb;
+                    for (size_t ib=0; ib < nb; ++ib) yj[ib] += wi*xi[ib];
+                 }
+                 activation(yj,nb);
+                 idxWeight += links[k];
+              }
+              std::swap(x,y);
+              for (size_t ib=0; ib < nb; ++ib) x[nout*nb+ib] = 1.0f; //add bias neuron
           }
-          x_.swap(y_);
-          x_[links_[k+1]-1] = 1.0f; //add bias neuron
-      }
 
-      //calculate output neuron value
-      float yf(0.0);
-      for (unsigned i=0;i<links_.back();++i) yf += wgts_[i+idxWeight]*x_[i];
+          //calculate output neuron value
+          const float* w = &net.wgts[idxWeight];
+          for (size_t ib=0; ib < nb; ++ib) y[ib] = 0.0f;
+          for (unsigned i=0;i<links.back();++i)
+          {
+             const float wi = w[i];
+             const float* xi = x + i*nb;
+             for (size_t ib=0; ib < nb; ++ib) y[ib] += wi*xi[ib];
+          }
 
-      if (oldMVA_) return yf;
-      return  1.0/(1.0+expf(-yf));
+          float* out = scores + first;
+          if (net.oldMVA)
+            for (size_t ib=0; ib < nb; ++ib) out[ib] = y[ib];
+          else
+            for (size_t ib=0; ib < nb; ++ib) out[ib] = 1.0/(1.0+expf(-y[ib]));
+      }
   }
 
 
 
 
-  float MVATools::activation(float arg) const
+  void MVATools::activation(float* y, size_t n) const
   {
-     if (activeType_== aType::tanh)
+     switch (net_->activeType)
      {
-       if (oldMVA_) return std::tanh(arg);
-       if (arg > 4.97) return 1.0;
-       if (arg < -4.97) return -1.0;
-       float arg2 = arg * arg;
-       float a = arg * (135135.0f + arg2 * (17325.0f + arg2 * (378.0f + arg2)));
-       float b = 135135.0f + arg2 * (62370.0f + arg2 * (3150.0f + arg2 * 28.0f));
-       return a/b;
+       case aType::tanh:
+         if (net_->oldMVA)
+         {
+           for (size_t i=0; i < n; ++i) y[i] = std::tanh(y[i]);
+           return;
+         }
+         for (size_t i=0; i < n; ++i)
+         {
+           float arg = y[i];
+           float arg2 = arg * arg;
+           float a = arg * (135135.0f + arg2 * (17325.0f + arg2 * (378.0f + arg2)));
+           float b = 135135.0f + arg2 * (62370.0f + arg2 * (3150.0f + arg2 * 28.0f));
+           y[i] = arg > 4.97 ? 1.0f : (arg < -4.97 ? -1.0f : a/b);
+         }
+         return;
+       case aType::sigmoid:
+         for (size_t i=0; i < n; ++i) y[i] = 1.0/(1.0+expf(-y[i]));
+         return;
+       case aType::relu:
+         for (size_t i=0; i < n; ++i) y[i] = std::max(0.0f,y[i]);
+         return;
+       default:
+         for (size_t i=0; i < n; ++i) y[i] = -999.0;
      }
-     if (activeType_== aType::sigmoid) return 1.0/(1.0+expf(-arg));
-     if (activeType_== aType::relu) return std::max(0.0f,arg);
-
-     return -999.0;
   }
 
 
   void MVATools::showMVA() const
   {
       std::cout << "MVA weights from file:" <<     mvaWgtsFile_ << std::endl;;
-      std::cout << "MVA NLayers: " << links_.size()-1 << std::endl;;
-      std::cout << "MVA NVars: " << title_.size() << std::endl;;
-      std::cout << "MVA Activation type: " << activationTypeString_ << std::endl;;
+      std::cout << "MVA NLayers: " << net_->links.size()-1 << std::endl;;
+      std::cout << "MVA NVars: " << net_->title.size() << std::endl;;
+      std::cout << "MVA Activation type: " << net_->activationTypeString << std::endl;;
 
       std::cout.setf(std::ios::scientific);
       std::cout.precision(7);
@@ -510,8 +567,8 @@ namespace mu2e
       const std::string stars1(12,'*');
       const std::string label1 = " MVA Normalization ";
       std::cout << stars1 << label1 << stars1 << std::endl;;
-      for (size_t i = 0; i <label_.size(); ++i)
-        std::cout << "Var " << i <<" "<< label_[i] << " " << title_[i] << ": min=" << voffset_[i] << " max=" << 2.0/vscale_[i]+voffset_[i] << std::endl;;
+      for (size_t i = 0; i <net_->label.size(); ++i)
+        std::cout << "Var " << i <<" "<< net_->label[i] << " " << net_->title[i] << ": min=" << net_->voffset[i] << " max=" << 2.0/net_->vscale[i]+net_->voffset[i] << std::endl;;
 
       const std::string morestars1(24+label1.size(),'*');
       std::cout << morestars1 << std::endl;;
@@ -522,21 +579,21 @@ namespace mu2e
 
 
       int idx(0);
-      for (unsigned k=0;k<links_.size()-1;++k)
+      for (unsigned k=0;k<net_->links.size()-1;++k)
       {
         std::cout<<"Layer "<<k<<std::endl;
-        for (unsigned j=0;j<links_[k+1]-1;++j)
+        for (unsigned j=0;j<net_->links[k+1]-1;++j)
         {
-	  std::cout<<"Synapses 1.."<<links_[k]<<" of current layer to synapse "<<j<<" of next layer"<<std::endl;
-	  for (unsigned i=idx;i<idx+links_[k];++i)std::cout<<wgts_[i]<<" ";
+	  std::cout<<"Synapses 1.."<<net_->links[k]<<" of current layer to synapse "<<j<<" of next layer"<<std::endl;
+	  for (unsigned i=idx;i<idx+net_->links[k];++i)std::cout<<net_->wgts[i]<<" ";
 	  std::cout<<std::endl;
-          idx += links_[k];
+          idx += net_->links[k];
         }
       }
 
-      std::cout<<"Layer "<<links_.size()-1<<std::endl;
-      std::cout<<"Synapses 1.."<<links_.back()<<" of current layer to synapse 0 of next layer"<<std::endl;
-      for (unsigned i=idx;i<idx+links_.back();++i)std::cout<<wgts_[i]<<" ";
+      std::cout<<"Layer "<<net_->links.size()-1<<std::endl;
+      std::cout<<"Synapses 1.."<<net_->links.back()<<" of current layer to synapse 0 of next layer"<<std::endl;
+      for (unsigned i=idx;i<idx+net_->links.back();++i)std::cout<<net_->wgts[i]<<" ";
       std::cout<<std::endl;
 
       const std::string morestars2(46+label2.size(),'*');
@@ -0,0 +1,72 @@
+//
+// Compare the per-vector and the batch evaluation of an MVA weights file.
+//
+//   mvaBenchmark weights.xml [nvec] [iterations]
+//
+// The weights file is looked up with MU2E_SEARCH_PATH.  The inputs are random
+// and uniform in [0,1); the time per vector and the largest difference between
+// the two evaluations are printed.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cetlib_except/exception.h"
+
+#include "Mu2eUtilities/inc/MVATools.hh"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "Usage: mvaBenchmark weights.xml [nvec] [iterations]" << std::endl;
+        return 1;
+    }
+    const size_t nvec  = argc > 2 ? std::strtoul(argv[2],nullptr,10) : 1000;
+    const size_t niter = argc > 3 ? std::strtoul(argv[3],nullptr,10) : 100;
+
+    try {
+        mu2e::MVATools mva(argv[1]);
+        mva.initMVA();
+        const size_t nvar = mva.titles().size();
+
+        std::mt19937 engine(12345);
+        std::uniform_real_distribution<float> flat(0.0,1.0);
+        std::vector<float> features(nvec*nvar);
+        for (auto& f : features) f = flat(engine);
+
+        typedef std::chrono::steady_clock clock;
+        std::vector<float> scalar(nvec), batch(nvec), v(nvar);
+
+        auto t0 = clock::now();
+        for (size_t it=0; it < niter; ++it) {
+            for (size_t i=0; i < nvec; ++i) {
+                std::copy(features.begin()+i*nvar,features.begin()+(i+1)*nvar,v.begin());
+                scalar[i] = mva.evalMVA(v);
+            }
+        }
+        auto t1 = clock::now();
+        for (size_t it=0; it < niter; ++it) {
+            mva.evalMVA(features.data(),nvec,nvar,batch.data());
+        }
+        auto t2 = clock::now();
+
+        float maxdiff(0.0);
+        for (size_t i=0; i < nvec; ++i) maxdiff = std::max(maxdiff,std::abs(scalar[i]-batch[i]));
+
+        const double norm = 1.0/double(nvec*niter);
+        std::cout << argv[1] << ": " << nvar << " variables, " << nvec << " vectors, " << niter << " iterations\n"
+                  << "  per vector: " << std::chrono::duration<double,std::nano>(t1-t0).count()*norm << " ns\n"
+                  << "  batch:      " << std::chrono::duration<double,std::nano>(t2-t1).count()*norm << " ns\n"
+                  << "  max |difference|: " << maxdiff << std::endl;
+    }
+    catch (cet::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+    return 0;
+}
@@ -13,9 +13,12 @@
 #include "fhiclcpp/types/OptionalAtom.h"
 #include "fhiclcpp/types/Sequence.h"
 #include "fhiclcpp/types/OptionalSequence.h"
+#include "fhiclcpp/types/Tuple.h"
 #include "art/Framework/Services/Registry/ActivityRegistry.h"
 #include "art/Framework/Services/Registry/ServiceHandle.h"
 #include "art/Framework/Services/Registry/ServiceMacros.h"
+#include "art/Framework/Principal/SubRun.h"
+#include "tbb/task_group.h"
 #include "cetlib_except/exception.h"
 
 #include "Mu2eInterfaces/inc/ProditionsEntity.hh"
@@ -48,6 +51,13 @@ namespace mu2e {
       using Comment=fhicl::Comment;
       fhicl::Atom<int> verbose{Name("verbose"),
           Comment("verbosity 0 or 1"),0};
+      fhicl::Atom<unsigned> maxCacheEntries{Name("maxCacheEntries"),
+          Comment("maximum number of entities kept by each cache, least recently used are dropped first, 0 means no limit"),0};
+      fhicl::OptionalSequence<fhicl::Tuple<std::string,unsigned> > cacheEntries{
+          Name("cacheEntries"),
+          Comment("maximum number of entities for individual caches, as [name,maxEntries] pairs, overrides maxCacheEntries") };
+      fhicl::Atom<bool> prefetch{Name("prefetch"),
+          Comment("when the source reads a subrun, make the entities for it, and for the end of their interval of validity, in the background"),false};
       fhicl::Table<EventTimingConfig> eventTiming{
           Name("eventTiming"),
           Comment("Event timing configuration") };
@@ -94,6 +104,7 @@ namespace mu2e {
 
     ProditionsService(Parameters const& config,
                        art::ActivityRegistry& iRegistry);
+    ~ProditionsService();
 
     ProditionsCache::ptr getCache(std::string name) {
       if(_caches.count(name)==0) return ProditionsCache::ptr();
@@ -102,6 +113,8 @@ namespace mu2e {
 
 
     //void postBeginJob();
+    void postEndJob();
+    void postSourceSubRun(art::SubRun const& subrun);
 
   private:
 
@@ -111,6 +124,8 @@ namespace mu2e {
 
     Config _config;
     std::map<std::string,ProditionsCache::ptr> _caches;
+    // background construction of the entities for upcoming subruns
+    tbb::task_group _prefetchTasks;
   };
 
 }
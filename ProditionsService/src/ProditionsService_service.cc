@@ -63,6 +63,28 @@ namespace mu2e {
     auto bkc = std::make_shared<mu2e::SimBookkeeperCache>(_config.simbookkeeper());
     _caches[bkc->name()] = bkc;
 
+    // limit the number of entities kept in the caches
+    for( auto cc : _caches) {
+      cc.second->setMaxEntries(_config.maxCacheEntries());
+    }
+    std::vector<std::tuple<std::string,unsigned> > cacheEntries;
+    if( _config.cacheEntries(cacheEntries) ) {
+      for( auto const& ce : cacheEntries) {
+        auto cc = _caches.find(std::get<0>(ce));
+        if(cc==_caches.end()) {
+          throw cet::exception("PRODITIONS_NO_CACHE")
+            << "ProditionsService cacheEntries refers to unknown cache "
+            << std::get<0>(ce);
+        }
+        cc->second->setMaxEntries(std::get<1>(ce));
+      }
+    }
+
+    iRegistry.sPostEndJob.watch (this, &ProditionsService::postEndJob );
+    if( _config.prefetch() ) {
+      iRegistry.sPostSourceSubRun.watch (this, &ProditionsService::postSourceSubRun );
+    }
+
     if( _config.verbose()>0) {
       cout << "Proditions built caches:" << endl;
       for( auto cc : _caches) {
@@ -72,6 +94,51 @@ namespace mu2e {
 
   }
 
+  ProditionsService::~ProditionsService() {
+    _prefetchTasks.wait();
+  }
+
+  /********************************************************/
+  void ProditionsService::postSourceSubRun(art::SubRun const& subrun){
+    // the source has read a new subrun, its events will follow.
+    // Make the entities for it, and those valid just after the end
+    // of their interval of validity, which is where they change next,
+    // while the events are processed.
+    // The caches are independent, dependencies between them
+    // go through their own locks
+    art::EventID eid = art::EventID::firstEvent(subrun.id());
+    for( auto cc : _caches) {
+      ProditionsCache::ptr cache = cc.second;
+      _prefetchTasks.run([cache,eid,this]{
+          try {
+            DbIoV iov = cache->prefetch(eid);
+            uint32_t run, subrun;
+            if(iov.inInterval(eid.run(),eid.subRun()) && iov.next(run,subrun)) {
+              cache->prefetch(art::EventID::firstEvent(art::SubRunID(run,subrun)));
+            }
+          } catch (std::exception const& e) {
+            // the entity will be made when it is needed
+            if( _config.verbose()>1) {
+              cout << "ProditionsService::postSourceSubRun prefetch of "
+                   << cache->name() << " failed: " << e.what() << endl;
+            }
+          }
+        });
+    }
+  }
+
+  /********************************************************/
+  void ProditionsService::postEndJob(){
+    _prefetchTasks.wait();
+    // print the cache use, prefetch results and lock times
+    if( _config.verbose()>0 || _config.prefetch() ) {
+      cout << "ProditionsService::endJob" << endl;
+      for( auto cc : _caches) {
+        cc.second->printStats(cout);
+      }
+    }
+  }
+
 }
 
 DEFINE_ART_SERVICE(mu2e::ProditionsService);
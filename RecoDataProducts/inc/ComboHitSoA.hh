@@ -0,0 +1,33 @@
+#ifndef RecoDataProducts_ComboHitSoA_hh
+#define RecoDataProducts_ComboHitSoA_hh
+//
+// Columnar (structure-of-arrays) copy of the ComboHit fields read by the time clustering:
+// the times, z and number of straw hits.  Loops over all the hits of a collection that read
+// only these fields stream through contiguous arrays instead of the full ComboHit objects.
+// This is a transient copy, owned by the module that uses it and refilled for each event; it
+// is not kept with the collection, so it cannot go out of date if the collection changes.
+//
+#include <stdint.h>
+#include <vector>
+namespace mu2e {
+
+  class ComboHitCollection;
+
+  class ComboHitSoA {
+    public:
+      ComboHitSoA() {}
+      explicit ComboHitSoA(ComboHitCollection const& chcol) { fill(chcol); }
+      // replace the content with a copy of the given collection, reusing the allocated memory
+      void fill(ComboHitCollection const& chcol);
+      size_t size() const { return _time.size(); }
+      // per-hit values; see the corresponding ComboHit accessors
+      std::vector<float> const& time() const { return _time; }
+      std::vector<float> const& correctedTime() const { return _ctime; }
+      std::vector<float> const& z() const { return _z; }
+      std::vector<uint16_t> const& nStrawHits() const { return _nsh; }
+    private:
+      std::vector<float> _time, _ctime, _z;
+      std::vector<uint16_t> _nsh;
+  };
+}
+#endif
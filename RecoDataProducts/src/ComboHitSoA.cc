@@ -0,0 +1,20 @@
+//
+// Columnar copy of ComboHit fields
+//
+// Mu2e includes
+#include "RecoDataProducts/inc/ComboHitSoA.hh"
+#include "RecoDataProducts/inc/ComboHit.hh"
+namespace mu2e {
+
+  void ComboHitSoA::fill(ComboHitCollection const& chcol) {
+    size_t nch = chcol.size();
+    _time.clear(); _ctime.clear(); _z.clear(); _nsh.clear();
+    _time.reserve(nch); _ctime.reserve(nch); _z.reserve(nch); _nsh.reserve(nch);
+    for(auto const& ch : chcol) {
+      _time.push_back(ch.time());
+      _ctime.push_back(ch.correctedTime());
+      _z.push_back(ch.pos().z());
+      _nsh.push_back(ch.nStrawHits());
+    }
+  }
+}
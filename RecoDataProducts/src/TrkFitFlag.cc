@@ -42,6 +42,7 @@ namespace mu2e {
       bitnames[std::string("CalPatRecHelix")]              = bit_to_mask(CPRHelix);
       bitnames[std::string("Straight")]              = bit_to_mask(Straight);
       bitnames[std::string("KKLoopHelix")]              = bit_to_mask(KKLoopHelix);
+      bitnames[std::string("BudgetExceeded")]              = bit_to_mask(BudgetExceeded);
     }
     return bitnames;
   }
@@ -0,0 +1,93 @@
+//
+// Compare the time clustering loop over a ComboHitCollection (time of flight corrected
+// time and weight of every hit) with the same loop over its columnar view.
+//
+//   comboHitSoABenchmark [nhits] [iterations] [aos|soa|both]
+//
+// To compare the cache misses, run each loop alone under perf, e.g.
+//   perf stat -e cache-references,cache-misses,L1-dcache-load-misses comboHitSoABenchmark 100000 1000 aos
+//   perf stat -e cache-references,cache-misses,L1-dcache-load-misses comboHitSoABenchmark 100000 1000 soa
+//
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "RecoDataProducts/inc/ComboHit.hh"
+#include "RecoDataProducts/inc/ComboHitSoA.hh"
+
+namespace {
+  // same form as TrkTimeCalculator::comboHitTime
+  const double tofScale = 1.0/(0.6*299.792458);
+
+  double loopAoS(mu2e::ComboHitCollection const& chcol) {
+    double sum(0.0);
+    for (auto const& ch : chcol) {
+      float t = ch.correctedTime() - ch.pos().z()*tofScale;
+      sum += ch.nStrawHits()*t;
+    }
+    return sum;
+  }
+
+  double loopSoA(mu2e::ComboHitSoA const& soa) {
+    double sum(0.0);
+    const float* ct = soa.correctedTime().data();
+    const float* z = soa.z().data();
+    const uint16_t* nsh = soa.nStrawHits().data();
+    for (size_t i=0; i < soa.size(); ++i) {
+      float t = ct[i] - z[i]*tofScale;
+      sum += nsh[i]*t;
+    }
+    return sum;
+  }
+}
+
+int main(int argc, char** argv) {
+  const size_t nhits = argc > 1 ? std::strtoul(argv[1],nullptr,10) : 100000;
+  const size_t niter = argc > 2 ? std::strtoul(argv[2],nullptr,10) : 1000;
+  const std::string which = argc > 3 ? argv[3] : "both";
+
+  std::mt19937 engine(12345);
+  std::uniform_real_distribution<float> flat(0.0,1.0);
+  mu2e::ComboHitCollection chcol;
+  chcol.reserve(nhits);
+  for (size_t i=0; i < nhits; ++i) {
+    mu2e::ComboHit ch;
+    ch._pos = XYZVec(1400*flat(engine)-700,1400*flat(engine)-700,3000*flat(engine)-1500);
+    ch._wdir = XYZVec(1.0,0.0,0.0);
+    ch._time = 1700*flat(engine);
+    ch._dtime = 20*flat(engine);
+    ch._nsh = 1 + (i%3);
+    ch._ncombo = 1;
+    chcol.push_back(ch);
+  }
+
+  typedef std::chrono::steady_clock clock;
+  auto t0 = clock::now();
+  mu2e::ComboHitSoA soa(chcol);
+  auto t1 = clock::now();
+
+  double sumAoS(0.0), sumSoA(0.0);
+  double nsAoS(0.0), nsSoA(0.0);
+  if (which != "soa") {
+    auto ta = clock::now();
+    for (size_t it=0; it < niter; ++it) sumAoS += loopAoS(chcol);
+    nsAoS = std::chrono::duration<double,std::nano>(clock::now()-ta).count();
+  }
+  if (which != "aos") {
+    auto ta = clock::now();
+    for (size_t it=0; it < niter; ++it) sumSoA += loopSoA(soa);
+    nsSoA = std::chrono::duration<double,std::nano>(clock::now()-ta).count();
+  }
+
+  const double norm = 1.0/double(nhits*niter);
+  std::cout << nhits << " hits, " << niter << " iterations\n"
+            << "  bytes read per hit: AoS " << sizeof(mu2e::ComboHit) << " (whole ComboHit), SoA "
+            << 2*sizeof(float)+sizeof(uint16_t) << "\n"
+            << "  view construction: " << std::chrono::duration<double,std::nano>(t1-t0).count()/nhits << " ns/hit\n";
+  if (which != "soa") std::cout << "  AoS loop: " << nsAoS*norm << " ns/hit (checksum " << sumAoS << ")\n";
+  if (which != "aos") std::cout << "  SoA loop: " << nsSoA*norm << " ns/hit (checksum " << sumSoA << ")\n";
+  return 0;
+}
@@ -111,9 +111,25 @@ namespace mu2e {
 
     virtual ~StrawElectronics() {}
     
+    // the part of the linear response fixed by a charge and its wire distance: the
+    // response tables of the 2 bracketing wire distance points, their weight, and the
+    // reflection delay and scale.  Computing this once per cluster lets a waveform be
+    // sampled at many times with only the table lookups.
+    struct ClusterResponse {
+      double const* _r0; // response table of the nearer wire distance point
+      double const* _r1; // response table of the next wire distance point
+      double _distFrac; // weight of _r0
+      double _reflectionTime;
+      double _reflectionScale;
+      double _charge;
+      double _dVdI;
+    };
+    ClusterResponse clusterResponse(Straw const& straw, Path ipath, double charge, double distance, bool forsaturation=false) const;
     // linear response to a charge pulse.  This does NOT include saturation effects,
     // since those are cumulative and cannot be computed for individual charges
     double linearResponse(Straw const& straw, Path ipath, double time, double charge, double distance, bool forsaturation=false) const; // mvolts per pCoulomb
+    // same, for a precomputed cluster response.  time is relative to the cluster
+    double linearResponse(ClusterResponse const& cresp, double time) const;
     double adcImpulseResponse(StrawId sid, double time, double charge) const;
     // Given a (linear) total voltage, compute the saturated voltage
     double saturatedResponse(double lineearresponse) const;
@@ -286,6 +302,23 @@ namespace mu2e {
     double _timeFromProtonsToDRMarker;
 
   };
+
+  // inline, as waveform sampling calls this for every cluster at every time
+  inline double StrawElectronics::linearResponse(ClusterResponse const& cresp, double time) const {
+    int index = time*_sampleRate + _responseBins/2.;
+    if ( index >= _responseBins)
+      index = _responseBins-1;
+    if (index < 0)
+      index = 0;
+    int index_refl = (time - cresp._reflectionTime)*_sampleRate + _responseBins/2.;
+    if (index_refl >= _responseBins)
+      index_refl = _responseBins-1;
+    if (index_refl < 0)
+      index_refl = 0;
+    double p0 = cresp._r0[index] + cresp._r0[index_refl]*cresp._reflectionScale;
+    double p1 = cresp._r1[index] + cresp._r1[index_refl]*cresp._reflectionScale;
+    return cresp._charge * ( p0 * cresp._distFrac + p1 * (1 - cresp._distFrac)) * cresp._dVdI;
+  }
   
 }
 
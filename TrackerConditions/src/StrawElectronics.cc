@@ -67,6 +67,38 @@ namespace mu2e {
       response[i] *= 1 / gain_160;
   }
 
+  StrawElectronics::ClusterResponse StrawElectronics::clusterResponse(Straw const& straw, Path ipath, double charge, double distance, bool forsaturation) const {
+    ClusterResponse cresp;
+    double straw_length = 2*straw.halfLength();
+    cresp._reflectionTime = _reflectionTimeShift + (2*straw_length-2*distance)/_reflectionVelocity;
+    cresp._reflectionScale = _reflectionFrac * exp(-(2*straw_length-2*distance)/_reflectionALength);
+
+    int  distIndex = 0;
+    for (size_t i=1;i<_wPoints.size()-1;i++){
+      if (distance < _wPoints[i]._distance)
+        break;
+      distIndex = i;
+    }
+    cresp._distFrac = 1 - (distance - _wPoints[distIndex]._distance)/(_wPoints[distIndex+1]._distance - _wPoints[distIndex]._distance);
+    if (ipath == thresh){
+      if (forsaturation){
+        cresp._r0 = _wPoints[distIndex]._preampToAdc1Response.data();
+        cresp._r1 = _wPoints[distIndex + 1]._preampToAdc1Response.data();
+      }else{
+        cresp._r0 = _wPoints[distIndex]._preampResponse.data();
+        cresp._r1 = _wPoints[distIndex + 1]._preampResponse.data();
+      }
+    }else{
+      cresp._r0 = _wPoints[distIndex]._adcResponse.data();
+      cresp._r1 = _wPoints[distIndex + 1]._adcResponse.data();
+    }
+    cresp._charge = charge;
+    cresp._dVdI = _dVdI[ipath][straw.id().getStraw()];
+    return cresp;
+  }
+
+  // the full evaluation at one time.  This is kept independent of clusterResponse so that
+  // it can serve as the reference for the cached cluster responses
   double StrawElectronics::linearResponse(Straw const& straw, Path ipath, double time, double charge, double distance, bool forsaturation) const {
     int index = time*_sampleRate + _responseBins/2.;
     if ( index >= _responseBins)
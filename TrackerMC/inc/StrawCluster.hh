@@ -5,13 +5,16 @@
 // It does not include time folding
 // or electronics effects.  It does include charge collection effects,
 // such as avalanche fluctuations, trapping, gas quenching, and propagation
-// effects such as drift time, wire propagation time delay, and dispersion
+// effects such as drift time, wire propagation time delay, and dispersion.
+// Collections of clusters can be written out as a pre-digitized
+// background frame, to be overlaid on other events before digitization.
 //
 // Original author David Brown, LBNL
 //
 
 // C++ includes
 #include <iostream>
+#include <vector>
 
 // Mu2e includes
 #include "DataProducts/inc/StrawId.hh"
@@ -57,6 +60,8 @@ namespace mu2e {
       float   propTime() const { return _proptime; }
       art::Ptr<StrawGasStep> const& strawGasStep() const { return _sgsptr; }
       float cluTime() const { return _ctime; }
+      // used when the StrawGasSteps are mixed into another event
+      void setStrawGasStep(art::Ptr<StrawGasStep> const& sgs) { _sgsptr = sgs; }
       // Print contents of the object.
       void print( std::ostream& ost = std::cout, bool doEndl = true ) const;
     private:
@@ -72,6 +77,7 @@ namespace mu2e {
       art::Ptr<StrawGasStep> _sgsptr; 
       float _ctime; 
     };
+    typedef std::vector<StrawCluster> StrawClusterCollection;
   } // namespace TrackerMC
 } // namespace mu2e
 #endif
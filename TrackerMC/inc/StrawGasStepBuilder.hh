@@ -0,0 +1,70 @@
+#ifndef TrackerMC_StrawGasStepBuilder_hh
+#define TrackerMC_StrawGasStepBuilder_hh
+//
+//  Build StrawGasSteps from the tracker StepPointMCs: steps are grouped by straw and SimParticle,
+//  short delta-rays are optionally combined with their parent, and each group becomes one StrawGasStep.
+//  This is the algorithm of MakeStrawGasSteps; it is also run inside Mu2eG4 when the StrawGasSteps
+//  are built directly from the sensitive detector.  The SimParticles are reached through a lookup,
+//  as the Ptrs cannot be dereferenced before the SimParticleCollection is in the event.
+//
+//  Original author: David Brown (LBNL), Krzysztof Genser 19 Aug. 2019
+//
+#include "MCDataProducts/inc/StepPointMC.hh"
+#include "MCDataProducts/inc/StepPointMCCollection.hh"
+#include "MCDataProducts/inc/SimParticle.hh"
+#include "MCDataProducts/inc/StrawGasStep.hh"
+#include "DataProducts/inc/StrawId.hh"
+#include "CLHEP/Vector/ThreeVector.h"
+#include "cetlib/map_vector.h"
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace HepPDT { class ParticleData; }
+
+namespace mu2e {
+  class Tracker;
+  class Straw;
+  class TrackerStatus;
+  class BFieldManager;
+  class DetectorSystem;
+
+  class StrawGasStepBuilder {
+    public:
+      typedef std::pair<StrawId,cet::map_vector_key> SSPair; // key for pair of straw, SimParticle
+      typedef std::vector<StepPointMC const*> StepPtrs;
+      typedef std::map< SSPair , StepPtrs > SPSMap; // steps by straw, SimParticle
+      // the SimParticle a Ptr refers to, or 0 if it is not available
+      typedef std::function<SimParticle const*(art::Ptr<SimParticle> const&)> SimLookup;
+
+      StrawGasStepBuilder(float maxDeltaLength, float minionBG, float minionKE,
+	  float curlRatio, float lineRatio, unsigned startSize, int debug=0);
+      // cache the field and straw radius; call at the start of each run
+      void beginRun(Tracker const& tracker, BFieldManager const& bfmgr, DetectorSystem const& det);
+      // sort the steps by straw and SimParticle, skipping straws without signal (if the status is given)
+      // and steps in the dead region at the end of the wires
+      void fillMap(Tracker const& tracker, TrackerStatus const* trackerStatus,
+	  StepPointMCCollection const& steps, SPSMap& spsmap) const;
+      // combine delta-rays that never leave the straw with their parent particle
+      void compressDeltas(SPSMap& spsmap, SimLookup const& sims) const;
+      void fillStep(StepPtrs const& spmcptrs, Straw const& straw,
+	  HepPDT::ParticleData const* pdata, cet::map_vector_key pid, StrawGasStep& sgs) const;
+      // all of the above for one collection, appending to the output
+      void makeSteps(Tracker const& tracker, TrackerStatus const* trackerStatus, StepPointMCCollection const& steps,
+	  bool combineDeltas, SimLookup const& sims, StrawGasStepCollection& sgsc) const;
+    private:
+      void setStepType(StepPointMC const& spmc, HepPDT::ParticleData const* pdata, StrawGasStep::StepType& stype) const;
+      float _maxDeltaLen;
+      float _minionBG, _minionKE;
+      float _curlfac, _linefac;
+      unsigned _ssize;
+      int _debug;
+      // run-dependent: the BField direction at the tracker center and derived momenta
+      CLHEP::Hep3Vector _bdir;
+      float _bnom; // BField in units of (MeV/c)/mm
+      double _rstraw; // straw radius cache
+      float _curlmom, _linemom;
+  };
+}
+#endif
@@ -45,12 +45,18 @@ namespace mu2e {
 	// disallow copy and assignment
 	StrawWaveform() = delete; // don't allow default constructor, references can't be assigned empty
 	StrawWaveform(StrawWaveform const& other);
+	// copy that samples by evaluating the full electronics response of every cluster at every
+	// time, as was done before the cluster responses were cached.  This is the reference used
+	// to validate the cached sampling, and is much slower
+	StrawWaveform(StrawWaveform const& other, bool reference);
 	StrawWaveform & operator=(StrawWaveform const& other) = delete;
 	// find the next point the waveform crosses threhold.  Waveform crossing
 	// is both input (determines starting point) and output
       bool crossesThreshold(StrawElectronics const& strawele, double threshold,WFX& wfx) const;
 	// sample the waveform at a given time, no saturation included.  Return value is in units of volts
 	double sampleWaveform(StrawElectronics const& strawele,StrawElectronics::Path ipath,double time) const;
+	// same, at a series of times, looping over the clusters outside the times
+	void sampleWaveform(StrawElectronics const& strawele,StrawElectronics::Path ipath,TrkTypes::ADCTimes const& times,TrkTypes::ADCVoltages& volts) const;
 	// sample the waveform at a series of points allowing saturation to occur after preamp stage
         // FIXME no cross talk yet
 	void sampleADCWaveform(StrawElectronics const& strawele,TrkTypes::ADCTimes const& times,TrkTypes::ADCVoltages& volts) const;
@@ -60,12 +66,24 @@ namespace mu2e {
 	XTalk const& xtalk() const { return _xtalk; }
 	StrawEnd const& strawEnd() const { return _cseq.strawEnd(); }
         Straw const& straw() const { return _straw;}
+	bool reference() const { return _reference; }
       private:
 	// clust sequence used in this waveform
 	StrawClusterSequence const& _cseq;
 	XTalk _xtalk; // X-talk applied to all voltages
         Straw const& _straw;
+	bool _reference; // sample with the full response of each cluster
+	// cluster times and responses, filled on first use for each path.  The extra path
+	// is the thresh path input to saturation.  A waveform must not be shared between threads
+	mutable StrawElectronics const* _strawele;
+	mutable std::vector<double> _ctime; // cluster time
+	mutable std::vector<double> _tstart; // time the cluster starts contributing
+	mutable std::array<std::vector<StrawElectronics::ClusterResponse>,StrawElectronics::npaths+1> _cresp;
 	// helper functions
+	std::vector<StrawElectronics::ClusterResponse> const& clusterResponses(StrawElectronics const& strawele, unsigned ipath) const;
+	double xtalkResponse(double linresp) const;
+	double sampleWaveformReference(StrawElectronics const& strawele,StrawElectronics::Path ipath,double time) const;
+	void sampleADCWaveformReference(StrawElectronics const& strawele,TrkTypes::ADCTimes const& times,TrkTypes::ADCVoltages& volts) const;
 	void returnCrossing(StrawElectronics const& strawele, double threshold, WFX& wfx) const;
 	bool roughCrossing(StrawElectronics const& strawele, double threshold, WFX& wfx) const;
 	bool fineCrossing(StrawElectronics const& strawele, double threshold, double vmax, WFX& wfx) const;
@@ -25,6 +25,7 @@
 #include "BTrk/BField/BField.hh"
 #include "Mu2eUtilities/inc/TwoLinePCA.hh"
 #include "Mu2eUtilities/inc/SimParticleTimeOffset.hh"
+#include "TrackerMC/inc/StrawGasStepBuilder.hh"
 
 #include "MCDataProducts/inc/StepPointMCCollection.hh"
 #include "MCDataProducts/inc/MCRelationship.hh"
@@ -87,36 +88,24 @@ namespace mu2e {
       void beginJob() override;
       void beginRun(art::Run& run) override;
       void produce(art::Event& e) override;
-      typedef pair<StrawId,cet::map_vector_key> SSPair; // key for pair of straw, SimParticle
       typedef art::Ptr<StepPointMC> SPMCP;
-      typedef vector<SPMCP> SPMCPV;
-      typedef map< SSPair , SPMCPV > SPSMap; // steps by straw, SimParticle
+      typedef StrawGasStepBuilder::StepPtrs SPMCPV;
+      typedef StrawGasStepBuilder::SPSMap SPSMap; // steps by straw, SimParticle
       typedef art::Handle<StepPointMCCollection> SPMCCH;
       typedef vector< SPMCCH > SPMCCHV;
-      void fillMap(Tracker const& tracker,TrackerStatus const& trackerStatus, 
-	  SPMCCH const& spmcch, SPSMap& spsmap);
-      void compressDeltas(SPSMap& spsmap);
-      void setStepType(SPMCP const& spmcptr, ParticleData const* pdata, StrawGasStep::StepType& stype);
-      void fillStep(SPMCPV const& spmcptrs, Straw const& straw,
-	  ParticleData const* pdata, cet::map_vector_key pid, StrawGasStep& sgs);
       void fillStepDiag(Straw const& straw, StrawGasStep const& sgs, SPMCPV const& spmcptrs);
       int _debug, _diag;
       bool _combineDeltas, _allAssns;
-      float _maxDeltaLen, _radtol, _parrot, _curlrot;
-      float _minionBG, _minionKE;
-      float _curlfac, _linefac;
-      float _curlmom, _linemom;
-      unsigned _csize, _ssize;
+      float _radtol, _parrot, _curlrot;
+      unsigned _csize;
       string _keepDeltas;
       // StepPointMC selector
       // This selector will select only data products with the given instance name.
       // optionally exclude modules: this is a fix
       art::Selector _selector;
       bool _firstEvent;
-      // cache the BField direction at the tracker center
-      Hep3Vector _bdir;
-      float _bnom; // BField in units of (MeV/c)/mm
-      double _rstraw; // straw radius cache
+      // grouping of the steps and the StrawGasStep content
+      StrawGasStepBuilder _builder;
       ProditionsHandle<TrackerStatus> _trackerStatus_h; // tracker element status
       // diagnostic histograms
       TH1F *_hendrad, *_hphi;
@@ -132,20 +121,16 @@ namespace mu2e {
     _diag(config().diag()),
     _combineDeltas(config().combineDeltas()),
     _allAssns(config().allStepsAssns()),
-    _maxDeltaLen(config().maxDeltaLength()),
     _radtol(config().radiusTolerance()),
     _parrot(config().parabolicRotation()),
     _curlrot(config().curlRotation()),
-    _minionBG(config().minionBG()),
-    _minionKE(config().minionKE()),
-    _curlfac(config().curlRatio()),
-    _linefac(config().lineRatio()),
     _csize(config().csize()),
-    _ssize(config().startSize()),
     _keepDeltas(config().keepDeltas()),
     _selector{art::ProductInstanceNameSelector(config().trackerSteps()) &&
       !art::ModuleLabelSelector(config().stepsToSkip()) },
-    _firstEvent(false)
+    _firstEvent(false),
+    _builder(config().maxDeltaLength(), config().minionBG(), config().minionKE(),
+	config().curlRatio(), config().lineRatio(), config().startSize(), config().debug())
   {
     consumesMany<StepPointMCCollection>();
     produces <StrawGasStepCollection>();
@@ -184,20 +169,7 @@ namespace mu2e {
   }
 
   void MakeStrawGasSteps::beginRun( art::Run& run ){
-    // get field at the center of the tracker
-    GeomHandle<BFieldManager> bfmgr;
-    GeomHandle<DetectorSystem> det;
-    auto vpoint_mu2e = det->toMu2e(Hep3Vector(0.0,0.0,0.0));
-    auto bnom = bfmgr->getBField(vpoint_mu2e);
-    _bdir = bnom.unit();
-    // B in units of mm/MeV/c
-    _bnom = bnom.mag()*BField::mmTeslaToMeVc;
-    // pre-compute momentum thresholds for straight, arc, and curler
-    const Tracker& tracker = *GeomHandle<Tracker>();
-    _rstraw = tracker.strawProperties()._strawInnerRadius;
-    float pstraw = _bnom*_rstraw;// transverse momentum with same radius as straw
-    _curlmom = _curlfac*pstraw;
-    _linemom = _linefac*pstraw;
+    _builder.beginRun(*GeomHandle<Tracker>(),*GeomHandle<BFieldManager>(),*GeomHandle<DetectorSystem>());
   }
 
   void MakeStrawGasSteps::produce(art::Event& event) {
@@ -233,6 +205,8 @@ namespace mu2e {
     }
     // diagnostic counters
     unsigned nspmcs(0), nspss(0);
+    // the SimParticles are in the event
+    StrawGasStepBuilder::SimLookup sims = [](art::Ptr<SimParticle> const& simptr) { return simptr.get(); };
     // Loop over StepPointMC collections
     for( auto const& handle : stepsHandles) {
       StepPointMCCollection const& steps(*handle);
@@ -247,9 +221,9 @@ namespace mu2e {
       }
       // Loop over the StepPointMCs in this collection and sort them by straw and SimParticle
       SPSMap spsmap; // map of step points by straw,sim particle
-      fillMap(tracker,trackerStatus,handle, spsmap);
+      _builder.fillMap(tracker,&trackerStatus,steps, spsmap);
       // optionally combine delta-rays that never leave the straw with their parent particle
-      if(dcomp)compressDeltas(spsmap);
+      if(dcomp)_builder.compressDeltas(spsmap,sims);
       nspss += spsmap.size();
       // convert the SimParticle/straw pair steps into StrawGas objects and fill the collection.  
       for(auto ispsmap = spsmap.begin(); ispsmap != spsmap.end(); ispsmap++){
@@ -261,13 +235,13 @@ namespace mu2e {
 	ParticleData const* pdata(0);
 	if(pref.isValid())pdata = &pref.ref();
 	StrawGasStep sgs;
-	fillStep(spmcptrs,straw,pdata,pid,sgs);
+	_builder.fillStep(spmcptrs,straw,pdata,pid,sgs);
 	sgsc->push_back(sgs);
 	auto sgsptr = art::Ptr<StrawGasStep>(StrawGasStepCollectionPID,sgsc->size()-1,StrawGasStepCollectionGetter);
 	// optionall add Assns for all StepPoints, including delta-rays
 	if(_allAssns){
 	  for(auto const& spmcptr : spmcptrs)
-	    sgsa->addSingle(sgsptr,spmcptr);
+	    sgsa->addSingle(sgsptr,SPMCP(handle,spmcptr - &steps.front()));
 	}
 	if(_diag > 0)fillStepDiag(straw,sgs,spmcptrs);
 	if(_debug > 1){
@@ -292,174 +266,22 @@ namespace mu2e {
     if(_allAssns) event.put(move(sgsa));
   } // end of produce
 
-  void MakeStrawGasSteps::fillStep(SPMCPV const& spmcptrs, Straw const& straw,
-      ParticleData const* pdata, cet::map_vector_key pid, StrawGasStep& sgs){
-    // variables we accumulate for all the StepPoints in this pair
-    double eion(0.0), pathlen(0.0);
-    if(_diag>1){
+  void MakeStrawGasSteps::fillStepDiag(Straw const& straw, StrawGasStep const& sgs, SPMCPV const& spmcptrs) {
+    _erad = sqrt((Geom::Hep3Vec(sgs.endPosition())-straw.getMidPoint()).perpPart(straw.getDirection()).mag2());
+    _hendrad->Fill(_erad);
+    _hphi->Fill(_brot);
+    if(_diag > 1){
       _npri=_nsec=0;
       _epri=_esec=0.0;
-    }
-    // keep track of the first and last PRIMARY step
-    SPMCP  first;
-    SPMCP  last;
-    // loop over all  the StepPoints for this SimParticle
-    for(auto const& spmcptr : spmcptrs){
-      bool primary=spmcptr->simParticle()->id() == pid;
-      // update eion for all contributions
-      eion += spmcptr->ionizingEdep();
-      // treat primary and secondary (delta-ray) energy differently
-      if(primary) {
-	// primary: update path length, and entry/exit
-	pathlen += spmcptr->stepLength();
-	if(first.isNull() || spmcptr->time() < first->time()) first = spmcptr;
-	if(last.isNull() || spmcptr->time() > last->time()) last = spmcptr;
-      }
-      // diagnostics
-      if(_diag >1){
-	if(primary){
+      for(auto const& spmcptr : spmcptrs){
+	if(spmcptr->simParticle() == sgs.simParticle()){
 	  _npri++;
 	  _epri += spmcptr->ionizingEdep();
 	} else {
 	  _nsec++;
 	  _esec += spmcptr->ionizingEdep();
 	}
-      }	    
-    }
-    if(first.isNull() || last.isNull())
-      throw cet::exception("SIM")<<"mu2e::MakeStrawGasSteps: No first or last step" << endl;
-    // Define the position at entrance and exit; note the StepPointMC position is at the start of the step, so we have to extend the last
-    XYZVec start = Geom::toXYZVec(first->position());
-    // determine the type of step
-    StrawGasStep::StepType stype;
-    setStepType(first,pdata,stype);
-    // compute the end position and step type
-    XYZVec end = Geom::toXYZVec(last->postPosition());
-    XYZVec momvec = Geom::toXYZVec(0.5*(first->momentum() + last->momentum()));	// average first and last momentum
-    float  mom = sqrt(momvec.mag2()); 
-    // determine the width from the sigitta or curl radius
-    auto pdir = first->momentum().unit();
-    auto pperp = pdir.perp(_bdir);
-    float bendrms = 0.5*std::min(_rstraw,mom*pperp/_bnom); // bend radius spread.  0.5 factor givs RMS of a circle
-    // only sigitta perp to the wire counts
-    float sint = (_bdir.cross(pdir).cross(straw.getDirection())).mag();
-    static const float prms(1.0/(12.0*sqrt(5.0))); // RMS for a parabola.  This includes a factor 1/8 for the sagitta calculation too
-    float sagrms = prms*sint*pathlen*pathlen*_bnom*pperp/mom;
-    double width = std::min(sagrms,bendrms); // choose the smaller: different approximations work for different momenta/directions
-  // create the gas step
-    sgs = StrawGasStep( first->strawId(), stype,
-	(float)eion,(float)pathlen, (float)width, first->time(),
-	start, end, momvec, first->simParticle());
-  }
-
-  void MakeStrawGasSteps::fillMap(Tracker const& tracker,TrackerStatus const& trackerStatus, 
-  SPMCCH const& spmcch, SPSMap& spsmap) {
-    StepPointMCCollection const& steps(*spmcch);
-    for (size_t ispmc =0; ispmc<steps.size();++ispmc) {
-      const auto& step = steps[ispmc];
-      StrawId const & sid = step.strawId();
-      // Skip straws that can't give signals,
-      if (!trackerStatus.noSignal(sid)) {
-	Straw const& straw = tracker.getStraw(sid);
-	double wpos = fabs((step.position()-straw.getMidPoint()).dot(straw.getDirection()));
-	//skip steps that occur in the deadened region near the end of each wire
-	if( wpos <  straw.halfLength()){
-	  cet::map_vector_key tid = step.simParticle().get()->id();
-	  // create key
-	  SSPair stpair(sid,tid);
-	  // create ptr to this step
-	  SPMCP  spmcptr(spmcch,ispmc);
-	  vector<SPMCP > spmcptrv;
-	  spmcptrv.reserve(_ssize);
-	  spmcptrv.push_back(spmcptr);
-	  // check if this key exists and add it if not
-	  auto ssp = spsmap.emplace(stpair,spmcptrv);
-	  // if the key already exists, just add this Ptr to the vector
-	  if(!ssp.second)ssp.first->second.push_back(spmcptr);
-	}
-      } else if ( _debug>1 ) {
-	std::cout << "No Signal, StrawId " << sid << endl;
-      }
-    }
-  }
-
-  void MakeStrawGasSteps::compressDeltas(SPSMap& spsmap) {
-    // first, make some helper maps
-    typedef map< cet::map_vector_key, StrawId > SMap; // map from key to Straw, to test for uniqueness
-    typedef map< cet::map_vector_key, cet::map_vector_key> DMap; // map from delta ray to parent
-    SMap smap;
-    DMap dmap;
-    for(auto isps = spsmap.begin(); isps != spsmap.end(); isps++ ) {
-      auto sid = isps->first.first;
-      auto tid = isps->first.second;
-      // map key to straw
-      auto sp = smap.emplace(tid,sid);
-      if(!sp.second && sp.first->second != sid && sp.first->second.valid())sp.first->second = StrawId(); // Particle already seen in another straw: make invalid to avoid compressing it
-    }
-
-    // loop over particle-straw pairs looking for delta rays
-    auto isps =spsmap.begin();
-    while(isps != spsmap.end()){
-      bool isdelta(false);
-      auto& dsteps = isps->second;
-      auto dkey =isps->first.second;
-      // see if this particle is a delta-ray and if it's step is short
-      auto pcode = dsteps.front()->simParticle()->creationCode();
-      if(pcode == ProcessCode::eIoni || pcode == ProcessCode::hIoni){
-	// make sure this particle doesnt have a step in any other straw
-	auto ifnd = smap.find(dkey);
-	if(ifnd == smap.end())
-	  throw cet::exception("SIM")<<"mu2e::MakeStrawGasSteps: No SimParticle found for delta key " << dkey << endl;
-	else if(ifnd->second.valid()){ // only compress delta rays without hits in any other straw
-	  // add the lengths of all the steps in this straw
-	  float len(0.0);
-	  for(auto const& istep : dsteps)
-	    len += istep->stepLength();
-	  if(len < _maxDeltaLen){
-	    // short delta ray. flag for combination
-	    isdelta = true;
-	  }
-	}
       }
-// if this is a delta, map it back to the primary
-      if(isdelta){
-	auto strawid = isps->first.first;
-      // find its parent
-	auto pkey = dsteps.front()->simParticle()->parentId();
-	// map it so that potential daughters can map back through this particle even after compression
-	dmap[dkey] = pkey;
-	// find the parent. This must be recursive, as delta rays can come from delta rays (from delta rays...)
-	auto jfnd = dmap.find(pkey);
-	while(jfnd != dmap.end()){
-	  pkey = jfnd->second;
-	  jfnd = dmap.find(pkey);
-	}
-	// now, find the parent back in the original map
-	auto ifnd = spsmap.find(make_pair(strawid,pkey));
-	if(ifnd != spsmap.end()){
-	  if(_debug > 1)cout << "mu2e::MakeStrawGasSteps: SimParticle found for delta parent key " << pkey << " straw " << strawid << endl;
-      // move the contents to the primary
-	  auto& psteps = ifnd->second;
-	  psteps.insert(psteps.end(),dsteps.begin(),dsteps.end());
-	  // erase the delta ray and advance the iterator
-	  isps = spsmap.erase(isps);
-	} else {
-	// there are a very few delta rays whose parents die in the straw walls that cause StepPoints, so this is not an error.  These stay
-	// as uncompressed particles.
-	  if(_debug > 1)cout << "mu2e::MakeStrawGasSteps: No SimParticle found for delta parent key " << pkey << " straw " << strawid << endl;
-	  isps++;
-	}
-      } else
-      // move to the next straw/particle pair
-	isps++;
-    }
-  }
-
-  void MakeStrawGasSteps::fillStepDiag(Straw const& straw, StrawGasStep const& sgs, SPMCPV const& spmcptrs) {
-    _erad = sqrt((Geom::Hep3Vec(sgs.endPosition())-straw.getMidPoint()).perpPart(straw.getDirection()).mag2());
-    _hendrad->Fill(_erad);
-    _hphi->Fill(_brot);
-    if(_diag > 1){
       _sshape = sgs.stepType().shape();
       _sion = sgs.stepType().ionization();
       _prilen = sgs.stepLength();
@@ -489,32 +311,6 @@ namespace mu2e {
     }
   }
 
-  void MakeStrawGasSteps::setStepType(SPMCP const& spmcptr, ParticleData const* pdata, StrawGasStep::StepType& stype) {
-  // now determine ioniztion and shape
-    int itype, shape;
-    if(pdata->charge() == 0.0){
-      itype = StrawGasStep::StepType::neutral;
-      shape = StrawGasStep::StepType::point;
-    } else {
-      double mom = spmcptr->momentum().mag();
-      if(mom < _curlmom)
-	shape = StrawGasStep::StepType::curl;
-      else if(mom < _linemom)
-	shape = StrawGasStep::StepType::arc;
-      else
-	shape = StrawGasStep::StepType::line;
-      double mass = pdata->mass();
-      double bg = mom/mass; // betagamma
-      double ke = sqrt(mom*mom + mass*mass)-mass; // kinetic energy
-      if(bg > _minionBG && ke > _minionKE)
-	itype =StrawGasStep::StepType::minion;
-      else
-     	itype =StrawGasStep::StepType::highion;
-    }
-    stype = StrawGasStep::StepType( (StrawGasStep::StepType::Shape)shape,
-	(StrawGasStep::StepType::Ionization)itype );
-  }
-
 }
 
 DEFINE_ART_MODULE(mu2e::MakeStrawGasSteps)
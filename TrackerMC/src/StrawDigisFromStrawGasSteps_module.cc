@@ -49,6 +49,7 @@
 #include "CLHEP/Random/RandFlat.h"
 #include "CLHEP/Random/RandExponential.h"
 #include "CLHEP/Random/RandPoisson.h"
+#include "CLHEP/Random/JamesRandom.h"
 #include "CLHEP/Vector/LorentzVector.h"
 // root
 #include "TMath.h"
@@ -57,12 +58,17 @@
 #include "TGraph.h"
 #include "TMarker.h"
 #include "TTree.h"
+// TBB
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
 // C++
+#include <cstdint>
 #include <map>
 #include <algorithm>
 #include <array>
 #include <iostream>
 #include <limits>
+#include <chrono>
 using namespace std;
 using CLHEP::Hep3Vector;
 namespace mu2e {
@@ -81,6 +87,15 @@ namespace mu2e {
       float _wdist; // propagation distance from the point of collection to the end
     };
 
+    struct StrawRandom { // random number distributions used to digitize straws
+      explicit StrawRandom(CLHEP::HepRandomEngine& engine) :
+	randgauss(engine), randflat(engine), randexp(engine), randP(engine) {}
+      CLHEP::RandGaussQ randgauss;
+      CLHEP::RandFlat randflat;
+      CLHEP::RandExponential randexp;
+      CLHEP::RandPoisson randP;
+    };
+
     class StrawDigisFromStrawGasSteps : public art::EDProducer {
       public:
 	using Name=fhicl::Name;
@@ -115,6 +130,10 @@ namespace mu2e {
 	  fhicl::Atom<string> spinstance { Name("StrawGasStepInstance"), Comment("StrawGasStep Instance name"),""};
 	  fhicl::Atom<string> spmodule { Name("StrawGasStepModule"), Comment("StrawGasStep Module name"),""};
 	  fhicl::Sequence<art::InputTag> SPTO { Name("TimeOffsets"), Comment("Sim Particle Time Offset Maps")};
+	  fhicl::Atom<bool> writeClusters{ Name("WriteClusters"), Comment("Write the clusters made from StrawGasSteps, to be used as a pre-digitized background frame"),false };
+	  fhicl::Sequence<art::InputTag> clusterOverlays { Name("StrawClusterOverlays"), Comment("Pre-digitized StrawCluster frames to overlay before digitization"), std::vector<art::InputTag>{} };
+	  fhicl::Atom<bool> parallel{ Name("ParallelStraws"), Comment("Digitize the straws in parallel tasks, each straw with its own engine seeded from the module seed, the event and the straw.  The result does not depend on the number of threads but differs from the serial mode.  Requires diagLevel 0"),false };
+	  fhicl::Atom<bool> validate{ Name("ValidateWaveforms"), Comment("Repeat the threshold crossing search, TOT and ADC sampling of every digi with the original full electronics response of each cluster, throw on any difference, and print the time taken by both at the end of the job.  Not compatible with ParallelStraws"),false };
 
 	};
 
@@ -134,6 +153,7 @@ namespace mu2e {
       private:
 
 	void beginJob() override;
+	void endJob() override;
 	void beginRun(art::Run& run) override;
 	void produce(art::Event& e) override;
 
@@ -160,13 +180,17 @@ namespace mu2e {
 	uint16_t _allStraw; 
 	std::vector<uint16_t> _allPlanes;
 	unsigned _maxnclu;
+	bool _writeClusters;
+	std::vector<art::InputTag> _clusterOverlays;
+	bool _parallel;
+	bool _validate;
+	double _sampleTime, _refTime; // time spent sampling waveforms and in the reference sampling when validating
+	unsigned _nxings; // number of threshold crossing searches validated
 	StrawElectronics::Path _diagpath; 
 	// Random number distributions
 	art::RandomNumberGenerator::base_engine_t& _engine;
-	CLHEP::RandGaussQ _randgauss;
-	CLHEP::RandFlat _randflat;
-	CLHEP::RandExponential _randexp;
-	CLHEP::RandPoisson _randP;
+	StrawRandom _rand;
+	uint64_t _strawSeedBase; // for the per-straw engines of the parallel mode
 	// A category for the error logger.
 	const string _messageCategory;
 	// Give some informationation messages only on the first event.
@@ -220,43 +244,58 @@ namespace mu2e {
 	void fillClusterMap(StrawPhysics const& strawphys,
 	    StrawElectronics const& strawele,Tracker const& tracker,
 	    art::Event const& event, StrawClusterMap & hmap);
+	bool inDigitizationWindow(StrawElectronics const& strawele, StrawId const& sid, double ctime) const;
 	void addStep(StrawPhysics const& strawphys,
 	    StrawElectronics const& strawele,
 	    Straw const& straw,
-	    SGSPtr const& sgsptr,
+	    SGSPtr const& sgsptr, double ctime,
+	    StrawRandom& rand, vector<IonCluster>& clusters,
 	    StrawClusterSequencePair& shsp);
 	void divideStep(StrawPhysics const& strawphys,
 	    StrawElectronics const& strawele,
 	    Straw const& straw,
 	    StrawGasStep const& step, 
+	    StrawRandom& rand,
 	    vector<IonCluster>& clusters);
 	void driftCluster(StrawPhysics const& strawphys, Straw const& straw,
-	    IonCluster const& cluster, WireCharge& wireq);
+	    IonCluster const& cluster, StrawRandom& rand, WireCharge& wireq);
 	void propagateCharge(StrawPhysics const& strawphys, Straw const& straw,
 	    WireCharge const& wireq, StrawEnd end, WireEndCharge& weq);
 	double microbunchTime(StrawElectronics const& strawele, double globaltime) const;
 	void addGhosts(StrawElectronics const& strawele, StrawCluster const& clust,StrawClusterSequence& shs);
 	void addNoise(StrawClusterMap& hmap);
-	void findThresholdCrossings(StrawElectronics const& strawele, SWFP const& swfp, WFXPList& xings);
+	void findThresholdCrossings(StrawElectronics const& strawele, SWFP const& swfp, StrawRandom& rand, WFXPList& xings);
+	void digitizeStraw(StrawPhysics const& strawphys,
+	    StrawElectronics const& strawele,
+	    Tracker const& tracker,
+	    StrawClusterSequencePair const& hsp,
+	    StrawRandom& rand,
+	    StrawDigiCollection* digis, StrawDigiADCWaveformCollection* digiadcs, StrawDigiMCCollection* mcdigis);
 	void createDigis(StrawPhysics const& strawphys,
 	    StrawElectronics const& strawele,
 	    Tracker const& tracker,
             Straw const& straw,
 	    StrawClusterSequencePair const& hsp,
 	    XTalk const& xtalk,
+	    StrawRandom& rand,
 	    StrawDigiCollection* digis, StrawDigiADCWaveformCollection* digiadcs, StrawDigiMCCollection* mcdigis);
 	void fillDigis(StrawPhysics const& strawphys,
 	    StrawElectronics const& strawele,
 	    Tracker const& tracker,
 	    WFXPList const& xings,SWFP const& swfp , StrawId sid,
+	    StrawRandom& rand,
 	    StrawDigiCollection* digis, StrawDigiADCWaveformCollection* digiadcs, StrawDigiMCCollection* mcdigis);
-	bool createDigi(StrawElectronics const& strawele,WFXP const& xpair, SWFP const& wf, StrawId sid, StrawDigiCollection* digis,
-            StrawDigiADCWaveformCollection* digiadcs, double &digitization_ready_time);
+	bool createDigi(StrawElectronics const& strawele,WFXP const& xpair, SWFP const& wf, StrawId sid, StrawRandom& rand,
+	    StrawDigiCollection* digis, StrawDigiADCWaveformCollection* digiadcs, double &digitization_ready_time);
 	void findCrossTalkStraws(Straw const& straw,vector<XTalk>& xtalk);
-	void fillClusterNe(StrawPhysics const& strawphys,std::vector<unsigned>& me);
-	void fillClusterPositions(StrawGasStep const& step, Straw const& straw, std::vector<StrawPosition>& cpos);
-	void fillClusterMinion(StrawPhysics const& strawphys, StrawGasStep const& step, std::vector<unsigned>& me, std::vector<float>& cen);
+	void fillClusterNe(StrawPhysics const& strawphys,StrawRandom& rand,std::vector<unsigned>& me);
+	void fillClusterPositions(StrawGasStep const& step, Straw const& straw, StrawRandom& rand, std::vector<StrawPosition>& cpos);
+	void fillClusterMinion(StrawPhysics const& strawphys, StrawGasStep const& step, StrawRandom& rand, std::vector<unsigned>& me, std::vector<float>& cen);
+	long strawSeed(art::EventID const& id, StrawId const& sid, unsigned phase) const;
 	bool readAll(StrawId const& sid) const;
+	bool crossesThreshold(StrawElectronics const& strawele, StrawWaveform const& wf, double threshold, WFX& wfx);
+	void validateDigi(StrawElectronics const& strawele, StrawWaveform const& wf, double threshold, double time,
+	    unsigned short tot, TrkTypes::ADCTimes const& adctimes, ADCVoltages const& volts);
 	// diagnostic functions
 	void waveformHist(StrawElectronics const& strawele,
 	    SWFP const& wf, WFXPList const& xings);
@@ -294,19 +333,28 @@ namespace mu2e {
       _allStraw(config().allStraw()),
       _allPlanes(config().allPlanes()),
       _maxnclu(config().maxnclu()),
+      _writeClusters(config().writeClusters()),
+      _clusterOverlays(config().clusterOverlays()),
+      _parallel(config().parallel()),
+      _validate(config().validate()),
+      _sampleTime(0.0), _refTime(0.0), _nxings(0),
       _diagpath(static_cast<StrawElectronics::Path>(config().diagpath())),
       // Random number distributions
       _engine(createEngine( art::ServiceHandle<SeedService>()->getSeed())),
-      _randgauss( _engine ),
-      _randflat( _engine ),
-      _randexp( _engine),
-      _randP( _engine),
+      _rand( _engine ),
+      _strawSeedBase(art::ServiceHandle<SeedService>()->getSeed()),
       _messageCategory("HITS"),
       _firstEvent(true),      // Control some information messages.
       // This selector will select only data products with the given instance name.
       _selector{ art::ProductInstanceNameSelector(config().spinstance())},
       _toff(config().SPTO())
       {
+        if(_parallel && _diag > 0){
+	  throw cet::exception("BADCONFIG")<<"mu2e::StrawDigisFromStrawGasSteps: ParallelStraws requires diagLevel 0" << endl;
+	}
+        if(_parallel && _validate){
+	  throw cet::exception("BADCONFIG")<<"mu2e::StrawDigisFromStrawGasSteps: ParallelStraws is not compatible with ValidateWaveforms" << endl;
+	}
         if (config().spmodule() != ""){
           _selector = art::Selector(_selector && art::ModuleLabelSelector(config().spmodule()));
         }
@@ -314,10 +362,12 @@ namespace mu2e {
 	consumesMany<StrawGasStepCollection>();
 	consumes<EventWindowMarker>(_ewMarkerTag);
 	consumes<ProtonBunchTimeMC>(_pbtmcTag);
+	for(auto const& tag : _clusterOverlays) consumes<StrawClusterCollection>(tag);
 	// Tell the framework what we make.
 	produces<StrawDigiCollection>();
         produces<StrawDigiADCWaveformCollection>();
 	produces<StrawDigiMCCollection>();
+	if(_writeClusters) produces<StrawClusterCollection>();
       }
 
     void StrawDigisFromStrawGasSteps::beginJob(){
@@ -420,6 +470,12 @@ namespace mu2e {
       }
     }
 
+    void StrawDigisFromStrawGasSteps::endJob(){
+      if(_validate)
+	cout << "StrawDigisFromStrawGasSteps waveform validation: " << _nxings << " threshold searches, sampling "
+	  << _sampleTime << " s, reference sampling " << _refTime << " s" << endl;
+    }
+
     void StrawDigisFromStrawGasSteps::beginRun( art::Run& run ){
       const Tracker& tracker = *GeomHandle<Tracker>();
       _rstraw = tracker.strawProperties()._strawInnerRadius;
@@ -461,7 +517,7 @@ namespace mu2e {
       _pbtimemc = pbtmc.pbtime_;
       // calculate event window marker jitter for this microbunch for each panel
       for (size_t i=0;i<StrawId::_nupanels;i++){
-	_ewMarkerROCdt.at(i) = _randgauss.fire(0,strawele.eventWindowMarkerROCJitter());
+	_ewMarkerROCdt.at(i) = _rand.randgauss.fire(0,strawele.eventWindowMarkerROCJitter());
       }
       // make the microbunch buffer long enough to get the full waveform
       _mbbuffer = (strawele.nADCSamples() - strawele.nADCPreSamples())*strawele.adcPeriod();
@@ -475,29 +531,52 @@ namespace mu2e {
       StrawClusterMap hmap;
       // fill this from the event
       fillClusterMap(strawphys,strawele,tracker,event,hmap);
+      // save the clusters from the steps as a pre-digitized frame
+      if(_writeClusters){
+	unique_ptr<StrawClusterCollection> clusters(new StrawClusterCollection);
+	for(auto const& ihsp : hmap){
+	  for(size_t iend=0;iend<2;++iend){
+	    StrawEnd end(static_cast<StrawEnd::End>(iend));
+	    auto const& clist = ihsp.second.clustSequence(end).clustList();
+	    clusters->insert(clusters->end(),clist.begin(),clist.end());
+	  }
+	}
+	event.put(move(clusters));
+      }
+      // overlay the clusters of pre-digitized frames.  Their times already have the
+      // time offsets and microbunch folding of the frame applied
+      for(auto const& tag : _clusterOverlays){
+	auto const& clusters = *event.getValidHandle<StrawClusterCollection>(tag);
+	for(auto const& clust : clusters)
+	  hmap[clust.strawId()].clustSequence(clust.strawEnd()).insert(clust);
+      }
       // add noise clusts
       if(_addNoise)addNoise(hmap);
       // loop over the clust sequences (i.e. loop over straws, and for each get their list of clusters)
-      for(auto ihsp=hmap.begin();ihsp!= hmap.end();++ihsp){
-	StrawClusterSequencePair const& hsp = ihsp->second;
-	Straw const& straw = tracker.getStraw(hsp.strawId());
-	// create primary digis from this clust sequence
-	XTalk self(hsp.strawId()); // this object represents the straws coupling to itself, ie 100%
-	createDigis(strawphys,strawele,tracker,straw,hsp,self,digis.get(),digiadcs.get(),mcdigis.get());
-	// if we're applying x-talk, look for nearby coupled straws
-	if(_addXtalk) {
-	  // only apply if the charge is above a threshold
-	  double totalCharge = 0;
-	  for(auto ih=hsp.clustSequence(StrawEnd::cal).clustList().begin();ih!= hsp.clustSequence(StrawEnd::cal).clustList().end();++ih){
-	    totalCharge += ih->charge();
-	  }
-	  if( totalCharge > _ctMinCharge){
-	    vector<XTalk> xtalk;
-	    findCrossTalkStraws(straw,xtalk);
-	    for(auto ixtalk=xtalk.begin();ixtalk!=xtalk.end();++ixtalk){
-	      createDigis(strawphys,strawele,tracker,straw,hsp,*ixtalk,digis.get(),digiadcs.get(),mcdigis.get());
+      if(!_parallel){
+	for(auto ihsp=hmap.begin();ihsp!= hmap.end();++ihsp){
+	  digitizeStraw(strawphys,strawele,tracker,ihsp->second,_rand,digis.get(),digiadcs.get(),mcdigis.get());
+	}
+      } else {
+	// digitize each straw in its own task and engine, then merge the digis in straw order
+	vector<StrawClusterSequencePair const*> hsps;
+	hsps.reserve(hmap.size());
+	for(auto const& ihsp : hmap) hsps.push_back(&ihsp.second);
+	vector<StrawDigiCollection> sdigis(hsps.size());
+	vector<StrawDigiADCWaveformCollection> sdigiadcs(hsps.size());
+	vector<StrawDigiMCCollection> smcdigis(hsps.size());
+	tbb::parallel_for(tbb::blocked_range<size_t>(0,hsps.size()),
+	    [&](tbb::blocked_range<size_t> const& range) {
+	    for(size_t ihsp=range.begin();ihsp!=range.end();++ihsp){
+	      CLHEP::HepJamesRandom engine(strawSeed(event.id(),hsps[ihsp]->strawId(),1));
+	      StrawRandom rand(engine);
+	      digitizeStraw(strawphys,strawele,tracker,*hsps[ihsp],rand,&sdigis[ihsp],&sdigiadcs[ihsp],&smcdigis[ihsp]);
 	    }
-	  }
+	  });
+	for(size_t ihsp=0;ihsp<hsps.size();++ihsp){
+	  digis->insert(digis->end(),sdigis[ihsp].begin(),sdigis[ihsp].end());
+	  digiadcs->insert(digiadcs->end(),sdigiadcs[ihsp].begin(),sdigiadcs[ihsp].end());
+	  mcdigis->insert(mcdigis->end(),smcdigis[ihsp].begin(),smcdigis[ihsp].end());
 	}
       }
       // store the digis in the event
@@ -511,6 +590,36 @@ namespace mu2e {
 
     } // end produce
 
+    void StrawDigisFromStrawGasSteps::digitizeStraw(
+	StrawPhysics const& strawphys,
+	StrawElectronics const& strawele,
+	Tracker const& tracker,
+	StrawClusterSequencePair const& hsp,
+	StrawRandom& rand,
+	StrawDigiCollection* digis, StrawDigiADCWaveformCollection* digiadcs,
+        StrawDigiMCCollection* mcdigis) {
+      Straw const& straw = tracker.getStraw(hsp.strawId());
+      // create primary digis from this clust sequence
+      XTalk self(hsp.strawId()); // this object represents the straws coupling to itself, ie 100%
+      createDigis(strawphys,strawele,tracker,straw,hsp,self,rand,digis,digiadcs,mcdigis);
+      // if we're applying x-talk, look for nearby coupled straws.  The coupled signal
+      // only depends on this straw's clusters, so it is digitized here too
+      if(_addXtalk) {
+	// only apply if the charge is above a threshold
+	double totalCharge = 0;
+	for(auto ih=hsp.clustSequence(StrawEnd::cal).clustList().begin();ih!= hsp.clustSequence(StrawEnd::cal).clustList().end();++ih){
+	  totalCharge += ih->charge();
+	}
+	if( totalCharge > _ctMinCharge){
+	  vector<XTalk> xtalk;
+	  findCrossTalkStraws(straw,xtalk);
+	  for(auto ixtalk=xtalk.begin();ixtalk!=xtalk.end();++ixtalk){
+	    createDigis(strawphys,strawele,tracker,straw,hsp,*ixtalk,rand,digis,digiadcs,mcdigis);
+	  }
+	}
+      }
+    }
+
     void StrawDigisFromStrawGasSteps::createDigis(
 	StrawPhysics const& strawphys,
 	StrawElectronics const& strawele,
@@ -518,6 +627,7 @@ namespace mu2e {
         Straw const& straw,
 	StrawClusterSequencePair const& hsp,
 	XTalk const& xtalk,
+	StrawRandom& rand,
 	StrawDigiCollection* digis, StrawDigiADCWaveformCollection* digiadcs,
         StrawDigiMCCollection* mcdigis) {
       // instantiate waveforms for both ends of this straw
@@ -526,9 +636,9 @@ namespace mu2e {
       // find the threshold crossing points for these waveforms
       WFXPList xings;
       // find the threshold crossings
-      findThresholdCrossings(strawele,waveforms,xings);
+      findThresholdCrossings(strawele,waveforms,rand,xings);
       // convert the crossing points into digis, and add them to the event data
-      fillDigis(strawphys,strawele,tracker,xings,waveforms,xtalk._dest,digis,digiadcs,mcdigis);
+      fillDigis(strawphys,strawele,tracker,xings,waveforms,xtalk._dest,rand,digis,digiadcs,mcdigis);
     }
 
     void StrawDigisFromStrawGasSteps::fillClusterMap(StrawPhysics const& strawphys,
@@ -549,10 +659,13 @@ namespace mu2e {
 	  log  << "   " << prov.branchName() << "\n";
 	}
       }
-      if(stepsHandles.empty()){
+      if(stepsHandles.empty() && _clusterOverlays.empty()){
 	throw cet::exception("SIM")<<"mu2e::StrawDigisFromStrawGasSteps: No StrawGasStep collections found for tracker" << endl;
       }
 
+      // in parallel mode, the steps of each straw with their times
+      typedef vector<pair<SGSPtr,double> > StepTimes;
+      map<StrawId,StepTimes> stepsByStraw;
       // Loop over StrawGasStep collections
       for ( auto const& sgsch : stepsHandles) {
 	StrawGasStepCollection const& steps(*sgsch);
@@ -564,65 +677,95 @@ namespace mu2e {
 	  Straw const& straw = tracker.getStraw(sid);
 	  if(sgs.ionizingEdep() > _minstepE){
 	    auto sgsptr = SGSPtr(sgsch,isgs);
-	    // create a clust from this step, and add it to the clust map
-	    addStep(strawphys,strawele,straw,sgsptr,hmap[sid]);
+	    StrawClusterSequencePair& shsp = hmap[sid];
+	    // apply time offsets, and take module with MB.  The time offsets are not thread safe
+	    double ctime  = microbunchTime(strawele,sgs.time() + _toff.totalTimeOffset(sgs.simParticle()));
+	    if(inDigitizationWindow(strawele,sid,ctime)){
+	      // create a clust from this step, and add it to the clust map
+	      if(_parallel)
+		stepsByStraw[sid].emplace_back(sgsptr,ctime);
+	      else
+		addStep(strawphys,strawele,straw,sgsptr,ctime,_rand,_clusters,shsp);
+	    }
 	  }
 	}
       }
+      if(_parallel){
+	// create the clusts of each straw in its own task and engine.  The map entries
+	// already exist, so each task only touches its own straw
+	vector<map<StrawId,StepTimes>::const_iterator> isteps;
+	isteps.reserve(stepsByStraw.size());
+	for(auto istep=stepsByStraw.cbegin();istep!=stepsByStraw.cend();++istep) isteps.push_back(istep);
+	tbb::parallel_for(tbb::blocked_range<size_t>(0,isteps.size()),
+	    [&](tbb::blocked_range<size_t> const& range) {
+	    vector<IonCluster> clusters;
+	    for(size_t i=range.begin();i!=range.end();++i){
+	      StrawId const& sid = isteps[i]->first;
+	      Straw const& straw = tracker.getStraw(sid);
+	      StrawClusterSequencePair& shsp = hmap.find(sid)->second;
+	      CLHEP::HepJamesRandom engine(strawSeed(event.id(),sid,0));
+	      StrawRandom rand(engine);
+	      for(auto const& steptime : isteps[i]->second)
+		addStep(strawphys,strawele,straw,steptime.first,steptime.second,rand,clusters,shsp);
+	    }
+	  });
+      }
+    }
+
+    bool StrawDigisFromStrawGasSteps::inDigitizationWindow(StrawElectronics const& strawele, StrawId const& sid, double ctime) const {
+      // test if this step point is roughly in the digitization window
+      return (ctime > strawele.digitizationStartFromMarker() - strawele.electronicsTimeDelay() - _steptimebuf
+	    && ctime <  max(_mbtime,_digitizationEndFromMarker) - strawele.electronicsTimeDelay() + _steptimebuf) || readAll(sid);
     }
 
     void StrawDigisFromStrawGasSteps::addStep(StrawPhysics const& strawphys,
 	StrawElectronics const& strawele,
 	Straw const& straw,
-	SGSPtr const& sgsptr,
+	SGSPtr const& sgsptr, double ctime,
+	StrawRandom& rand, vector<IonCluster>& clusters,
 	StrawClusterSequencePair& shsp) {
       auto const& sgs = *sgsptr;
       StrawId sid = sgs.strawId();
-      // apply time offsets, and take module with MB
-      double ctime  = microbunchTime(strawele,sgs.time() + _toff.totalTimeOffset(sgs.simParticle()));
-      // test if this step point is roughly in the digitization window
-      if( (ctime > strawele.digitizationStartFromMarker() - strawele.electronicsTimeDelay() - _steptimebuf
-	    && ctime <  max(_mbtime,_digitizationEndFromMarker) - strawele.electronicsTimeDelay() + _steptimebuf) || readAll(sid)) {
-	// Subdivide the StrawGasStep into ionization clusters
-	_clusters.clear();
-	divideStep(strawphys,strawele,straw,sgs,_clusters);
-	// check
-	// drift these clusters to the wire, and record the charge at the wire
-	for(auto iclu = _clusters.begin(); iclu != _clusters.end(); ++iclu){
-	  WireCharge wireq;
-	  driftCluster(strawphys,straw,*iclu,wireq);
-	  // propagate this charge to each end of the wire
-	  for(size_t iend=0;iend<2;++iend){
-	    StrawEnd end(static_cast<StrawEnd::End>(iend));
-	    // compute the longitudinal propagation effects
-	    WireEndCharge weq;
-	    propagateCharge(strawphys,straw,wireq,end,weq);
-	    // time of this cluster was produced, including offset
-	    // compute the time the signal arrives at the wire end
-	    double gtime = ctime + wireq._time + weq._time;
-	    // create the clust
-	    StrawCluster clust(StrawCluster::primary,sid,end,(float)gtime,weq._charge,weq._wdist,wireq._pos,(float)wireq._time,(float)weq._time,sgsptr,(float)ctime);
-	    // add the clusts to the appropriate sequence.
-	    shsp.clustSequence(end).insert(clust);
-	    // if required, add a 'ghost' copy of this clust
-            if (_onSpill)
-  	      addGhosts(strawele,clust,shsp.clustSequence(end));
-	  }
+      // Subdivide the StrawGasStep into ionization clusters
+      clusters.clear();
+      divideStep(strawphys,strawele,straw,sgs,rand,clusters);
+      // check
+      // drift these clusters to the wire, and record the charge at the wire
+      for(auto iclu = clusters.begin(); iclu != clusters.end(); ++iclu){
+	WireCharge wireq;
+	driftCluster(strawphys,straw,*iclu,rand,wireq);
+	// propagate this charge to each end of the wire
+	for(size_t iend=0;iend<2;++iend){
+	  StrawEnd end(static_cast<StrawEnd::End>(iend));
+	  // compute the longitudinal propagation effects
+	  WireEndCharge weq;
+	  propagateCharge(strawphys,straw,wireq,end,weq);
+	  // time of this cluster was produced, including offset
+	  // compute the time the signal arrives at the wire end
+	  double gtime = ctime + wireq._time + weq._time;
+	  // create the clust
+	  StrawCluster clust(StrawCluster::primary,sid,end,(float)gtime,weq._charge,weq._wdist,wireq._pos,(float)wireq._time,(float)weq._time,sgsptr,(float)ctime);
+	  // add the clusts to the appropriate sequence.
+	  shsp.clustSequence(end).insert(clust);
+	  // if required, add a 'ghost' copy of this clust
+	  if (_onSpill)
+	    addGhosts(strawele,clust,shsp.clustSequence(end));
 	}
-	if(_diag > 0) stepDiag(strawphys, strawele, sgs);
       }
+      if(_diag > 0) stepDiag(strawphys, strawele, sgs);
     }
 
     void StrawDigisFromStrawGasSteps::divideStep(StrawPhysics const& strawphys,
 	StrawElectronics const& strawele,
 	Straw const& straw,
 	StrawGasStep const& sgs,
+	StrawRandom& rand,
 	vector<IonCluster>& clusters) {
       // single cluster
       if (sgs.stepType().shape() == StrawGasStep::StepType::point || sgs.stepLength() < strawphys.meanFreePath()){
 	float cen = sgs.ionizingEdep();
 	float fne = cen/strawphys.meanElectronEnergy();
-	unsigned ne = std::max( static_cast<unsigned>(_randP(fne)),(unsigned)1);
+	unsigned ne = std::max( static_cast<unsigned>(rand.randP(fne)),(unsigned)1);
 	auto spos = strawPosition(sgs.startPosition(),straw);
 	if(_drift1e){
 	  for (size_t i=0;i<ne;i++){
@@ -637,7 +780,7 @@ namespace mu2e {
 	// compute the number of clusters for this step from the mean free path
 	double fnc = sgs.stepLength()/strawphys.meanFreePath();
 	// use a truncated Poisson distribution; this keeps both the mean and variance physical
-	unsigned nc = std::max(static_cast<unsigned>(_randP.fire(fnc)),(unsigned)1);
+	unsigned nc = std::max(static_cast<unsigned>(rand.randP.fire(fnc)),(unsigned)1);
 	// if not minion, limit the number of steps geometrically
 	bool minion = (sgs.stepType().ionization()==StrawGasStep::StepType::minion);
 	if(!minion )nc = std::min(nc,_maxnclu);
@@ -645,17 +788,17 @@ namespace mu2e {
 	nc = std::min(nc,static_cast<unsigned>(floor(sgs.ionizingEdep()/strawphys.ionizationEnergy((unsigned)1))));
 	// generate random positions for the clusters
 	std::vector<StrawPosition> cposv(nc);
-	fillClusterPositions(sgs,straw,cposv);
+	fillClusterPositions(sgs,straw,rand,cposv);
 	// generate electron counts and energies for these clusters: minion model is more detailed
 	std::vector<unsigned> ne(nc);
 	std::vector<float> cen(nc);
 	if(minion){
-	  fillClusterMinion(strawphys,sgs,ne,cen);
+	  fillClusterMinion(strawphys,sgs,rand,ne,cen);
 	} else {
 	  // get Poisson distribution of # of electrons for the average energy
 	  double fne = sgs.ionizingEdep()/(nc*strawphys.meanElectronEnergy()); // average # of electrons/cluster for non-minion clusters
 	  for(unsigned ic=0;ic<nc;++ic){
-	    ne[ic] = static_cast<unsigned>(std::max(_randP.fire(fne),(long)1));
+	    ne[ic] = static_cast<unsigned>(std::max(rand.randP.fire(fne),(long)1));
 	    cen[ic] = ne[ic]*strawphys.meanElectronEnergy(); // average energy per electron, works for large numbers of electrons
 	  }
 	}
@@ -679,14 +822,14 @@ namespace mu2e {
 
     void StrawDigisFromStrawGasSteps::driftCluster(
 	StrawPhysics const& strawphys,Straw const& straw,
-	IonCluster const& cluster, WireCharge& wireq ) {
+	IonCluster const& cluster, StrawRandom& rand, WireCharge& wireq ) {
       // sample the gain for this cluster
-      double gain = strawphys.clusterGain(_randgauss, _randflat, cluster._ne);
+      double gain = strawphys.clusterGain(rand.randgauss, rand.randflat, cluster._ne);
       wireq._charge = cluster._charge*(gain);
       // compute drift time for this cluster
       double dt = strawphys.driftDistanceToTime(cluster._pos.Rho(),cluster._pos.Phi()); // this is now from the lorentz corrected r-component of the drift
       wireq._pos = cluster._pos;
-      wireq._time = _randgauss.fire(dt,strawphys.driftTimeSpread(cluster._pos.Rho()));
+      wireq._time = rand.randgauss.fire(dt,strawphys.driftTimeSpread(cluster._pos.Rho()));
     }
 
     void StrawDigisFromStrawGasSteps::propagateCharge(
@@ -726,14 +869,14 @@ namespace mu2e {
       if(clust.time() > _mbtime - _mbbuffer) shs.insert(StrawCluster(clust,-_mbtime));
     }
 
-    void StrawDigisFromStrawGasSteps::findThresholdCrossings(StrawElectronics const& strawele, SWFP const& swfp, WFXPList& xings){
+    void StrawDigisFromStrawGasSteps::findThresholdCrossings(StrawElectronics const& strawele, SWFP const& swfp, StrawRandom& rand, WFXPList& xings){
       //randomize the threshold to account for electronics noise; this includes parts that are coherent
       // for both ends (coming from the straw itself)
       // Keep track of crossings on each end to keep them in sequence
-      double strawnoise = _randgauss.fire(0,strawele.strawNoise());
+      double strawnoise = rand.randgauss.fire(0,strawele.strawNoise());
       // add specifics for each end
-      double thresh[2] = {_randgauss.fire(strawele.threshold(swfp[0].straw().id(),static_cast<StrawEnd::End>(0))+strawnoise,strawele.analogNoise(StrawElectronics::thresh)),
-	_randgauss.fire(strawele.threshold(swfp[0].straw().id(),static_cast<StrawEnd::End>(1))+strawnoise,strawele.analogNoise(StrawElectronics::thresh))};
+      double thresh[2] = {rand.randgauss.fire(strawele.threshold(swfp[0].straw().id(),static_cast<StrawEnd::End>(0))+strawnoise,strawele.analogNoise(StrawElectronics::thresh)),
+	rand.randgauss.fire(strawele.threshold(swfp[0].straw().id(),static_cast<StrawEnd::End>(1))+strawnoise,strawele.analogNoise(StrawElectronics::thresh))};
       // Initialize search when the electronics becomes enabled:
       double tstart =strawele.digitizationStartFromMarker() - _flashbuffer; 
       // for reading all hits, make sure we start looking for clusters at the minimum possible cluster time
@@ -743,7 +886,7 @@ namespace mu2e {
       // search for coherent crossings on both ends
       bool crosses[2];
       for(size_t iend=0;iend<2;++iend){
-	crosses[iend] = swfp[iend].crossesThreshold(strawele,thresh[iend],wfx[iend]);
+	crosses[iend] = crossesThreshold(strawele,swfp[iend],thresh[iend],wfx[iend]);
       }
       // loop until we hit the end of the waveforms.  Require both in time.  Buffer to account for eventual TDC jitter
       // this is a loose pre-selection, final selection is done at digitization
@@ -756,23 +899,23 @@ namespace mu2e {
 	  if(std::min(wfx[0]._time,wfx[1]._time) > 0.0 )xings.push_back(wfx);
 	  // search for next crossing:
 	  // update threshold for straw noise
-	  strawnoise = _randgauss.fire(0,strawele.strawNoise());
+	  strawnoise = rand.randgauss.fire(0,strawele.strawNoise());
 	  for(unsigned iend=0;iend<2;++iend){
 	    // insure a minimum time buffer between crossings
 	    wfx[iend]._time += strawele.deadTimeAnalog();
 	    // skip to the next clust
 	    ++(wfx[iend]._iclust);
 	    // update threshold for incoherent noise
-	    thresh[iend] = _randgauss.fire(strawele.threshold(swfp[0].straw().id(),static_cast<StrawEnd::End>(iend)),strawele.analogNoise(StrawElectronics::thresh));
+	    thresh[iend] = rand.randgauss.fire(strawele.threshold(swfp[0].straw().id(),static_cast<StrawEnd::End>(iend)),strawele.analogNoise(StrawElectronics::thresh));
 	    // find next crossing
-	    crosses[iend] = swfp[iend].crossesThreshold(strawele,thresh[iend],wfx[iend]);
+	    crosses[iend] = crossesThreshold(strawele,swfp[iend],thresh[iend],wfx[iend]);
 	  }
 	} else {
 	  // skip to the next crossing on the earlier waveform
 	  unsigned iearly = wfx[0]._time < wfx[1]._time ? 0 : 1;
 	  ++(wfx[iearly]._iclust);
 	  wfx[iearly]._time += strawele.deadTimeAnalog();
-	  crosses[iearly] = swfp[iearly].crossesThreshold(strawele,thresh[iearly],wfx[iearly]);
+	  crosses[iearly] = crossesThreshold(strawele,swfp[iearly],thresh[iearly],wfx[iearly]);
 	}
       }
     }
@@ -782,6 +925,7 @@ namespace mu2e {
 	Tracker const& tracker,
 	WFXPList const& xings, SWFP const& wf,
 	StrawId sid,
+	StrawRandom& rand,
 	StrawDigiCollection* digis, StrawDigiADCWaveformCollection* digiadcs,
         StrawDigiMCCollection* mcdigis ) {
 	//
@@ -791,7 +935,7 @@ namespace mu2e {
       for(auto xpair : xings) {
 	// create a digi from this pair.  This also performs a finial test
 	// on whether the pair should make a digi
-	if(createDigi(strawele,xpair,wf,sid,digis,digiadcs,digitization_ready_time)){
+	if(createDigi(strawele,xpair,wf,sid,rand,digis,digiadcs,digitization_ready_time)){
 	  // fill associated MC truth matching. Only count the same step once
 	  StrawDigiMC::SGSPA sgspa;
 	  StrawDigiMC::PA cpos;
@@ -825,8 +969,48 @@ namespace mu2e {
       }
     }
 
+    bool StrawDigisFromStrawGasSteps::crossesThreshold(StrawElectronics const& strawele, StrawWaveform const& wf, double threshold, WFX& wfx){
+      if(!_validate)return wf.crossesThreshold(strawele,threshold,wfx);
+      // repeat the search from the same start on the reference waveform
+      WFX refwfx(wfx);
+      StrawWaveform refwf(wf,true);
+      auto t0 = std::chrono::steady_clock::now();
+      bool crosses = wf.crossesThreshold(strawele,threshold,wfx);
+      auto t1 = std::chrono::steady_clock::now();
+      bool refcrosses = refwf.crossesThreshold(strawele,threshold,refwfx);
+      auto t2 = std::chrono::steady_clock::now();
+      _sampleTime += std::chrono::duration<double>(t1-t0).count();
+      _refTime += std::chrono::duration<double>(t2-t1).count();
+      ++_nxings;
+      if(crosses != refcrosses || wfx._time != refwfx._time || wfx._vstart != refwfx._vstart
+	  || wfx._vcross != refwfx._vcross || wfx._iclust != refwfx._iclust)
+	throw cet::exception("SIM")<<"mu2e::StrawDigisFromStrawGasSteps: threshold crossing differs from the reference for straw "
+	  << wf.straw().id() << " end " << wf.strawEnd() << ": crosses " << crosses << " at " << wfx._time << " vs "
+	  << refcrosses << " at " << refwfx._time << endl;
+      return crosses;
+    }
+
+    void StrawDigisFromStrawGasSteps::validateDigi(StrawElectronics const& strawele, StrawWaveform const& wf, double threshold, double time,
+	unsigned short tot, TrkTypes::ADCTimes const& adctimes, ADCVoltages const& volts) {
+      // the TOT and the ADC samples, saturated or not, from the reference waveform
+      StrawWaveform refwf(wf,true);
+      auto t0 = std::chrono::steady_clock::now();
+      unsigned short reftot = refwf.digitizeTOT(strawele,threshold,time);
+      ADCVoltages refvolts;
+      refwf.sampleADCWaveform(strawele,adctimes,refvolts);
+      _refTime += std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+      if(tot != reftot)
+	throw cet::exception("SIM")<<"mu2e::StrawDigisFromStrawGasSteps: TOT differs from the reference for straw "
+	  << wf.straw().id() << " end " << wf.strawEnd() << ": " << tot << " vs " << reftot << endl;
+      for(size_t isamp=0;isamp<adctimes.size();++isamp){
+	if(volts[isamp] != refvolts[isamp])
+	  throw cet::exception("SIM")<<"mu2e::StrawDigisFromStrawGasSteps: ADC sample differs from the reference for straw "
+	    << wf.straw().id() << " end " << wf.strawEnd() << " at time " << adctimes[isamp] << ": " << volts[isamp] << " vs " << refvolts[isamp] << endl;
+      }
+    }
+
     bool StrawDigisFromStrawGasSteps::createDigi(StrawElectronics const& strawele, WFXP const& xpair, SWFP const& waveform,
-	StrawId sid, StrawDigiCollection* digis, StrawDigiADCWaveformCollection* digiadcs, double &digitization_ready_time){
+	StrawId sid, StrawRandom& rand, StrawDigiCollection* digis, StrawDigiADCWaveformCollection* digiadcs, double &digitization_ready_time){
       // initialize the float variables that we later digitize
       TDCTimes xtimes = {0.0,0.0};
       TrkTypes::TOTValues tot;
@@ -843,14 +1027,21 @@ namespace mu2e {
 	WFX const& wfx = xpair[iend];
 	// record the crossing time for this end, including clock jitter  These already include noise effects
 	// add noise for TDC on each side
-	double tdc_jitter = _randgauss.fire(0.0,strawele.TDCResolution());
+	double tdc_jitter = rand.randgauss.fire(0.0,strawele.TDCResolution());
 	xtimes[iend] = wfx._time+dt+tdc_jitter;
 	// randomize threshold using the incoherent noise
-	double threshold = _randgauss.fire(wfx._vcross,strawele.analogNoise(StrawElectronics::thresh));
+	double threshold = rand.randgauss.fire(wfx._vcross,strawele.analogNoise(StrawElectronics::thresh));
+	// the digitization is only timed when it is validated
+	std::chrono::steady_clock::time_point t0;
+	if(_validate) t0 = std::chrono::steady_clock::now();
 	// find TOT
 	tot[iend] = waveform[iend].digitizeTOT(strawele,threshold,wfx._time + dt);
 	// sample ADC
 	waveform[iend].sampleADCWaveform(strawele,adctimes,wf[iend]);
+	if(_validate){
+	  _sampleTime += std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+	  validateDigi(strawele,waveform[iend],threshold,wfx._time + dt,tot[iend],adctimes,wf[iend]);
+	}
       }
       double digitize_time = std::max(xtimes[0],xtimes[1]);
       if (digitize_time < digitization_ready_time)
@@ -861,7 +1052,7 @@ namespace mu2e {
       // add ends and add noise
       ADCVoltages wfsum; wfsum.reserve(adctimes.size());
       for(unsigned isamp=0;isamp<adctimes.size();++isamp){
-	wfsum.push_back(wf[0][isamp]+wf[1][isamp]+_randgauss.fire(0.0,strawele.analogNoise(StrawElectronics::adc)));
+	wfsum.push_back(wf[0][isamp]+wf[1][isamp]+rand.randgauss.fire(0.0,strawele.analogNoise(StrawElectronics::adc)));
       }
       // digitize, and make final test.  This call includes the clock error WRT the proton pulse
       TrkTypes::TDCValues tdcs;
@@ -914,24 +1105,24 @@ namespace mu2e {
       // create random noise clusts and add them to the sequences of random straws.
     }
 
-    void StrawDigisFromStrawGasSteps::fillClusterPositions(StrawGasStep const& sgs, Straw const& straw, std::vector<StrawPosition>& cposv) {
+    void StrawDigisFromStrawGasSteps::fillClusterPositions(StrawGasStep const& sgs, Straw const& straw, StrawRandom& rand, std::vector<StrawPosition>& cposv) {
       // generate a random position between the start and end points.
       XYZVec path = sgs.endPosition() - sgs.startPosition();
       for(auto& cpos : cposv) {
-	XYZVec pos = sgs.startPosition() + _randflat.fire(1.0)*path;
+	XYZVec pos = sgs.startPosition() + rand.randflat.fire(1.0)*path;
       	// randomize the position by width.  This needs to be 2-d to avoid problems at the origin
 	if(_randrad){
 	  XYZVec sdir = Geom::toXYZVec(straw.getDirection());
 	  XYZVec p1 = path.Cross(sdir).Unit();
 	  XYZVec p2 = path.Cross(p1).Unit();
-	  pos += p1*_randgauss.fire()*sgs.width();
-	  pos += p2*_randgauss.fire()*sgs.width();
+	  pos += p1*rand.randgauss.fire()*sgs.width();
+	  pos += p2*rand.randgauss.fire()*sgs.width();
 	}
 	cpos = strawPosition(pos,straw);
       }
     }
 
-    void StrawDigisFromStrawGasSteps::fillClusterMinion(StrawPhysics const& strawphys, StrawGasStep const& step, std::vector<unsigned>& ne, std::vector<float>& cen) {
+    void StrawDigisFromStrawGasSteps::fillClusterMinion(StrawPhysics const& strawphys, StrawGasStep const& step, StrawRandom& rand, std::vector<unsigned>& ne, std::vector<float>& cen) {
       // Loop until we've assigned energy + electrons to every cluster
       unsigned mc(0);
       double esum(0.0);
@@ -940,7 +1131,7 @@ namespace mu2e {
       while(mc < nc){
 	std::vector<unsigned> me(nc);
 	// fill an array of random# of electrons according to the measured distribution. 
-	fillClusterNe(strawphys,me);
+	fillClusterNe(strawphys,rand,me);
 	// loop through these as long as there's enough energy to have at least 1 electron in each cluster.  If not, re-throw the # of electrons/cluster for the remainder
 	for(auto ie : me) {
 	  double emax = etot - esum - (nc -mc -1)*strawphys.ionizationEnergy((unsigned)1);
@@ -958,12 +1149,12 @@ namespace mu2e {
       // distribute any residual energy randomly to these clusters.  This models delta rays
       unsigned ns;
       do{
-	unsigned me = strawphys.nePerIon(_randflat.fire());
+	unsigned me = strawphys.nePerIon(rand.randflat.fire());
 	double emax = etot - esum;
 	double eele = strawphys.ionizationEnergy(me);
 	if(eele < emax){
 	  // choose a random cluster to assign this energy to
-	  unsigned mc = std::min(nc-1,static_cast<unsigned>(floor(_randflat.fire(nc))));
+	  unsigned mc = std::min(nc-1,static_cast<unsigned>(floor(rand.randflat.fire(nc))));
 	  ne[mc] += me;
 	  cen[mc] += eele;
 	  esum += eele;
@@ -973,10 +1164,26 @@ namespace mu2e {
       } while(ns > 0);
     }
 
-    void StrawDigisFromStrawGasSteps::fillClusterNe(StrawPhysics const& strawphys,std::vector<unsigned>& me) {
+    void StrawDigisFromStrawGasSteps::fillClusterNe(StrawPhysics const& strawphys,StrawRandom& rand,std::vector<unsigned>& me) {
       for(size_t ie=0;ie < me.size(); ++ie){
-	me[ie] = strawphys.nePerIon(_randflat.fire());
+	me[ie] = strawphys.nePerIon(rand.randflat.fire());
+      }
+    }
+
+    // The seed of the engine of one straw in parallel mode.  It depends only on the module seed,
+    // the event, the straw and the phase (clusts or digis), not on the thread or task that uses it
+    long StrawDigisFromStrawGasSteps::strawSeed(art::EventID const& id, StrawId const& sid, unsigned phase) const {
+      uint64_t seed = _strawSeedBase;
+      for(uint64_t word : {(uint64_t)id.run(),(uint64_t)id.subRun(),(uint64_t)id.event(),
+	  (uint64_t)sid.asUint16(),(uint64_t)phase}){
+	// splitmix64 step
+	seed += word + 0x9e3779b97f4a7c15ULL;
+	seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	seed = (seed ^ (seed >> 27)) * 0x94d049bb133111ebULL;
+	seed ^= seed >> 31;
       }
+      // HepJamesRandom takes seeds up to 900000000
+      return static_cast<long>(seed % 900000000ULL);
     }
 
     bool StrawDigisFromStrawGasSteps::readAll(StrawId const& sid) const {
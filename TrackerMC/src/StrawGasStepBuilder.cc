@@ -0,0 +1,243 @@
+//
+//  Build StrawGasSteps from the tracker StepPointMCs
+//
+//  Original author: David Brown (LBNL), Krzysztof Genser 19 Aug. 2019
+//
+#include "TrackerMC/inc/StrawGasStepBuilder.hh"
+#include "TrackerGeom/inc/Tracker.hh"
+#include "TrackerConditions/inc/TrackerStatus.hh"
+#include "GeometryService/inc/DetectorSystem.hh"
+#include "BFieldGeom/inc/BFieldManager.hh"
+#include "BTrk/BField/BField.hh"
+#include "GlobalConstantsService/inc/GlobalConstantsHandle.hh"
+#include "GlobalConstantsService/inc/ParticleDataTable.hh"
+#include "HepPDT/ParticleData.hh"
+#include "MCDataProducts/inc/ProcessCode.hh"
+#include "cetlib_except/exception.h"
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+using CLHEP::Hep3Vector;
+using HepPDT::ParticleData;
+namespace mu2e {
+
+  StrawGasStepBuilder::StrawGasStepBuilder(float maxDeltaLength, float minionBG, float minionKE,
+      float curlRatio, float lineRatio, unsigned startSize, int debug) :
+    _maxDeltaLen(maxDeltaLength),
+    _minionBG(minionBG),
+    _minionKE(minionKE),
+    _curlfac(curlRatio),
+    _linefac(lineRatio),
+    _ssize(startSize),
+    _debug(debug),
+    _bnom(0.0), _rstraw(0.0), _curlmom(0.0), _linemom(0.0)
+  {}
+
+  void StrawGasStepBuilder::beginRun(Tracker const& tracker, BFieldManager const& bfmgr, DetectorSystem const& det) {
+    // get field at the center of the tracker
+    auto vpoint_mu2e = det.toMu2e(Hep3Vector(0.0,0.0,0.0));
+    auto bnom = bfmgr.getBField(vpoint_mu2e);
+    _bdir = bnom.unit();
+    // B in units of mm/MeV/c
+    _bnom = bnom.mag()*BField::mmTeslaToMeVc;
+    // pre-compute momentum thresholds for straight, arc, and curler
+    _rstraw = tracker.strawProperties()._strawInnerRadius;
+    float pstraw = _bnom*_rstraw;// transverse momentum with same radius as straw
+    _curlmom = _curlfac*pstraw;
+    _linemom = _linefac*pstraw;
+  }
+
+  void StrawGasStepBuilder::makeSteps(Tracker const& tracker, TrackerStatus const* trackerStatus,
+      StepPointMCCollection const& steps, bool combineDeltas, SimLookup const& sims, StrawGasStepCollection& sgsc) const {
+    GlobalConstantsHandle<ParticleDataTable> pdt;
+    SPSMap spsmap;
+    fillMap(tracker,trackerStatus,steps,spsmap);
+    if(combineDeltas)compressDeltas(spsmap,sims);
+    for(auto const& sps : spsmap){
+      auto const& spmcptrs = sps.second;
+      SimParticle const* sim = sims(spmcptrs.front()->simParticle());
+      if(sim == 0)
+	throw cet::exception("SIM")<<"mu2e::StrawGasStepBuilder: No SimParticle found for key " << sps.first.second << endl;
+      auto pref = pdt->particle(sim->pdgId());
+      ParticleData const* pdata(0);
+      if(pref.isValid())pdata = &pref.ref();
+      StrawGasStep sgs;
+      fillStep(spmcptrs,tracker.getStraw(sps.first.first),pdata,sps.first.second,sgs);
+      sgsc.push_back(sgs);
+    }
+  }
+
+  void StrawGasStepBuilder::fillStep(StepPtrs const& spmcptrs, Straw const& straw,
+      ParticleData const* pdata, cet::map_vector_key pid, StrawGasStep& sgs) const {
+    // variables we accumulate for all the StepPoints in this pair
+    double eion(0.0), pathlen(0.0);
+    // keep track of the first and last PRIMARY step
+    StepPointMC const* first(0);
+    StepPointMC const* last(0);
+    // loop over all  the StepPoints for this SimParticle
+    for(auto const& spmcptr : spmcptrs){
+      bool primary=spmcptr->simParticle().key() == pid.asUint();
+      // update eion for all contributions
+      eion += spmcptr->ionizingEdep();
+      // treat primary and secondary (delta-ray) energy differently
+      if(primary) {
+	// primary: update path length, and entry/exit
+	pathlen += spmcptr->stepLength();
+	if(first == 0 || spmcptr->time() < first->time()) first = spmcptr;
+	if(last == 0 || spmcptr->time() > last->time()) last = spmcptr;
+      }
+    }
+    if(first == 0 || last == 0)
+      throw cet::exception("SIM")<<"mu2e::StrawGasStepBuilder: No first or last step" << endl;
+    // Define the position at entrance and exit; note the StepPointMC position is at the start of the step, so we have to extend the last
+    XYZVec start = Geom::toXYZVec(first->position());
+    // determine the type of step
+    StrawGasStep::StepType stype;
+    setStepType(*first,pdata,stype);
+    // compute the end position and step type
+    XYZVec end = Geom::toXYZVec(last->postPosition());
+    XYZVec momvec = Geom::toXYZVec(0.5*(first->momentum() + last->momentum()));	// average first and last momentum
+    float  mom = sqrt(momvec.mag2());
+    // determine the width from the sigitta or curl radius
+    auto pdir = first->momentum().unit();
+    auto pperp = pdir.perp(_bdir);
+    float bendrms = 0.5*std::min(_rstraw,mom*pperp/_bnom); // bend radius spread.  0.5 factor givs RMS of a circle
+    // only sigitta perp to the wire counts
+    float sint = (_bdir.cross(pdir).cross(straw.getDirection())).mag();
+    static const float prms(1.0/(12.0*sqrt(5.0))); // RMS for a parabola.  This includes a factor 1/8 for the sagitta calculation too
+    float sagrms = prms*sint*pathlen*pathlen*_bnom*pperp/mom;
+    double width = std::min(sagrms,bendrms); // choose the smaller: different approximations work for different momenta/directions
+  // create the gas step
+    sgs = StrawGasStep( first->strawId(), stype,
+	(float)eion,(float)pathlen, (float)width, first->time(),
+	start, end, momvec, first->simParticle());
+  }
+
+  void StrawGasStepBuilder::fillMap(Tracker const& tracker, TrackerStatus const* trackerStatus,
+      StepPointMCCollection const& steps, SPSMap& spsmap) const {
+    for (auto const& step : steps) {
+      StrawId const & sid = step.strawId();
+      // Skip straws that can't give signals,
+      if (trackerStatus == 0 || !trackerStatus->noSignal(sid)) {
+	Straw const& straw = tracker.getStraw(sid);
+	double wpos = fabs((step.position()-straw.getMidPoint()).dot(straw.getDirection()));
+	//skip steps that occur in the deadened region near the end of each wire
+	if( wpos <  straw.halfLength()){
+	  // the Ptr key is the SimParticle id
+	  cet::map_vector_key tid(step.simParticle().key());
+	  // create key
+	  SSPair stpair(sid,tid);
+	  // check if this key exists and add it if not
+	  auto ssp = spsmap.emplace(stpair,StepPtrs());
+	  if(ssp.second)ssp.first->second.reserve(_ssize);
+	  ssp.first->second.push_back(&step);
+	}
+      } else if ( _debug>1 ) {
+	std::cout << "No Signal, StrawId " << sid << endl;
+      }
+    }
+  }
+
+  void StrawGasStepBuilder::compressDeltas(SPSMap& spsmap, SimLookup const& sims) const {
+    // first, make some helper maps
+    typedef map< cet::map_vector_key, StrawId > SMap; // map from key to Straw, to test for uniqueness
+    typedef map< cet::map_vector_key, cet::map_vector_key> DMap; // map from delta ray to parent
+    SMap smap;
+    DMap dmap;
+    for(auto isps = spsmap.begin(); isps != spsmap.end(); isps++ ) {
+      auto sid = isps->first.first;
+      auto tid = isps->first.second;
+      // map key to straw
+      auto sp = smap.emplace(tid,sid);
+      if(!sp.second && sp.first->second != sid && sp.first->second.valid())sp.first->second = StrawId(); // Particle already seen in another straw: make invalid to avoid compressing it
+    }
+
+    // loop over particle-straw pairs looking for delta rays
+    auto isps =spsmap.begin();
+    while(isps != spsmap.end()){
+      bool isdelta(false);
+      auto& dsteps = isps->second;
+      auto dkey =isps->first.second;
+      SimParticle const* dsim = sims(dsteps.front()->simParticle());
+      if(dsim == 0)
+	throw cet::exception("SIM")<<"mu2e::StrawGasStepBuilder: No SimParticle found for key " << dkey << endl;
+      // see if this particle is a delta-ray and if it's step is short
+      auto pcode = dsim->creationCode();
+      if(pcode == ProcessCode::eIoni || pcode == ProcessCode::hIoni){
+	// make sure this particle doesnt have a step in any other straw
+	auto ifnd = smap.find(dkey);
+	if(ifnd == smap.end())
+	  throw cet::exception("SIM")<<"mu2e::StrawGasStepBuilder: No SimParticle found for delta key " << dkey << endl;
+	else if(ifnd->second.valid()){ // only compress delta rays without hits in any other straw
+	  // add the lengths of all the steps in this straw
+	  float len(0.0);
+	  for(auto const& istep : dsteps)
+	    len += istep->stepLength();
+	  if(len < _maxDeltaLen){
+	    // short delta ray. flag for combination
+	    isdelta = true;
+	  }
+	}
+      }
+// if this is a delta, map it back to the primary
+      if(isdelta){
+	auto strawid = isps->first.first;
+      // find its parent
+	auto pkey = dsim->parentId();
+	// map it so that potential daughters can map back through this particle even after compression
+	dmap[dkey] = pkey;
+	// find the parent. This must be recursive, as delta rays can come from delta rays (from delta rays...)
+	auto jfnd = dmap.find(pkey);
+	while(jfnd != dmap.end()){
+	  pkey = jfnd->second;
+	  jfnd = dmap.find(pkey);
+	}
+	// now, find the parent back in the original map
+	auto ifnd = spsmap.find(make_pair(strawid,pkey));
+	if(ifnd != spsmap.end()){
+	  if(_debug > 1)cout << "mu2e::StrawGasStepBuilder: SimParticle found for delta parent key " << pkey << " straw " << strawid << endl;
+      // move the contents to the primary
+	  auto& psteps = ifnd->second;
+	  psteps.insert(psteps.end(),dsteps.begin(),dsteps.end());
+	  // erase the delta ray and advance the iterator
+	  isps = spsmap.erase(isps);
+	} else {
+	// there are a very few delta rays whose parents die in the straw walls that cause StepPoints, so this is not an error.  These stay
+	// as uncompressed particles.
+	  if(_debug > 1)cout << "mu2e::StrawGasStepBuilder: No SimParticle found for delta parent key " << pkey << " straw " << strawid << endl;
+	  isps++;
+	}
+      } else
+      // move to the next straw/particle pair
+	isps++;
+    }
+  }
+
+  void StrawGasStepBuilder::setStepType(StepPointMC const& spmc, ParticleData const* pdata, StrawGasStep::StepType& stype) const {
+  // now determine ioniztion and shape
+    int itype, shape;
+    if(pdata->charge() == 0.0){
+      itype = StrawGasStep::StepType::neutral;
+      shape = StrawGasStep::StepType::point;
+    } else {
+      double mom = spmc.momentum().mag();
+      if(mom < _curlmom)
+	shape = StrawGasStep::StepType::curl;
+      else if(mom < _linemom)
+	shape = StrawGasStep::StepType::arc;
+      else
+	shape = StrawGasStep::StepType::line;
+      double mass = pdata->mass();
+      double bg = mom/mass; // betagamma
+      double ke = sqrt(mom*mom + mass*mass)-mass; // kinetic energy
+      if(bg > _minionBG && ke > _minionKE)
+	itype =StrawGasStep::StepType::minion;
+      else
+     	itype =StrawGasStep::StepType::highion;
+    }
+    stype = StrawGasStep::StepType( (StrawGasStep::StepType::Shape)shape,
+	(StrawGasStep::StepType::Ionization)itype );
+  }
+
+}
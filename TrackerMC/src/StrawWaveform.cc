@@ -7,6 +7,8 @@
 //
 #include "TrackerMC/inc/StrawWaveform.hh"
 #include <cmath>
+#include <limits>
+#include <algorithm>
 #include <boost/math/special_functions/binomial.hpp>
 
 using namespace std;
@@ -14,13 +16,46 @@ namespace mu2e {
   using namespace TrkTypes;
   namespace TrackerMC {
     StrawWaveform::StrawWaveform(Straw const& straw, StrawClusterSequence const& hseq, XTalk const& xtalk) :
-      _cseq(hseq), _xtalk(xtalk), _straw(straw)
+      _cseq(hseq), _xtalk(xtalk), _straw(straw), _reference(false), _strawele(0)
     {}
 
     StrawWaveform::StrawWaveform(StrawWaveform const& other) : _cseq(other._cseq),
-    _xtalk(other._xtalk), _straw(other._straw)
+    _xtalk(other._xtalk), _straw(other._straw), _reference(other._reference), _strawele(0)
     {}
 
+    StrawWaveform::StrawWaveform(StrawWaveform const& other, bool reference) : _cseq(other._cseq),
+    _xtalk(other._xtalk), _straw(other._straw), _reference(reference), _strawele(0)
+    {}
+
+    std::vector<StrawElectronics::ClusterResponse> const& StrawWaveform::clusterResponses(StrawElectronics const& strawele, unsigned ipath) const {
+      if(_strawele != &strawele){
+	_strawele = &strawele;
+	_ctime.clear();
+	_tstart.clear();
+	for(auto& cresp : _cresp) cresp.clear();
+	for(auto const& clust : _cseq.clustList()){
+	  _ctime.push_back(clust.time());
+	  _tstart.push_back(clust.time()-strawele.clusterLookbackTime());
+	}
+      }
+      auto& cresp = _cresp[ipath];
+      if(cresp.size() != _ctime.size()){
+	cresp.reserve(_ctime.size());
+	bool forsaturation = ipath == StrawElectronics::npaths;
+	auto path = forsaturation ? StrawElectronics::thresh : static_cast<StrawElectronics::Path>(ipath);
+	for(auto const& clust : _cseq.clustList())
+	  cresp.push_back(strawele.clusterResponse(_straw,path,clust.charge(),clust.wireDistance(),forsaturation));
+      }
+      return cresp;
+    }
+
+    double StrawWaveform::xtalkResponse(double linresp) const {
+      double totresp = linresp * _xtalk._postamp;
+      if(_xtalk._preamp>0.0)
+	totresp += _xtalk._preamp*linresp;
+      return totresp;
+    }
+
     bool StrawWaveform::crossesThreshold(StrawElectronics const& strawele,double threshold,WFX& wfx) const {
       bool retval(false);
       // make sure we start past the input time
@@ -147,6 +182,48 @@ namespace mu2e {
     }
 
     double StrawWaveform::sampleWaveform(StrawElectronics const& strawele,StrawElectronics::Path ipath,double time) const {
+      if(_reference)return sampleWaveformReference(strawele,ipath,time);
+      // loop over all clusts and add their response at this time
+      auto const& cresp = clusterResponses(strawele,ipath);
+      double linresp(0.0);
+      for(size_t iclust=0;iclust < _tstart.size() && _tstart[iclust] < time; ++iclust){
+	// compute the linear straw electronics response to this charge.  This is pre-saturation
+	linresp += strawele.linearResponse(cresp[iclust],time-_ctime[iclust]);
+      }
+      return xtalkResponse(linresp);
+    }
+
+    void StrawWaveform::sampleWaveform(StrawElectronics const& strawele,StrawElectronics::Path ipath,ADCTimes const& times,ADCVoltages& volts) const {
+      volts.clear();
+      volts.reserve(times.size());
+      if(_reference){
+	for(auto time : times)
+	  volts.push_back(sampleWaveformReference(strawele,ipath,time));
+	return;
+      }
+      auto const& cresp = clusterResponses(strawele,ipath);
+      // add each cluster into all the times it contributes to.  A cluster contributes at a time when it
+      // and all the clusters before it start before that time, as for a single sample.  Each time
+      // still sums its clusters in list order, so the result is the same as sampling the times one by one
+      std::vector<double> linresp(times.size(),0.0);
+      double tlast(-std::numeric_limits<double>::max());
+      for(auto time : times) tlast = std::max(tlast,(double)time);
+      double tstart(-std::numeric_limits<double>::max());
+      for(size_t iclust=0;iclust < _tstart.size();++iclust){
+	tstart = std::max(tstart,_tstart[iclust]);
+	if(tstart >= tlast)break;
+	auto const& cr = cresp[iclust];
+	double ctime = _ctime[iclust];
+	for(size_t itime=0;itime<times.size();++itime){
+	  if(tstart < times[itime])
+	    linresp[itime] += strawele.linearResponse(cr,times[itime]-ctime);
+	}
+      }
+      for(auto resp : linresp)
+	volts.push_back(xtalkResponse(resp));
+    }
+
+    double StrawWaveform::sampleWaveformReference(StrawElectronics const& strawele,StrawElectronics::Path ipath,double time) const {
       // loop over all clusts and add their response at this time
       StrawClusterList const& hlist = _cseq.clustList();
       double linresp(0.0);
@@ -164,6 +241,71 @@ namespace mu2e {
     }
 
     void StrawWaveform::sampleADCWaveform(StrawElectronics const& strawele,ADCTimes const& times,ADCVoltages& volts) const {
+      if(_reference){
+        sampleADCWaveformReference(strawele,times,volts);
+        return;
+      }
+      volts.clear();
+      volts.reserve(times.size());
+      if (_xtalk._dest != _xtalk._source){
+        //FIXME doesn't deal with cross talk hits yet
+        for (size_t j=0;j<times.size();j++){
+          volts.push_back(0);
+        }
+        return;
+      }
+
+      // check if going to be saturated
+      double max_possible_voltage = 0;
+      for (auto iclust = _cseq.clustList().begin();iclust != _cseq.clustList().end();++iclust){
+        max_possible_voltage += maxLinearResponse(strawele,iclust);
+      }
+      if (max_possible_voltage > strawele.saturationVoltage()){
+        // create waveform of threshold circuit output
+        // step along waveform and apply saturation
+        // for each time, get contribution from each step in waveform using impulse response
+
+        // skip to the first cluster that matters for the first adc time
+        auto const& cresp = clusterResponses(strawele,StrawElectronics::npaths);
+        size_t iclust(0);
+        while (iclust < _tstart.size()){
+          if (_tstart[iclust] + strawele.truncationTime(StrawElectronics::thresh) > times[0])
+            break;
+          else
+            ++iclust;
+        }
+
+        // step through time
+        for (size_t j=0;j<times.size();j++){
+          volts.push_back(0);
+        }
+        if (iclust == _tstart.size())
+          return;
+
+        int num_steps = (int)ceil((times[times.size()-1]-_ctime[iclust]-strawele.clusterLookbackTime())/strawele.saturationTimeStep());
+
+        for (int i=0;i<num_steps;i++){
+          double time = _tstart[iclust] + i*strawele.saturationTimeStep();
+          // sum up the preamp response at this step
+          double response = 0;
+          for (size_t jclust=iclust;jclust < _tstart.size() && _tstart[jclust] < time;++jclust){
+            response += strawele.linearResponse(cresp[jclust],time-_ctime[jclust]);
+          }
+          // now saturate it
+          double sat_response = strawele.saturatedResponse(response);
+          // then calculate the impulse response at each of the adctimes and add it to that
+          for (size_t j=0;j<times.size();j++){
+            // this function includes multiplication by number of steps in saturationTimeStep
+            volts[j] += strawele.adcImpulseResponse(_straw.id(),times[j]-time,sat_response);
+          }
+        }
+      }else{
+        // all the samples in one pass
+        sampleWaveform(strawele,StrawElectronics::adc,times,volts);
+      }
+    }
+
+    void StrawWaveform::sampleADCWaveformReference(StrawElectronics const& strawele,ADCTimes const& times,ADCVoltages& volts) const {
       volts.clear();
       volts.reserve(times.size());
       if (_xtalk._dest != _xtalk._source){
@@ -198,6 +340,9 @@ namespace mu2e {
         for (size_t j=0;j<times.size();j++){
           volts.push_back(0);
         }
+        // no cluster left: all samples are 0, as in the cached sampling
+        if (iclust == _cseq.clustList().end())
+          return;
 
         int num_steps = (int)ceil((times[times.size()-1]-iclust->time()-strawele.clusterLookbackTime())/strawele.saturationTimeStep());
 
@@ -220,7 +365,7 @@ namespace mu2e {
         }
       }else{
         for(auto itime=times.begin();itime!=times.end();++itime){
-          volts.push_back(sampleWaveform(strawele,StrawElectronics::adc,*itime));
+          volts.push_back(sampleWaveformReference(strawele,StrawElectronics::adc,*itime));
         }
       }
     }
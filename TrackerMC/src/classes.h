@@ -1 +1,3 @@
+#include "canvas/Persistency/Common/Wrapper.h"
 #include "TrackerMC/inc/IonCluster.hh"
+#include "TrackerMC/inc/StrawCluster.hh"
@@ -87,6 +87,9 @@ namespace mu2e {
     event.getByLabel(_kalSeedTag, kalSeedHandle);
     const auto& kalSeeds = *kalSeedHandle;
 
+    // the MVA is evaluated for all selected tracks at once below
+    std::vector<size_t> imva;
+    std::vector<float> mvavars;
     for (const auto& kseed : kalSeeds) {
       TrkCaloHitPID tchpid;
       tchpid.setMVAStatus(MVAStatus::unset);
@@ -121,14 +124,22 @@ namespace mu2e {
 	  // reconstructed as a downstream particle associated to this cluster
 	  if(tchpid[TrkCaloHitPID::DeltaE] < _maxde){
 	    // evaluate the MVA
-	    tchpid.setMVAValue(_tchmva->evalMVA(tchpid.values()));
+	    imva.push_back(tchpcol->size());
+	    mvavars.insert(mvavars.end(),tchpid.values().begin(),tchpid.values().end());
 	    tchpid.setMVAStatus(MVAStatus::calculated);
 	  }
 	}
       }
       tchpcol->push_back(tchpid);
-      rqcol->push_back(RecoQual(tchpid.status(),tchpid.MVAValue()));
     }
+    if(!imva.empty()){
+      std::vector<float> mvaout(imva.size());
+      _tchmva->evalMVA(mvavars.data(),imva.size(),TrkCaloHitPID::n_vars,mvaout.data());
+      for(size_t i=0; i < imva.size(); ++i)
+	(*tchpcol)[imva[i]].setMVAValue(mvaout[i]);
+    }
+    for (const auto& tchpid : *tchpcol)
+      rqcol->push_back(RecoQual(tchpid.status(),tchpid.MVAValue()));
     // put the output products into the event
     event.put(move(tchpcol));
     event.put(move(rqcol));
@@ -94,7 +94,10 @@ namespace mu2e
       trkQualEntry._mvaTool.showMVA();
     }
 
-    // Go through the tracks and calculate their track qualities
+    // Go through the tracks and fill their track quality variables; the MVA is
+    // evaluated for all tracks at once below
+    std::vector<size_t> imva;
+    std::vector<float> mvavars;
     for (const auto& i_kalSeed : kalSeeds) {
       TrkQual trkqual;
 
@@ -142,7 +145,8 @@ namespace mu2e
           trkqual[TrkQual::rmax] = -1*charge*(bestkseg->helix().d0() + 2.0/bestkseg->helix().omega());
 
           trkqual.setMVAStatus(MVAStatus::calculated);
-          trkqual.setMVAValue(trkQualEntry._mvaTool.evalMVA(trkqual.values(), trkQualEntry._mvaMask));
+          imva.push_back(tqcol->size());
+          mvavars.insert(mvavars.end(), trkqual.values().begin(), trkqual.values().end());
 
         }
         else {
@@ -150,7 +154,17 @@ namespace mu2e
         }
       }
       tqcol->push_back(trkqual);
+    }
+
+    if (!imva.empty()) {
+      std::vector<float> mvaout(imva.size());
+      trkQualEntry._mvaTool.evalMVA(mvavars.data(), imva.size(), TrkQual::n_vars, mvaout.data(), trkQualEntry._mvaMask);
+      for (size_t i = 0; i < imva.size(); ++i) {
+        (*tqcol)[imva[i]].setMVAValue(mvaout[i]);
+      }
+    }
 
+    for (const auto& trkqual : *tqcol) {
       // Get the efficiency cut that this track passes
       Float_t passCalib = 0.0; // everything will pass a 100% efficient cut
       if (trkQualEntry._calibrated) {
@@ -8,7 +8,7 @@
 #include "RecoDataProducts/inc/ComboHit.hh"
 // art includes.
 #include "canvas/Persistency/Common/Ptr.h"
-#include "art/Framework/Core/EDProducer.h"
+#include "art/Framework/Core/SharedProducer.h"
 #include "art/Framework/Core/ModuleMacros.h"
 #include "art/Framework/Principal/Event.h"
 #include "art/Framework/Principal/Handle.h"
@@ -30,22 +30,20 @@ using namespace std;
 
 namespace mu2e {
 
-  class CombineStrawHits : public art::EDProducer {
+  class CombineStrawHits : public art::SharedProducer {
 
   public:
-    explicit CombineStrawHits(fhicl::ParameterSet const& pset);
+    explicit CombineStrawHits(fhicl::ParameterSet const& pset, art::ProcessingFrame const& pf);
 
-    void produce( art::Event& e);
+    void produce( art::Event& e, art::ProcessingFrame const& pf) override;
 
   private:
     // utility functions
-    void combineHits(ComboHit& combohit);
+    void combineHits(ComboHit& combohit, ComboHitCollection const& chcol) const;
     // configuration
     int _debug;
     // event object Tags
     art::InputTag _chTag;
-    // input event collection cache
-    const ComboHitCollection* _chcol;
     // Parameters
     bool _testflag; //test flag or not
     bool _testrad; // test position radius
@@ -61,8 +59,8 @@ namespace mu2e {
     StrawIdMask _mask;
   };
 
-  CombineStrawHits::CombineStrawHits(fhicl::ParameterSet const& pset) :
-    art::EDProducer{pset},
+  CombineStrawHits::CombineStrawHits(fhicl::ParameterSet const& pset, art::ProcessingFrame const& pf) :
+    art::SharedProducer{pset},
     // Parameters
     _debug(pset.get<int>("debugLevel",0)),
     _chTag(pset.get<art::InputTag>("ComboHitCollection")),
@@ -85,28 +83,30 @@ namespace mu2e {
     _maxR2 = maxR*maxR;
     consumes<ComboHitCollection>(_chTag);
     produces<ComboHitCollection>();
+    // all state is configuration, so events can be processed concurrently
+    async<art::InEvent>();
   }
 
-  void CombineStrawHits::produce(art::Event& event)
+  void CombineStrawHits::produce(art::Event& event, art::ProcessingFrame const& pf)
   {
     // find event data.  Note I have to get a Handle, not a ValidHandle,
     // as a literal handle is needed to find the productID
     art::Handle<ComboHitCollection> chH;
     if(!event.getByLabel(_chTag, chH))
       throw cet::exception("RECO")<<"mu2e::CombineStrawHits: No ComboHit collection found for tag" <<  _chTag << endl;
-    _chcol = chH.product();
+    ComboHitCollection const& inchcol = *chH.product();
 
     // create output
     auto chcol = std::make_unique<ComboHitCollection>();
-    chcol->reserve(_chcol->size());
+    chcol->reserve(inchcol.size());
     // reference the parent in the new collection
     chcol->setParent(chH);
 
     // sort hits by panel
     std::array<std::vector<uint16_t>,StrawId::_nupanels> panels;
-    size_t nsh = _chcol->size();
+    size_t nsh = inchcol.size();
     for(uint16_t ish=0;ish<nsh;++ish){
-      ComboHit const& ch = (*_chcol)[ish];
+      ComboHit const& ch = inchcol[ish];
       // select hits based on flag
       if((!_testflag) || (ch.flag().hasAllProperties(_shsel) && (!ch.flag().hasAnyProperty(_shmask))) ){
         panels[ch.strawId().uniquePanel()].push_back(ish);
@@ -120,14 +120,14 @@ namespace mu2e {
       for(size_t ihit=0;ihit < phits.size(); ++ihit){
         if(!used[ihit]){
           used[ihit] = true;
-          ComboHit const& hit1 = (*_chcol)[phits[ihit]];
+          ComboHit const& hit1 = inchcol[phits[ihit]];
           // create a combo hit for every hit; initialize it with this hit
           ComboHit combohit;
           combohit.init(hit1,phits[ihit]);
           // loop over other hits in this panel
           for(size_t jhit=ihit+1;jhit < phits.size(); ++jhit){
             if(!used[jhit]){
-              ComboHit const& hit2 = (*_chcol)[phits[jhit]];
+              ComboHit const& hit2 = inchcol[phits[jhit]];
               // require straws be near each other
               int ds = abs( (int)hit1.strawId().straw()-(int)hit2.strawId().straw());
               if(ds > 0 && ds <= _maxds ){
@@ -153,7 +153,7 @@ namespace mu2e {
             } // 2nd hit not used
           } // 2nd panel hit
           // compute floating point info for this combo hit and save it
-          if(combohit.nCombo() > 1)combineHits(combohit);
+          if(combohit.nCombo() > 1)combineHits(combohit,inchcol);
           // radius test
           float r2 = combohit.pos().Perp2();
           bool goodrad = r2 < _maxR2 && r2 > _minR2;
@@ -168,7 +168,7 @@ namespace mu2e {
   }
 
   // compute the properties of this combined hit
-  void CombineStrawHits::combineHits(ComboHit& combohit) {
+  void CombineStrawHits::combineHits(ComboHit& combohit, ComboHitCollection const& chcol) const {
     // if there's only 1 hit, take the info from the orginal collections
     // This is because the boost accumulators sometimes don't work for low stats
     // init from the 0th hit
@@ -189,9 +189,9 @@ namespace mu2e {
       // get back the original information
       size_t index = combohit.index(ich);
       if(_debug > 3)std::cout << index << ", ";
-      if(index > _chcol->size())
+      if(index > chcol.size())
         throw cet::exception("RECO")<<"mu2e::CombineStrawHits: inconsistent index "<< endl;
-      ComboHit const& ch = (*_chcol)[index];
+      ComboHit const& ch = chcol[index];
       combohit._flag.merge(ch.flag());
       eacc(ch.energyDep());
       tacc(ch.time());// time is an unweighted average
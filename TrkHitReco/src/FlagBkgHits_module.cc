@@ -1,6 +1,6 @@
 #include "art/Framework/Principal/Event.h"
 #include "art/Framework/Principal/Handle.h"
-#include "art/Framework/Core/EDProducer.h"
+#include "art/Framework/Core/ReplicatedProducer.h"
 #include "art/Framework/Core/ModuleMacros.h"
 #include "art_root_io/TFileService.h"
 #include "canvas/Utilities/InputTag.h"
@@ -23,6 +23,7 @@
 #include "TrkReco/inc/TNTClusterer.hh"
 #include "TrkReco/inc/ScanClusterer.hh"
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -30,7 +31,7 @@
 namespace mu2e
 {
 
-  class FlagBkgHits : public art::EDProducer
+  class FlagBkgHits : public art::ReplicatedProducer
   {
       public:
           
@@ -59,9 +60,9 @@ namespace mu2e
          };
 
          enum clusterer {TwoNiveauThreshold=1, ComptonKiller=2};
-         explicit FlagBkgHits(const art::EDProducer::Table<Config>& config);
-         void beginJob() override;
-         void produce(art::Event& event) override;        
+         explicit FlagBkgHits(const art::ReplicatedProducer::Table<Config>& config, art::ProcessingFrame const& pf);
+         void beginJob(art::ProcessingFrame const& pf) override;
+         void produce(art::Event& event, art::ProcessingFrame const& pf) override;
 
       private:
          const art::ProductToken<ComboHitCollection> chtoken_;
@@ -71,7 +72,7 @@ namespace mu2e
          bool                                        filter_, flagch_, flagsh_;
          bool                                        savebkg_;
          StrawHitFlag                                bkgmsk_, stereo_;
-         BkgClusterer*                               clusterer_;
+         std::unique_ptr<BkgClusterer>               clusterer_;
          float                                       cperr2_;
          float                                       bkgMVAcut_;
          MVATools                                    bkgMVA_;
@@ -82,15 +83,15 @@ namespace mu2e
          void classifyCluster(BkgClusterCollection& bkgccolFast, BkgClusterCollection& bkgccol, BkgQualCollection& bkgqcol, 
                               StrawHitFlagCollection& chfcol, const ComboHitCollection& chcol) const;
          void fillBkgQual(    const BkgCluster& cluster, BkgQual& cqual, const ComboHitCollection& chcol) const;
-         void fillMVA(        BkgQual& cqual) const;
+         void fillMVA(        std::vector<BkgQual>& cquals) const;
          void countHits(      const BkgCluster& cluster, unsigned& nactive, unsigned& nstereo, const ComboHitCollection& chcol) const;
          void countPlanes(    const BkgCluster& cluster, BkgQual& cqual, const ComboHitCollection& chcol) const;
          int  findClusterIdx( BkgClusterCollection& bkgccol, unsigned ich) const;
   };
 
 
-  FlagBkgHits::FlagBkgHits(const art::EDProducer::Table<Config>& config) :
-     art::EDProducer{config},
+  FlagBkgHits::FlagBkgHits(const art::ReplicatedProducer::Table<Config>& config, art::ProcessingFrame const& pf) :
+     art::ReplicatedProducer{config,pf},
      chtoken_{     consumes<ComboHitCollection>(config().comboHitCollection()) },
      shtoken_{     consumes<StrawHitCollection>(config().strawHitCollection()) },
      minnhits_(    config().minActiveHits() ),
@@ -126,10 +127,10 @@ namespace mu2e
       switch ( ctype )
       {
         case TwoNiveauThreshold:
-           clusterer_ = new TNTClusterer(config().TNTClustering());
+           clusterer_ = std::make_unique<TNTClusterer>(config().TNTClustering());
            break;
         case ComptonKiller:
-           clusterer_ = new ScanClusterer(config().ScanClustering());
+           clusterer_ = std::make_unique<ScanClusterer>(config().ScanClustering());
            break;
        default:
            throw cet::exception("RECO")<< "Unknown clusterer" << ctype << std::endl;
@@ -137,7 +138,7 @@ namespace mu2e
   }
 
 
-  void FlagBkgHits::beginJob()
+  void FlagBkgHits::beginJob(art::ProcessingFrame const& pf)
   {
       clusterer_->init();
       bkgMVA_.initMVA();
@@ -145,7 +146,7 @@ namespace mu2e
 
 
   //------------------------------------------------------------------------------------------
-  void FlagBkgHits::produce(art::Event& event )
+  void FlagBkgHits::produce(art::Event& event, art::ProcessingFrame const& pf)
   {
     
      //unsigned iev=event.event();
@@ -263,11 +264,14 @@ namespace mu2e
          for (const auto& chit : cluster.hits()) chfcol[chit] = flag;
       }      
       
-      for (auto& cluster : bkgccol)
+      std::vector<BkgQual> cquals(bkgccol.size());
+      for (size_t ic=0; ic < bkgccol.size(); ++ic) fillBkgQual(bkgccol[ic], cquals[ic], chcol);
+      fillMVA(cquals);
+
+      for (size_t ic=0; ic < bkgccol.size(); ++ic)
       {                
-           BkgQual cqual;
-           fillBkgQual(cluster, cqual, chcol);
-           fillMVA(cqual);
+           auto& cluster = bkgccol[ic];
+           BkgQual& cqual = cquals[ic];
 
            StrawHitFlag flag(StrawHitFlag::bkgclust);
            if (cqual.MVAOutput() > bkgMVAcut_)
@@ -323,22 +327,35 @@ namespace mu2e
   
   
   //----------------------------------------------
-  void FlagBkgHits::fillMVA(BkgQual& cqual) const
+  void FlagBkgHits::fillMVA(std::vector<BkgQual>& cquals) const
   {
-       if (cqual.status() == MVAStatus::unset) return;
-
-       std::vector<float> mvavars(7,0.0);
-       mvavars[0] = cqual.varValue(BkgQual::crho);
-       mvavars[1] = cqual.varValue(BkgQual::zmin);
-       mvavars[2] = cqual.varValue(BkgQual::zmax);
-       mvavars[3] = cqual.varValue(BkgQual::zgap);
-       mvavars[4] = cqual.varValue(BkgQual::np);
-       mvavars[5] = cqual.varValue(BkgQual::npfrac);
-       mvavars[6] = cqual.varValue(BkgQual::nhits);
-       float mvaout = bkgMVA_.evalMVA(mvavars);
-
-       cqual.setMVAValue(mvaout);
-       cqual.setMVAStatus(MVAStatus::calculated);
+       // evaluate all the clusters with a filled quality in one call
+       constexpr size_t nvars = 7;
+       std::vector<size_t> icquals;
+       std::vector<float> mvavars;
+       for (size_t ic=0; ic < cquals.size(); ++ic)
+       {
+          const BkgQual& cqual = cquals[ic];
+          if (cqual.status() == MVAStatus::unset) continue;
+          icquals.push_back(ic);
+          mvavars.push_back(cqual.varValue(BkgQual::crho));
+          mvavars.push_back(cqual.varValue(BkgQual::zmin));
+          mvavars.push_back(cqual.varValue(BkgQual::zmax));
+          mvavars.push_back(cqual.varValue(BkgQual::zgap));
+          mvavars.push_back(cqual.varValue(BkgQual::np));
+          mvavars.push_back(cqual.varValue(BkgQual::npfrac));
+          mvavars.push_back(cqual.varValue(BkgQual::nhits));
+       }
+       if (icquals.empty()) return;
+
+       std::vector<float> mvaout(icquals.size());
+       bkgMVA_.evalMVA(mvavars.data(),icquals.size(),nvars,mvaout.data());
+
+       for (size_t i=0; i < icquals.size(); ++i)
+       {
+          cquals[icquals[i]].setMVAValue(mvaout[i]);
+          cquals[icquals[i]].setMVAStatus(MVAStatus::calculated);
+       }
    }
 
 
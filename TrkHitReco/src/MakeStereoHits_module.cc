@@ -6,7 +6,7 @@
 //  
 
 #include "canvas/Persistency/Common/Ptr.h"
-#include "art/Framework/Core/EDProducer.h"
+#include "art/Framework/Core/ReplicatedProducer.h"
 #include "art/Framework/Core/ModuleMacros.h"
 #include "art/Framework/Principal/Event.h"
 #include "art/Framework/Principal/Handle.h"
@@ -31,6 +31,8 @@
 #include <boost/accumulators/statistics/min.hpp>
 using namespace boost::accumulators;
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <float.h>
 using namespace std;
@@ -50,12 +52,13 @@ namespace {
 }
 
 namespace mu2e {
-  class MakeStereoHits : public art::EDProducer {
+  class MakeStereoHits : public art::ReplicatedProducer {
     public:
-      explicit MakeStereoHits(fhicl::ParameterSet const& pset);
-      void produce( art::Event& e);
-      virtual void beginJob();
-      virtual void beginRun(art::Run & run);
+      explicit MakeStereoHits(fhicl::ParameterSet const& pset, art::ProcessingFrame const& pf);
+      void produce( art::Event& e, art::ProcessingFrame const& pf) override;
+      void beginJob(art::ProcessingFrame const& pf) override;
+      void beginRun(art::Run const& run, art::ProcessingFrame const& pf) override;
+      void endJob(art::ProcessingFrame const& pf) override;
     private:
       typedef std::vector<uint16_t> ComboHits;
 
@@ -63,7 +66,6 @@ namespace mu2e {
       art::InputTag  _shTag;
       art::InputTag  _chTag;
       art::InputTag  _shfTag;
-      ComboHitCollection const* _chcol;
 
       StrawHitFlag   _shsel;      // flag selection
       StrawHitFlag   _shmask;     // flag anti-selection 
@@ -85,12 +87,26 @@ namespace mu2e {
       StereoMVA _vmva; 
 
       std::array<std::vector<StrawId>,StrawId::_nupanels > _panelOverlap;   // which panels overlap each other
+      bool _mapInit; // overlap map is filled
+      // selected hits sorted by unique panel, then by time; the hits of panel ipan are
+      // _shits[_pbegin[ipan]] to _shits[_pbegin[ipan+1]-1], with times in _stimes
+      std::vector<uint16_t> _shits;
+      std::vector<float> _stimes;
+      std::array<size_t,StrawId::_nupanels+1> _pbegin;
+      std::vector<uint16_t> _cands; // candidate partner hits inside the time window
       void genMap();    
-      void finalize(ComboHit& combohit);
+      void sortHits(ComboHitCollection const& chcol);
+      float hitTime(ComboHit const& ch) const { return _useTOT ? ch.correctedTime() : ch.time(); }
+      void finalize(ComboHit& combohit, ComboHitCollection const& chcol) const;
+      void testPair(ComboHit& combohit, uint16_t jhit, ComboHitCollection const& chcol, std::vector<bool>& used) const;
+      bool _checkPairSearch; // also run the original search over all hits and compare
+      void checkPairSearch(ComboHitCollection const& chcol, ComboHitCollection const& inchcol);
+      double _searchTime, _checkTime; // accumulated time (seconds) of the pair search and the check, with CheckPairSearch
+      unsigned _nevents;
   };
 
-  MakeStereoHits::MakeStereoHits(fhicl::ParameterSet const& pset) :
-    art::EDProducer{pset},
+  MakeStereoHits::MakeStereoHits(fhicl::ParameterSet const& pset, art::ProcessingFrame const& pf) :
+    art::ReplicatedProducer{pset,pf},
     _debug(pset.get<int>(           "debugLevel",0)),
     _chTag(pset.get<art::InputTag>("ComboHitCollection")),
     _shsel(pset.get<std::vector<std::string> >("StrawHitSelectionBits",std::vector<std::string>{"EnergySelection","TimeSelection"} )),
@@ -108,7 +124,10 @@ namespace mu2e {
     _testflag(pset.get<bool>("TestFlag")),
     _smask("uniquepanel"),  // define the mask to select hits in the same unique panel
 
-    _mvatool(pset.get<fhicl::ParameterSet>("MVATool",fhicl::ParameterSet()))
+    _mvatool(pset.get<fhicl::ParameterSet>("MVATool",fhicl::ParameterSet())),
+    _mapInit(false),
+    _checkPairSearch(pset.get<bool>("CheckPairSearch",false)),
+    _searchTime(0.0), _checkTime(0.0), _nevents(0)
     {
       float minR = pset.get<float>("minimumRadius",395); // mm
       _minR2 = minR*minR;
@@ -117,7 +136,7 @@ namespace mu2e {
       produces<ComboHitCollection>();
     }
 
-  void MakeStereoHits::beginJob()
+  void MakeStereoHits::beginJob(art::ProcessingFrame const& pf)
   {
     if(_doMVA){
       _mvatool.initMVA();    
@@ -126,115 +145,208 @@ namespace mu2e {
     }
   }
 
-  void MakeStereoHits::beginRun(art::Run & run)
+  void MakeStereoHits::endJob(art::ProcessingFrame const& pf)
+  {
+    if(_checkPairSearch && _nevents > 0)
+      std::cout << "MakeStereoHits pair search: " << 1e6*_searchTime/_nevents << " us/event, original search "
+	<< 1e6*_checkTime/_nevents << " us/event over " << _nevents << " events" << std::endl;
+  }
+
+  void MakeStereoHits::beginRun(art::Run const& run, art::ProcessingFrame const& pf)
   {
     genMap();
   }
 
-  void MakeStereoHits::produce(art::Event& event) {
+  void MakeStereoHits::produce(art::Event& event, art::ProcessingFrame const& pf) {
 // find input: I have to get a Handle, not ValidHandle, to get the productID
     art::Handle<ComboHitCollection> chH;
     if(!event.getByLabel(_chTag, chH))
       throw cet::exception("RECO")<<"mu2e::MakeStereoHits: No ComboHit collection found for tag" <<  _chTag << endl;
-    _chcol = chH.product();
+    ComboHitCollection const& inchcol = *chH.product();
     // setup output
     std::unique_ptr<ComboHitCollection> chcol(new ComboHitCollection());
-    chcol->reserve(_chcol->size());
+    chcol->reserve(inchcol.size());
     // reference the parent in the new collection
     chcol->setParent(chH);
-    // sort hits by unique panel.  This should be built in by construction upstream FIXME!!
-    std::array<std::vector<uint16_t>,StrawId::_nupanels> phits;
-    size_t nch = _chcol->size();
+    size_t nch = inchcol.size();
     if(_debug > 1)cout << "MakeStereoHits found " << nch << " Input hits" << endl;
-    std::vector<bool> used(nch,false);
-    for(uint16_t ihit=0;ihit<nch;++ihit){
-      ComboHit const& ch = (*_chcol)[ihit];
-      // select hits based on flag
-      if( (!_testflag) ||( ch.flag().hasAllProperties(_shsel) && (!ch.flag().hasAnyProperty(_shmask))) ){
-	phits[ch.strawId().uniquePanel()].push_back(ihit);
-      }
-    }
+    sortHits(inchcol);
     if(_debug > 2){
       for (unsigned ipan=0; ipan < StrawId::_nupanels; ++ipan) {
-	if(phits[ipan].size() > 0 ){
-	  cout << "Panel " << ipan << " has " << phits[ipan].size() << " hits "<< endl;
+	if(_pbegin[ipan+1] > _pbegin[ipan]){
+	  cout << "Panel " << ipan << " has " << _pbegin[ipan+1]-_pbegin[ipan] << " hits "<< endl;
 	}
       }
     }
+    // the search is only timed when it is checked
+    std::chrono::steady_clock::time_point t0;
+    if(_checkPairSearch) t0 = std::chrono::steady_clock::now();
+    std::vector<bool> used(nch,false);
     //  Loop over all hits.  Every one must appear somewhere in the output 
     for (size_t ihit=0;ihit<nch;++ihit) {
       if(used[ihit])continue;
       used[ihit] = true;
       // create an output combo hit for every hit; initialize it with this hit
-      ComboHit const& ch1 = (*_chcol)[ihit];
+      ComboHit const& ch1 = inchcol[ihit];
       ComboHit combohit;
       combohit.init(ch1,ihit);
       // zero values that accumulate in pairs
       combohit._qual = 0.0;
       combohit._pos = XYZVec(0.0,0.0,0.0);
+      // the time window is slightly widened so that rounding never drops a pair accepted by the dt test below
+      float t1 = hitTime(ch1);
+      float tlo = static_cast<float>(double(t1) - 1.001*_maxDt);
+      float thi = static_cast<float>(double(t1) + 1.001*_maxDt);
       // loop over the panels which overlap this hit's panel
       for (auto sid : _panelOverlap[ch1.strawId().uniquePanel()]) {
-      // loop over hits in the overlapping panel
-	for (auto jhit : phits[sid.uniquePanel()]) {
-	  const ComboHit& ch2 = (*_chcol)[jhit];
-	  if(_debug > 3) cout << " comparing hits " << ch1.strawId().uniquePanel() << " and " << ch2.strawId().uniquePanel();
-	  if (!used[jhit] ){
-            float dt;
-            if (_useTOT)
-	      dt = fabs(ch1.correctedTime()-ch2.correctedTime());
-            else
-	      dt = fabs(ch1.time()-ch2.time());
-	    if(_debug > 3) cout << " dt = " << dt;
-	    if (dt < _maxDt){
-	      float ddot = ch1.wdir().Dot(ch2.wdir());
-	      XYZVec dp = ch1.pos()-ch2.pos();
-	      float dperp = sqrt(dp.perp2());
-	      // negative crosings are in opposite quadrants and longitudinal separation isn't too big
-	      if(_debug > 3) cout << " ddot = " << ddot << " dperp = " << dperp;
-	      if (ddot > _minDdot && dperp < _maxDPerp ) {
-		// solve for the POCA.
-		TwoLinePCA_XYZ pca(ch1.pos(),ch1.wdir(),ch2.pos(),ch2.wdir());
-		if(pca.closeToParallel()){  
-		  cet::exception("RECO")<<"mu2e::StereoHit: parallel wires" << std::endl;
-		}
-		// check the points are inside the tracker active volume; these are all the same as the
-		float rho2 = pca.point1().Perp2();
-		if(_debug > 3) cout << " rho2 = " << rho2;
-		if(rho2 < _maxR2 && rho2 > _minR2 ){
-		  // compute chisquared; include error for particle angle
-		  // should be a cumulative linear regression FIXME!
-		  float terr = _tfac*fabs(ch1.pos().z()-ch2.pos().z());
-		  float terr2 = terr*terr;
-		  float dw1 = pca.s1();
-		  float dw2 = pca.s2();
-		  float chisq = dw1*dw1/(ch1.wireErr2()+terr2) + dw2*dw2/(ch2.wireErr2()+terr2);
-		  if(_debug > 3) cout << " chisq = " << chisq;
-		  if (chisq < _maxChisq){
-		    if(_debug > 3) cout << " added ";
-		    // if we get to here, try to add the hit
-		    // accumulate the chisquared
-		    if(combohit.addIndex(jhit)) {
-		      // average z 
-		      combohit._qual += chisq;
-		      combohit._pos += XYZVec(pca.point1().x(),pca.point1().y(),0.5*(pca.point1().z()+pca.point2().z()));	    
-		    } else
-		      std::cout << "MakeStereoHits can't add hit" << std::endl;
-		    used[jhit] = true;
-		  }	
-		}
-	      }
-	    }
-	  }
-	  if(_debug > 3) cout << endl;
+	// select the hits in the overlapping panel inside the time window, then test them in index order
+	uint16_t upan = sid.uniquePanel();
+	auto tbegin = _stimes.begin();
+	auto ilo = std::lower_bound(tbegin+_pbegin[upan],tbegin+_pbegin[upan+1],tlo);
+	auto ihi = std::upper_bound(ilo,tbegin+_pbegin[upan+1],thi);
+	_cands.clear();
+	for (auto it = ilo; it != ihi; ++it) {
+	  uint16_t jhit = _shits[it-tbegin];
+	  if (!used[jhit]) _cands.push_back(jhit);
 	}
+	std::sort(_cands.begin(),_cands.end());
+	for (auto jhit : _cands) testPair(combohit,jhit,inchcol,used);
       }
-      finalize(combohit);
+      finalize(combohit,inchcol);
       chcol->push_back(std::move(combohit));
     }
+    if(_checkPairSearch){
+      auto t1 = std::chrono::steady_clock::now();
+      _searchTime += std::chrono::duration<double>(t1-t0).count();
+      ++_nevents;
+      checkPairSearch(*chcol,inchcol);
+    }
     event.put(std::move(chcol));
   } 
 
-  void MakeStereoHits::finalize(ComboHit& combohit) {
+  // order the selected hits by unique panel (counting sort, keeping the index order) and then by time
+  void MakeStereoHits::sortHits(ComboHitCollection const& chcol) {
+    size_t nch = chcol.size();
+    _pbegin.fill(0);
+    _shits.clear();
+    for(uint16_t ihit=0;ihit<nch;++ihit){
+      ComboHit const& ch = chcol[ihit];
+      // select hits based on flag
+      if( (!_testflag) ||( ch.flag().hasAllProperties(_shsel) && (!ch.flag().hasAnyProperty(_shmask))) ){
+	_shits.push_back(ihit);
+	++_pbegin[ch.strawId().uniquePanel()+1];
+      }
+    }
+    for (size_t ipan=0; ipan < StrawId::_nupanels; ++ipan) _pbegin[ipan+1] += _pbegin[ipan];
+    std::array<size_t,StrawId::_nupanels> pfill;
+    std::copy(_pbegin.begin(),_pbegin.end()-1,pfill.begin());
+    _cands.resize(_shits.size());
+    for (auto ihit : _shits) _cands[pfill[chcol[ihit].strawId().uniquePanel()]++] = ihit;
+    _shits.swap(_cands);
+    auto byTime = [this,&chcol](uint16_t i, uint16_t j) { return hitTime(chcol[i]) < hitTime(chcol[j]); };
+    for (size_t ipan=0; ipan < StrawId::_nupanels; ++ipan)
+      std::stable_sort(_shits.begin()+_pbegin[ipan],_shits.begin()+_pbegin[ipan+1],byTime);
+    _stimes.resize(_shits.size());
+    for (size_t i=0; i < _shits.size(); ++i) _stimes[i] = hitTime(chcol[_shits[i]]);
+  }
+
+  // test if hit jhit forms a stereo pair with the first hit of combohit, and if so add it
+  void MakeStereoHits::testPair(ComboHit& combohit, uint16_t jhit, ComboHitCollection const& chcol, std::vector<bool>& used) const {
+    const ComboHit& ch1 = chcol[combohit.index(0)];
+    const ComboHit& ch2 = chcol[jhit];
+    if(_debug > 3) cout << " comparing hits " << ch1.strawId().uniquePanel() << " and " << ch2.strawId().uniquePanel();
+    float dt = fabs(hitTime(ch1)-hitTime(ch2));
+    if(_debug > 3) cout << " dt = " << dt;
+    if (dt < _maxDt){
+      float ddot = ch1.wdir().Dot(ch2.wdir());
+      XYZVec dp = ch1.pos()-ch2.pos();
+      float dperp = sqrt(dp.perp2());
+      // negative crosings are in opposite quadrants and longitudinal separation isn't too big
+      if(_debug > 3) cout << " ddot = " << ddot << " dperp = " << dperp;
+      if (ddot > _minDdot && dperp < _maxDPerp ) {
+	// solve for the POCA.
+	TwoLinePCA_XYZ pca(ch1.pos(),ch1.wdir(),ch2.pos(),ch2.wdir());
+	if(pca.closeToParallel()){  
+	  cet::exception("RECO")<<"mu2e::StereoHit: parallel wires" << std::endl;
+	}
+	// check the points are inside the tracker active volume; these are all the same as the
+	float rho2 = pca.point1().Perp2();
+	if(_debug > 3) cout << " rho2 = " << rho2;
+	if(rho2 < _maxR2 && rho2 > _minR2 ){
+	  // compute chisquared; include error for particle angle
+	  // should be a cumulative linear regression FIXME!
+	  float terr = _tfac*fabs(ch1.pos().z()-ch2.pos().z());
+	  float terr2 = terr*terr;
+	  float dw1 = pca.s1();
+	  float dw2 = pca.s2();
+	  float chisq = dw1*dw1/(ch1.wireErr2()+terr2) + dw2*dw2/(ch2.wireErr2()+terr2);
+	  if(_debug > 3) cout << " chisq = " << chisq;
+	  if (chisq < _maxChisq){
+	    if(_debug > 3) cout << " added ";
+	    // if we get to here, try to add the hit
+	    // accumulate the chisquared
+	    if(combohit.addIndex(jhit)) {
+	      // average z 
+	      combohit._qual += chisq;
+	      combohit._pos += XYZVec(pca.point1().x(),pca.point1().y(),0.5*(pca.point1().z()+pca.point2().z()));	    
+	    } else
+	      std::cout << "MakeStereoHits can't add hit" << std::endl;
+	    used[jhit] = true;
+	  }	
+	}
+      }
+    }
+    if(_debug > 3) cout << endl;
+  }
+
+  // rebuild the stereo hits with the original search, which tests every selected hit of the overlapping
+  // panels, and throw if the result differs from the time-ordered search
+  void MakeStereoHits::checkPairSearch(ComboHitCollection const& chcol, ComboHitCollection const& inchcol) {
+    auto t0 = std::chrono::steady_clock::now();
+    size_t nch = inchcol.size();
+    std::array<std::vector<uint16_t>,StrawId::_nupanels> phits;
+    for(uint16_t ihit=0;ihit<nch;++ihit){
+      ComboHit const& ch = inchcol[ihit];
+      if( (!_testflag) ||( ch.flag().hasAllProperties(_shsel) && (!ch.flag().hasAnyProperty(_shmask))) )
+	phits[ch.strawId().uniquePanel()].push_back(ihit);
+    }
+    ComboHitCollection refcol;
+    refcol.reserve(nch);
+    std::vector<bool> used(nch,false);
+    for (size_t ihit=0;ihit<nch;++ihit) {
+      if(used[ihit])continue;
+      used[ihit] = true;
+      ComboHit const& ch1 = inchcol[ihit];
+      ComboHit combohit;
+      combohit.init(ch1,ihit);
+      combohit._qual = 0.0;
+      combohit._pos = XYZVec(0.0,0.0,0.0);
+      for (auto sid : _panelOverlap[ch1.strawId().uniquePanel()]) {
+	for (auto jhit : phits[sid.uniquePanel()]) {
+	  if(!used[jhit]) testPair(combohit,jhit,inchcol,used);
+	}
+      }
+      finalize(combohit,inchcol);
+      refcol.push_back(std::move(combohit));
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    _checkTime += std::chrono::duration<double>(t1-t0).count();
+    if(refcol.size() != chcol.size())
+      throw cet::exception("RECO")<<"mu2e::MakeStereoHits: pair search made " << chcol.size()
+	<< " hits, original search " << refcol.size() << std::endl;
+    for(size_t ich=0;ich < chcol.size(); ++ich){
+      ComboHit const& ch = chcol[ich];
+      ComboHit const& ref = refcol[ich];
+      bool same = ch.nCombo() == ref.nCombo() && ch._qual == ref._qual && ch._pos == ref._pos
+	&& ch._time == ref._time && ch._flag == ref._flag;
+      for(size_t ic=0; same && ic < ch.nCombo(); ++ic) same = ch.index(ic) == ref.index(ic);
+      if(!same)
+	throw cet::exception("RECO")<<"mu2e::MakeStereoHits: stereo hit " << ich
+	  << " differs from the original search" << std::endl;
+    }
+  }
+
+  void MakeStereoHits::finalize(ComboHit& combohit, ComboHitCollection const& chcol) const {
     combohit._mask = _smask;
     if(combohit.nCombo() > 1){
       combohit._flag.merge(StrawHitFlag::stereo);
@@ -248,7 +360,7 @@ namespace mu2e {
       combohit._nsh = 0;
       for(size_t ich = 0; ich < combohit.nCombo(); ++ich){
 	size_t index = combohit.index(ich);
-	ComboHit const& ch = (*_chcol)[index];
+	ComboHit const& ch = chcol[index];
 	combohit._flag.merge(ch.flag());
 	eacc(ch.energyDep(),weight=ch.nStrawHits());
 	tacc(ch.time(),weight=ch.nStrawHits());
@@ -273,15 +385,15 @@ namespace mu2e {
       combohit._wdir = XYZVec(0.0,0.0,1.0);
     } else {
       size_t index = combohit.index(0);
-      combohit._pos = (*_chcol)[index].pos();// put back original position
+      combohit._pos = chcol[index].pos();// put back original position
     }
   }
 
   // generate the overlap map
   void MakeStereoHits::genMap() {
-    static bool init(false);
-    if(!init){
-      init = true;
+    // each module instance (one per schedule) fills its own copy
+    if(!_mapInit){
+      _mapInit = true;
       // initialize
       const Tracker& tt(*GeomHandle<Tracker>());
       // establihit the extent of a panel using the longest straw (0)
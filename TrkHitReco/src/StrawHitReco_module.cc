@@ -8,10 +8,11 @@
 #include "art/Framework/Principal/Event.h"
 #include "art/Framework/Principal/Handle.h"
 #include "GeometryService/inc/GeomHandle.hh"
-#include "art/Framework/Core/EDProducer.h"
+#include "art/Framework/Core/ReplicatedProducer.h"
 #include "GeometryService/inc/DetectorSystem.hh"
 #include "art/Framework/Core/ModuleMacros.h"
 #include "art_root_io/TFileService.h"
+#include "art/Utilities/Globals.h"
 
 // conditions
 #include "ProditionsService/inc/ProditionsHandle.hh"
@@ -45,7 +46,7 @@
 namespace mu2e {
   using namespace TrkTypes;
 
-  class StrawHitReco : public art::EDProducer {
+  class StrawHitReco : public art::ReplicatedProducer {
     public:
       using Name=fhicl::Name;
       using Comment=fhicl::Comment;
@@ -71,11 +72,11 @@ namespace mu2e {
 	fhicl::Atom<art::InputTag> pbttoken{ Name("ProtonBunchTimeTag"), Comment("ProtonBunchTime producer")};
       };
 
-      using Parameters = art::EDProducer::Table<Config>;
-      explicit StrawHitReco(Parameters const& config);
-      void produce( art::Event& e) override;
-      void beginRun( art::Run& run ) override;
-      void beginJob() override;
+      using Parameters = art::ReplicatedProducer::Table<Config>;
+      explicit StrawHitReco(Parameters const& config, art::ProcessingFrame const& pf);
+      void produce( art::Event& e, art::ProcessingFrame const& pf) override;
+      void beginRun( art::Run const& run, art::ProcessingFrame const& pf) override;
+      void beginJob(art::ProcessingFrame const& pf) override;
 
 
     private:
@@ -116,8 +117,8 @@ namespace mu2e {
       ProditionsHandle<Tracker> _alignedTracker_h;
   };
 
-  StrawHitReco::StrawHitReco(Parameters const& config) :
-    art::EDProducer{config},
+  StrawHitReco::StrawHitReco(Parameters const& config, art::ProcessingFrame const& pf) :
+    art::ReplicatedProducer{config,pf},
     _fittype((TrkHitReco::FitType) config().fittype()),
     _usecc(config().usecc()),
     _clusterDt(config().clusterDt()),
@@ -143,10 +144,13 @@ namespace mu2e {
       produces<ComboHitCollection>();
       if(_writesh)produces<StrawHitCollection>();
       if (_printLevel > 0) std::cout << "In StrawHitReco constructor " << std::endl;
+      // each schedule has its own copy of this module; histograms can't be shared between them
+      if (_diagLevel > 0 && art::Globals::instance()->nschedules() > 1)
+        throw cet::exception("CONFIG")<<"StrawHitReco: diagLevel > 0 requires a single schedule" << std::endl;
   }
 
   //------------------------------------------------------------------------------------------
-  void StrawHitReco::beginJob()
+  void StrawHitReco::beginJob(art::ProcessingFrame const& pf)
   {
     if(_diagLevel > 0){
       art::ServiceHandle<art::TFileService> tfs;
@@ -154,7 +158,7 @@ namespace mu2e {
     }
   }
 
-  void StrawHitReco::beginRun(art::Run& run)
+  void StrawHitReco::beginRun(art::Run const& run, art::ProcessingFrame const& pf)
   {
       auto const& srep = _strawResponse_h.get(run.id());
 // set cache for peak-ped calculation (default)
@@ -172,7 +176,7 @@ namespace mu2e {
   }
 
   //------------------------------------------------------------------------------------------
-  void StrawHitReco::produce(art::Event& event)
+  void StrawHitReco::produce(art::Event& event, art::ProcessingFrame const& pf)
   {
       if (_printLevel > 0) std::cout << "In StrawHitReco produce " << std::endl;
 
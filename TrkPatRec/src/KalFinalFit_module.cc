@@ -8,9 +8,10 @@
 #include "art/Framework/Principal/Event.h"
 #include "fhiclcpp/ParameterSet.h"
 #include "art/Framework/Principal/Handle.h"
-#include "art/Framework/Core/EDProducer.h"
+#include "art/Framework/Core/ReplicatedProducer.h"
 #include "art/Framework/Core/ModuleMacros.h"
 #include "art_root_io/TFileService.h"
+#include "art/Utilities/Globals.h"
 #include "art/Utilities/make_tool.h"
 // conditions
 #include "ProditionsService/inc/ProditionsHandle.hh"
@@ -67,14 +68,14 @@ namespace mu2e
 {
   using namespace KalFinalFitTypes;
 
-  class KalFinalFit : public art::EDProducer
+  class KalFinalFit : public art::ReplicatedProducer
   {
   public:
-    explicit KalFinalFit(fhicl::ParameterSet const&);
+    explicit KalFinalFit(fhicl::ParameterSet const&, art::ProcessingFrame const&);
     virtual ~KalFinalFit();
-    void beginRun(art::Run& aRun);
+    void beginRun(art::Run const& aRun, art::ProcessingFrame const&) override;
   private:
-    void produce(art::Event& event) override;
+    void produce(art::Event& event, art::ProcessingFrame const&) override;
 
     unsigned _iev;
     // configuration parameters
@@ -126,8 +127,8 @@ namespace mu2e
     // flow diagnostic
   };
 
-  KalFinalFit::KalFinalFit(fhicl::ParameterSet const& pset) :
-    art::EDProducer{pset},
+  KalFinalFit::KalFinalFit(fhicl::ParameterSet const& pset, art::ProcessingFrame const& pf) :
+    art::ReplicatedProducer{pset,pf},
     _debug(pset.get<int>("debugLevel", 0)),
     _diag(pset.get<int>("diagLevel",0)),
     _printfreq(pset.get<int>("printFrequency", 101)),
@@ -164,6 +165,9 @@ namespace mu2e
     _data.result    = &_result;
 
     if (_diag != 0) {
+      // the diagnostic histograms would be booked once per schedule under the same names
+      if (art::Globals::instance()->nschedules() > 1)
+        throw cet::exception("CONFIG")<<"mu2e::KalFinalFit: diagLevel != 0 requires a single schedule"<< endl;
       _hmanager = art::make_tool<ModuleHistToolBase>(pset.get<fhicl::ParameterSet>("diagPlugin"));
       fhicl::ParameterSet ps1 = pset.get<fhicl::ParameterSet>("KalFit.DoubletAmbigResolver");
       _data.dar               = new DoubletAmbigResolver(ps1,0,0,0);
@@ -186,7 +190,7 @@ namespace mu2e
     }
   }
 //-----------------------------------------------------------------------------
-  void KalFinalFit::beginRun(art::Run& r) {
+  void KalFinalFit::beginRun(art::Run const& r, art::ProcessingFrame const&) {
     mu2e::GeomHandle<mu2e::Calorimeter> ch;
     _data.calorimeter = ch.get();
 
@@ -195,7 +199,7 @@ namespace mu2e
   }
 
 
-  void KalFinalFit::produce(art::Event& event ) {
+  void KalFinalFit::produce(art::Event& event, art::ProcessingFrame const&) {
 
     auto srep = _strawResponse_h.getPtr(event.id());
     auto detmodel = _mu2eDetector_h.getPtr(event.id());
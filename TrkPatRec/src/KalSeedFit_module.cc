@@ -11,10 +11,11 @@
 #include "art/Framework/Principal/Event.h"
 #include "fhiclcpp/ParameterSet.h"
 #include "art/Framework/Principal/Handle.h"
-#include "art/Framework/Core/EDProducer.h"
+#include "art/Framework/Core/ReplicatedProducer.h"
 #include "GeometryService/inc/DetectorSystem.hh"
 #include "art/Framework/Core/ModuleMacros.h"
 #include "art_root_io/TFileService.h"
+#include "art/Utilities/Globals.h"
 #include "art/Utilities/make_tool.h"
 // conditions
 #include "ConditionsService/inc/ConditionsHandle.hh"
@@ -75,13 +76,13 @@ namespace mu2e
   using namespace KalSeedFitTypes;
 
 
-  class KalSeedFit : public art::EDProducer
+  class KalSeedFit : public art::ReplicatedProducer
   {
   public:
-    explicit KalSeedFit(fhicl::ParameterSet const&);
+    explicit KalSeedFit(fhicl::ParameterSet const&, art::ProcessingFrame const&);
     virtual ~KalSeedFit();
-    virtual void beginRun(art::Run&);
-    virtual void produce(art::Event& event );
+    void beginRun(art::Run const&, art::ProcessingFrame const&) override;
+    void produce(art::Event& event, art::ProcessingFrame const&) override;
   private:
     unsigned _iev;
     // configuration parameters
@@ -134,8 +135,8 @@ namespace mu2e
     void findMissingHits(KalFitData&kalData);
   };
 
-  KalSeedFit::KalSeedFit(fhicl::ParameterSet const& pset) :
-    art::EDProducer{pset},
+  KalSeedFit::KalSeedFit(fhicl::ParameterSet const& pset, art::ProcessingFrame const& pf) :
+    art::ReplicatedProducer{pset,pf},
     _debug(pset.get<int>("debugLevel",0)),
     _diag(pset.get<int>("diagLevel",0)),
     _printfreq(pset.get<int>("printFrequency",101)),
@@ -181,13 +182,18 @@ namespace mu2e
     _data.result    = &_result;
 
 
-    if (_diag != 0) _hmanager = art::make_tool<ModuleHistToolBase>(pset.get<fhicl::ParameterSet>("diagPlugin"));
+    if (_diag != 0) {
+      // the diagnostic tool histograms are not replicated per schedule
+      if (art::Globals::instance()->nschedules() > 1)
+        throw cet::exception("CONFIG")<<"mu2e::KalSeedFit: diagLevel != 0 requires a single schedule"<< endl;
+      _hmanager = art::make_tool<ModuleHistToolBase>(pset.get<fhicl::ParameterSet>("diagPlugin"));
+    }
     else            _hmanager = std::make_unique<ModuleHistToolBase>();
   }
 
   KalSeedFit::~KalSeedFit(){}
 
-  void KalSeedFit::beginRun(art::Run& run){
+  void KalSeedFit::beginRun(art::Run const& run, art::ProcessingFrame const&){
     // calculate the helicity
     GeomHandle<BFieldManager> bfmgr;
     GeomHandle<DetectorSystem> det;
@@ -208,7 +214,7 @@ namespace mu2e
     _helicity = Helicity(static_cast<float>(_fdir.dzdt()*_amsign));
   }
 
-  void KalSeedFit::produce(art::Event& event ) {
+  void KalSeedFit::produce(art::Event& event, art::ProcessingFrame const&) {
 
     auto srep = _strawResponse_h.getPtr(event.id());
     auto detmodel = _mu2eDetector_h.getPtr(event.id());
@@ -10,9 +10,10 @@
 #include "fhiclcpp/types/Atom.h"
 #include "fhiclcpp/types/Sequence.h"
 #include "art/Framework/Principal/Handle.h"
-#include "art/Framework/Core/EDProducer.h"
+#include "art/Framework/Core/ReplicatedProducer.h"
 #include "art/Framework/Core/ModuleMacros.h"
 #include "art_root_io/TFileService.h"
+#include "art/Utilities/Globals.h"
 #include "GeneralUtilities/inc/Angles.hh"
 #include "Mu2eUtilities/inc/MVATools.hh"
 
@@ -103,7 +104,7 @@ namespace {
 namespace mu2e {
 
   
-  class RobustHelixFinder : public art::EDProducer {
+  class RobustHelixFinder : public art::ReplicatedProducer {
   public:
 
     struct Config
@@ -151,11 +152,11 @@ namespace mu2e {
       fhicl::Atom<bool>                     UpdateStereo{         Name("UpdateStereo"),         Comment("Update Stereo") };
     };
 
-    explicit RobustHelixFinder(const art::EDProducer::Table<Config>& config);
+    explicit RobustHelixFinder(const art::ReplicatedProducer::Table<Config>& config, art::ProcessingFrame const& pf);
     virtual ~RobustHelixFinder();
-    virtual void beginJob();
-    virtual void beginRun(art::Run&   run   );
-    virtual void produce(art::Event& event );
+    void beginJob(art::ProcessingFrame const& pf) override;
+    void beginRun(art::Run const& run, art::ProcessingFrame const& pf) override;
+    void produce(art::Event& event, art::ProcessingFrame const& pf) override;
 
   private:
     int                                 _diag,_debug;
@@ -231,8 +232,8 @@ namespace mu2e {
     void     updateHelixZPhiInfo(RobustHelixFinderData& helixData);
   };
   
-  RobustHelixFinder::RobustHelixFinder(const art::EDProducer::Table<Config>& config):
-     art::EDProducer{config},
+  RobustHelixFinder::RobustHelixFinder(const art::ReplicatedProducer::Table<Config>& config, art::ProcessingFrame const& pf):
+     art::ReplicatedProducer{config,pf},
     _diag        (config().diagLevel()),
     _debug       (config().debugLevel()),
     _printfreq   (config().printFrequency()),
@@ -279,21 +280,26 @@ namespace mu2e {
 	produces<HelixSeedCollection>(Helicity::name(hel));
       }
 
-      if (_diag != 0) _hmanager = art::make_tool<ModuleHistToolBase>(config().DiagPlugin," ");
+      if (_diag != 0) {
+	// every schedule has its own instance; they would all book the same histograms
+	if (art::Globals::instance()->nschedules() > 1)
+	  throw cet::exception("CONFIG")<<"RobustHelixFinder: DiagLevel != 0 requires a single schedule" << std::endl;
+	_hmanager = art::make_tool<ModuleHistToolBase>(config().DiagPlugin," ");
+      }
       else            _hmanager = std::make_unique<ModuleHistToolBase>();
     }
   
   RobustHelixFinder::~RobustHelixFinder(){}
 
   //-----------------------------------------------------------------------------
-  void RobustHelixFinder::beginRun(art::Run& ) {
+  void RobustHelixFinder::beginRun(art::Run const&, art::ProcessingFrame const&) {
     mu2e::GeomHandle<mu2e::Calorimeter> ch;
 
     _hfit.setCalorimeter(ch.get());
   }
   //--------------------------------------------------------------------------------
 
-  void RobustHelixFinder::beginJob() {
+  void RobustHelixFinder::beginJob(art::ProcessingFrame const&) {
 
     _stmva.initMVA();
     _nsmva.initMVA();
@@ -315,7 +321,7 @@ namespace mu2e {
     }
   }
 
-  void RobustHelixFinder::produce(art::Event& event ) {
+  void RobustHelixFinder::produce(art::Event& event, art::ProcessingFrame const&) {
       
     _tracker = _alignedTracker_h.getPtr(event.id()).get();
     _hfit.setTracker    (_tracker);
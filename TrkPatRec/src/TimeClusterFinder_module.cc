@@ -8,15 +8,17 @@
 #include "art/Framework/Principal/Event.h"
 #include "fhiclcpp/ParameterSet.h"
 #include "art/Framework/Principal/Handle.h"
-#include "art/Framework/Core/EDProducer.h"
+#include "art/Framework/Core/ReplicatedProducer.h"
 #include "art/Framework/Core/ModuleMacros.h"
 #include "art_root_io/TFileService.h"
+#include "art/Utilities/Globals.h"
 // Mu2e
 #include "GeneralUtilities/inc/Angles.hh"
 #include "Mu2eUtilities/inc/MVATools.hh"
 #include "Mu2eUtilities/inc/polyAtan2.hh"
 // data
 #include "RecoDataProducts/inc/ComboHit.hh"
+#include "RecoDataProducts/inc/ComboHitSoA.hh"
 #include "RecoDataProducts/inc/StrawHitFlag.hh"
 #include "RecoDataProducts/inc/TimeCluster.hh"
 #include "RecoDataProducts/inc/CaloCluster.hh"
@@ -65,7 +67,7 @@ namespace {
 
 namespace mu2e {
    
-  class TimeClusterFinder : public art::EDProducer
+  class TimeClusterFinder : public art::ReplicatedProducer
   {  
     public:
        
@@ -105,10 +107,10 @@ namespace mu2e {
             fhicl::Atom<int>                        debugLevel             {Name("debugLevel"),             Comment("Debut Level"), 0 }; 
         };
 
-        explicit TimeClusterFinder(const art::EDProducer::Table<Config>& config);
+        explicit TimeClusterFinder(const art::ReplicatedProducer::Table<Config>& config, art::ProcessingFrame const& pf);
 
-        void beginJob() override;
-        void produce(art::Event& e) override;
+        void beginJob(art::ProcessingFrame const& pf) override;
+        void produce(art::Event& e, art::ProcessingFrame const& pf) override;
 
     
     private:
@@ -121,6 +123,8 @@ namespace mu2e {
        const art::ProductToken<CaloClusterCollection>  _ccToken;      
        const StrawHitFlagCollection* _shfcol;
        const ComboHitCollection*     _chcol;
+       ComboHitSoA                   _chsoa; // columnar copy of _chcol, refilled for each event
+       std::vector<float>            _htimes; // hit times corrected for time of flight, for all the hits of _chcol
        const CaloClusterCollection*  _cccol;
        StrawHitFlag                  _hsel;
        StrawHitFlag                  _hbkg;
@@ -145,6 +149,7 @@ namespace mu2e {
        int                           _debug;    
        TH1F                          _timespec;
        TimeCluMVA                    _pmva; // input variables to TMVA for cluster cleaning
+       std::vector<float>            _mvavars, _mvaout; // batch MVA input and output for cluster refinement
 
 
       void findClusters(TimeClusterCollection& tccol);
@@ -163,8 +168,8 @@ namespace mu2e {
   };
 
   
-  TimeClusterFinder::TimeClusterFinder(const art::EDProducer::Table<Config>& config) :
-     art::EDProducer{config},
+  TimeClusterFinder::TimeClusterFinder(const art::ReplicatedProducer::Table<Config>& config, art::ProcessingFrame const& pf) :
+     art::ReplicatedProducer{config,pf},
      _chToken      { consumes<ComboHitCollection>(      config().comboHitCollection()) },
      _shfToken     { mayConsume<StrawHitFlagCollection>(config().strawHitFlagCollection()) },
      _ccToken      { mayConsume<CaloClusterCollection>( config().caloClusterCollection()) },
@@ -197,10 +202,14 @@ namespace mu2e {
     {
         unsigned nbins = (unsigned)rint((_tmax-_tmin)/_tbin);
         _timespec = TH1F("timespec","time spectrum",nbins,_tmin,_tmax);
+        // the spectrum is private working space of this instance: keep it out of the ROOT directory
+        _timespec.SetDirectory(nullptr);
         produces<TimeClusterCollection>();
+        if (_debug > 2 && art::Globals::instance()->nschedules() > 1)
+          throw cet::exception("CONFIG")<<"TimeClusterFinder: time spectrum histograms (debugLevel > 2) require a single schedule" << endl;
     }
 
-  void TimeClusterFinder::beginJob() {
+  void TimeClusterFinder::beginJob(art::ProcessingFrame const& pf) {
     _tcMVA.initMVA();
     _tcCaloMVA.initMVA();
     if (_debug > 0)
@@ -214,13 +223,16 @@ namespace mu2e {
 
 
   //--------------------------------------------------------------------------------------------------------------
-  void TimeClusterFinder::produce(art::Event & event ){
+  void TimeClusterFinder::produce(art::Event & event, art::ProcessingFrame const& pf){
     _iev = event.id().event();
 
     if (_debug > 0 && (_iev%_printfreq)==0) std::cout<<"TimeClusterFinder: event="<<_iev<<std::endl;
 
     auto const& chH = event.getValidHandle(_chToken);
     _chcol = chH.product();
+    _chsoa.fill(*_chcol);
+    // the hit times are used repeatedly; compute them once per event
+    _ttcalc.comboHitTimes(_chsoa,_pitch,_htimes);
 
     art::Handle<CaloClusterCollection> ccH{}; // need to cache for later Ptr creation 
     if(_usecc){
@@ -309,11 +321,10 @@ namespace mu2e {
   //--------------------------------------------------------------------------------------------------------------
   void TimeClusterFinder::fillTimeSpectrum() {
     _timespec.Reset();
+    auto const& nsh = _chsoa.nStrawHits();
     for (unsigned istr=0; istr<_chcol->size();++istr) {
       if (_testflag && !goodHit((*_shfcol)[istr])) continue;
-      ComboHit const& ch = (*_chcol)[istr];
-      float time = _ttcalc.comboHitTime((*_chcol)[istr],_pitch);
-      _timespec.Fill(time,ch.nStrawHits());
+      _timespec.Fill(_htimes[istr],nsh[istr]);
     }
   }
 
@@ -321,8 +332,7 @@ namespace mu2e {
   // assign hits to the closest time peak
     for(size_t istr=0; istr<_chcol->size(); ++istr) {
       if ((!_testflag) || goodHit((*_shfcol)[istr])) {
-	ComboHit const& ch =(*_chcol)[istr];
-	float time = _ttcalc.comboHitTime(ch,_pitch);
+	float time = _htimes[istr];
 	float mindt(1e5);
 	auto besttc = tccol.end();
 	// find the closest seed (if any)
@@ -391,7 +401,7 @@ namespace mu2e {
       unsigned nsh = ch.nStrawHits();
       tc._nsh += nsh;
       const XYZVec& pos = ch.pos();
-      float htime = _ttcalc.comboHitTime(ch,_pitch);
+      float htime = _htimes[ish];
       float hwt = ch.nStrawHits();
       tmin(htime);
       tmax(htime);
@@ -454,7 +464,7 @@ namespace mu2e {
 	if ((!_testflag) || goodHit((*_shfcol)[ich])) {
 	  if(std::find(tc._strawHitIdxs.begin(),tc._strawHitIdxs.end(),ich) == tc._strawHitIdxs.end()){
 	    ComboHit const& ch = (*_chcol)[ich];
-	    float cht = _ttcalc.comboHitTime(ch,_pitch);
+	    float cht = _htimes[ich];
 	    _pmva._dt = fabs(cht - tc._t0._t0);
 	    if(_pmva._dt < _maxdt+tc._t0._t0err){
 	      float phi = polyAtan2(ch.pos().y(), ch.pos().x());//ch.phi();
@@ -490,7 +500,7 @@ namespace mu2e {
     float denom = float(tc._nsh - nsh);
     // update time cluster properties 
     if(!tc.hasCaloCluster()){
-      float cht = _ttcalc.comboHitTime(ch,_pitch);
+      float cht = _htimes[*iworst];
       float newt0  = (tc._t0._t0*tc._nsh - cht*nsh)/denom;
       tc._t0._t0err = sqrt((tc._t0._t0err*tc._t0._t0err*tc._nsh - (cht-newt0)*(cht-tc._t0._t0)*nsh )/denom);
       tc._t0._t0 = newt0;
@@ -508,7 +518,7 @@ namespace mu2e {
     float denom = float(tc._nsh + nsh);
     // update time cluster properties 
     if(!tc.hasCaloCluster()){
-      float cht = _ttcalc.comboHitTime(ch,_pitch);
+      float cht = _htimes[iadd];
       float newt0  = (tc._t0._t0*tc._nsh + cht*nsh)/denom;
       tc._t0._t0err = sqrt((tc._t0._t0err*tc._t0._t0err*tc._nsh + (cht-newt0)*(cht-tc._t0._t0)*nsh )/denom);
       tc._t0._t0 = newt0;
@@ -527,7 +537,7 @@ namespace mu2e {
     for(StrawHitIndex ish : tc._strawHitIdxs) {
       ComboHit const& ch = (*_chcol)[ish];
       float hwt = ch.nStrawHits();
-      float cht = _ttcalc.comboHitTime(ch,_pitch);
+      float cht = _htimes[ish];
       terr(cht,weight=hwt);
       xacc(ch.pos().x(),weight=hwt);
       yacc(ch.pos().y(),weight=hwt);
@@ -549,16 +559,16 @@ namespace mu2e {
   } 
 
   void TimeClusterFinder::refineCluster(TimeCluster& tc) {
-    // mva filtering; remove worst hit iteratively
+    // mva filtering; remove worst hit iteratively. All the hits of the cluster are evaluated in one MVA call
+    const size_t nvars = _pmva._pars.size();
     bool changed = true;
     while (changed) {
       changed = false;
-      auto iworst = tc._strawHitIdxs.end();
-      float worstmva(100.0);
       float pphi = polyAtan2(tc._pos.y(), tc._pos.x());
+      _mvavars.clear();
       for (auto ips=tc._strawHitIdxs.begin();ips != tc._strawHitIdxs.end();++ips) {
         ComboHit const& ch = (*_chcol)[*ips];
-        float cht = _ttcalc.comboHitTime(ch,_pitch);
+        float cht = _htimes[*ips];
 
         _pmva._dt = fabs(cht - tc._t0._t0);
         float phi = polyAtan2(ch.pos().y(), ch.pos().x());//ch.phi();
@@ -569,15 +579,22 @@ namespace mu2e {
 	_pmva._plane = ch.strawId().plane();
 	_pmva._werr = ch.wireRes();
 	_pmva._wdist = fabs(ch.wireDist());
+	_mvavars.insert(_mvavars.end(),_pmva._pars.begin(),_pmva._pars.end());
+      }
 
-	float mvaout(-1.0);
-	if (tc.hasCaloCluster())
-	   mvaout = _tcCaloMVA.evalMVA(_pmva._pars);
-	else
-	  mvaout = _tcMVA.evalMVA(_pmva._pars);
-	if (mvaout < worstmva) {
-	  worstmva = mvaout;
-	  iworst = ips;
+      const size_t nhits = tc._strawHitIdxs.size();
+      _mvaout.resize(nhits);
+      if (tc.hasCaloCluster())
+	_tcCaloMVA.evalMVA(_mvavars.data(),nhits,nvars,_mvaout.data());
+      else
+	_tcMVA.evalMVA(_mvavars.data(),nhits,nvars,_mvaout.data());
+
+      auto iworst = tc._strawHitIdxs.end();
+      float worstmva(100.0);
+      for (size_t ih=0;ih < nhits;++ih) {
+	if (_mvaout[ih] < worstmva) {
+	  worstmva = _mvaout[ih];
+	  iworst = tc._strawHitIdxs.begin()+ih;
         }
       }
 
@@ -0,0 +1,49 @@
+#! /bin/bash
+#
+# Measure the event throughput of the multi-threaded tracker reconstruction
+# (TrkPatRec/test/TrkRecoMT.fcl) as a function of the number of threads.
+#
+# Usage: trkRecoScaling.sh <digi file> [nevents] [max threads]
+#
+# For each thread count the job is run once with a single event, to measure
+# the startup cost, and once with nevents; the throughput is computed from the
+# difference so that geometry and conditions initialization are not included.
+# The number of schedules is set equal to the number of threads.
+# Run on a pileup (mixed) digi sample to get a representative load.
+#
+
+input=${1:?"Usage: $0 <digi file> [nevents] [max threads]"}
+nevents=${2:-500}
+maxthreads=${3:-$(nproc)}
+fcl=TrkPatRec/test/TrkRecoMT.fcl
+
+runjob() {
+  local nthreads=$1
+  local nev=$2
+  local log=trkRecoScaling_${nthreads}_${nev}.log
+  local tstart=$(date +%s.%N)
+  mu2e -c $fcl -s $input -n $nev --nthreads $nthreads --nschedules $nthreads > $log 2>&1
+  local ret=$?
+  local tend=$(date +%s.%N)
+  if [ $ret -ne 0 ]; then
+    echo "mu2e failed with status $ret for $nthreads threads; see $log" >&2
+    exit $ret
+  fi
+  echo "$tend - $tstart" | bc -l
+}
+
+# thread counts: powers of 2, plus the maximum
+counts=""
+n=1
+while [ $n -lt $maxthreads ]; do counts="$counts $n"; n=$((n*2)); done
+counts="$counts $maxthreads"
+
+printf "%8s %12s %12s %10s\n" threads "time(s)" "events/s" speedup
+base=""
+for nthreads in $counts; do
+  tinit=$(runjob $nthreads 1) || exit 1
+  tfull=$(runjob $nthreads $nevents) || exit 1
+  rate=$(echo "($nevents-1)/($tfull-$tinit)" | bc -l)
+  if [ -z "$base" ]; then base=$rate; fi
+  printf "%8d %12.2f %12.2f %10.2f\n" $nthreads $(echo "$tfull-$tinit" | bc -l) $rate $(echo "$rate/$base" | bc -l)
+done
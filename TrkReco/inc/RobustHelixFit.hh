@@ -19,6 +19,9 @@
 
 #include "Mu2eUtilities/inc/MedianCalculator.hh"
 
+#include <utility>
+#include <vector>
+
 //using namespace ROOT::Math::VectorUtil;
 
 namespace mu2e 
@@ -96,6 +99,8 @@ namespace mu2e
       
       fhicl::Atom<unsigned> ntripleMin{fhicl::Name("ntripleMin"), fhicl::Comment("minimum number of triplets")};
       fhicl::Atom<unsigned> ntripleMax{fhicl::Name("ntripleMax"), fhicl::Comment("maximum number of triplets")};
+      fhicl::Atom<unsigned> maxTripletTests{fhicl::Name("maxTripletTests"), fhicl::Comment("maximum number of triplets tested; with more usable hits the triplets are sampled randomly (0 = test all)"), 0};
+      fhicl::Atom<unsigned> tripletSampleSeed{fhicl::Name("tripletSampleSeed"), fhicl::Comment("seed of the random triplet sampling, reused for every fit"), 1};
       fhicl::Atom<bool> use_initFZ_from_dzFrequency{fhicl::Name("use_initFZ_from_dzFrequency"), fhicl::Comment("use initFZ from dz frequency")};
       fhicl::Atom<float> initFZMinLambda{fhicl::Name("initFZMinLambda"), fhicl::Comment("init FZ minimum lambda")};
       fhicl::Atom<float> initFZMaxLambda{fhicl::Name("initFZMaxLambda"), fhicl::Comment("init FZ maximum lambda")};
@@ -163,6 +168,41 @@ namespace mu2e
     bool stereo(ComboHit const&) const;
     void setOutlier(ComboHit&) const;
 
+    // circle through a hit triplet; returns false if the triplet fails the selection
+    bool tripletCircle(XYWVec const& p1, XYWVec const& p2, XYWVec const& p3, float dist2ij, bool forceTargetCon,
+		       float& cx, float& cy, float& rho, float& area2) const;
+
+    // state of a hit entering the circle triplets
+    struct CircleHit {
+      bool  _use;
+      int   _face;
+      float _x, _y, _wt;
+      bool samePosition(CircleHit const& other) const {
+	return _face == other._face && _x == other._x && _y == other._y && _wt == other._wt; }
+    };
+    // accepted triplet: hit indices, circle center and radius, and weight
+    struct Triplet {
+      uint16_t _i1, _i2, _i3;
+      float    _cx, _cy, _rho, _wt;
+    };
+    void updateTriplets(RobustHelixFinderData& helixData, bool forceTargetCon, bool useTripleAreaWt);
+    void scanTriplets(RobustHelixFinderData& helixData, bool forceTargetCon, bool useTripleAreaWt, int s1, int s2, int s3);
+
+    // state of a hit entering the phi-z lambda histogram
+    struct FZHit {
+      bool     _use;
+      uint16_t _face;
+      float    _z;
+      float    _hphi;
+      bool operator ==(FZHit const& other) const {
+	return _use == other._use && _face == other._face && _z == other._z && _hphi == other._hphi; }
+      bool operator !=(FZHit const& other) const { return !(*this == other); }
+    };
+    // histogram bin of a hit pair, or fzSkip if the pair doesn't enter, or fzStop if it ends the row of its first hit
+    enum { fzSkip = -1, fzStop = -2 };
+    int  fzPairBin(FZHit const& hit1, FZHit const& hit2, Helicity const& helicity, float dzdphisign) const;
+    void updateFZHist(RobustHelixFinderData& helixData, Helicity const& helicity, float dzdphisign);
+
     static float deltaPhi(float phi1, float phi2);
     void initPhi(ComboHit& hh, RobustHelix const& myhel) const;
     bool resolvePhi(ComboHit& hh, RobustHelix const& myhel) const;
@@ -221,6 +261,38 @@ namespace mu2e
     unsigned _fitFZNBins;
     float    _fitFZMinL, _fitFZMaxL, _fitFZStepL;
     MedianCalculator  _medianCalculator;
+    unsigned _maxTripletTests; // maximum # of triplets tested in the circle fit (0 = all)
+    unsigned _tripletSampleSeed; // seed of the triplet sampling
+
+    // scratch space, reused across calls and events so that the fits don't allocate once it has grown
+    struct Scratch {
+      MedianCalculator accx, accy, accr, acci, accage;
+      std::vector<std::pair<float,float> > radii;
+      std::vector<unsigned> usedHits;
+      // triplets accepted by the last exhaustive circle fit, in the order they were found, and the
+      // hit states they were found with.  If hits have only been removed since, the triplets with
+      // removed hits are dropped and the search resumes after the last triplet tested
+      std::vector<Triplet>   triplets;
+      std::vector<CircleHit> circHits;
+      std::vector<char>      circRemoved;
+      int                    circNext[3] = {0,0,0}; // next triplet to test
+      bool                   circDone = false;      // all the triplets were tested
+      bool                   circTargetCon = false, circAreaWt = false;
+      bool                   circValid = false;
+      std::vector<int> initFZHist, dzHist, dzHistSum;
+      // lambda histogram of fitFZ.  The pairs of each first hit are scanned in order until a pair
+      // below the lambda range, as in a full refill; a row is rescanned only if one of the hits it
+      // scanned changed since the last call, e.g. by outlier filtering or a new phi loop
+      std::vector<int>     fzHist;
+      std::vector<FZHit>   fzHits;    // hit states the histogram was filled with
+      std::vector<int16_t> fzPairBin; // bin filled by each hit pair [i*nhits+j] (i<j), -1 if none
+      std::vector<int>     fzRowEnd;  // last second hit scanned in the row of each first hit
+      std::vector<int>     fzNChanged; // number of changed hits before each index
+      int                  fzNPairs = 0;
+      int                  fzHelicity = 0;
+      bool                 fzValid = false;
+    };
+    Scratch _scratch;
   };
 }
 #endif
@@ -81,6 +81,8 @@ namespace mu2e {
                                std::vector<BkgHit>& hinfo, float tbin);
           unsigned formClusters(const ComboHitCollection& chcol, std::vector<BkgCluster>& clusters, float tbin, 
                                 std::vector<BkgHit>& hinfo, arrayVecBkg& hitIndex);
+          void     closestBucket(const ComboHit& hit, const std::vector<BkgCluster>& clusters, float tbin, 
+                                 const arrayVecBkg& hitIndex, int& minc, float& mindist) const;
           void     mergeClusters(std::vector<BkgCluster>& clusters, const ComboHitCollection& chcol, 
                                  std::vector<BkgHit>& hinfo, float dt, float dd2);
           void     mergeTwoClu(BkgCluster& clu1, BkgCluster& clu2 );
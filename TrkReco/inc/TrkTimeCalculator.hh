@@ -14,6 +14,7 @@
 #include "RecoDataProducts/inc/TimeCluster.hh"
 #include "RecoDataProducts/inc/HelixSeed.hh"
 #include "RecoDataProducts/inc/ComboHit.hh"
+#include "RecoDataProducts/inc/ComboHitSoA.hh"
 #include "RecoDataProducts/inc/TrkFitDirection.hh"
 #include "RecoDataProducts/inc/HelixSeed.hh"
 #include "BTrk/TrkBase/TrkErrCode.hh"
@@ -56,6 +57,8 @@ namespace mu2e
        double caloClusterTimeErr() const { return _caloTimeErr; }
        // same for a ComboHit
        double comboHitTime(ComboHit const& ch,double pitch);
+       // same for all the hits of a collection, from its columnar view
+       void comboHitTimes(ComboHitSoA const& soa,double pitch,std::vector<float>& times) const;
        // calculate the t0 for a calo cluster.
        double caloClusterTime(CaloCluster const& cc,double pitch) const;
 
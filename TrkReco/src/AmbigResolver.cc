@@ -10,6 +10,8 @@
 #include "BTrk/TrkBase/TrkPoca.hh"
 #include "BTrk/difAlgebra/DifPoint.hh"
 #include "BTrk/difAlgebra/DifVector.hh"
+#include <memory>
+#include <typeinfo>
 #include <vector>
 #include <algorithm>
 #include <functional>
@@ -51,11 +53,15 @@ namespace mu2e {
       // back off one
       if(first != sites.begin())--first;
       if(last == sites.end())--last;
-// create a trajectory from the fit which excludes this set of hits
-// Use of static is memory-efficient but not threadsafe FIXME!!!
-      static TrkSimpTraj* straj = krep->seed()->clone();
-      if(krep->smoothedTraj(first,last,straj)){
-	retval = straj;
+// create a trajectory from the fit which excludes this set of hits.
+// One scratch trajectory per thread; smoothedTraj overwrites its parameters, so it is
+// only cloned again if the seed is of another type.  The result is valid until the
+// next call on the same thread
+      thread_local std::unique_ptr<TrkSimpTraj> straj;
+      if(!straj || typeid(*straj) != typeid(*krep->seed()))
+	straj.reset(krep->seed()->clone());
+      if(krep->smoothedTraj(first,last,straj.get())){
+	retval = straj.get();
       } 
     }
 //  Otherwise, use the reference traj at the center of these hits
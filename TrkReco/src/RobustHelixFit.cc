@@ -21,6 +21,8 @@
 // #include "Math/VectorUtil.h"
 // #include "Math/Vector2D.h"
 //c++
+#include <algorithm>
+#include <random>
 #include <vector>
 #include <utility>
 #include <string>
@@ -87,8 +89,12 @@ namespace mu2e
     _initFZStepL(config.initFZStepLambda()),
     _fitFZMinL(config.fitFZMinLambda()),
     _fitFZMaxL(config.fitFZMaxLambda()),
-    _fitFZStepL(config.fitFZStepLambda())
+    _fitFZStepL(config.fitFZStepLambda()),
+    _maxTripletTests(config.maxTripletTests()),
+    _tripletSampleSeed(config.tripletSampleSeed())
   { 
+    // _hphi is scratch space owned by this fitter, not by the current ROOT directory
+    _hphi.SetDirectory(nullptr);
     _maxdphi=_minzsep/_initFZMinL;
     float minarea(config.minArea());
     _minarea2    = minarea*minarea;
@@ -101,6 +107,9 @@ namespace mu2e
       _initFZFrequencyNMaxPeaks       = config.initFZFrequencyNMaxPeaks();
       _initFZFrequencyTolerance       = config.initFZFrequencyTolerance();
     }
+    _scratch.accx.reserve(_ntripleMax+1);
+    _scratch.accy.reserve(_ntripleMax+1);
+    _scratch.accr.reserve(_ntripleMax+1);
   }
 
   RobustHelixFit::~RobustHelixFit()
@@ -296,7 +305,8 @@ namespace mu2e
     // float          minX(30);
     // float          maxX(530);
     // float          stepX(20);
-    int            hist[_initFZNBins] = {0};
+    std::vector<int>& hist = _scratch.initFZHist;
+    hist.assign(_initFZNBins,0);
     // int            nbins(25);
     int            wg      = 1;
     unsigned       counter = 0;
@@ -836,8 +846,10 @@ namespace mu2e
 
     // make initial estimate of dfdz using 'nearby' pairs.  This insures they are on the same loop
     // need to define an array of a given length 
-    std::vector<int> hist(_initFZFrequencyArraySize);
-    std::vector<int> hist_sum(_initFZFrequencyArraySize);
+    std::vector<int>& hist = _scratch.dzHist;
+    std::vector<int>& hist_sum = _scratch.dzHistSum;
+    hist.assign(_initFZFrequencyArraySize,0);
+    hist_sum.assign(_initFZFrequencyArraySize,0);
     float            bin_size(16.);//mm
     float            start_dz(0);
     float            dzdphisign(0);
@@ -955,8 +967,7 @@ namespace mu2e
     // float          minX(10);
     // float          maxX(510);//500
     // float          stepX(4); //10
-    int            hist[_fitFZNBins] = {0};// 49
-    // int            nbins(125);     // 49
+    const std::vector<int>& hist = _scratch.fzHist;
 
     //iterate over lambda and loop resolution
     unsigned niter(0);
@@ -965,47 +976,9 @@ namespace mu2e
       {
 	changed = false;
 
-	ComboHit*      hitP1(0), *hitP2(0);
-	uint16_t       facezF1(0), facezF2(0);
-        int            nHits(HelixData._chHitsToProcess.size());
-	int            wg  = 1;
-	int            counter = 0;
-
-	//reset the array
-	for (unsigned i=0; i<_fitFZNBins; ++i) hist[i]=0;
-
-	for (int f1=0; f1<nHits-1; ++f1){
-	  hitP1 = &HelixData._chHitsToProcess[f1];
-	  if (!use(*hitP1))                               continue;
-	  facezF1 = hitP1->strawId().uniqueFace();
-
-	  for (int f2=f1+1; f2<nHits; ++f2){
-	    hitP2 = &HelixData._chHitsToProcess[f2];
-	    facezF2 = hitP2->strawId().uniqueFace();
-
-	    if (!use(*hitP2) || (facezF1 == facezF2) )    continue;
-		
-	    float dz   = hitP2->pos().z() - hitP1->pos().z();//facezF2->z - facezF1->z;
-	    float dphi = hitP2->helixPhi()- hitP1->helixPhi(); 
-	    if (fabs(dphi) < _mindphi)          continue;
-  
-	    float lambda = dz/dphi;
-	    if(goodLambda(rhel.helicity(),lambda)){
-	      
-	      int bin = (lambda*dzdphisign-_fitFZMinL)/_fitFZStepL;
-	      if (lambda*dzdphisign >= _fitFZMaxL) {
-		continue;
-	      }
-	      else if (lambda*dzdphisign <= _fitFZMinL){
-		break;
-	      }
-	      hist[bin] += wg;
-	      counter += 1;
-	    }
-	      //	    }
-		
-	  }//end secondloop over faces 
-	}//end first loop over faces
+	ComboHit*      hitP1(0);
+	updateFZHist(HelixData,rhel.helicity(),dzdphisign);
+	int            counter = _scratch.fzNPairs;
 
 	float       swmax(0), sw(0), xmp(0);
 	unsigned    binsToIntegrate(10);
@@ -1039,7 +1012,8 @@ namespace mu2e
 	  printf("[RobustHelixFinder::fitFZ:PEAK_SEARCH]   lambda = %1.1f\n", rhel._lambda);
 	}
 	// now extract intercept.  Here we solve for the difference WRT the previous value
-	MedianCalculator acci(HelixData._chHitsToProcess.size());
+	MedianCalculator& acci = _scratch.acci;
+	acci.clear();
 
 	for (unsigned i=0; i<HelixData._chHitsToProcess.size(); ++i){ 
 	  hitP1 = &HelixData._chHitsToProcess[i];
@@ -1100,99 +1074,23 @@ namespace mu2e
   // simple median fit.  No initialization required
   void RobustHelixFit::fitCircleMedian(RobustHelixFinderData& HelixData, bool forceTargetCon, bool useTripleAreaWt) 
   {
-    const float mind2 = _mindist*_mindist;
-    const float maxd2 = _maxdist*_maxdist;
-      
     // ComboHitCollection& hhits = HelixData._hseed._hhits;
     RobustHelix* rhel         = &HelixData._hseed._helix;
-    MedianCalculator   accx(_ntripleMax), accy(_ntripleMax), accr(_ntripleMax);
-    // loop over all triples
-    unsigned      ntriple(0);
- 
-    ComboHit*     hitP1(0), *hitP2(0), *hitP3(0);
-    int           facezP1(-1), facezP2(-1), facezP3(-1);
-    int           nHits(HelixData._chHitsToProcess.size());
-
-    for (int f1=0; f1<nHits-2; ++f1){
-      hitP1 = &HelixData._chHitsToProcess[f1];
-      if (!use(*hitP1) )                          continue;
-      XYWVec& wposP1 = HelixData._chHitsWPos[f1];
-      facezP1 = wposP1.face();
-      float   ri2    = wposP1.Mag2();
-
-      for (int f2=f1+1; f2<nHits-1; ++f2){
-	hitP2 = &HelixData._chHitsToProcess[f2];
-	XYWVec& wposP2  = HelixData._chHitsWPos[f2];
-	facezP2 = wposP2.face();
-	if (!use(*hitP2) || (facezP1 == facezP2)) continue;
-
-	float   dist2ij = (wposP1 - wposP2).Mag2();
-	if (dist2ij < mind2 || dist2ij > maxd2) continue;	  
-
-	float rj2 = wposP2.Mag2();
-
-	for (int f3=f2+1; f3<nHits; ++f3){
-	  hitP3 = &HelixData._chHitsToProcess[f3];
-	  XYWVec& wposP3 = HelixData._chHitsWPos[f3];
-	  facezP3 = wposP3.face();
-	  if (!use(*hitP3) || (facezP2 == facezP3) ) continue;
-
-	  float dist2ik = (wposP1-wposP3).Mag2();
-	  float dist2jk = (wposP2-wposP3).Mag2();
-	  if (dist2ik < mind2 || dist2jk < mind2 ||
-	      dist2ik > maxd2 || dist2jk > maxd2)   continue;
-
-	  // Heron's formula
-	  float area2 = (dist2ij*dist2jk + dist2ik*dist2jk + dist2ij*dist2ik) - 0.5*(dist2ij*dist2ij + dist2jk*dist2jk + dist2ik*dist2ik);
-	  if(area2 < _minarea2)              continue;
-	  // this effectively measures the slope difference
-	  float delta = (wposP3.x() - wposP2.x())*(wposP2.y() - wposP1.y()) -
-	    (wposP2.x() - wposP1.x())*(wposP3.y() - wposP2.y());
-
-	  float rk2 = wposP3.Mag2();
-
-	  // find circle center for this triple
-	  float cx = 0.5* (
-			   (wposP3.y() - wposP2.y())*ri2 +
-			   (wposP1.y() - wposP3.y())*rj2 +
-			   (wposP2.y() - wposP1.y())*rk2 ) / delta;
-	  float cy = -0.5* (
-			    (wposP3.x() - wposP2.x())*ri2 +
-			    (wposP1.x() - wposP3.x())*rj2 +
-			    (wposP2.x() - wposP1.x())*rk2 ) / delta;
-	  XYVec cent(cx,cy);
-	  float rho = sqrtf((wposP1-cent).Mag2());
-	  float rc = sqrtf(cent.Mag2());
-	  float rmin = fabs(rc-rho);
-	  float rmax = rc+rho;
-
-	  // test circle parameters for this triple: should be inside the tracker,
-	  // optionally consistent with the target
-	  if (rc > _rcmin && rc < _rcmax &&
-	      rho > _rmin && rho < _rmax && rmax < _trackerradius && 
-	      //	      ( !_targetcon || rmin < _targetradius) )
-	      ( !forceTargetCon || rmin < _targetradius) )
-
-	    {
-	      ++ntriple;
-
-	      float wt(0);
-	      if (!useTripleAreaWt){
-		wt  = cbrtf(wposP1.weight()*wposP2.weight()*wposP3.weight());
-	      } else{
-		wt = area2;
-	      }
-	      
-	      accx.push(cx,wt);
-	      accy.push(cy,wt);
-	      if(_tripler) accr.push(rho,wt);
-	      if (ntriple>_ntripleMax) {
-		f1=nHits-2; f2=nHits-1; f3=nHits;
-	      }
-	    }
-	}//end loop for f3 Faces
-      }//end loop for f2 Faces
-    }//end loop for f1 Faces
+    MedianCalculator& accx = _scratch.accx;
+    MedianCalculator& accy = _scratch.accy;
+    MedianCalculator& accr = _scratch.accr;
+    accx.clear();
+    accy.clear();
+    accr.clear();
+
+    ComboHit*     hitP1(0);
+    updateTriplets(HelixData, forceTargetCon, useTripleAreaWt);
+    unsigned      ntriple(_scratch.triplets.size());
+    for (auto const& trip : _scratch.triplets) {
+      accx.push(trip._cx,trip._wt);
+      accy.push(trip._cy,trip._wt);
+      if(_tripler) accr.push(trip._rho,trip._wt);
+    }
     
     // median calculation needs a reasonable number of points to function
     if (ntriple > _ntripleMin)
@@ -1249,12 +1147,250 @@ namespace mu2e
     }
   }
   
+  void RobustHelixFit::updateTriplets(RobustHelixFinderData& HelixData, bool forceTargetCon, bool useTripleAreaWt)
+  {
+    auto&  trips = _scratch.triplets;
+    auto&  state = _scratch.circHits;
+    auto&  removed = _scratch.circRemoved;
+    int    nHits(HelixData._chHitsToProcess.size());
+
+    // if there are too many triplets to test them all, test a random sample of them.  This bounds
+    // the time spent on high-occupancy time clusters
+    std::vector<unsigned>& used = _scratch.usedHits;
+    used.clear();
+    for (int f=0; f<nHits; ++f)
+      if (use(HelixData._chHitsToProcess[f])) used.push_back(f);
+    const uint64_t nused(used.size());
+    if (_maxTripletTests > 0 && nused*(nused-1)*(nused-2)/6 > _maxTripletTests) {
+      const float mind2 = _mindist*_mindist;
+      const float maxd2 = _maxdist*_maxdist;
+      _scratch.circValid = false;
+      trips.clear();
+      // the engine is reseeded for every fit, so the result doesn't depend on the previous fits
+      std::minstd_rand engine(_tripletSampleSeed);
+      std::uniform_int_distribution<unsigned> flat(0,nused-1);
+      for (unsigned itest=0; itest<_maxTripletTests && trips.size()<=_ntripleMax; ++itest){
+	unsigned i1(flat(engine)), i2(flat(engine)), i3(flat(engine));
+	if (i1 == i2 || i1 == i3 || i2 == i3)       continue;
+	// order the hits as in the exhaustive search
+	if (i1 > i2) std::swap(i1,i2);
+	if (i2 > i3) std::swap(i2,i3);
+	if (i1 > i2) std::swap(i1,i2);
+	XYWVec& wposP1 = HelixData._chHitsWPos[used[i1]];
+	XYWVec& wposP2 = HelixData._chHitsWPos[used[i2]];
+	XYWVec& wposP3 = HelixData._chHitsWPos[used[i3]];
+	if (wposP1.face() == wposP2.face() || wposP2.face() == wposP3.face()) continue;
+
+	float   dist2ij = (wposP1 - wposP2).Mag2();
+	if (dist2ij < mind2 || dist2ij > maxd2) continue;
+
+	float cx, cy, rho, area2;
+	if (tripletCircle(wposP1,wposP2,wposP3,dist2ij,forceTargetCon,cx,cy,rho,area2)){
+	  float wt = useTripleAreaWt ? area2 : cbrtf(wposP1.weight()*wposP2.weight()*wposP3.weight());
+	  trips.push_back(Triplet{uint16_t(used[i1]),uint16_t(used[i2]),uint16_t(used[i3]),cx,cy,rho,wt});
+	}
+      }
+      return;
+    }
+
+    // the previous triplets can be reused if the hits didn't move and none was restored
+    bool reuse = _scratch.circValid && (int)state.size() == nHits &&
+      _scratch.circTargetCon == forceTargetCon && _scratch.circAreaWt == useTripleAreaWt;
+    removed.assign(nHits,0);
+    bool anyRemoved(false);
+    for (int f=0; f<nHits; ++f) {
+      XYWVec const& wpos = HelixData._chHitsWPos[f];
+      CircleHit current{use(HelixData._chHitsToProcess[f]),wpos.face(),(float)wpos.x(),(float)wpos.y(),wpos.weight()};
+      if (reuse) {
+	if (!current.samePosition(state[f]) || (current._use && !state[f]._use))
+	  reuse = false;
+	else if (state[f]._use && !current._use)
+	  anyRemoved = removed[f] = 1;
+      }
+      if (f < (int)state.size())
+	state[f] = current;
+      else
+	state.push_back(current);
+    }
+    state.resize(nHits);
+
+    if (!reuse) {
+      trips.clear();
+      _scratch.circTargetCon = forceTargetCon;
+      _scratch.circAreaWt    = useTripleAreaWt;
+      _scratch.circValid     = true;
+      scanTriplets(HelixData,forceTargetCon,useTripleAreaWt,0,1,2);
+    } else if (anyRemoved) {
+      trips.erase(std::remove_if(trips.begin(),trips.end(),[&removed](Triplet const& trip) {
+	    return removed[trip._i1] || removed[trip._i2] || removed[trip._i3]; }),trips.end());
+      if (!_scratch.circDone && trips.size() <= _ntripleMax)
+	scanTriplets(HelixData,forceTargetCon,useTripleAreaWt,
+		     _scratch.circNext[0],_scratch.circNext[1],_scratch.circNext[2]);
+    }
+  }
+
+  // test the triplets in index order, starting with (s1,s2,s3), until more than _ntripleMax are accepted
+  void RobustHelixFit::scanTriplets(RobustHelixFinderData& HelixData, bool forceTargetCon, bool useTripleAreaWt,
+				    int s1, int s2, int s3)
+  {
+    const float mind2 = _mindist*_mindist;
+    const float maxd2 = _maxdist*_maxdist;
+    auto&  trips = _scratch.triplets;
+    auto const& state = _scratch.circHits;
+    int    nHits(HelixData._chHitsToProcess.size());
+
+    for (int f1=s1; f1<nHits-2; ++f1){
+      if (!state[f1]._use)                        continue;
+      XYWVec& wposP1 = HelixData._chHitsWPos[f1];
+      int facezP1 = wposP1.face();
+
+      for (int f2=(f1 == s1 ? s2 : f1+1); f2<nHits-1; ++f2){
+	XYWVec& wposP2  = HelixData._chHitsWPos[f2];
+	int facezP2 = wposP2.face();
+	if (!state[f2]._use || (facezP1 == facezP2)) continue;
+
+	float   dist2ij = (wposP1 - wposP2).Mag2();
+	if (dist2ij < mind2 || dist2ij > maxd2) continue;	  
+
+	for (int f3=(f1 == s1 && f2 == s2 ? s3 : f2+1); f3<nHits; ++f3){
+	  XYWVec& wposP3 = HelixData._chHitsWPos[f3];
+	  int facezP3 = wposP3.face();
+	  if (!state[f3]._use || (facezP2 == facezP3) ) continue;
+
+	  float cx, cy, rho, area2;
+	  if (tripletCircle(wposP1,wposP2,wposP3,dist2ij,forceTargetCon,cx,cy,rho,area2))
+	    {
+	      float wt = useTripleAreaWt ? area2 : cbrtf(wposP1.weight()*wposP2.weight()*wposP3.weight());
+	      trips.push_back(Triplet{uint16_t(f1),uint16_t(f2),uint16_t(f3),cx,cy,rho,wt});
+	      if (trips.size()>_ntripleMax) {
+		_scratch.circNext[0] = f1; _scratch.circNext[1] = f2; _scratch.circNext[2] = f3+1;
+		_scratch.circDone = false;
+		return;
+	      }
+	    }
+	}//end loop for f3 Faces
+      }//end loop for f2 Faces
+    }//end loop for f1 Faces
+    _scratch.circDone = true;
+  }
+
+  bool RobustHelixFit::tripletCircle(XYWVec const& wposP1, XYWVec const& wposP2, XYWVec const& wposP3, float dist2ij,
+				     bool forceTargetCon, float& cx, float& cy, float& rho, float& area2) const
+  {
+    const float mind2 = _mindist*_mindist;
+    const float maxd2 = _maxdist*_maxdist;
+
+    float dist2ik = (wposP1-wposP3).Mag2();
+    float dist2jk = (wposP2-wposP3).Mag2();
+    if (dist2ik < mind2 || dist2jk < mind2 ||
+	dist2ik > maxd2 || dist2jk > maxd2)   return false;
+
+    // Heron's formula
+    area2 = (dist2ij*dist2jk + dist2ik*dist2jk + dist2ij*dist2ik) - 0.5*(dist2ij*dist2ij + dist2jk*dist2jk + dist2ik*dist2ik);
+    if(area2 < _minarea2)              return false;
+    // this effectively measures the slope difference
+    float delta = (wposP3.x() - wposP2.x())*(wposP2.y() - wposP1.y()) -
+      (wposP2.x() - wposP1.x())*(wposP3.y() - wposP2.y());
+
+    float ri2 = wposP1.Mag2();
+    float rj2 = wposP2.Mag2();
+    float rk2 = wposP3.Mag2();
+
+    // find circle center for this triple
+    cx = 0.5* (
+	       (wposP3.y() - wposP2.y())*ri2 +
+	       (wposP1.y() - wposP3.y())*rj2 +
+	       (wposP2.y() - wposP1.y())*rk2 ) / delta;
+    cy = -0.5* (
+		(wposP3.x() - wposP2.x())*ri2 +
+		(wposP1.x() - wposP3.x())*rj2 +
+		(wposP2.x() - wposP1.x())*rk2 ) / delta;
+    XYVec cent(cx,cy);
+    rho = sqrtf((wposP1-cent).Mag2());
+    float rc = sqrtf(cent.Mag2());
+    float rmin = fabs(rc-rho);
+    float rmax = rc+rho;
+
+    // test circle parameters for this triple: should be inside the tracker,
+    // optionally consistent with the target
+    return rc > _rcmin && rc < _rcmax &&
+      rho > _rmin && rho < _rmax && rmax < _trackerradius && 
+      ( !forceTargetCon || rmin < _targetradius);
+  }
+
+  int RobustHelixFit::fzPairBin(FZHit const& hit1, FZHit const& hit2, Helicity const& helicity, float dzdphisign) const
+  {
+    if (!hit1._use || !hit2._use || hit1._face == hit2._face) return fzSkip;
+    float dz   = hit2._z - hit1._z;
+    float dphi = hit2._hphi - hit1._hphi; 
+    if (fabs(dphi) < _mindphi)                    return fzSkip;
+    float lambda = dz/dphi;
+    if (!goodLambda(helicity,lambda))             return fzSkip;
+    if (lambda*dzdphisign >= _fitFZMaxL)          return fzSkip;
+    // a pair below the lambda range ends the row of the first hit
+    if (lambda*dzdphisign <= _fitFZMinL)          return fzStop;
+    int bin = (lambda*dzdphisign-_fitFZMinL)/_fitFZStepL;
+    return bin < (int)_fitFZNBins ? bin : fzSkip;
+  }
+
+  void RobustHelixFit::updateFZHist(RobustHelixFinderData& HelixData, Helicity const& helicity, float dzdphisign)
+  {
+    auto&  hits  = HelixData._chHitsToProcess;
+    int    nhits = hits.size();
+    auto&  state = _scratch.fzHits;
+    auto&  pbin  = _scratch.fzPairBin;
+    auto&  hist  = _scratch.fzHist;
+    auto&  rowEnd = _scratch.fzRowEnd;
+    auto&  nchanged = _scratch.fzNChanged;
+    int    hel   = helicity._value;
+
+    // refill everything if the hits or helicity are not those of the last call
+    bool refill = !_scratch.fzValid || (int)state.size() != nhits || _scratch.fzHelicity != hel;
+    if (refill) {
+      hist.assign(_fitFZNBins,0);
+      pbin.assign(nhits*nhits,fzSkip);
+      rowEnd.assign(nhits,0);
+      state.resize(nhits);
+      _scratch.fzNPairs   = 0;
+      _scratch.fzHelicity = hel;
+      _scratch.fzValid    = true;
+    }
+    nchanged.assign(nhits+1,0);
+    for (int i=0; i<nhits; ++i) {
+      ComboHit const& hit = hits[i];
+      FZHit current{use(hit),hit.strawId().uniqueFace(),hit.pos().z(),hit.helixPhi()};
+      bool changed = refill || current != state[i];
+      if (changed) state[i] = current;
+      nchanged[i+1] = nchanged[i] + (changed ? 1 : 0);
+    }
+    // rescan the rows which scanned a changed hit
+    for (int i=0; i<nhits-1; ++i) {
+      bool changed = nchanged[i+1] != nchanged[i];
+      if (!refill && !changed && nchanged[rowEnd[i]+1] == nchanged[i+1]) continue;
+      for (int j=i+1; j<=rowEnd[i]; ++j) {
+	int16_t& bin = pbin[i*nhits+j];
+	if (bin >= 0) { --hist[bin]; --_scratch.fzNPairs; }
+	bin = fzSkip;
+      }
+      rowEnd[i] = i;
+      if (!state[i]._use) continue;
+      rowEnd[i] = nhits-1;
+      for (int j=i+1; j<nhits; ++j) {
+	int bin = fzPairBin(state[i],state[j],helicity,dzdphisign);
+	if (bin == fzStop) { rowEnd[i] = j; break; }
+	pbin[i*nhits+j] = bin;
+	if (bin >= 0) { ++hist[bin]; ++_scratch.fzNPairs; }
+      }
+    }
+  }
+
   void RobustHelixFit::findAGE(RobustHelixFinderData const& HelixData, XYZVec const& center,float& rmed, float& age)
   {     
     const ComboHitCollection& hhits = HelixData._hseed._hhits;
 
     // fill radial information for all points, given this center
-    std::vector<WVal> radii;
+    std::vector<WVal>& radii = _scratch.radii;
+    radii.clear();
     float wtot(0.0);
     for(auto const& hhit : hhits)
       {
@@ -1282,7 +1418,8 @@ namespace mu2e
     if (radii.size() > _minnhit)
       {
         // find the median radius
-	MedianCalculator accr(radii.size());
+	MedianCalculator& accr = _scratch.accage;
+	accr.clear();
         for(unsigned irad=0;irad<radii.size();++irad)
 	  accr.push(radii[irad].first, radii[irad].second);
 
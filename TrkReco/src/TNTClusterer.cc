@@ -195,18 +195,7 @@ namespace mu2e
            // -- Find cluster closest to hit
            int minc(-1);                  
            float mindist(dseed_+1.0f);         
-           int itime = int(chcol[hit.chidx_].time()/tbin);
-
-           for (auto i : hitDtIdx_)
-           {
-               for (const auto& ic : hitIndex[itime+i])
-               {                
-                   float dist = distance(clusters[ic],chcol[hit.chidx_]);
-                   if (dist < mindist) {mindist = dist; minc = ic;}
-                   if (mindist < dhit_) break;               
-               }          
-               if (mindist < dhit_) break;               
-           }
+           closestBucket(chcol[hit.chidx_], clusters, tbin, hitIndex, minc, mindist);
 
            // -- Form new cluster, add hit to new cluster or do nothing
            if (mindist < dhit_) 
@@ -275,6 +264,26 @@ namespace mu2e
    }
 
 
+   //-------------------------------------------------------------------------------------------------------------------
+   // closest cluster in the time buckets around the hit, in cluster order. Stop at the first one within the hit distance
+   void TNTClusterer::closestBucket(const ComboHit& hit, const std::vector<BkgCluster>& clusters, float tbin, 
+                                    const arrayVecBkg& hitIndex, int& minc, float& mindist) const
+   {
+       int itime = int(hit.time()/tbin);
+       for (auto i : hitDtIdx_)
+       {
+           if (itime+i < 0 || itime+i >= numBuckets) continue;
+           for (const auto& ic : hitIndex[itime+i])
+           {                
+               float dist = distance(clusters[ic],hit);
+               if (dist < mindist) {mindist = dist; minc = ic;}
+               if (mindist < dhit_) break;               
+           }          
+           if (mindist < dhit_) break;               
+       }
+   }
+
+
    //-----------------------------------------------------------------------------------------------
    void TNTClusterer::mergeClusters(std::vector<BkgCluster>& clusters, const ComboHitCollection& chcol, 
                                     std::vector<BkgHit>& BkgHits, float dt, float dd2)
@@ -48,6 +48,18 @@ namespace mu2e
         return ch.time() - tflt - _avgDriftTime; // otherwise make an average correction
    }
 
+   void TrkTimeCalculator::comboHitTimes(ComboHitSoA const& soa,double pitch,std::vector<float>& times) const
+   {
+      // same arithmetic as comboHitTime, hit by hit
+      size_t nch = soa.size();
+      times.resize(nch);
+      const float* z = soa.z().data();
+      const float* t = _useTOTdrift ? soa.correctedTime().data() : soa.time().data();
+      const double toffset = _useTOTdrift ? 0.0 : _avgDriftTime;
+      for (size_t ich=0; ich < nch; ++ich)
+        times[ich] = t[ich] - timeOfFlightTimeOffset(z[ich],pitch) - toffset;
+   }
+
    double TrkTimeCalculator::caloClusterTime(CaloCluster const& cc,double pitch) const 
    {
       mu2e::GeomHandle<mu2e::Calorimeter> ch;